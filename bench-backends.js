@@ -0,0 +1,116 @@
+// Benchmark: compute backend matrix (backend × flash attention × threads)
+// Usage: node bench-backends.js <model> <clip> [language] [name=ggml-backend-library ...]
+//
+// Each configuration runs in its own child process because ggml backends cannot
+// be unloaded once registered. Extra name=path arguments add BLAS variants that
+// are loaded through backend_libraries (ggml built with GGML_BACKEND_DL).
+const fs = require('fs');
+const os = require('os');
+const { execFileSync } = require('child_process');
+
+// 子进程: 按给定配置加载模型并转录一次, 结果以 JSON 输出到 stdout
+if (process.argv[2] === '--run') {
+    const config = JSON.parse(process.argv[3]);
+    const llwhisper = require('./build/bin/Release/llwhisper.node');
+    try {
+        let start = process.hrtime.bigint();
+        llwhisper.loadModel(config.model, config.backend);
+        const loadMs = Number(process.hrtime.bigint() - start) / 1e6;
+
+        const decoded = llwhisper.decodeAudio(config.clip, {});
+        const audioSeconds = decoded.samples.length / decoded.sampleRate;
+
+        start = process.hrtime.bigint();
+        const segments = llwhisper.transcribe(config.clip, {
+            language: config.language,
+            n_threads: config.threads,
+            stream_decode: false
+        });
+        const elapsed = Number(process.hrtime.bigint() - start) / 1e9;
+
+        const info = llwhisper.getBackendInfo();
+        process.stdout.write(JSON.stringify({
+            ok: true,
+            loadMs,
+            rtf: elapsed / audioSeconds,
+            segments: segments.length,
+            devices: info.devices.filter(d => d.active).map(d => d.name),
+            systemInfo: info.systemInfo
+        }));
+    } catch (err) {
+        process.stdout.write(JSON.stringify({ ok: false, error: err.message }));
+    }
+    process.exit(0);
+}
+
+const modelPath = process.argv[2] || 'F:\\ollama\\model\\whisper-large-v3-gglm\\ggml-large-v3.bin';
+const clipPath = process.argv[3] || 'F:\\Downloads\\bench-clip.wav';
+const language = process.argv[4] || 'auto';
+const libraries = process.argv.slice(5).map(arg => {
+    const eq = arg.indexOf('=');
+    return { name: arg.slice(0, eq), path: arg.slice(eq + 1) };
+});
+
+if (!fs.existsSync(modelPath) || !fs.existsSync(clipPath)) {
+    console.log('⚠️  Model or clip not found');
+    console.log('Usage: node bench-backends.js <model> <clip> [language] [name=ggml-backend-library ...]');
+    process.exit(0);
+}
+
+const backends = [
+    { name: 'auto', options: { backend: 'auto' } },
+    { name: 'cpu', options: { backend: 'cpu' } },
+    { name: 'blas', options: { backend: 'blas' } },
+    ...libraries.map(lib => ({ name: lib.name, options: { backend: 'blas', backend_libraries: [lib.path] } }))
+];
+const cores = os.cpus().length;
+const threadCounts = [...new Set([1, 2, 4, 8, cores].filter(n => n <= cores))].sort((a, b) => a - b);
+
+console.log('\n⏱️  Compute Backend Benchmark');
+console.log('='.repeat(72));
+console.log(`Model: ${modelPath}`);
+console.log(`Clip:  ${clipPath}`);
+console.log(`Cores: ${cores}`);
+
+const rows = [];
+let systemInfo = '';
+for (const backend of backends) {
+    for (const flashAttn of [false, true]) {
+        for (const threads of threadCounts) {
+            const config = {
+                model: modelPath,
+                clip: clipPath,
+                language,
+                threads,
+                backend: { ...backend.options, flash_attn: flashAttn }
+            };
+            const output = execFileSync(process.execPath, [__filename, '--run', JSON.stringify(config)], {
+                encoding: 'utf8',
+                stdio: ['ignore', 'pipe', 'ignore']
+            });
+            const result = JSON.parse(output);
+            rows.push({ backend: backend.name, flashAttn, threads, ...result });
+            if (result.ok) systemInfo = result.systemInfo;
+            if (!result.ok) break;   // 后端不可用时其余线程数也不可用
+        }
+    }
+}
+
+console.log('\n' + '='.repeat(72));
+console.log('Backend      Flash  Threads   Load (ms)   RTF      Devices');
+console.log('-'.repeat(72));
+for (const r of rows) {
+    const head = `${r.backend.padEnd(12)} ${(r.flashAttn ? 'on' : 'off').padEnd(6)} ${String(r.threads).padStart(7)}   `;
+    if (!r.ok) {
+        console.log(head + `unavailable: ${r.error}`);
+        continue;
+    }
+    console.log(head + `${r.loadMs.toFixed(0).padStart(9)}   ${r.rtf.toFixed(3).padEnd(8)} ${r.devices.join(' + ')}`);
+}
+
+const best = rows.filter(r => r.ok).sort((a, b) => a.rtf - b.rtf)[0];
+if (best) {
+    console.log(`\n🏆 Fastest: backend=${best.backend} flash_attn=${best.flashAttn} n_threads=${best.threads} (RTF ${best.rtf.toFixed(3)})`);
+}
+console.log(`\nSystem: ${systemInfo}`);
+console.log('RTF = transcription time / audio duration (lower is faster)');
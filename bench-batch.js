@@ -0,0 +1,63 @@
+// Benchmark: per-file transcribe() calls vs transcribeBatch() at several concurrency levels
+// Usage: node bench-batch.js <model> <folder> [language] [concurrency list, e.g. 1,2,4]
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const modelPath = process.argv[2] || 'models/ggml-base.bin';
+const folder = process.argv[3] || 'F:\\Downloads\\bench-batch';
+const language = process.argv[4] || 'ja';
+const levels = (process.argv[5] || '1,2,4').split(',').map(n => parseInt(n, 10));
+const extensions = new Set(['.wav', '.mp3', '.m4a', '.flac', '.mp4', '.mkv', '.mov']);
+
+if (!fs.existsSync(modelPath) || !fs.existsSync(folder)) {
+    console.log('⚠️  Model or folder not found');
+    console.log('Usage: node bench-batch.js <model> <folder> [language] [concurrency list]');
+    process.exit(0);
+}
+
+const files = fs.readdirSync(folder)
+    .filter(name => extensions.has(path.extname(name).toLowerCase()))
+    .map(name => path.join(folder, name));
+
+console.log('\n⏱️  Batch Transcription Benchmark');
+console.log('='.repeat(72));
+console.log(`Model:  ${modelPath}`);
+console.log(`Files:  ${files.length}`);
+
+llwhisper.loadModel(modelPath);
+const cores = os.cpus().length;
+
+(async () => {
+    // 旧方式: 每个文件一次 transcribe, 文件之间没有重叠
+    const t0 = process.hrtime.bigint();
+    for (const file of files) {
+        await llwhisper.transcribe(file, { language, n_threads: cores });
+    }
+    const sequentialMs = Number(process.hrtime.bigint() - t0) / 1e6;
+
+    const rows = [];
+    for (const concurrency of levels) {
+        // 总线程数保持为核心数
+        const nThreads = Math.max(1, Math.floor(cores / concurrency));
+        const batch = await llwhisper.transcribeBatch(files, { language, n_threads: nThreads }, { concurrency });
+        const failed = batch.files.filter(f => f.error).length;
+        rows.push({ concurrency, nThreads, batch, failed });
+    }
+
+    const audioSeconds = rows.length > 0 ? rows[0].batch.audioSeconds : 0;
+    console.log('\n' + '='.repeat(72));
+    console.log(`Audio: ${(audioSeconds / 3600).toFixed(2)} h`);
+    console.log(`transcribe() x ${files.length}:  ${(sequentialMs / 1000).toFixed(1)} s  ` +
+                `${(audioSeconds / (sequentialMs / 1000)).toFixed(1)} audio h/h`);
+    for (const { concurrency, nThreads, batch, failed } of rows) {
+        console.log(`batch c=${concurrency} t=${String(nThreads).padEnd(3)}     ${(batch.wallMs / 1000).toFixed(1)} s  ` +
+                    `${batch.audioHoursPerHour.toFixed(1)} audio h/h  states=${batch.states}` +
+                    (failed ? `  ❌ ${failed} failed` : ''));
+    }
+})().catch(err => {
+    console.error('❌ Benchmark failed:', err.message);
+    process.exit(1);
+});
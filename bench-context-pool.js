@@ -0,0 +1,80 @@
+// Benchmark: FFmpeg decoder/resampler reuse on a corpus of short clips
+// Usage: node bench-context-pool.js <clips-dir> [rounds]
+const path = require('path');
+const fs = require('fs');
+const os = require('os');
+
+const llvideo = require('./build/bin/Release/llvideo.node');
+
+const clipsDir = process.argv[2] || 'F:\\Downloads\\clips';
+const rounds = parseInt(process.argv[3] || '3', 10);
+const extensions = ['.wav', '.mp3', '.m4a', '.aac', '.flac', '.mp4', '.mkv', '.webm'];
+
+if (!fs.existsSync(clipsDir)) {
+    console.log('⚠️  Clips directory not found:', clipsDir);
+    console.log('Usage: node bench-context-pool.js <clips-dir> [rounds]');
+    console.log('The directory should contain a few hundred 1-5 s clips.');
+    process.exit(0);
+}
+
+const clips = fs.readdirSync(clipsDir)
+    .filter(f => extensions.includes(path.extname(f).toLowerCase()))
+    .map(f => path.join(clipsDir, f));
+
+if (clips.length === 0) {
+    console.log('⚠️  No media clips found in', clipsDir);
+    process.exit(0);
+}
+
+const outputPath = path.join(os.tmpdir(), 'bench_context_pool.wav');
+const options = { sampleRate: 16000, channels: 1, codec: 'pcm_s16le', format: 'wav' };
+
+function runCorpus() {
+    const start = process.hrtime.bigint();
+    let audioSeconds = 0;
+    for (const clip of clips) {
+        llvideo.isValidMediaFile(clip);
+        const info = llvideo.getVideoInfo(clip);
+        audioSeconds += info.duration || 0;
+        if (info.hasAudio) {
+            llvideo.extractAudio(clip, outputPath, options);
+        }
+    }
+    const elapsedMs = Number(process.hrtime.bigint() - start) / 1e6;
+    return { elapsedMs, audioSeconds };
+}
+
+function bench(label, enabled) {
+    llvideo.setContextPoolEnabled(enabled);
+    runCorpus(); // warm-up (fills the pool / OS cache)
+
+    const times = [];
+    let audioSeconds = 0;
+    for (let i = 0; i < rounds; i++) {
+        const r = runCorpus();
+        times.push(r.elapsedMs);
+        audioSeconds = r.audioSeconds;
+    }
+    times.sort((a, b) => a - b);
+    const median = times[Math.floor(times.length / 2)];
+
+    console.log(`\n${label}`);
+    console.log('-'.repeat(60));
+    console.log(`  Total (median of ${rounds}): ${median.toFixed(1)} ms`);
+    console.log(`  Per clip: ${(median / clips.length).toFixed(3)} ms`);
+    console.log(`  Audio / wall-clock: ${(audioSeconds / (median / 1000)).toFixed(1)}x`);
+    console.log('  Pool stats:', llvideo.getContextPoolStats());
+    return median;
+}
+
+console.log('\n⏱️  FFmpeg Context Pool Benchmark');
+console.log('='.repeat(60));
+console.log(`Clips: ${clips.length} in ${clipsDir}`);
+
+const baseline = bench('Pool disabled (fresh contexts per file)', false);
+const pooled = bench('Pool enabled (reused decoders/resamplers/packets)', true);
+
+console.log('\n' + '='.repeat(60));
+console.log(`Speedup: ${(baseline / pooled).toFixed(2)}x`);
+
+if (fs.existsSync(outputPath)) fs.unlinkSync(outputPath);
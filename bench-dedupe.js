@@ -0,0 +1,62 @@
+// Benchmark: transcribing a folder with and without fingerprint deduplication
+// Usage: node bench-dedupe.js <model> <folder> [language]
+// The folder should contain some re-encodes / trimmed copies of the same recordings.
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const modelPath = process.argv[2] || 'models/ggml-base.bin';
+const folder = process.argv[3] || 'F:\\Downloads\\bench-dedupe';
+const language = process.argv[4] || 'ja';
+const extensions = new Set(['.wav', '.mp3', '.m4a', '.flac', '.mp4', '.mkv', '.mov']);
+
+if (!fs.existsSync(modelPath) || !fs.existsSync(folder)) {
+    console.log('⚠️  Model or folder not found');
+    console.log('Usage: node bench-dedupe.js <model> <folder> [language]');
+    process.exit(0);
+}
+
+const files = fs.readdirSync(folder)
+    .filter(name => extensions.has(path.extname(name).toLowerCase()))
+    .map(name => path.join(folder, name));
+const indexPath = path.join(os.tmpdir(), `bench-dedupe-${process.pid}.llfp`);
+
+console.log('\n⏱️  Fingerprint Dedupe Benchmark');
+console.log('='.repeat(72));
+console.log(`Model:  ${modelPath}`);
+console.log(`Files:  ${files.length}`);
+
+llwhisper.loadModel(modelPath);
+const cores = os.cpus().length;
+
+(async () => {
+    const t0 = process.hrtime.bigint();
+    for (const file of files) {
+        await llwhisper.transcribe(file, { language, n_threads: cores, stream_decode: false });
+    }
+    const plainMs = Number(process.hrtime.bigint() - t0) / 1e6;
+
+    // 先逐个查重 (只解码 + 指纹), 再带索引转录: 命中的文件直接复用
+    let hits = 0;
+    const t1 = process.hrtime.bigint();
+    for (const file of files) {
+        // 查重与转录使用相同的 language: 索引只复用相同解码参数产生的记录
+        const dup = await llwhisper.findDuplicate(file, { language, dedupe_index: indexPath });
+        if (dup) {
+            hits++;
+            console.log(`  ${path.basename(file)} -> ${path.basename(dup.path)} ` +
+                        `(+${dup.offsetSeconds.toFixed(2)} s, similarity ${dup.similarity.toFixed(3)})`);
+        }
+        await llwhisper.transcribe(file, { language, n_threads: cores, dedupe_index: indexPath });
+    }
+    const dedupeMs = Number(process.hrtime.bigint() - t1) / 1e6;
+
+    console.log('-'.repeat(72));
+    console.log(`Without dedupe: ${(plainMs / 1000).toFixed(1)} s`);
+    console.log(`With dedupe:    ${(dedupeMs / 1000).toFixed(1)} s  (${hits}/${files.length} reused, lookups included)`);
+    console.log(`Index size:     ${(fs.statSync(indexPath).size / 1024).toFixed(0)} KB`);
+    console.log('='.repeat(72));
+    fs.unlinkSync(indexPath);
+})();
@@ -0,0 +1,85 @@
+// Benchmark: five separate exportTo* calls vs one exportAll (parallel formatting, direct file writes)
+// Usage: node bench-export.js [segmentCount] [outDir]
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const segmentCount = parseInt(process.argv[2] || '100000', 10);
+const outDir = process.argv[3] || path.join(os.tmpdir(), 'llwhisper-bench-export');
+const formats = ['txt', 'srt', 'vtt', 'json', 'lrc'];
+
+// exportTo* 需要已创建的 wrapper 实例, exportAll 不需要
+const modelPath = process.env.WHISPER_MODEL;
+if (modelPath && fs.existsSync(modelPath)) {
+    llwhisper.loadModel(modelPath);
+}
+
+// 合成转录: 中英混合文本, 偶尔带引号 / 换行 (检验 JSON 转义)
+const segments = [];
+for (let i = 0; i < segmentCount; i++) {
+    const start = i * 2.5;
+    segments.push({
+        startTime: start,
+        endTime: start + 2.1,
+        text: i % 50 === 0 ? `Line ${i} says "hello"\nand continues` : `第 ${i} 段 segment text for export benchmark`
+    });
+}
+
+console.log('\n⏱️  Export Benchmark');
+console.log('='.repeat(72));
+console.log(`Segments: ${segmentCount}`);
+console.log(`Out dir:  ${outDir}`);
+
+(async () => {
+    fs.mkdirSync(outDir, { recursive: true });
+
+    // 旧方式: 每种格式各调用一次 (每次都重新读取 JS 片段), 再由 JS 写文件
+    let separateMs = null;
+    if (typeof llwhisper.exportToSrt === 'function' && llwhisper.exportToSrt(segments.slice(0, 1)) !== null) {
+        const t0 = process.hrtime.bigint();
+        const names = { txt: 'exportToTxt', srt: 'exportToSrt', vtt: 'exportToVtt', json: 'exportToJson', lrc: 'exportToLrc' };
+        for (const format of formats) {
+            const text = llwhisper[names[format]](segments);
+            fs.writeFileSync(path.join(outDir, `separate.${format}`), text);
+        }
+        separateMs = Number(process.hrtime.bigint() - t0) / 1e6;
+    } else {
+        console.log('(exportTo* skipped: set WHISPER_MODEL to create the wrapper instance)');
+    }
+
+    const t1 = process.hrtime.bigint();
+    const files = await llwhisper.exportAll(segments, { formats, outDir, baseName: 'all' });
+    const allMs = Number(process.hrtime.bigint() - t1) / 1e6;
+
+    const t2 = process.hrtime.bigint();
+    const inMemory = await llwhisper.exportAll(segments, { formats });
+    const memoryMs = Number(process.hrtime.bigint() - t2) / 1e6;
+
+    console.log('\n' + '='.repeat(72));
+    for (const file of files) {
+        console.log(`${file.format.padEnd(5)} ${(file.bytes / 1024 / 1024).toFixed(2).padStart(8)} MB  ${file.error || file.path}`);
+    }
+    console.log('-'.repeat(72));
+    if (separateMs !== null) {
+        console.log(`5 x exportTo* + writeFileSync: ${separateMs.toFixed(1)} ms`);
+    }
+    console.log(`exportAll (files):             ${allMs.toFixed(1)} ms`);
+    console.log(`exportAll (in memory):         ${memoryMs.toFixed(1)} ms`);
+
+    // 校验: JSON 可解析且文本一致, 与逐个导出结果相同
+    const json = JSON.parse(fs.readFileSync(path.join(outDir, 'all.json'), 'utf8'));
+    const jsonOk = json.segments.length === segmentCount && json.segments[0].text === segments[0].text;
+    console.log(`JSON valid:                    ${jsonOk ? '✅' : '❌'}`);
+    if (separateMs !== null) {
+        const same = formats.every(f =>
+            fs.readFileSync(path.join(outDir, `all.${f}`)).equals(fs.readFileSync(path.join(outDir, `separate.${f}`))));
+        console.log(`Matches exportTo*:             ${same ? '✅' : '❌'}`);
+    }
+    const memoryOk = inMemory.every(f => !f.error && Buffer.byteLength(f.content) === f.bytes);
+    console.log(`In-memory sizes consistent:    ${memoryOk ? '✅' : '❌'}`);
+})().catch(err => {
+    console.error('❌ Benchmark failed:', err.message);
+    process.exit(1);
+});
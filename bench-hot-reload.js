@@ -0,0 +1,80 @@
+// Benchmark: throughput of concurrent transcriptions while the model is swapped with reloadModel
+// Usage: node bench-hot-reload.js <modelA> <modelB> <audio> [concurrency] [seconds]
+const fs = require('fs');
+
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const modelA = process.argv[2] || 'models/ggml-base.bin';
+const modelB = process.argv[3] || 'models/ggml-base-q5_1.bin';
+const audioPath = process.argv[4] || 'F:\\Downloads\\short.wav';
+const concurrency = parseInt(process.argv[5] || '4', 10);
+const seconds = parseInt(process.argv[6] || '60', 10);
+
+if (!fs.existsSync(modelA) || !fs.existsSync(modelB) || !fs.existsSync(audioPath)) {
+    console.log('⚠️  Model or audio file not found');
+    console.log('Usage: node bench-hot-reload.js <modelA> <modelB> <audio> [concurrency] [seconds]');
+    process.exit(0);
+}
+
+console.log('\n⏱️  Hot Reload Benchmark');
+console.log('='.repeat(72));
+console.log(`Models: ${modelA} ⇄ ${modelB}`);
+console.log(`Audio:  ${audioPath}`);
+console.log(`Jobs:   ${concurrency} concurrent, ${seconds} s, model swapped every ${seconds / 4} s`);
+console.log('-'.repeat(72));
+
+llwhisper.loadModel(modelA);
+
+const started = Date.now();
+const completions = [];
+let failed = 0;
+let running = true;
+
+// 每个通道不停地提交转录作业 (transcribeBatch 在后台线程运行, 不阻塞事件循环)
+async function lane() {
+    while (running) {
+        try {
+            const batch = await llwhisper.transcribeBatch([audioPath], { language: 'auto', n_threads: 2 });
+            if (batch.files[0].error) failed++;
+            else completions.push(Date.now() - started);
+        } catch (e) {
+            failed++;
+        }
+    }
+}
+
+// 每 1/4 时长切换一次模型, 并记录旧版本排空所需的时间
+async function swapper() {
+    const models = [modelB, modelA, modelB];
+    for (const model of models) {
+        await new Promise(resolve => setTimeout(resolve, seconds * 250));
+        const t0 = Date.now();
+        const loaded = await llwhisper.reloadModel(model);
+        const loadMs = Date.now() - t0;
+        while (llwhisper.getLoadedModels().some(m => !m.current && !m.draft)) {
+            await new Promise(resolve => setTimeout(resolve, 20));
+        }
+        console.log(`swap → v${loaded.version} ${model}: load ${loadMs} ms, old version drained after ${Date.now() - t0} ms`);
+    }
+}
+
+(async () => {
+    const lanes = Array.from({ length: concurrency }, lane);
+    await swapper();
+    await new Promise(resolve => setTimeout(resolve, seconds * 250));
+    running = false;
+    await Promise.all(lanes);
+
+    // 每秒完成的作业数与最长的完成间隔
+    const buckets = new Array(Math.ceil(seconds)).fill(0);
+    completions.forEach(t => { if (t < seconds * 1000) buckets[Math.floor(t / 1000)]++; });
+    let maxGap = 0;
+    for (let i = 1; i < completions.length; i++) maxGap = Math.max(maxGap, completions[i] - completions[i - 1]);
+    const mean = completions.length / ((Date.now() - started) / 1000);
+
+    console.log('-'.repeat(72));
+    console.log(`Completed ${completions.length} jobs (${failed} failed), ${mean.toFixed(2)} jobs/s`);
+    console.log(`Per-second min ${Math.min(...buckets)}, max ${Math.max(...buckets)}; longest gap between completions ${maxGap} ms`);
+    console.log(`Loaded versions at exit: ${JSON.stringify(llwhisper.getLoadedModels())}`);
+    console.log('='.repeat(72));
+})();
@@ -0,0 +1,57 @@
+// Benchmark: peak memory and wall time of concurrent transcriptions with and without a memory budget
+// Usage: node bench-memory-budget.js <model> <audio> [budget MB] [jobs]
+const fs = require('fs');
+
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const modelPath = process.argv[2] || 'models/ggml-base.bin';
+const audioPath = process.argv[3] || 'F:\\Downloads\\long.mp4';
+const budgetMb = parseInt(process.argv[4] || '1024', 10);
+const jobs = parseInt(process.argv[5] || '4', 10);
+
+if (!fs.existsSync(modelPath) || !fs.existsSync(audioPath)) {
+    console.log('⚠️  Model or audio file not found');
+    console.log('Usage: node bench-memory-budget.js <model> <audio> [budget MB] [jobs]');
+    process.exit(0);
+}
+
+console.log('\n⏱️  Memory Budget Benchmark');
+console.log('='.repeat(72));
+console.log(`Model:  ${modelPath}`);
+console.log(`Audio:  ${audioPath}`);
+console.log(`Jobs:   ${jobs}`);
+
+const mb = bytes => (bytes / 1024 / 1024).toFixed(0).padStart(6) + ' MB';
+
+async function run(label, limitBytes) {
+    llwhisper.setMemoryBudget(limitBytes, 0);
+    llwhisper.loadModel(modelPath);
+
+    // 采样进程 RSS 与预算统计
+    let peakRss = 0;
+    let peakQueued = 0;
+    const timer = setInterval(() => {
+        peakRss = Math.max(peakRss, process.memoryUsage().rss);
+        peakQueued = Math.max(peakQueued, llwhisper.getMemoryStats().queued);
+    }, 50);
+
+    const t0 = process.hrtime.bigint();
+    // 需要整段 PCM 的作业 (说话人分离) 与可分块的作业混合
+    const results = await Promise.allSettled(Array.from({ length: jobs }, (_, i) =>
+        llwhisper.transcribe(audioPath, { language: 'auto', diarize: i % 2 === 1 })));
+    const ms = Number(process.hrtime.bigint() - t0) / 1e6;
+    clearInterval(timer);
+
+    const stats = llwhisper.getMemoryStats();
+    const failed = results.filter(r => r.status === 'rejected').length;
+    console.log(`${label.padEnd(14)} ${(ms / 1000).toFixed(1).padStart(7)} s  RSS peak ${mb(peakRss)}  ` +
+                `estimate peak ${mb(stats.peak)}  queued ${peakQueued}  chunked ${stats.chunked}  ` +
+                `rejected ${stats.rejected}  failed ${failed}`);
+}
+
+(async () => {
+    console.log('-'.repeat(72));
+    await run('unlimited', 0);
+    await run(`${budgetMb} MB`, budgetMb * 1024 * 1024);
+    console.log('='.repeat(72));
+})();
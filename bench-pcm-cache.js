@@ -0,0 +1,55 @@
+// Benchmark: repeated transcription with and without the decoded-PCM cache
+// Usage: node bench-pcm-cache.js <model> <media> [language]
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const modelPath = process.argv[2] || 'F:\\ollama\\model\\whisper-large-v3-gglm\\ggml-large-v3.bin';
+const mediaPath = process.argv[3] || 'F:\\Downloads\\bench-long.mkv';
+const language = process.argv[4] || 'auto';
+
+if (!fs.existsSync(modelPath) || !fs.existsSync(mediaPath)) {
+    console.log('⚠️  Model or media not found');
+    console.log('Usage: node bench-pcm-cache.js <model> <media> [language]');
+    process.exit(0);
+}
+
+// 缓存写到临时目录, 每次运行都从未命中开始
+const cacheDir = fs.mkdtempSync(path.join(os.tmpdir(), 'llpcm-'));
+
+function time(fn) {
+    const start = process.hrtime.bigint();
+    const result = fn();
+    return { ms: Number(process.hrtime.bigint() - start) / 1e6, result };
+}
+
+console.log('\n⏱️  PCM Cache Benchmark');
+console.log('='.repeat(72));
+console.log(`Model: ${modelPath}`);
+console.log(`Media: ${mediaPath}`);
+
+const uncached = time(() => llwhisper.decodeAudio(mediaPath, {}));
+const miss = time(() => llwhisper.decodeAudio(mediaPath, { pcm_cache: true, pcm_cache_dir: cacheDir }));
+const hit = time(() => llwhisper.decodeAudio(mediaPath, { pcm_cache: true, pcm_cache_dir: cacheDir }));
+const audioSeconds = uncached.result.samples.length / uncached.result.sampleRate;
+
+llwhisper.loadModel(modelPath);
+const plain = time(() => llwhisper.transcribe(mediaPath, { language, stream_decode: false }));
+const cached = time(() => llwhisper.transcribe(mediaPath, { language, pcm_cache: true, pcm_cache_dir: cacheDir }));
+
+const cacheFile = fs.readdirSync(cacheDir).map(f => path.join(cacheDir, f))[0];
+
+console.log('\n' + '='.repeat(72));
+console.log('Step                          Time (ms)');
+console.log('-'.repeat(72));
+console.log(`decode (no cache)             ${uncached.result.decodeMs.toFixed(1).padStart(9)}`);
+console.log(`decode + write cache (miss)   ${miss.result.decodeMs.toFixed(1).padStart(9)}`);
+console.log(`map cache (hit)               ${hit.result.decodeMs.toFixed(1).padStart(9)}`);
+console.log(`transcribe (decode)           ${plain.ms.toFixed(0).padStart(9)}`);
+console.log(`transcribe (cache hit)        ${cached.ms.toFixed(0).padStart(9)}`);
+console.log(`\nAudio: ${audioSeconds.toFixed(1)}s, cache file: ${(fs.statSync(cacheFile).size / 1048576).toFixed(1)} MB`);
+console.log('decodeAudio copies the mapped samples into its Float32Array; transcribe passes the mapping to whisper directly');
+
+fs.rmSync(cacheDir, { recursive: true, force: true });
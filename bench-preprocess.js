@@ -0,0 +1,71 @@
+// Benchmark: cost and effect of the audio preprocessing stage
+// Usage: node bench-preprocess.js <model> <clip> [language]
+//
+// For each preprocessing configuration this reports the preprocessing cost
+// extrapolated to one hour of audio, the transcription time, and how many
+// segments scored below logprob_thold / entropy_thold (lowConfidence, an
+// estimate of the windows whisper had to retry at higher temperatures).
+// Use a noisy or quiet recording to see the effect on confidence.
+const fs = require('fs');
+
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const modelPath = process.argv[2] || 'F:\\ollama\\model\\whisper-large-v3-gglm\\ggml-large-v3.bin';
+const clipPath = process.argv[3] || 'F:\\Downloads\\bench-noisy.wav';
+const language = process.argv[4] || 'auto';
+
+if (!fs.existsSync(modelPath) || !fs.existsSync(clipPath)) {
+    console.log('⚠️  Model or clip not found');
+    console.log('Usage: node bench-preprocess.js <model> <clip> [language]');
+    process.exit(0);
+}
+
+const configs = [
+    { name: 'none', options: {} },
+    { name: 'highpass', options: { highpass: true } },
+    { name: 'normalize', options: { normalize: true } },
+    { name: 'denoise', options: { highpass: true, denoise: true } },
+    { name: 'all', options: { highpass: true, denoise: true, normalize: true } }
+];
+
+console.log('\n⏱️  Audio Preprocessing Benchmark');
+console.log('='.repeat(72));
+console.log(`Model: ${modelPath}`);
+console.log(`Clip:  ${clipPath}`);
+
+llwhisper.loadModel(modelPath);
+
+const rows = [];
+for (const config of configs) {
+    // 预处理耗时取三次解码的最小值
+    let preprocessMs = Infinity;
+    let audioSeconds = 0;
+    for (let i = 0; i < 3; i++) {
+        const decoded = llwhisper.decodeAudio(clipPath, config.options);
+        preprocessMs = Math.min(preprocessMs, decoded.preprocessMs);
+        audioSeconds = decoded.samples.length / decoded.sampleRate;
+    }
+
+    const start = process.hrtime.bigint();
+    const segments = llwhisper.transcribe(clipPath, { language, ...config.options });
+    const elapsed = Number(process.hrtime.bigint() - start) / 1e9;
+
+    rows.push({
+        name: config.name,
+        msPerHour: preprocessMs * 3600 / audioSeconds,
+        rtf: elapsed / audioSeconds,
+        lowConfidence: segments.filter(s => s.lowConfidence).length,
+        segments: segments.length,
+        avgLogprob: segments.reduce((sum, s) => sum + s.avgLogprob, 0) / Math.max(1, segments.length)
+    });
+}
+
+console.log('\n' + '='.repeat(72));
+console.log('Config      Preproc (ms/h)   RTF      Low conf.    Avg logprob');
+console.log('-'.repeat(72));
+for (const r of rows) {
+    console.log(`${r.name.padEnd(11)} ${r.msPerHour.toFixed(0).padStart(14)}   ${r.rtf.toFixed(3).padEnd(8)} ` +
+                `${`${r.lowConfidence}/${r.segments}`.padStart(9)}    ${r.avgLogprob.toFixed(3)}`);
+}
+console.log('\nPreproc = preprocessing time per hour of audio (decode excluded)');
+console.log('RTF = transcription time / audio duration (lower is faster)');
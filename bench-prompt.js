@@ -0,0 +1,54 @@
+// Benchmark: cost of initial_prompt (cached tokenisation) on transcription throughput
+// Usage: node bench-prompt.js <model> <audio> [language] [prompt]
+const fs = require('fs');
+
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const modelPath = process.argv[2] || 'models/ggml-base.bin';
+const audioPath = process.argv[3] || 'F:\\Downloads\\bench-30min.wav';
+const language = process.argv[4] || 'ja';
+const prompt = process.argv[5] || '用語集: 量子化、ビームサーチ、話者分離、ウィスパー、エンコーダ、デコーダ。';
+
+if (!fs.existsSync(modelPath) || !fs.existsSync(audioPath)) {
+    console.log('⚠️  Model or audio not found');
+    console.log('Usage: node bench-prompt.js <model> <audio> [language] [prompt]');
+    process.exit(0);
+}
+
+console.log('\n⏱️  Initial Prompt Benchmark');
+console.log('='.repeat(72));
+console.log(`Model:  ${modelPath}`);
+console.log(`Audio:  ${audioPath}`);
+console.log(`Prompt: ${prompt}`);
+
+llwhisper.loadModel(modelPath);
+
+// 第一次分词写入缓存, 之后直接命中
+let t = process.hrtime.bigint();
+const tokens = llwhisper.tokenize(prompt);
+const firstUs = Number(process.hrtime.bigint() - t) / 1e3;
+t = process.hrtime.bigint();
+for (let i = 0; i < 1000; i++) llwhisper.tokenize(prompt);
+const cachedUs = Number(process.hrtime.bigint() - t) / 1e3 / 1000;
+
+(async () => {
+    const run = async (options) => {
+        const start = process.hrtime.bigint();
+        const segments = await llwhisper.transcribe(audioPath, { language, ...options });
+        return { ms: Number(process.hrtime.bigint() - start) / 1e6, segments };
+    };
+
+    const plain = await run({});
+    const primed = await run({ initial_prompt: prompt });
+
+    console.log('\n' + '='.repeat(72));
+    console.log(`Prompt tokens:          ${tokens.length}`);
+    console.log(`tokenize (first):       ${firstUs.toFixed(1)} µs`);
+    console.log(`tokenize (cached):      ${cachedUs.toFixed(2)} µs`);
+    console.log(`transcribe:             ${(plain.ms / 1000).toFixed(2)} s  (${plain.segments.length} segments)`);
+    console.log(`transcribe + prompt:    ${(primed.ms / 1000).toFixed(2)} s  (${primed.segments.length} segments)`);
+    console.log(`Overhead:               ${((primed.ms / plain.ms - 1) * 100).toFixed(1)} %`);
+})().catch(err => {
+    console.error('❌ Benchmark failed:', err.message);
+    process.exit(1);
+});
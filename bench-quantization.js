@@ -0,0 +1,110 @@
+// Benchmark: realtime factor and WER across model quantization levels
+// Usage: node bench-quantization.js <f16-model> <clip> [reference.txt] [language]
+//
+// Quantized models are written next to the source model (<name>-q8_0.bin, ...)
+// and reused on later runs. Without a reference transcript the f16 output is
+// used as the reference, so the WER column shows the drift caused by quantization.
+const path = require('path');
+const fs = require('fs');
+
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+const llvideo = require('./build/bin/Release/llvideo.node');
+
+const modelPath = process.argv[2] || 'F:\\ollama\\model\\whisper-large-v3-gglm\\ggml-large-v3.bin';
+const clipPath = process.argv[3] || 'F:\\Downloads\\bench-clip.wav';
+const referencePath = process.argv[4];
+const language = process.argv[5] || 'auto';
+const types = ['f16', 'q8_0', 'q5_1', 'q4_0'];
+
+if (!fs.existsSync(modelPath) || !fs.existsSync(clipPath)) {
+    console.log('⚠️  Model or clip not found');
+    console.log('Usage: node bench-quantization.js <f16-model> <clip> [reference.txt] [language]');
+    process.exit(0);
+}
+
+// 以空白分词; 无空格的语言 (日语 / 中文) 按字符计算, 即 CER
+function tokenize(text) {
+    const normalized = text.toLowerCase().replace(/[.,!?;:"'“”、。！？，]/g, ' ').trim();
+    const words = normalized.split(/\s+/).filter(Boolean);
+    return words.length > 1 ? words : Array.from(normalized.replace(/\s+/g, ''));
+}
+
+function errorRate(reference, hypothesis) {
+    const ref = tokenize(reference);
+    const hyp = tokenize(hypothesis);
+    if (ref.length === 0) return hyp.length === 0 ? 0 : 1;
+
+    let prev = Array.from({ length: hyp.length + 1 }, (_, j) => j);
+    for (let i = 1; i <= ref.length; i++) {
+        const cur = [i];
+        for (let j = 1; j <= hyp.length; j++) {
+            const cost = ref[i - 1] === hyp[j - 1] ? 0 : 1;
+            cur[j] = Math.min(prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + cost);
+        }
+        prev = cur;
+    }
+    return prev[hyp.length] / ref.length;
+}
+
+function modelFor(type) {
+    if (type === 'f16') return modelPath;
+    const ext = path.extname(modelPath);
+    return path.join(path.dirname(modelPath), `${path.basename(modelPath, ext)}-${type}${ext}`);
+}
+
+async function main() {
+    const clipSeconds = llvideo.getVideoInfo(clipPath).duration;
+
+    console.log('\n⏱️  Whisper Quantization Benchmark');
+    console.log('='.repeat(72));
+    console.log(`Model: ${modelPath}`);
+    console.log(`Clip:  ${clipPath} (${clipSeconds.toFixed(1)} s)`);
+
+    let reference = referencePath ? fs.readFileSync(referencePath, 'utf8') : null;
+    const rows = [];
+
+    for (const type of types) {
+        const typedModel = modelFor(type);
+        if (!fs.existsSync(typedModel)) {
+            console.log(`\nQuantizing to ${type}...`);
+            const start = Date.now();
+            await llwhisper.quantizeModel(modelPath, typedModel, type);
+            console.log(`  done in ${((Date.now() - start) / 1000).toFixed(1)} s`);
+        }
+
+        llwhisper.loadModel(typedModel);
+        const info = llwhisper.getModelInfo();
+
+        // 预热一次, 排除首次运行的页面缓存和内存分配开销
+        llwhisper.transcribe(clipPath, { language, duration_ms: 5000 });
+
+        const start = process.hrtime.bigint();
+        const segments = llwhisper.transcribe(clipPath, { language });
+        const elapsed = Number(process.hrtime.bigint() - start) / 1e9;
+        const text = segments.map(s => s.text).join(' ');
+
+        if (reference === null) reference = text;
+        rows.push({
+            type,
+            sizeMB: info.tensorBytes / 1048576,
+            tensorTypes: info.tensorTypes.map(t => `${t.type}:${t.tensors}`).join(' '),
+            rtf: elapsed / clipSeconds,
+            wer: errorRate(reference, text)
+        });
+    }
+
+    console.log('\n' + '='.repeat(72));
+    console.log('Type   Size (MB)   RTF      WER      Tensor types');
+    console.log('-'.repeat(72));
+    for (const r of rows) {
+        console.log(`${r.type.padEnd(6)} ${r.sizeMB.toFixed(0).padStart(9)}   ${r.rtf.toFixed(3).padEnd(8)} ` +
+                    `${(r.wer * 100).toFixed(1).padStart(5)}%   ${r.tensorTypes}`);
+    }
+    console.log('\nRTF = processing time / audio duration (lower is faster)');
+    if (!referencePath) console.log('WER is measured against the f16 transcript');
+}
+
+main().catch(err => {
+    console.error('❌ Benchmark failed:', err.message);
+    process.exit(1);
+});
@@ -0,0 +1,46 @@
+// Benchmark: decoding a short region of a long file (seek) vs decoding everything
+// Usage: node bench-range.js <media> [offsetSeconds] [durationSeconds]
+const fs = require('fs');
+
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const mediaPath = process.argv[2] || 'F:\\Downloads\\bench-long.mkv';
+const offsetSeconds = parseFloat(process.argv[3] || '5400');
+const durationSeconds = parseFloat(process.argv[4] || '30');
+
+if (!fs.existsSync(mediaPath)) {
+    console.log('⚠️  Media not found');
+    console.log('Usage: node bench-range.js <media> [offsetSeconds] [durationSeconds]');
+    process.exit(0);
+}
+
+console.log('\n⏱️  Range Decode Benchmark');
+console.log('='.repeat(72));
+console.log(`Media:  ${mediaPath}`);
+console.log(`Region: ${offsetSeconds}s + ${durationSeconds}s`);
+
+// 整个文件解码后再截取区间 (旧行为)
+const full = llwhisper.decodeAudio(mediaPath, {});
+const start = Math.round(offsetSeconds * full.sampleRate);
+const reference = full.samples.subarray(start, start + Math.round(durationSeconds * full.sampleRate));
+
+// seek 到区间只解码需要的样本
+const range = llwhisper.decodeAudio(mediaPath, {
+    offset_ms: Math.round(offsetSeconds * 1000),
+    duration_ms: Math.round(durationSeconds * 1000)
+});
+
+// 与整段解码的对应区间比较, 确认样本对齐
+let maxDiff = 0;
+const n = Math.min(reference.length, range.samples.length);
+for (let i = 0; i < n; i++) {
+    maxDiff = Math.max(maxDiff, Math.abs(reference[i] - range.samples[i]));
+}
+
+console.log('\n' + '='.repeat(72));
+console.log('Mode          Decode (ms)   Samples      PCM (MB)');
+console.log('-'.repeat(72));
+console.log(`full file     ${full.decodeMs.toFixed(0).padStart(11)}   ${String(full.samples.length).padEnd(12)} ${(full.samples.byteLength / 1048576).toFixed(1)}`);
+console.log(`range         ${range.decodeMs.toFixed(0).padStart(11)}   ${String(range.samples.length).padEnd(12)} ${(range.samples.byteLength / 1048576).toFixed(1)}`);
+console.log(`\nSpeedup: ${(full.decodeMs / range.decodeMs).toFixed(1)}x`);
+console.log(`Max sample difference vs full decode: ${maxDiff.toExponential(2)} (over ${n} samples)`);
@@ -0,0 +1,50 @@
+// Benchmark: time-to-first-segment with streaming decode vs decode-then-infer
+// Usage: node bench-stream.js <model> <media> [language] [chunkSeconds]
+const fs = require('fs');
+
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const modelPath = process.argv[2] || 'F:\\ollama\\model\\whisper-large-v3-gglm\\ggml-large-v3.bin';
+const mediaPath = process.argv[3] || 'F:\\Downloads\\bench-long.mkv';
+const language = process.argv[4] || 'auto';
+const chunkSeconds = parseInt(process.argv[5] || '30', 10);
+
+if (!fs.existsSync(modelPath) || !fs.existsSync(mediaPath)) {
+    console.log('⚠️  Model or media not found');
+    console.log('Usage: node bench-stream.js <model> <media> [language] [chunkSeconds]');
+    process.exit(0);
+}
+
+async function main() {
+    console.log('\n⏱️  Streaming Decode Benchmark');
+    console.log('='.repeat(72));
+    console.log(`Model: ${modelPath}`);
+    console.log(`Media: ${mediaPath}`);
+
+    llwhisper.loadModel(modelPath);
+
+    // 先解码后推理: 第一个片段在整个转录结束时才可用
+    let start = process.hrtime.bigint();
+    const serial = llwhisper.transcribe(mediaPath, { language, stream_decode: false });
+    const serialTotal = Number(process.hrtime.bigint() - start) / 1e6;
+
+    // 边解码边推理: 记录第一次回调的时间
+    let firstMs = -1;
+    start = process.hrtime.bigint();
+    const streamed = await llwhisper.transcribeStream(mediaPath, { language, chunk_seconds: chunkSeconds }, () => {
+        if (firstMs < 0) firstMs = Number(process.hrtime.bigint() - start) / 1e6;
+    });
+    const streamTotal = Number(process.hrtime.bigint() - start) / 1e6;
+
+    console.log('\n' + '='.repeat(72));
+    console.log('Mode             First segment (ms)   Total (ms)   Segments');
+    console.log('-'.repeat(72));
+    console.log(`decode → infer   ${serialTotal.toFixed(0).padStart(18)}   ${serialTotal.toFixed(0).padStart(10)}   ${serial.length}`);
+    console.log(`streaming        ${firstMs.toFixed(0).padStart(18)}   ${streamTotal.toFixed(0).padStart(10)}   ${streamed.length}`);
+    console.log(`\nChunk: ${chunkSeconds}s`);
+}
+
+main().catch(err => {
+    console.error('❌ Benchmark failed:', err);
+    process.exit(1);
+});
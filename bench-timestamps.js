@@ -0,0 +1,43 @@
+// Benchmark: cue formatting throughput on millions of cues (integer-millisecond timestamps)
+// Usage: node bench-timestamps.js [cueCount]
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const cueCount = parseInt(process.argv[2] || '2000000', 10);
+const formats = ['srt', 'vtt', 'json', 'lrc'];
+
+// 时间取 whisper 的厘秒精度再转成秒, 与真实转录的浮点误差一致
+const segments = new Array(cueCount);
+for (let i = 0; i < cueCount; i++) {
+    const t0 = i * 137;
+    segments[i] = { startTime: t0 / 100, endTime: (t0 + 99) / 100, text: 'cue' };
+}
+
+console.log('\n⏱️  Timestamp Formatting Benchmark');
+console.log('='.repeat(72));
+console.log(`Cues: ${cueCount}`);
+
+(async () => {
+    console.log('\n' + '='.repeat(72));
+    for (const format of formats) {
+        const t = process.hrtime.bigint();
+        const [result] = await llwhisper.exportAll(segments, { formats: [format] });
+        const ms = Number(process.hrtime.bigint() - t) / 1e6;
+        if (result.error) {
+            console.log(`${format.padEnd(5)} ❌ ${result.error}`);
+            continue;
+        }
+        const rate = cueCount / (ms / 1000) / 1e6;
+        console.log(`${format.padEnd(5)} ${ms.toFixed(1).padStart(9)} ms  ${rate.toFixed(2).padStart(6)} M cues/s  ` +
+                    `${(result.bytes / 1024 / 1024).toFixed(1)} MB`);
+    }
+
+    // 厘秒转秒再截断会少 1 毫秒 (例如 1.999999 -> 00:00:01,999), 四舍五入后应为整 10 毫秒
+    const [srt] = await llwhisper.exportAll(segments.slice(0, 10000), { formats: ['srt'] });
+    const stamps = srt.content.match(/\d\d:\d\d:\d\d,\d\d\d/g);
+    const exact = stamps.every(s => s.endsWith('0'));
+    console.log('-'.repeat(72));
+    console.log(`Centisecond times exact: ${exact ? '✅' : '❌'}`);
+})().catch(err => {
+    console.error('❌ Benchmark failed:', err.message);
+    process.exit(1);
+});
@@ -0,0 +1,71 @@
+// Benchmark: subtitle editor queries (visible range, time range, search, edit) on a large synthetic transcript
+// Usage: node bench-transcript-store.js [segments]
+const llwhisper = require('./build/bin/Release/llwhisper.node');
+
+const count = parseInt(process.argv[2] || '100000', 10);
+const FRAME_MS = 16;
+
+console.log('\n⏱️  Transcript Store Benchmark');
+console.log('='.repeat(72));
+console.log(`Segments: ${count}`);
+
+// 中日英混合的合成字幕 (固定种子, 每次结果一致)
+let seed = 1;
+const random = () => (seed = (seed * 1103515245 + 12345) & 0x7fffffff) / 0x7fffffff;
+const ja = ['今日は', 'いい天気', 'ですね', '字幕', '編集', '検索', 'テスト', '動画', '翻訳', 'ありがとう'];
+const zh = ['今天', '天气', '很好', '字幕', '编辑', '搜索', '测试', '视频', '翻译', '谢谢'];
+const en = ['the', 'quick', 'brown', 'fox', 'subtitle', 'editor', 'search', 'Index', 'virtual', 'list'];
+const pick = (words, n) => Array.from({ length: n }, () => words[Math.floor(random() * words.length)]);
+
+const segments = Array.from({ length: count }, (_, i) => ({
+    id: `seg_${i}`,
+    startTime: i * 2,
+    endTime: i * 2 + 1.8,
+    text: pick(ja, 6).join('') + ' ' + pick(en, 3).join(' '),
+    translatedText: pick(zh, 8).join(''),
+    speaker: i % 3 === 0 ? '说话人A' : undefined
+}));
+
+function time(fn, runs = 200) {
+    const samples = [];
+    let result;
+    for (let i = 0; i < runs; i++) {
+        const t0 = process.hrtime.bigint();
+        result = fn(i);
+        samples.push(Number(process.hrtime.bigint() - t0) / 1e6);
+    }
+    samples.sort((a, b) => a - b);
+    return { result, p50: samples[Math.floor(runs / 2)], p99: samples[Math.floor(runs * 0.99)] };
+}
+
+function report(label, { p50, p99 }, extra = '') {
+    const flag = p99 <= FRAME_MS ? '✓' : '✗';
+    console.log(`${label.padEnd(30)} p50 ${p50.toFixed(3).padStart(8)} ms  p99 ${p99.toFixed(3).padStart(8)} ms ${flag} ${extra}`);
+}
+
+const t0 = process.hrtime.bigint();
+const info = llwhisper.createTranscriptStore('bench', segments);
+console.log(`Build:    ${(Number(process.hrtime.bigint() - t0) / 1e6).toFixed(0)} ms (${info.count} segments, ${info.duration.toFixed(0)} s)`);
+console.log('-'.repeat(72));
+
+// 滚动: 每帧读取一屏 (约 40 行)
+report('range (40 rows, random)', time(() =>
+    llwhisper.getTranscriptRange('bench', Math.floor(random() * (count - 40)), 40)));
+report('range by time (60 s)', time(() => {
+    const start = random() * count * 2;
+    return llwhisper.getTranscriptRangeByTime('bench', start, start + 60);
+}));
+report('index at time', time(() => llwhisper.getTranscriptIndexAt('bench', random() * count * 2)));
+
+// 搜索: 稀有词、常见词、CJK 短语、大小写与全角
+for (const query of ['ありがとう', '天气很好', '字', 'fox', 'QUICK BROWN', 'ｓｕｂｔｉｔｌｅ', '不存在的词']) {
+    const r = time(() => llwhisper.searchTranscript('bench', query, 5000), 50);
+    report(`search "${query}"`, r, `(${r.result.total} hits)`);
+}
+
+// 编辑: 修改文本 (重建该行的索引) 与删除 (之后的行下标前移)
+report('update text', time(i => llwhisper.updateTranscriptSegment('bench', i * 97 % count, { text: `修改后的字幕 ${i}` })));
+report('remove', time(i => llwhisper.removeTranscriptSegment('bench', (i * 389) % (count - i))));
+
+llwhisper.releaseTranscriptStore('bench');
+console.log('='.repeat(72));
@@ -4,7 +4,10 @@
       "target_name": "llvideo",
       "sources": [
         "native/src/llvideo.cpp",
-        "native/src/ffmpeg_wrapper.cpp"
+        "native/src/ffmpeg_wrapper.cpp",
+        "native/src/waveform_index.cpp",
+        "native/src/ffmpeg_context_pool.cpp",
+        "native/src/ffmpeg_demux.cpp"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")",
@@ -51,7 +54,22 @@
       "target_name": "llwhisper",
       "sources": [
         "native/src/llwhisper.cpp",
-        "native/src/whisper_wrapper.cpp"
+        "native/src/whisper_wrapper.cpp",
+        "native/src/diarization.cpp",
+        "native/src/model_quantizer.cpp",
+        "native/src/transcript_checkpoint.cpp",
+        "native/src/subtitle_segmenter.cpp",
+        "native/src/audio_preprocess.cpp",
+        "native/src/pcm_ring_buffer.cpp",
+        "native/src/compute_backend.cpp",
+        "native/src/pcm_cache.cpp",
+        "native/src/transcript_text.cpp",
+        "native/src/memory_budget.cpp",
+        "native/src/audio_fingerprint.cpp",
+        "native/src/transcript_store.cpp",
+        "native/src/fft.cpp",
+        "native/src/ffmpeg_context_pool.cpp",
+        "native/src/ffmpeg_demux.cpp"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")",
@@ -79,6 +97,8 @@
         ["OS=='win'", {
           "libraries": [
             "../native/whisper.cpp/build/src/Release/whisper.lib",
+            "../native/whisper.cpp/build/ggml/src/Release/ggml.lib",
+            "../native/whisper.cpp/build/ggml/src/Release/ggml-base.lib",
             "../native/ffmpeg/lib/avcodec.lib",
             "../native/ffmpeg/lib/avformat.lib",
             "../native/ffmpeg/lib/avutil.lib",
@@ -0,0 +1,112 @@
+#ifndef AUDIO_FINGERPRINT_H
+#define AUDIO_FINGERPRINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "fft.h"
+#include "whisper_wrapper.h"
+
+namespace llwhisper {
+
+// 声学指纹 (Chromaprint / Philips 风格): 每 64ms 一个 32 位子指纹
+// 16kHz 输入先降采样到 8kHz, 2048 点 Hann 窗 (256ms) 的功率谱按 300-2000Hz 对数划分 33 个频带,
+// 第 m 位 = 相邻频带能量差在时间上的变化方向。只依赖能量的相对大小, 对重新编码、码率与音量变化稳健。
+// 静音帧输出 0, 不参与匹配。
+class AudioFingerprinter {
+public:
+    static constexpr double kHopSeconds = 0.064;
+
+    AudioFingerprinter();
+
+    // 处理 16kHz 单声道样本 (可分多次送入, 解码循环中逐块调用)
+    void process(const float* samples, size_t n);
+
+    const std::vector<uint32_t>& fingerprint() const { return values; }
+
+    // 一次性计算整段样本的指纹
+    static std::vector<uint32_t> compute(const float* samples, size_t n);
+
+private:
+    // 分析从 x 开始的两个相邻帧 (x 与 x + kHop)
+    void processFrames(const float* x);
+    void emitFrame(const float* energy, bool silent);
+
+    // 降采样: 低通 FIR 后隔点取样
+    std::vector<float> taps;
+    std::vector<float> input;       // 尚未用完的 16kHz 样本 (含 FIR 所需的历史)
+    size_t inputStart = 0;          // 下一个输出样本对应的第一个输入样本
+
+    // 8kHz 帧
+    Fft fft;
+    std::vector<float> window;
+    std::vector<float> decimated;   // 尚未用完的 8kHz 样本
+    size_t frameStart = 0;          // 下一帧在 decimated 中的起点
+    std::vector<float> re;
+    std::vector<float> im;
+    std::vector<int> bandEdges;     // 34 个边界 (FFT bin)
+    std::vector<float> previous;    // 上一帧的相邻频带能量差
+    bool hasPrevious = false;
+
+    std::vector<uint32_t> values;
+};
+
+// 指纹索引中找到的近似重复文件
+struct FingerprintMatch {
+    std::string path;               // 已转录的文件
+    double offsetSeconds = 0.0;     // 查询时间 + offsetSeconds = 该文件中的时间
+    double similarity = 0.0;        // 1 - 比特错误率
+    double coverage = 0.0;          // 对齐后能比较的非静音帧占查询的比例
+    std::vector<TranscriptSegment> segments;   // 已平移到查询时间轴并裁剪到查询时长 (decodeTimeMs 为 0)
+};
+
+// 已转录文件的指纹索引 (磁盘上为只追加的二进制文件, 每条记录含指纹与片段)
+// 内存中对抽样的子指纹建立倒排表 (按值排序的数组), 查找时按对齐偏移投票, 再用比特错误率验证候选。
+// 每条记录带有产生该转录的解码参数 key (模型、语言、翻译、提示等), 只复用 key 完全相同的记录。
+class FingerprintIndex {
+public:
+    // 读取索引; 文件不存在时为空索引, 末尾被截断的记录丢弃
+    // 旧版本 (记录不含解码 key, 无法判断能否复用) 视为空索引, 下次 add 时重写
+    bool load(const std::string& path, std::string& error);
+
+    // 追加一个已转录文件 (同一路径与 key 再次加入时替换旧记录); segments 的时间相对于指纹起点
+    bool add(const std::string& mediaPath, const std::string& decodeKey, const std::vector<uint32_t>& fingerprint,
+             const std::vector<TranscriptSegment>& segments, std::string& error);
+
+    // 查找近似重复: 只考虑 decodeKey 相同的记录, similarity 与 coverage 都达到阈值时返回 true
+    // durationSeconds 为查询音频时长, 复用的片段裁剪到该范围
+    bool lookup(const std::string& decodeKey, const std::vector<uint32_t>& fingerprint, double durationSeconds,
+                double minSimilarity, double minCoverage, FingerprintMatch& match) const;
+
+    size_t size() const { return entries.size(); }
+
+private:
+    struct Entry {
+        std::string path;
+        std::string decodeKey;
+        std::vector<uint32_t> fingerprint;
+        std::vector<TranscriptSegment> segments;
+        bool replaced = false;      // 已被同一路径与 key 的新记录替换
+    };
+
+    // 倒排表项: 子指纹的半字 (高 / 低 16 位, 最高位区分) -> (记录, 位置)
+    struct Posting {
+        uint32_t key;
+        uint32_t entry;
+        uint32_t position;
+    };
+
+    void indexEntry(uint32_t entry);
+
+    std::string filePath;
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, uint32_t> byPath;   // 路径 + '\n' + key -> 最新记录
+    bool rewrite = false;           // 旧版本文件, 下次 add 时截断重写
+    std::vector<Posting> postings;  // 按 key 排序
+};
+
+} // namespace llwhisper
+
+#endif // AUDIO_FINGERPRINT_H
@@ -0,0 +1,79 @@
+#ifndef AUDIO_PREPROCESS_H
+#define AUDIO_PREPROCESS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "fft.h"
+
+namespace llwhisper {
+
+// 送入 whisper 之前的预处理 (16kHz 单声道), 默认全部关闭
+struct PreprocessOptions {
+    bool highpass = false;              // 高通滤波, 去除低频隆隆声 / 直流
+    float highpassHz = 80.0f;
+    bool denoise = false;               // 谱减法降噪
+    float denoiseStrength = 1.5f;       // 过减系数
+    float denoiseFloor = 0.1f;          // 最小增益 (-20dB), 抑制音乐噪声
+    bool normalize = false;             // 响度归一化 (慢速 AGC + 峰值限制)
+    float targetDbfs = -23.0f;          // 语音段目标 RMS
+    float maxGainDb = 30.0f;            // 最大提升
+
+    bool enabled() const { return highpass || denoise || normalize; }
+
+    // 影响输出样本的全部参数 (检查点等缓存的 key 使用); 未启用的阶段不计入
+    std::string key() const;
+};
+
+// 流式预处理器: 以 256 样本为块处理, 所有缓冲在构造时分配, 处理过程不再分配内存。
+// 降噪使用 512 点 STFT (50% 重叠), 输出样本与输入逐一对齐 (内部延迟在输出端补偿)。
+class AudioPreprocessor {
+public:
+    explicit AudioPreprocessor(const PreprocessOptions& options);
+
+    // 处理 n 个输入样本, 把已完成的输出样本追加到 out
+    void process(const float* samples, size_t n, std::vector<float>& out);
+
+    // 输出剩余样本; 调用后 out 中的样本数与输入总数相同
+    void flush(std::vector<float>& out);
+
+private:
+    void processBlock();
+    void highpassBlock(float* block);
+    void denoiseBlock(float* block);
+    void normalizeBlock(float* block);
+    void emitBlock(std::vector<float>& out);
+
+    PreprocessOptions options;
+
+    // 输入块
+    std::vector<float> block;
+    size_t blockFill = 0;
+    size_t latency = 0;         // 尚未补偿的延迟样本数
+    size_t inputCount = 0;
+    size_t outputCount = 0;
+
+    // 高通 (RBJ biquad, 转置直接 II 型)
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    float z1 = 0.0f, z2 = 0.0f;
+
+    // 谱减法
+    Fft fft;
+    std::vector<float> window;      // sqrt-Hann, 分析与合成共用
+    std::vector<float> frame;       // 最近 512 个输入样本
+    std::vector<float> overlap;     // 重叠相加缓冲
+    std::vector<float> re;
+    std::vector<float> im;
+    std::vector<float> smoothed;    // 平滑后的功率谱
+    std::vector<float> noise;       // 噪声功率谱估计 (最小值跟踪)
+    std::vector<float> gain;
+    bool noiseInitialized = false;
+
+    // 响度归一化
+    float level = 0.0f;             // 语音段均方值的滑动估计
+    float currentGain = 1.0f;
+};
+
+} // namespace llwhisper
+
+#endif // AUDIO_PREPROCESS_H
@@ -0,0 +1,52 @@
+#ifndef COMPUTE_BACKEND_H
+#define COMPUTE_BACKEND_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace llwhisper {
+
+// 计算后端选项 (加载模型时生效)
+// backend:
+//   auto - whisper 默认行为: 有 GPU 用 GPU, 已注册的加速后端 (BLAS 等) 全部参与
+//   cpu  - 只用 ggml CPU 后端 (不能有已注册的加速后端)
+//   blas - CPU + BLAS 加速后端 (OpenBLAS / BLIS / MKL 等, 取决于 ggml-blas 的链接对象)
+//   gpu  - 必须使用 gpuDevice 指定的 GPU
+struct BackendOptions {
+    std::string backend = "auto";
+    bool flashAttn = false;                 // flash attention (CPU 与多数 GPU 后端均支持)
+    int gpuDevice = 0;                      // 第几个 GPU 设备
+    std::vector<std::string> libraries;     // 动态加载的 ggml 后端库 (ggml 以 GGML_BACKEND_DL 构建时)
+};
+
+// ggml 已注册的计算设备
+struct BackendDevice {
+    std::string name;
+    std::string description;
+    std::string type;                       // cpu / gpu / accel
+    std::string registry;                   // 所属后端 (CPU / BLAS / CUDA / Vulkan ...)
+    uint64_t memoryFree = 0;
+    uint64_t memoryTotal = 0;
+    bool active = false;                    // 按当前选项 whisper 会使用该设备
+};
+
+struct BackendInfo {
+    BackendOptions options;                 // 当前模型加载时使用的选项
+    std::vector<std::string> registries;    // 已注册的后端
+    std::vector<BackendDevice> devices;
+    std::string systemInfo;                 // whisper_print_system_info (编译时的 SIMD / BLAS 特性)
+};
+
+// 加载 options.libraries, 并检查 options.backend 在当前构建 / 主机上是否可用
+bool prepareBackend(const BackendOptions& options, std::string& error);
+
+// whisper 是否应当尝试 GPU (whisper_context_params.use_gpu)
+bool backendUsesGpu(const BackendOptions& options);
+
+// 枚举已注册的后端与设备, 按 whisper 选择设备的规则标出 options 下参与计算的设备
+BackendInfo queryBackends(const BackendOptions& options);
+
+} // namespace llwhisper
+
+#endif // COMPUTE_BACKEND_H
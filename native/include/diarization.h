@@ -0,0 +1,42 @@
+#ifndef DIARIZATION_H
+#define DIARIZATION_H
+
+#include <cstddef>
+#include <vector>
+#include "whisper_wrapper.h"
+
+namespace llwhisper {
+
+// 说话人分离参数
+struct DiarizationOptions {
+    int maxSpeakers = 0;            // 最大说话人数 (0=按阈值自动确定)
+    float threshold = 0.9f;         // 聚类合并的余弦距离阈值 (嵌入已做全局标准化)
+    int maxClusters = 32;           // 增量聚类时同时保留的簇数上限 (决定距离矩阵大小)
+};
+
+// 连续的同一说话人区间
+struct SpeakerTurn {
+    double startTime;
+    double endTime;
+    int speaker;
+};
+
+// 基于 log-mel 统计量的说话人分离
+// 只依赖 PCM, 可与 whisper_full 并行运行
+class Diarizer {
+public:
+    explicit Diarizer(const DiarizationOptions& options);
+
+    // pcmf32 为 16kHz 单声道, 返回按时间排序的说话人区间 (说话人编号按首次出现顺序从 0 开始)
+    std::vector<SpeakerTurn> analyze(const float* pcmf32, size_t n_samples) const;
+
+private:
+    DiarizationOptions options;
+};
+
+// 按重叠时长为每个片段选出说话人, 无重叠时保持 speaker = -1
+void assignSpeakers(std::vector<TranscriptSegment>& segments, const std::vector<SpeakerTurn>& turns);
+
+} // namespace llwhisper
+
+#endif // DIARIZATION_H
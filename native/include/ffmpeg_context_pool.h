@@ -0,0 +1,191 @@
+#ifndef FFMPEG_CONTEXT_POOL_H
+#define FFMPEG_CONTEXT_POOL_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libswresample/swresample.h>
+}
+
+namespace llvideo {
+
+// ============================================================================
+// RAII 封装 (替代 goto cleanup)
+// ============================================================================
+struct InputFormatDeleter {
+    void operator()(AVFormatContext* ctx) const { avformat_close_input(&ctx); }
+};
+
+struct OutputFormatDeleter {
+    void operator()(AVFormatContext* ctx) const {
+        if (ctx->oformat && !(ctx->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&ctx->pb);
+        }
+        avformat_free_context(ctx);
+    }
+};
+
+struct CodecContextDeleter {
+    void operator()(AVCodecContext* ctx) const { avcodec_free_context(&ctx); }
+};
+
+struct SwrContextDeleter {
+    void operator()(SwrContext* ctx) const { swr_free(&ctx); }
+};
+
+struct PacketDeleter {
+    void operator()(AVPacket* pkt) const { av_packet_free(&pkt); }
+};
+
+struct FrameDeleter {
+    void operator()(AVFrame* frame) const { av_frame_free(&frame); }
+};
+
+using InputFormatPtr  = std::unique_ptr<AVFormatContext, InputFormatDeleter>;
+using OutputFormatPtr = std::unique_ptr<AVFormatContext, OutputFormatDeleter>;
+using CodecContextPtr = std::unique_ptr<AVCodecContext, CodecContextDeleter>;
+using SwrContextPtr   = std::unique_ptr<SwrContext, SwrContextDeleter>;
+using PacketPtr       = std::unique_ptr<AVPacket, PacketDeleter>;
+using FramePtr        = std::unique_ptr<AVFrame, FrameDeleter>;
+
+// 打开输入文件, 失败时返回空指针并写入 errorCode
+InputFormatPtr openInput(const std::string& path, AVDictionary** options = nullptr, int* errorCode = nullptr);
+
+// FFmpeg 错误码转字符串
+std::string ffmpegErrorString(int errorCode);
+
+// send_packet / receive_frame 的返回值是否为真正的解码错误 (EAGAIN / EOF 不算)
+inline bool isDecodeError(int ret) {
+    return ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF;
+}
+
+class ContextPool;
+
+// 从池中借出的解码器, 析构时自动归还
+class PooledDecoder {
+public:
+    PooledDecoder() = default;
+    PooledDecoder(ContextPool* pool, uint64_t key, AVCodecContext* ctx);
+    PooledDecoder(PooledDecoder&& other) noexcept;
+    PooledDecoder& operator=(PooledDecoder&& other) noexcept;
+    PooledDecoder(const PooledDecoder&) = delete;
+    PooledDecoder& operator=(const PooledDecoder&) = delete;
+    ~PooledDecoder();
+
+    AVCodecContext* get() const { return ctx; }
+    AVCodecContext* operator->() const { return ctx; }
+    explicit operator bool() const { return ctx != nullptr; }
+
+    // 出错返回前调用, 上下文不再回池而是直接释放 (可能处于错误状态)
+    void discard();
+
+private:
+    void release();
+
+    ContextPool* pool = nullptr;
+    uint64_t key = 0;
+    AVCodecContext* ctx = nullptr;
+};
+
+// 从池中借出的重采样器, 析构时自动归还
+class PooledResampler {
+public:
+    PooledResampler() = default;
+    PooledResampler(ContextPool* pool, uint64_t key, SwrContext* ctx);
+    PooledResampler(PooledResampler&& other) noexcept;
+    PooledResampler& operator=(PooledResampler&& other) noexcept;
+    PooledResampler(const PooledResampler&) = delete;
+    PooledResampler& operator=(const PooledResampler&) = delete;
+    ~PooledResampler();
+
+    SwrContext* get() const { return ctx; }
+    explicit operator bool() const { return ctx != nullptr; }
+
+    void discard();
+
+private:
+    void release();
+
+    ContextPool* pool = nullptr;
+    uint64_t key = 0;
+    SwrContext* ctx = nullptr;
+};
+
+// 池统计信息
+struct ContextPoolStats {
+    uint64_t decoderHits = 0;
+    uint64_t decoderMisses = 0;
+    uint64_t resamplerHits = 0;
+    uint64_t resamplerMisses = 0;
+    uint64_t packetHits = 0;
+    uint64_t frameHits = 0;
+    size_t idleDecoders = 0;
+    size_t idleResamplers = 0;
+    bool enabled = true;
+};
+
+// 解码器 / 重采样器 / AVPacket / AVFrame 复用池
+// 解码器按编解码参数 (codec id, 采样率, 声道布局, 采样格式, extradata) 分组,
+// 重采样器按输入输出配置分组。处理大量短片段时可省去反复 open/init 的开销。
+class ContextPool {
+public:
+    static ContextPool& instance();
+
+    // 借出与 codecpar 匹配的已打开解码器, 失败返回空句柄
+    PooledDecoder acquireDecoder(const AVCodecParameters* codecpar, int* errorCode = nullptr);
+
+    // 借出已初始化的重采样器, 失败返回空句柄
+    PooledResampler acquireResampler(const AVChannelLayout* inLayout, AVSampleFormat inFormat, int inRate,
+                                     const AVChannelLayout* outLayout, AVSampleFormat outFormat, int outRate);
+
+    PacketPtr acquirePacket();
+    void releasePacket(PacketPtr packet);
+
+    FramePtr acquireFrame();
+    void releaseFrame(FramePtr frame);
+
+    // 禁用后每次都重新创建 (用于基准对比)
+    void setEnabled(bool value);
+    bool isEnabled() const;
+
+    // 释放所有空闲对象
+    void clear();
+
+    ContextPoolStats getStats() const;
+
+private:
+    friend class PooledDecoder;
+    friend class PooledResampler;
+
+    ContextPool() = default;
+    ~ContextPool();
+    ContextPool(const ContextPool&) = delete;
+    ContextPool& operator=(const ContextPool&) = delete;
+
+    void releaseDecoder(uint64_t key, AVCodecContext* ctx);
+    void releaseResampler(uint64_t key, SwrContext* ctx);
+
+    // 每个 key 最多保留的空闲对象数量
+    static constexpr size_t kMaxIdlePerKey = 4;
+    static constexpr size_t kMaxIdlePackets = 16;
+
+    mutable std::mutex mutex;
+    bool enabled = true;
+    std::unordered_map<uint64_t, std::vector<AVCodecContext*>> idleDecoders;
+    std::unordered_map<uint64_t, std::vector<SwrContext*>> idleResamplers;
+    std::vector<PacketPtr> idlePackets;
+    std::vector<FramePtr> idleFrames;
+    ContextPoolStats stats;
+};
+
+} // namespace llvideo
+
+#endif // FFMPEG_CONTEXT_POOL_H
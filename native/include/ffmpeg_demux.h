@@ -0,0 +1,45 @@
+#ifndef FFMPEG_DEMUX_H
+#define FFMPEG_DEMUX_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace llvideo {
+
+// 单个被解码的音频流
+// onOpen 在调用线程中依次调用 (解码线程启动之前); onFrame / onFinish 在该流自己的解码线程中调用,
+// 不同流之间互不共享数据即可无锁处理
+struct DemuxTrack {
+    int streamIndex = -1;
+
+    // 解码器打开后在调用线程中调用 (可在此根据解码器参数创建重采样器 / 编码器)
+    std::function<bool(AVCodecContext* decoder)> onOpen;
+
+    // 每个解码出的帧
+    std::function<bool(AVFrame* frame)> onFrame;
+
+    // 解码器 flush 完毕后调用
+    std::function<bool()> onFinish;
+
+    // 输出: 该流是否成功处理
+    bool ok = true;
+    std::string error;
+};
+
+// 对 formatCtx 只做一次 av_read_frame 遍历, 把各音频流的包分发到各自的
+// 解码线程并行解码。formatCtx 需已完成 avformat_find_stream_info。
+// 仅当 demux 本身失败时返回 false, 单个流的失败记录在 DemuxTrack::ok / error 中。
+bool demuxAudioTracks(AVFormatContext* formatCtx, std::vector<DemuxTrack>& tracks, std::string& error);
+
+// 返回文件中所有音频流的索引
+std::vector<int> findAudioStreams(AVFormatContext* formatCtx);
+
+} // namespace llvideo
+
+#endif // FFMPEG_DEMUX_H
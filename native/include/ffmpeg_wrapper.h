@@ -3,6 +3,10 @@
 
 #include <string>
 #include <functional>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
 
 namespace llvideo {
 
@@ -17,6 +21,17 @@ struct AudioExtractionOptions {
     double duration = 0.0;            // 持续时间 (0=全部)
 };
 
+// 音频流信息
+struct AudioStreamInfo {
+    int index = -1;              // 流索引
+    std::string codec;           // 音频编码
+    std::string language;        // 语言标签 (容器元数据, 如 jpn / eng)
+    std::string title;           // 标题
+    int sampleRate = 0;          // 采样率
+    int channels = 0;            // 声道数
+    bool isDefault = false;      // 是否为默认音轨
+};
+
 // 视频信息
 struct VideoInfo {
     std::string format;          // 容器格式
@@ -31,6 +46,55 @@ struct VideoInfo {
     int64_t bitrate = 0;         // 比特率
     bool hasAudio = false;       // 是否有音频流
     bool hasVideo = false;       // 是否有视频流
+    std::vector<AudioStreamInfo> audioStreams;  // 所有音频流
+};
+
+// 单个音轨的提取结果
+struct AudioTrackResult {
+    int streamIndex = -1;
+    std::string language;
+    std::string outputPath;
+    bool ok = false;
+    std::string error;
+};
+
+// 探测模式
+enum class ProbeMode {
+    Header,   // 仅解析容器头 (不解码帧), 适合大规模媒体库扫描
+    Full      // 调用 avformat_find_stream_info 完整探测
+};
+
+// 批量探测选项
+struct ProbeOptions {
+    ProbeMode mode = ProbeMode::Header;
+    int64_t probeSize = 256 * 1024;           // 头部探测的最大字节数
+    int64_t analyzeDuration = 500000;         // 头部信息不足时的最大分析时长 (微秒)
+    int threads = 0;                          // 线程数 (0=硬件线程数)
+    bool useCache = true;                     // 按 路径+修改时间+大小 缓存结果
+};
+
+// 单个文件的探测结果
+struct ProbeResult {
+    std::string path;
+    bool ok = false;             // 是否为有效的媒体文件
+    bool cached = false;         // 是否命中缓存
+    std::string error;           // 失败原因
+    VideoInfo info;
+};
+
+// 字幕条目
+struct SubtitleCue {
+    double startTime = 0.0;      // 开始时间 (秒)
+    double endTime = 0.0;        // 结束时间 (秒)
+    std::string text;            // 文本 (可包含换行)
+};
+
+// 字幕封装选项
+struct SubtitleMuxOptions {
+    std::string codec;           // 字幕编码 (mov_text, srt, ass, webvtt; 空=按输出容器自动选择)
+    std::string language;        // 语言标签 (如 chi / jpn / eng)
+    std::string title;           // 字幕轨标题
+    bool setDefault = false;     // 设为默认字幕轨
 };
 
 // 进度回调函数类型
@@ -47,8 +111,30 @@ public:
                      const AudioExtractionOptions& options,
                      ProgressCallback callback = nullptr);
 
+    // 单次 demux 提取多条音轨 (streams 为空表示全部音轨)
+    // outputPattern 中的 {stream} / {lang} 会被替换为流索引 / 语言标签
+    std::vector<AudioTrackResult> extractAudioTracks(const std::string& inputPath,
+                                                     const std::string& outputPattern,
+                                                     const std::vector<int>& streams,
+                                                     const AudioExtractionOptions& options);
+
+    // 直接复制音视频流并添加字幕轨 (不重新编码)
+    bool muxSubtitles(const std::string& videoPath,
+                      const std::vector<SubtitleCue>& cues,
+                      const std::string& outputPath,
+                      const SubtitleMuxOptions& options,
+                      ProgressCallback callback = nullptr);
+
     // 获取视频信息
     VideoInfo getVideoInfo(const std::string& inputPath);
+    VideoInfo getVideoInfo(const std::string& inputPath, ProbeMode mode);
+
+    // 批量探测 (线程池并行, 可缓存)
+    std::vector<ProbeResult> probeBatch(const std::vector<std::string>& paths,
+                                        const ProbeOptions& options);
+
+    // 清空探测缓存
+    void clearProbeCache();
 
     // 获取最后的错误信息
     std::string getLastError() const;
@@ -57,7 +143,18 @@ public:
     bool isValidMediaFile(const std::string& inputPath);
 
 private:
+    // 探测缓存条目
+    struct ProbeCacheEntry {
+        int64_t mtime = 0;
+        uintmax_t size = 0;
+        ProbeMode mode = ProbeMode::Header;
+        VideoInfo info;
+    };
+
     std::string lastError;
+    std::mutex probeCacheMutex;
+    std::unordered_map<std::string, ProbeCacheEntry> probeCache;
+
     void setError(const std::string& error);
     void init();
     void cleanup();
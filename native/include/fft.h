@@ -0,0 +1,30 @@
+#ifndef LLWHISPER_FFT_H
+#define LLWHISPER_FFT_H
+
+#include <vector>
+
+namespace llwhisper {
+
+// 基 2 迭代 FFT (原位), 实部 / 虚部分开存放以便编译器向量化相邻循环
+// 旋转因子与位反转表在构造时生成, 变换过程不分配内存
+class Fft {
+public:
+    explicit Fft(int size);
+
+    int size() const { return n; }
+
+    void forward(float* re, float* im) const;
+
+    // 逆变换, 结果已除以 N
+    void inverse(float* re, float* im) const;
+
+private:
+    int n;
+    std::vector<float> cosTable;
+    std::vector<float> sinTable;
+    std::vector<int> bitrev;
+};
+
+} // namespace llwhisper
+
+#endif // LLWHISPER_FFT_H
@@ -0,0 +1,113 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace llwhisper {
+
+// 按类别统计的内存 (字节, 估算值)
+struct MemoryUsage {
+    uint64_t model = 0;                    // 模型权重
+    uint64_t state = 0;                    // whisper_state: KV 缓存 + 计算缓冲
+    uint64_t pcm = 0;                      // 解码后的 PCM (整段 / 环形缓冲)
+    uint64_t output = 0;                   // 片段与导出结果
+
+    uint64_t total() const { return model + state + pcm + output; }
+    MemoryUsage& operator+=(const MemoryUsage& other);
+};
+
+struct JobMemory {
+    uint64_t id = 0;
+    std::string name;                      // 作业类型与文件 (transcribe: a.mp4)
+    MemoryUsage usage;
+};
+
+struct MemoryStats {
+    uint64_t limit = 0;                    // 预算 (0 = 不限制)
+    MemoryUsage resident;                  // 常驻: 已加载模型的权重与默认 state
+    MemoryUsage jobs;                      // 运行中作业的合计
+    uint64_t total = 0;                    // resident + jobs
+    uint64_t peak = 0;                     // 历史最高 total
+    int queued = 0;                        // 正在等待预算的作业数
+    uint64_t chunked = 0;                  // 因预算改为分块 (流式) 处理的作业数
+    uint64_t rejected = 0;                 // 因预算被拒绝的作业数
+    std::vector<JobMemory> active;
+};
+
+// 进程内的内存预算
+// 模型等常驻内存用 setResident 登记; 每个作业开始前用 reserve 申请估算用量:
+// 能放下就立即运行, 需要等其它作业释放时排队, 单独运行也放不下时拒绝 (调用方可先尝试分块)。
+class MemoryBudget {
+public:
+    // 作业持有的预算, 析构时归还
+    class Reservation {
+    public:
+        Reservation() = default;
+        ~Reservation() { release(); }
+        Reservation(Reservation&& other) noexcept;
+        Reservation& operator=(Reservation&& other) noexcept;
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+
+        // 按实际用量修正 (不等待, 可能暂时超出预算)
+        void update(const MemoryUsage& usage);
+        void release();
+        bool valid() const { return owner != nullptr; }
+
+    private:
+        friend class MemoryBudget;
+        MemoryBudget* owner = nullptr;
+        uint64_t id = 0;
+    };
+
+    // limit 为 0 表示不限制; queueTimeoutMs 为排队等待上限 (0 = 一直等待)
+    void setLimit(uint64_t limit, uint64_t queueTimeoutMs);
+    uint64_t limit() const;
+
+    // 登记常驻内存 (key: model / draft), usage 全为 0 表示移除
+    void setResident(const std::string& key, const MemoryUsage& usage);
+
+    // usage 在没有其它作业时能否放下
+    bool fitsAlone(const MemoryUsage& usage) const;
+
+    // 申请预算, 必要时排队; 单独运行也放不下或等待超时时返回 false 并填写 error
+    bool reserve(const std::string& job, const MemoryUsage& usage, Reservation& reservation, std::string& error);
+
+    // 不等待: 当前放得下时才申请
+    bool tryReserve(const std::string& job, const MemoryUsage& usage, Reservation& reservation);
+
+    void countChunked();
+    void countRejected();
+
+    MemoryStats stats() const;
+
+private:
+    uint64_t usedLocked() const;
+    void grant(const std::string& job, const MemoryUsage& usage, Reservation& reservation);
+    void updateJob(uint64_t id, const MemoryUsage& usage);
+    void releaseJob(uint64_t id);
+
+    mutable std::mutex mutex;
+    std::condition_variable released;
+    uint64_t limitBytes = 0;
+    uint64_t queueTimeoutMs = 0;
+    std::map<std::string, MemoryUsage> resident;
+    std::map<uint64_t, JobMemory> jobs;
+    uint64_t nextId = 1;
+    uint64_t peak = 0;
+    int queued = 0;
+    uint64_t chunked = 0;
+    uint64_t rejected = 0;
+};
+
+// 以 MB 显示的字节数 (错误信息用)
+std::string formatMegabytes(uint64_t bytes);
+
+} // namespace llwhisper
+
+#endif // MEMORY_BUDGET_H
@@ -0,0 +1,49 @@
+#ifndef MODEL_QUANTIZER_H
+#define MODEL_QUANTIZER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace llwhisper {
+
+// 某一种张量类型的统计
+struct TensorTypeStats {
+    std::string type;                       // ggml 类型名 (f32 / f16 / q8_0 ...)
+    int tensors = 0;
+    uint64_t elements = 0;
+    uint64_t bytes = 0;
+};
+
+// GGML whisper 模型文件信息 (只读取头部和张量表, 跳过张量数据)
+struct ModelInfo {
+    std::string path;
+    int ftype = 0;                          // 去掉量化版本号后的 ftype
+    int qntVersion = 0;                     // 量化格式版本 (未量化为 0)
+    int nVocab = 0;
+    int nAudioState = 0;
+    int nAudioLayer = 0;
+    int nTextState = 0;
+    int nTextLayer = 0;
+    int nMels = 0;
+    uint64_t tensorBytes = 0;               // 所有张量数据的总字节数
+    std::vector<TensorTypeStats> tensorTypes;
+};
+
+// 量化进度 (0.0 - 1.0)
+using QuantizeProgressCallback = std::function<void(float progress)>;
+
+// 读取模型文件头和张量类型分布
+bool inspectModel(const std::string& path, ModelInfo& info, std::string& error);
+
+// 将 f32/f16 模型量化为 type (q8_0 / q5_1 / q5_0 / q4_1 / q4_0)
+// 与 whisper.cpp 的 quantize 工具一致: 只量化二维权重, 卷积偏置和位置编码保持原类型
+// 先写入 dstPath.tmp, 成功后再替换 dstPath; 失败时删除临时文件
+bool quantizeModel(const std::string& srcPath, const std::string& dstPath, const std::string& type,
+                   int nThreads, ModelInfo* dstInfo, std::string& error,
+                   QuantizeProgressCallback progress = nullptr);
+
+} // namespace llwhisper
+
+#endif // MODEL_QUANTIZER_H
@@ -0,0 +1,49 @@
+#ifndef PCM_CACHE_H
+#define PCM_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace llwhisper {
+
+// 解码后 PCM 的 sidecar 缓存 (16kHz 单声道 float, 未预处理)
+// 文件 = 64 字节头 + 连续的 float 样本, 打开时整体内存映射, 样本指针直接交给 whisper_full。
+// 头中记录源文件的大小与修改时间, 源文件变化后缓存自动失效。
+class PcmCache {
+public:
+    ~PcmCache();
+
+    PcmCache(const PcmCache&) = delete;
+    PcmCache& operator=(const PcmCache&) = delete;
+
+    // 映射缓存; 不存在、格式错误或与源文件不匹配时返回 nullptr
+    static std::unique_ptr<PcmCache> open(const std::string& cachePath, const std::string& mediaPath);
+
+    // 写入缓存 (先写临时文件再替换)
+    static bool write(const std::string& cachePath, const std::string& mediaPath,
+                      const float* samples, size_t count, std::string& error);
+
+    // 缓存文件路径: cacheDir 为空时放在媒体文件旁 (media.llpcm), 否则以路径哈希命名放入 cacheDir
+    static std::string cachePath(const std::string& mediaPath, const std::string& cacheDir);
+
+    const float* samples() const { return data; }
+    size_t sampleCount() const { return count; }
+
+private:
+    PcmCache() = default;
+
+    void* mapping = nullptr;        // 映射起点 (含文件头)
+    size_t mappedBytes = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+    const float* data = nullptr;
+    size_t count = 0;
+};
+
+} // namespace llwhisper
+
+#endif // PCM_CACHE_H
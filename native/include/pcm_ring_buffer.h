@@ -0,0 +1,54 @@
+#ifndef PCM_RING_BUFFER_H
+#define PCM_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace llwhisper {
+
+// 单生产者 / 单消费者的无锁 float 环形缓冲
+// 解码线程写入 PCM, 推理线程按块读取; 读写位置为单调递增的样本计数, 只用原子变量同步。
+// 等待 (缓冲满 / 数据不足) 采用自旋后短暂休眠, 不使用互斥锁。
+class PcmRingBuffer {
+public:
+    explicit PcmRingBuffer(size_t capacity);
+
+    size_t capacity() const { return buffer.size(); }
+
+    // ---- 生产者 ----
+    // 写入全部样本, 缓冲满时等待; 消费者已取消时返回 false
+    bool write(const float* samples, size_t n);
+
+    // 数据写入完毕 (EOF 或解码失败)
+    void close();
+
+    // ---- 消费者 ----
+    // 等待至少 n 个样本可读或生产者已关闭; 返回当前可读样本数
+    size_t waitFor(size_t n) const;
+
+    size_t available() const;
+
+    // 生产者已关闭 (之后 available() 不再增加)
+    bool closed() const { return isClosed.load(std::memory_order_acquire); }
+
+    // 复制前 n 个可读样本但不移动读位置 (n 不能超过 available())
+    void peek(float* dst, size_t n) const;
+
+    // 丢弃前 n 个可读样本, 释放空间给生产者
+    void consume(size_t n);
+
+    // 消费者放弃读取, 阻塞中的生产者立即返回
+    void cancel();
+
+private:
+    std::vector<float> buffer;
+    alignas(64) std::atomic<size_t> writePos{0};
+    alignas(64) std::atomic<size_t> readPos{0};
+    std::atomic<bool> isClosed{false};
+    std::atomic<bool> isCancelled{false};
+};
+
+} // namespace llwhisper
+
+#endif // PCM_RING_BUFFER_H
@@ -0,0 +1,32 @@
+#ifndef SUBTITLE_SEGMENTER_H
+#define SUBTITLE_SEGMENTER_H
+
+#include <vector>
+#include "whisper_wrapper.h"
+
+namespace llwhisper {
+
+// 字幕重新分段选项
+// 拉丁文字与 CJK 文字分别设置每行字数和阅读速度, 混排时按比例累计
+struct SegmentationOptions {
+    int maxCharsPerLine = 42;          // 每行最多字符数 (拉丁文字)
+    int maxCjkCharsPerLine = 16;       // 每行最多字符数 (中日韩文字)
+    int maxLines = 2;                  // 每条字幕最多行数
+    double minDuration = 1.0;          // 最短显示时长 (秒)
+    double maxDuration = 7.0;          // 最长显示时长 (秒)
+    double maxCharsPerSecond = 17.0;   // 阅读速度上限 (拉丁文字)
+    double maxCjkCharsPerSecond = 7.0; // 阅读速度上限 (中日韩文字)
+    double minGap = 0.0;               // 相邻字幕之间的最小间隔 (秒)
+    double pauseThreshold = 1.0;       // 停顿超过该值时强制断开 (秒)
+};
+
+// 按行宽 / 行数 / 时长重新切分与合并片段, 行内以 '\n' 换行
+// 阅读速度只用于在不侵占下一条字幕的前提下延长显示时间, 不触发切分 (语速过快时仍可能超出上限)
+// 切分点优先选择句末标点、逗号、原片段边界; 不会跨越说话人切换。
+// 时间复杂度与输入片段的字符总数成线性关系。
+std::vector<TranscriptSegment> resegment(const std::vector<TranscriptSegment>& segments,
+                                         const SegmentationOptions& options);
+
+} // namespace llwhisper
+
+#endif // SUBTITLE_SEGMENTER_H
@@ -0,0 +1,47 @@
+#ifndef TRANSCRIPT_CHECKPOINT_H
+#define TRANSCRIPT_CHECKPOINT_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "whisper_wrapper.h"
+
+namespace llwhisper {
+
+// 检查点中恢复出的转录进度
+struct CheckpointData {
+    std::vector<TranscriptSegment> segments;   // 已完成的片段 (含解码统计量与说话人)
+    int offsetMs = 0;                          // 已完成到的音频位置
+    std::vector<int32_t> promptTokens;         // 最近片段的 token, 恢复时作为 prompt
+    bool complete = false;                     // 转录已全部完成
+    uint64_t validBytes = 0;                   // 最后一条完整提交记录的结束位置, 续写前截断到这里
+};
+
+// 转录检查点 sidecar 文件
+// 只追加写入: 每个解码窗口结束后追加新片段, 再写入偏移与 prompt 作为提交记录。
+// 进程在写入中途崩溃时, 读取端会丢弃最后一条提交记录之后的内容, 续写时先把这部分截掉。
+class TranscriptCheckpoint {
+public:
+    // 读取检查点; 文件不存在、格式错误或 key 不匹配 (音频 / 参数已变化) 时返回 false
+    static bool load(const std::string& path, const std::string& key, CheckpointData& data);
+
+    // 打开检查点文件; resumed 为 load 读出的进度时截断到 validBytes 后续写, 为空时重新创建
+    bool open(const std::string& path, const std::string& key, const CheckpointData* resumed = nullptr);
+
+    // 追加已完成的片段并提交进度
+    void commit(const std::vector<TranscriptSegment>& segments, int offsetMs,
+                const std::vector<int32_t>& promptTokens);
+
+    // 标记转录完成
+    void markComplete();
+
+    bool isOpen() const { return out.is_open(); }
+
+private:
+    std::ofstream out;
+};
+
+} // namespace llwhisper
+
+#endif // TRANSCRIPT_CHECKPOINT_H
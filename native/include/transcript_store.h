@@ -0,0 +1,82 @@
+#ifndef TRANSCRIPT_STORE_H
+#define TRANSCRIPT_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace llwhisper {
+
+// 字幕编辑器中的一行 (时间 + 原文 + 译文 + 说话人)
+struct StoredSegment {
+    std::string id;                        // 界面使用的片段 ID
+    double startTime = 0.0;
+    double endTime = 0.0;
+    std::string text;
+    std::string translatedText;
+    std::string speaker;
+};
+
+// 字幕编辑器的片段存储: 界面只按下标 / 时间取可见的行, 搜索在本地索引上完成
+// 片段按开始时间排序; 原文与译文按码点二元组 (bigram) 建立倒排表, 中日韩文本不需要分词。
+// 搜索时先对查询的全部二元组求交集, 再在规范化文本 (ASCII / 全角英数字转小写半角) 上确认子串。
+// 存储按 key 保存在进程内 (同一 key 再次创建时替换), 所有方法可在任意线程调用。
+class TranscriptStore {
+public:
+    static std::shared_ptr<TranscriptStore> create(const std::string& key, std::vector<StoredSegment> segments);
+    static std::shared_ptr<TranscriptStore> get(const std::string& key);
+    static bool release(const std::string& key);
+
+    size_t size() const;
+    double duration() const;
+
+    // 下标 [start, start + count) 的片段 (超出范围的部分忽略)
+    std::vector<StoredSegment> range(size_t start, size_t count) const;
+
+    // 从第一个与 [startTime, endTime) 相交的片段到最后一个开始于 endTime 之前的片段, first 为第一个片段的下标
+    // 下标连续: 夹在中间、已在 startTime 前结束的短片段 (被更早的长片段覆盖时) 也包含在内
+    std::vector<StoredSegment> rangeByTime(double startTime, double endTime, size_t& first) const;
+
+    // 包含 / 之后最近的片段下标 (time 之后没有片段时为 size())
+    size_t indexAt(double time) const;
+
+    // 原文或译文包含 query 的片段下标 (升序, 最多 limit 个); total 为全部匹配数
+    std::vector<uint32_t> search(const std::string& query, size_t limit, size_t& total) const;
+
+    // 替换下标 index 的片段 (开始时间变化时移动到排序后的位置), 返回新下标; 越界时返回 false
+    bool update(size_t index, const StoredSegment& segment, size_t& newIndex);
+
+    // 在同一次加锁中读取、修改并写回下标 index 的片段 (edit 在锁内调用, 不能再访问本存储)
+    bool update(size_t index, const std::function<void(StoredSegment&)>& edit, size_t& newIndex);
+
+    bool remove(size_t index);
+
+private:
+    // 片段存放在固定的槽中, 删除只影响 order, 倒排表按槽号记录
+    struct Slot {
+        StoredSegment segment;
+        std::string normalized;            // 规范化的原文 + '\n' + 译文, 用于确认匹配
+    };
+
+    void indexSlot(uint32_t slot);
+    void unindexSlot(uint32_t slot);
+    void renumber(size_t from);
+    size_t sortedPosition(double startTime) const;
+    void replace(size_t index, const StoredSegment& segment, size_t& newIndex);   // 调用方持有 mutex
+
+    mutable std::mutex mutex;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> order;           // 下标 -> 槽
+    std::vector<uint32_t> position;        // 槽 -> 下标
+    std::vector<double> maxEnd;            // 下标 -> 下标 0..i 的最大结束时间 (前缀最大值, 单调不减)
+    std::unordered_map<uint64_t, std::vector<uint32_t>> postings;   // 二元组 -> 升序的槽号
+};
+
+} // namespace llwhisper
+
+#endif // TRANSCRIPT_STORE_H
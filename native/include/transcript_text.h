@@ -0,0 +1,42 @@
+#ifndef TRANSCRIPT_TEXT_H
+#define TRANSCRIPT_TEXT_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace llwhisper {
+
+// 秒 -> 整数毫秒 (四舍五入)
+// whisper 的时间戳是整数厘秒, 除以 100 后再乘 1000 会带浮点误差, 截断会少 1 毫秒 (1.999999 -> 1999)
+inline int64_t secondsToMs(double seconds) {
+    return static_cast<int64_t>(std::llround(seconds * 1000.0));
+}
+
+// 以下写入函数都不分配内存、不写 '\0', 返回写入的字节数; out 至少需要 kMaxTimestampChars 字节
+const size_t kMaxTimestampChars = 32;
+
+// 十进制无符号整数
+size_t writeUnsigned(char* out, uint64_t value);
+
+// HH:MM:SS<separator>mmm (SRT 用 ',', VTT 用 '.'); 小时超过 99 时位数增加, 负数按 0 处理
+size_t writeTimestamp(char* out, int64_t ms, char separator);
+
+// LRC 的 [mm:ss.xx] (毫秒四舍五入到厘秒)
+size_t writeLrcTimestamp(char* out, int64_t ms);
+
+// 秒数的三位定点小数 (-1.250 / 3.000), 用于 JSON
+size_t writeSeconds(char* out, int64_t ms);
+
+// 原地规范化 whisper 片段文本, 单次遍历:
+//   - 去掉首尾空白, 中间连续空白 (ASCII 空白 / U+00A0) 合并为一个空格; 全角空格 U+3000 属于文本, 原样保留
+//   - 删除残留的特殊 token (<|endoftext|>、[_BEG_]、[_TT_150] 等)
+//   - 删除被 token 边界截断的 UTF-8 字节 (孤立的后续字节、不完整的多字节序列)
+// whisper 常把一个多字节字符拆在相邻两个片段之间: 传入 carry 时, 先把 carry 中上一片段
+// 末尾的不完整序列接到本片段开头, 再把本片段末尾的不完整序列移入 carry 留给下一片段
+void normalizeSegmentText(std::string& text, std::string* carry = nullptr);
+
+} // namespace llwhisper
+
+#endif // TRANSCRIPT_TEXT_H
@@ -0,0 +1,79 @@
+#ifndef WAVEFORM_INDEX_H
+#define WAVEFORM_INDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvideo {
+
+// 波形索引构建选项
+struct WaveformIndexOptions {
+    int levels = 6;                  // 金字塔层数
+    int samplesPerPeak = 512;        // 最精细一层每个峰值覆盖的样本数
+    int levelFactor = 4;             // 相邻两层的缩放倍数
+    int streamIndex = -1;            // 音频流索引 (-1=默认音轨)
+    std::string indexPath;           // sidecar 路径 (空=<媒体路径>.llwave)
+    bool force = false;              // 忽略已有的 sidecar 重新构建
+};
+
+// 单层峰值 (min / max / rms 量化为 int16, 满幅为 32767)
+struct WaveformLevel {
+    uint32_t samplesPerPeak = 0;
+    std::vector<int16_t> peaks;      // 每个峰值依次为 min, max, rms
+    size_t size() const { return peaks.size() / 3; }
+};
+
+// 查询结果, 每列一个值 (-1.0 - 1.0)
+struct WaveformRange {
+    int level = 0;                   // 使用的层
+    uint32_t samplesPerPeak = 0;
+    std::vector<float> min;
+    std::vector<float> max;
+    std::vector<float> rms;
+};
+
+// 多分辨率峰值金字塔
+// sidecar 记录源文件的大小与修改时间, 源文件变化后自动失效
+class WaveformIndex {
+public:
+    // 单次解码构建索引并写入 sidecar; sidecar 仍然有效时直接读取
+    static std::shared_ptr<const WaveformIndex> build(const std::string& mediaPath,
+                                                      const WaveformIndexOptions& options,
+                                                      std::string& error);
+
+    // 读取 sidecar (按路径缓存在内存中, 重复查询不再读文件)
+    static std::shared_ptr<const WaveformIndex> open(const std::string& indexPath, std::string& error);
+
+    // 释放内存中缓存的索引
+    static void clearCache();
+
+    // 默认的 sidecar 路径
+    static std::string defaultIndexPath(const std::string& mediaPath);
+
+    // 返回 [startTime, endTime) 区间按 width 列聚合后的峰值
+    WaveformRange query(double startTime, double endTime, int width) const;
+
+    const std::string& indexPath() const { return path; }
+    int sampleRate() const { return rate; }
+    uint64_t totalSamples() const { return samples; }
+    double duration() const { return rate > 0 ? static_cast<double>(samples) / rate : 0.0; }
+    const std::vector<WaveformLevel>& getLevels() const { return levels; }
+
+private:
+    bool read(const std::string& file, std::string& error);
+    bool write(const std::string& file, std::string& error) const;
+
+    std::string path;
+    std::string sourcePath;
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+    int rate = 0;
+    uint64_t samples = 0;
+    std::vector<WaveformLevel> levels;
+};
+
+} // namespace llvideo
+
+#endif // WAVEFORM_INDEX_H
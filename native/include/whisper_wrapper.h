@@ -1,16 +1,51 @@
 #ifndef WHISPER_WRAPPER_H
 #define WHISPER_WRAPPER_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "model_quantizer.h"
+#include "audio_preprocess.h"
+#include "compute_backend.h"
+#include "memory_budget.h"
+#include "pcm_cache.h"
+#include "transcript_text.h"
 
 namespace llwhisper {
 
+class FingerprintIndex;
+struct FingerprintMatch;
+
 struct TranscriptSegment {
     double startTime;
     double endTime;
     std::string text;
+    int speaker = -1;                       // 说话人编号 (未启用说话人分离时为 -1)
+    
+    // 解码统计 (来自 whisper 的 token 数据)
+    double avgLogprob = 0.0;                // 文本 token 的平均对数概率
+    double noSpeechProb = 0.0;              // 无语音概率
+    double compressionRatio = 1.0;          // 文本压缩比估计, 重复输出时偏高
+    // 事后按 logprob_thold / entropy_thold 判断的低置信度片段;
+    // whisper 不报告实际使用的温度, 不能据此确定是否发生过温度回退
+    bool lowConfidence = false;
+    double decodeTimeMs = 0.0;              // 所在解码窗口耗时按片段均分
+    
+    // 整数毫秒时间 (四舍五入), 导出与检查点都用它, 不受浮点截断影响
+    int64_t startMs() const { return secondsToMs(startTime); }
+    int64_t endMs() const { return secondsToMs(endTime); }
+};
+
+// 单条音轨的转录结果
+struct TrackTranscript {
+    int streamIndex = -1;
+    std::string language;                   // 容器中的语言标签 (如 jpn / eng)
+    std::vector<TranscriptSegment> segments;
+    std::string error;                      // 该音轨失败时的原因
 };
 
 // Whisper 参数配置
@@ -27,11 +62,16 @@ struct WhisperParams {
     // 采样策略
     int n_threads = 4;                    // 线程数
     int n_max_text_ctx = 16384;          // 最大文本上下文
-    int offset_ms = 0;                    // 时间偏移（毫秒）
+    int offset_ms = 0;                    // 时间偏移（毫秒）, 只解码该位置之后的音频
     int duration_ms = 0;                  // 处理时长（0=全部）
     
     // 解码参数
     bool no_context = false;              // 不使用历史上下文
+    
+    // 提示: 领域词汇 / 人名等放在 initial_prompt, 分词结果缓存在已加载的模型上,
+    // 同一提示在多次调用、流式分块、批量文件之间只分词一次; 每个块都会带上它
+    std::string initial_prompt;
+    std::vector<int32_t> prompt_tokens;   // 额外的上下文 token (如上一个文件末尾文本的 tokenize 结果), 接在 initial_prompt 之后
     bool single_segment = false;          // 强制单段输出
     int max_len = 0;                      // 最大段长度（0=默认）
     
@@ -53,6 +93,34 @@ struct WhisperParams {
     // 压制参数
     bool suppress_non_speech_tokens = false;  // 抑制非语音标记 (--suppress-nst)
     
+    // 说话人分离 (与推理并行运行)
+    bool diarize = false;                 // 为片段标注说话人
+    int max_speakers = 0;                 // 最大说话人数 (0=自动)
+    float speaker_threshold = 0.9f;       // 说话人聚类的余弦距离阈值
+    
+    // 解码时的流式预处理 (高通 / 降噪 / 响度归一化)
+    PreprocessOptions preprocess;
+    
+    // 流式解码: 解码线程经环形缓冲把 PCM 交给按块推理的循环, 解码与推理重叠
+    // (启用 diarize、检查点或去重时需要完整 PCM, 自动退回先解码后推理)
+    bool stream_decode = true;
+    int chunk_seconds = 30;               // 每次推理的音频块长度 (秒)
+    
+    // 解码结果缓存 (同一文件多次转录时跳过 FFmpeg 解码)
+    bool pcm_cache = false;               // 使用 / 生成 16kHz PCM 缓存 (内存映射后直接送入 whisper)
+    std::string pcm_cache_dir;            // 缓存目录 (空=媒体文件旁的 .llpcm sidecar)
+    
+    // 去重: 指纹索引文件 (空=不去重)。解码时顺带计算声学指纹, 索引中有近似重复的已转录文件
+    // (重新编码 / 重新上传的同一录音) 且模型、语言、提示等解码参数相同时直接复用其片段
+    // (按对齐偏移平移, decodeTimeMs 为 0), 不运行推理; 否则转录后把指纹与片段加入索引。需要完整 PCM, 不使用流式解码
+    std::string dedupe_index;
+    float dedupe_similarity = 0.65f;      // 最低相似度 (1 - 指纹比特错误率, 无关音频约为 0.5)
+    float dedupe_coverage = 0.9f;         // 对齐后可比较的帧至少占本文件非静音部分的比例
+    
+    // 检查点 (长音频可中断后继续)
+    std::string checkpoint_path;          // 检查点 sidecar 文件 (空=不写检查点)
+    bool resume = false;                  // 从已有检查点继续转录
+    
     // 输出格式选项
     bool output_txt = false;              // 输出纯文本
     bool output_srt = false;              // 输出 SRT 字幕
@@ -64,19 +132,181 @@ struct WhisperParams {
 // 进度回调
 using ProgressCallback = std::function<void(int progress)>;
 
+// 流式转录: 每个音频块推理完成后回调该块确定的片段
+using SegmentCallback = std::function<void(const std::vector<TranscriptSegment>& segments)>;
+
+// 两遍转录的事件
+struct TwoPassEvent {
+    enum Kind { Draft, Refine };
+    Kind kind = Draft;
+    // Refine: 用 segments 替换当前片段列表中的 [replaceStart, replaceStart + replaceCount)
+    // (按事件顺序依次应用, 下标基于前面的替换已生效后的列表)
+    size_t replaceStart = 0;
+    size_t replaceCount = 0;
+    std::vector<TranscriptSegment> segments;
+};
+
+using TwoPassCallback = std::function<void(const TwoPassEvent& event)>;
+
+// 语言检测选项: 只解码 positions 处的若干短窗口
+struct LanguageDetectOptions {
+    double sampleSeconds = 8.0;           // 每个窗口的时长 (所有窗口合计不超过 30 秒)
+    std::vector<double> positions;        // 窗口中心在文件中的相对位置 (0-1, 空=0.2/0.5/0.8)
+    int n_threads = 4;
+};
+
+struct LanguageProbability {
+    std::string language;                 // 语言代码 (en, ja, zh ...)
+    std::string name;                     // 语言全名
+    float probability = 0.0f;
+};
+
+struct LanguageDetectResult {
+    std::vector<LanguageProbability> languages;   // 按概率降序
+    std::vector<double> sampleTimes;              // 实际使用的窗口起点 (秒)
+    double durationSeconds = 0.0;                 // 文件时长 (未知时为 0)
+};
+
+// 批量转录选项
+struct BatchOptions {
+    int concurrency = 1;                  // 同时推理的文件数 (每个各占一份 whisper_state: KV 缓存与计算缓冲)
+    int prefetch = 1;                     // 等待推理的已解码文件数上限
+};
+
+struct BatchFileResult {
+    std::string path;
+    std::vector<TranscriptSegment> segments;
+    std::string error;                    // 非空表示该文件失败, 不影响其它文件
+    double audioSeconds = 0.0;            // 转录的音频时长
+    double decodeMs = 0.0;
+    double inferenceMs = 0.0;
+};
+
+struct BatchResult {
+    std::vector<BatchFileResult> files;   // 与输入顺序一致
+    double audioSeconds = 0.0;
+    double wallMs = 0.0;
+    double audioHoursPerHour = 0.0;       // 吞吐量: 音频时长 / 实际耗时
+    int states = 0;                       // 实际创建的 whisper_state 数
+};
+
+// 批量转录中每个文件完成时回调; index 为输入下标, 完成顺序不一定与输入顺序相同
+using BatchCallback = std::function<void(size_t index, const BatchFileResult& result)>;
+
+// 一次导出多种格式
+struct ExportOptions {
+    std::vector<std::string> formats;     // txt / srt / vtt / json / lrc
+    std::string outDir;                   // 输出目录; 为空时不写文件, 内容放在 ExportedFile::content
+    std::string baseName = "transcript";  // 文件名 (不含扩展名)
+};
+
+struct ExportedFile {
+    std::string format;
+    std::string path;                     // 写入的文件 (outDir 为空时为空)
+    uint64_t bytes = 0;
+    std::string content;                  // 只在 outDir 为空时填充
+    std::string error;                    // 非空表示该格式导出失败
+};
+
+// 已加载的模型: 一个 whisper_context 与它的分词缓存
+// 作业开始时取得当前版本并持有到结束; 重新加载只替换 WhisperWrapper 中的指针,
+// 进行中的作业在旧版本上完成, 最后一个作业结束时释放旧权重并从内存预算中移除
+struct LoadedModel {
+    ~LoadedModel();
+
+    void* ctx = nullptr;                  // whisper_context pointer
+    uint64_t version = 0;
+    bool draft = false;                   // 两遍模式的草稿模型
+    ModelInfo info;
+    std::string identity;                 // 路径|文件大小|修改时间|ftype, 同一路径上替换过的模型文件 key 不同
+    BackendOptions backend;
+    uint64_t stateBytes = 0;              // 一份 whisper_state 的估算大小
+    MemoryBudget* budget = nullptr;       // 常驻用量登记在 budget 的 residentKey 下
+    std::string residentKey;
+
+    // 上下文自带的 state 同一时间只允许一个推理
+    std::mutex inferenceMutex;
+
+    // 提示文本的分词缓存 (词表随模型变化, .en 模型与多语言模型不同)
+    std::mutex promptMutex;
+    std::unordered_map<std::string, std::vector<int32_t>> promptCache;
+};
+
+// 已加载的模型版本 (当前版本, 以及被替换后仍有作业在使用的旧版本)
+struct ModelVersionInfo {
+    uint64_t version = 0;
+    std::string path;
+    bool draft = false;                   // 两遍模式的草稿模型
+    bool current = false;                 // false 表示已被替换, 等待作业结束
+    long jobs = 0;                        // 正在使用该版本的作业数
+};
+
+// 作业可在多个工作线程中同时运行, 不保存共享的 "最后一次错误":
+// 转录类接口失败时抛出 std::runtime_error, 批量接口把各文件的错误写入结果, 加载模型通过 error 参数返回
 class WhisperWrapper {
 public:
     WhisperWrapper();
     ~WhisperWrapper();
 
-    // 加载模型
-    bool loadModel(const std::string& modelPath);
+    // 加载模型; backend 选择计算后端 (之后加载的草稿模型沿用同一选项)
+    // 已有模型时不等待进行中的作业: 新作业使用新版本, 旧版本在最后一个作业结束时释放; 加载失败时保留原模型
+    // installed 非空时写入本次加载的版本 (并发加载时不必再从 getLoadedModels 中猜测)
+    bool loadModel(const std::string& modelPath, const BackendOptions& backend, std::string& error,
+                   ModelVersionInfo* installed = nullptr);
+    
+    // 加载两遍模式使用的草稿模型 (tiny / base 等小模型), 替换方式与 loadModel 相同
+    bool loadDraftModel(const std::string& modelPath, std::string& error, ModelVersionInfo* installed = nullptr);
+    
+    // 当前版本与仍在排空的旧版本
+    std::vector<ModelVersionInfo> getLoadedModels() const;
+    
+    // 已注册的 ggml 后端 / 设备, 以及当前模型实际使用的设备
+    BackendInfo getBackendInfo() const;
+    
+    // 用当前模型的词表分词 (结果缓存在该模型版本中)
+    std::vector<int32_t> tokenize(const std::string& text);
 
     // 转录音频（使用参数结构）
     std::vector<TranscriptSegment> transcribe(const std::string& audioPath, 
                                                const WhisperParams& params,
                                                ProgressCallback callback = nullptr);
 
+    // 边解码边转录: 解码在独立线程运行, 第一个音频块解码完成即开始推理
+    // 块边界处未结束的最后一个片段留到下一块重新识别, onSegments 收到的片段不会再改变
+    std::vector<TranscriptSegment> transcribeStream(const std::string& audioPath,
+                                                    const WhisperParams& params,
+                                                    SegmentCallback onSegments = nullptr);
+
+    // 单次 demux 转录多条音轨（streams 为空表示全部音轨）
+    std::vector<TrackTranscript> transcribeTracks(const std::string& audioPath,
+                                                  const WhisperParams& params,
+                                                  const std::vector<int>& streams);
+
+    // 两遍转录: 先用草稿模型转录全文并立即回调, 再用主模型只重新转录低置信度片段
+    // 低置信度判定沿用 logprob_thold (平均对数概率) 与 entropy_thold (token 重复度)
+    std::vector<TranscriptSegment> transcribeTwoPass(const std::string& audioPath,
+                                                     const WhisperParams& params,
+                                                     TwoPassCallback callback = nullptr);
+
+    // 只在音频的若干采样窗口上检测语言, 不解码整个文件
+    LanguageDetectResult detectLanguage(const std::string& audioPath,
+                                        const LanguageDetectOptions& options);
+
+    // 批量转录: 模型只加载一次, 解码线程预取后续文件, 多个 whisper_state 并行推理
+    // 检查点与流式解码只针对单个文件, 批量模式下不使用
+    BatchResult transcribeBatch(const std::vector<std::string>& files, const WhisperParams& params,
+                                const BatchOptions& options = BatchOptions(), BatchCallback onFile = nullptr);
+
+    // 在 params.dedupe_index 中查找 audioPath 的近似重复 (只解码并计算指纹, 不保留 PCM, 不推理)
+    // 只考虑当前模型在相同参数下产生的记录, 未加载模型时抛出异常
+    // match 的片段已平移到 audioPath 的时间轴
+    bool findDuplicate(const std::string& audioPath, const WhisperParams& params, FingerprintMatch& match);
+    
+    // 解码为 16kHz 单声道 PCM 并按 params.preprocess 预处理 (不运行推理)
+    // decodeMs 为解码总耗时, preprocessMs 为其中预处理部分的耗时
+    std::vector<float> decodeAudio(const std::string& audioPath, const WhisperParams& params,
+                                   double& decodeMs, double& preprocessMs);
+
     // 简化的转录接口（向后兼容）
     std::vector<TranscriptSegment> transcribe(const std::string& audioPath, 
                                                const std::string& language);
@@ -87,17 +317,91 @@ public:
     std::string exportToVtt(const std::vector<TranscriptSegment>& segments);
     std::string exportToJson(const std::vector<TranscriptSegment>& segments);
     std::string exportToLrc(const std::vector<TranscriptSegment>& segments);
+    
+    // 从同一份片段并行生成多种格式, 每种格式一个线程, 直接分块写入 outDir
+    static std::vector<ExportedFile> exportAll(const std::vector<TranscriptSegment>& segments,
+                                               const ExportOptions& options);
 
     // 检查模型是否已加载
     bool isModelLoaded() const;
+    bool isDraftModelLoaded() const;
+    
+    // 当前模型的文件信息 (ftype 与各张量类型的数量 / 大小)
+    ModelInfo getModelInfo() const;
     
-    // 获取最后一次错误
-    std::string getLastError() const;
+    // 内存预算 (字节, 0=不限制): 作业开始前按估算用量申请, 放不下时排队 (最多 queueTimeoutMs, 0=一直等待);
+    // 单独运行也放不下的整段转录改为流式分块, 无法分块 (说话人分离 / 检查点 / 多音轨) 时拒绝
+    void setMemoryBudget(uint64_t limitBytes, uint64_t queueTimeoutMs = 0);
+    
+    // 常驻模型与运行中作业的内存估算
+    MemoryStats getMemoryStats() const;
 
 private:
-    void* ctx;  // whisper_context pointer
-    bool modelLoaded;
-    std::string lastError;
+    // 模型权重与 whisper_state 常驻内存, 作业的 PCM / 输出 / 额外 state 按作业申请
+    // (声明在模型之前: 析构时模型先释放, 再销毁预算)
+    MemoryBudget memoryBudget;
+    
+    // 当前模型版本; 作业通过 acquireModel 取得 shared_ptr 并持有到结束
+    mutable std::mutex modelMutex;
+    std::shared_ptr<LoadedModel> currentModel;
+    std::shared_ptr<LoadedModel> currentDraft;
+    std::vector<std::weak_ptr<LoadedModel>> retiredModels;   // 已被替换, 可能仍有作业在使用
+    uint64_t modelVersion = 0;
+    
+    // 串行化 loadModel / loadDraftModel (加载期间作业照常在当前版本上运行)
+    std::mutex loadMutex;
+    
+    // 当前版本; 未加载时抛出异常
+    std::shared_ptr<LoadedModel> acquireModel(bool draft = false);
+    
+    // 创建新版本并替换当前版本 (调用方持有 loadMutex)
+    bool installModel(const std::string& modelPath, const BackendOptions& backend, bool draft, std::string& error,
+                      ModelVersionInfo* installed);
+    
+    // 估算 audioPath 的用量并申请预算, 返回是否按流式分块处理
+    // streaming: 原本就走流式路径; canChunk: 整段 PCM 放不下时允许改为流式
+    // tracks: 同时解码的音轨数 (0=文件中的全部音轨)
+    bool admitJob(const std::string& job, const std::string& audioPath, const WhisperParams& params,
+                  bool streaming, bool canChunk, MemoryBudget::Reservation& reservation, size_t tracks = 1);
+    
+    // transcribeStream 的主体 (预算已由调用方申请)
+    std::vector<TranscriptSegment> runStream(LoadedModel& model, const std::string& audioPath,
+                                             const WhisperParams& params, SegmentCallback onSegments);
+    
+    // 对已解码的 16kHz 单声道 PCM 运行 whisper
+    // sourcePath 用于生成检查点 key, 为空时不写检查点
+    // startSeconds 为 pcmf32 第一个样本在源文件中的时间 (只解码了 offset_ms 之后的范围时)
+    // state 为空时使用上下文自带的 state (持有 model.inferenceMutex); 否则在该 whisper_state 上推理, 不加锁
+    std::vector<TranscriptSegment> transcribePcm(LoadedModel& model, const float* samples, size_t n_samples,
+                                                 const WhisperParams& params,
+                                                 const std::string& sourcePath = "",
+                                                 double startSeconds = 0.0,
+                                                 void* state = nullptr);
+    
+    // 用 model 的词表分词 (结果缓存在该版本中)
+    std::vector<int32_t> cachedTokens(LoadedModel& model, const std::string& text);
+    
+    // initial_prompt (model 的词表) + params.prompt_tokens + carried, 超出上限时保留 initial_prompt 与最近的上下文
+    std::vector<int32_t> buildPrompt(LoadedModel& model, const WhisperParams& params,
+                                     const std::vector<int32_t>& carried);
+    
+    // 去重用的指纹索引 (按索引文件路径缓存, 首次使用时读取)
+    std::mutex dedupeMutex;
+    std::unordered_map<std::string, std::unique_ptr<FingerprintIndex>> dedupeIndexes;
+    
+    // 调用方持有 dedupeMutex; 索引文件无法读取时抛出异常
+    FingerprintIndex& dedupeIndex(const std::string& path);
+    
+    // 索引中有近似重复时复用其片段, 否则转录并把指纹与片段加入索引
+    std::vector<TranscriptSegment> transcribeDeduped(LoadedModel& model, const float* samples, size_t n_samples,
+                                                     const std::vector<uint32_t>& fingerprint,
+                                                     const WhisperParams& params, const std::string& audioPath,
+                                                     double startSeconds, void* state = nullptr);
+    
+    // 打开 audioPath 的 PCM 缓存; 未命中且转录整个文件时解码并写入缓存
+    // 缓存无法写入时返回 nullptr, 已解码的 PCM 留在 decoded 中
+    std::unique_ptr<PcmCache> acquirePcmCache(const std::string& audioPath, const WhisperParams& params,
+                                              std::vector<float>& decoded);
     
     // 格式化时间戳
     std::string formatTimestamp(double seconds, bool srtFormat = false);
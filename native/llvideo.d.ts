@@ -95,6 +95,66 @@ declare module 'llvideo' {
 
     /** 是否包含视频流 */
     hasVideo: boolean;
+
+    /** 所有音频流 (多语言音轨) */
+    audioStreams: AudioStreamInfo[];
+  }
+
+  /**
+   * 音频流信息
+   */
+  export interface AudioStreamInfo {
+    /** 流索引 (用于 extractAudioTracks / transcribeTracks 的 streams 选项) */
+    index: number;
+
+    /** 音频编码格式 */
+    codec: string;
+
+    /** 语言标签 (容器元数据, 例如 "jpn", "eng"; 未知时为空) */
+    language: string;
+
+    /** 音轨标题 */
+    title: string;
+
+    /** 采样率 (Hz) */
+    sampleRate: number;
+
+    /** 声道数 */
+    channels: number;
+
+    /** 是否为默认音轨 */
+    isDefault: boolean;
+  }
+
+  /**
+   * 多音轨提取选项
+   */
+  export interface AudioTracksExtractionOptions extends AudioExtractionOptions {
+    /**
+     * 要提取的流索引
+     * @default [] (全部音轨)
+     */
+    streams?: number[];
+  }
+
+  /**
+   * 单条音轨的提取结果
+   */
+  export interface AudioTrackResult {
+    /** 流索引 */
+    streamIndex: number;
+
+    /** 语言标签 */
+    language: string;
+
+    /** 输出文件路径 */
+    outputPath: string;
+
+    /** 是否成功 */
+    ok: boolean;
+
+    /** 失败原因 */
+    error: string;
   }
 
   /**
@@ -138,6 +198,99 @@ declare module 'llvideo' {
     options?: AudioExtractionOptions
   ): boolean;
 
+  /**
+   * 单次读取文件, 同时提取多条音轨
+   * 
+   * 所有选中的音轨共用一次 demux, 各音轨在独立线程中解码和编码。
+   * 
+   * @param inputPath - 输入视频文件路径
+   * @param outputPattern - 输出路径模板, {stream} / {lang} 会被替换为流索引 / 语言标签
+   *                        (多条音轨且不含 {stream} 时自动追加)
+   * @param options - 音频提取选项 (可选)
+   * @returns AudioTrackResult[] - 每条音轨的结果
+   * @throws Error - 无法打开文件或没有音轨时抛出错误
+   * 
+   * @example
+   * ```typescript
+   * const tracks = extractAudioTracks('movie.mkv', 'out/movie.{lang}.{stream}.wav');
+   * tracks.filter(t => t.ok).forEach(t => console.log(t.language, t.outputPath));
+   * ```
+   */
+  export function extractAudioTracks(
+    inputPath: string,
+    outputPattern: string,
+    options?: AudioTracksExtractionOptions
+  ): AudioTrackResult[];
+
+  /**
+   * 字幕条目 (与 llwhisper 的 TranscriptSegment 兼容)
+   */
+  export interface SubtitleCue {
+    /** 开始时间 (秒) */
+    startTime: number;
+
+    /** 结束时间 (秒) */
+    endTime: number;
+
+    /** 字幕文本 (可包含换行) */
+    text: string;
+  }
+
+  /**
+   * 字幕封装选项
+   */
+  export interface SubtitleMuxOptions {
+    /**
+     * 字幕编码
+     * @default 按输出容器自动选择 (mp4/mov: mov_text, mkv: srt, webm: webvtt)
+     * @example "mov_text", "srt", "ass", "webvtt"
+     */
+    codec?: string;
+
+    /** 语言标签 (例如 "chi", "jpn", "eng") */
+    language?: string;
+
+    /** 字幕轨标题 */
+    title?: string;
+
+    /**
+     * 设为默认字幕轨
+     * @default false
+     */
+    default?: boolean;
+  }
+
+  /**
+   * 为视频添加字幕轨
+   * 
+   * 原有的音视频流直接复制 (不重新编码), 字幕包按时间穿插写入,
+   * 整个过程只需顺序读写一次文件。输出容器由 outputPath 的扩展名决定。
+   * 字幕时间以文件开头为 0, 自动对齐 start_time 不为 0 的文件 (如 MPEG-TS);
+   * 输出容器不支持的原有字幕轨 (如 MKV 中的 mov_text) 不会被复制。
+   * 输出为 MKV 时附件流 (字体等) 也会复制, 保证带样式的原有字幕正常渲染;
+   * 其他容器不支持附件, 附件会被丢弃。
+   * 字幕文本中的 `{` `}` 会被转义, 不会被当作 ASS 覆盖标签。
+   * 
+   * @param videoPath - 输入视频文件路径
+   * @param segments - 字幕条目
+   * @param outputPath - 输出文件路径
+   * @param options - 封装选项 (可选)
+   * @returns true - 成功时返回 true
+   * @throws Error - 失败时抛出错误
+   * 
+   * @example
+   * ```typescript
+   * const segments = llwhisper.transcribe('audio.wav', 'ja');
+   * muxSubtitles('video.mp4', segments, 'video.sub.mp4', { language: 'jpn' });
+   * ```
+   */
+  export function muxSubtitles(
+    videoPath: string,
+    segments: SubtitleCue[],
+    outputPath: string,
+    options?: SubtitleMuxOptions
+  ): boolean;
+
   /**
    * 获取视频文件信息
    * 
@@ -154,7 +307,86 @@ declare module 'llvideo' {
    * console.log(`Has Audio: ${info.hasAudio}`);
    * ```
    */
-  export function getVideoInfo(inputPath: string): VideoInfo;
+  export function getVideoInfo(inputPath: string, options?: { mode?: ProbeMode }): VideoInfo;
+
+  /**
+   * 探测模式
+   * - header: 仅解析容器头, 不解码帧 (头部信息不足时自动做一次有界探测)
+   * - full: 调用 avformat_find_stream_info 完整探测
+   */
+  export type ProbeMode = 'header' | 'full';
+
+  /**
+   * 批量探测选项
+   */
+  export interface ProbeBatchOptions {
+    /**
+     * 探测模式
+     * @default "header"
+     */
+    mode?: ProbeMode;
+
+    /**
+     * 工作线程数
+     * @default 0 (硬件线程数)
+     */
+    threads?: number;
+
+    /**
+     * 头部探测的最大字节数
+     * @default 262144
+     */
+    probeSize?: number;
+
+    /**
+     * 头部信息不足时的最大分析时长 (微秒)
+     * @default 500000
+     */
+    analyzeDuration?: number;
+
+    /**
+     * 按 路径 + 修改时间 + 文件大小 缓存结果
+     * @default true
+     */
+    cache?: boolean;
+  }
+
+  /**
+   * 单个文件的探测结果
+   */
+  export interface ProbeResult extends VideoInfo {
+    /** 文件路径 */
+    path: string;
+
+    /** 是否为有效的媒体文件 */
+    ok: boolean;
+
+    /** 是否命中缓存 */
+    cached: boolean;
+
+    /** 失败原因 */
+    error: string;
+  }
+
+  /**
+   * 批量探测媒体文件 (线程池并行, 不阻塞主线程)
+   * 
+   * @param paths - 文件路径列表
+   * @param options - 探测选项 (可选)
+   * @returns Promise<ProbeResult[]> - 与输入顺序一致的结果
+   * 
+   * @example
+   * ```typescript
+   * const results = await probeBatch(files, { mode: 'header' });
+   * const valid = results.filter(r => r.ok && r.hasAudio);
+   * ```
+   */
+  export function probeBatch(paths: string[], options?: ProbeBatchOptions): Promise<ProbeResult[]>;
+
+  /**
+   * 清空 probeBatch 的结果缓存
+   */
+  export function clearProbeCache(): boolean;
 
   /**
    * 检查文件是否为有效的媒体文件
@@ -186,6 +418,147 @@ declare module 'llvideo' {
    * ```
    */
   export function getLastError(): string;
+
+  /**
+   * 解码器复用池统计
+   */
+  export interface ContextPoolStats {
+    /** 是否启用复用 */
+    enabled: boolean;
+
+    /** 复用已打开解码器的次数 */
+    decoderHits: number;
+
+    /** 新建解码器的次数 */
+    decoderMisses: number;
+
+    /** 复用重采样器的次数 */
+    resamplerHits: number;
+
+    /** 新建重采样器的次数 */
+    resamplerMisses: number;
+
+    /** 复用 AVPacket 的次数 */
+    packetHits: number;
+
+    /** 复用 AVFrame 的次数 */
+    frameHits: number;
+
+    /** 当前空闲的解码器数量 */
+    idleDecoders: number;
+
+    /** 当前空闲的重采样器数量 */
+    idleResamplers: number;
+  }
+
+  /**
+   * 启用或禁用解码器 / 重采样器复用池
+   * 
+   * 默认启用。禁用时会释放所有空闲对象, 之后每个文件都重新创建 (用于基准对比)。
+   * 
+   * @param enabled - 是否启用
+   */
+  export function setContextPoolEnabled(enabled: boolean): boolean;
+
+  /**
+   * 获取解码器复用池统计信息
+   * 
+   * @example
+   * ```typescript
+   * const stats = getContextPoolStats();
+   * console.log(`Decoder reuse: ${stats.decoderHits}/${stats.decoderHits + stats.decoderMisses}`);
+   * ```
+   */
+  export function getContextPoolStats(): ContextPoolStats;
+
+  /**
+   * 波形索引构建选项
+   */
+  export interface WaveformIndexOptions {
+    /** 金字塔层数 @default 6 */
+    levels?: number;
+
+    /** 最精细一层每个峰值覆盖的样本数 @default 512 */
+    samplesPerPeak?: number;
+
+    /** 相邻两层的缩放倍数 @default 4 */
+    levelFactor?: number;
+
+    /** 音频流索引 (-1 = 默认音轨) @default -1 */
+    streamIndex?: number;
+
+    /** sidecar 路径 @default "<mediaPath>.llwave" */
+    indexPath?: string;
+
+    /** 忽略已有的 sidecar 重新构建 @default false */
+    force?: boolean;
+  }
+
+  /**
+   * 波形索引信息
+   */
+  export interface WaveformIndexInfo {
+    /** sidecar 路径 (传给 getWaveformPeaks) */
+    indexPath: string;
+
+    /** 源音频采样率 */
+    sampleRate: number;
+
+    /** 样本总数 */
+    totalSamples: number;
+
+    /** 时长 (秒) */
+    duration: number;
+
+    /** 各层的分辨率与峰值数量 */
+    levels: Array<{ samplesPerPeak: number; peaks: number }>;
+  }
+
+  /**
+   * 某个时间区间的峰值, 每列一个值 (-1.0 - 1.0)
+   */
+  export interface WaveformPeaks {
+    /** 使用的金字塔层 */
+    level: number;
+    samplesPerPeak: number;
+    sampleRate: number;
+    min: Float32Array;
+    max: Float32Array;
+    rms: Float32Array;
+  }
+
+  /**
+   * 构建多分辨率 min/max/RMS 波形索引
+   * 
+   * 单次解码写入二进制 sidecar。源文件大小、修改时间与层级配置未变化时直接复用已有 sidecar。
+   * 
+   * @param mediaPath - 媒体文件路径
+   * @param options - 层数或构建选项
+   * 
+   * @example
+   * ```typescript
+   * const index = await buildWaveformIndex('movie.mkv', 6);
+   * const peaks = getWaveformPeaks(index.indexPath, 0, index.duration, 1200);
+   * ```
+   */
+  export function buildWaveformIndex(mediaPath: string, options?: number | WaveformIndexOptions): Promise<WaveformIndexInfo>;
+
+  /**
+   * 读取 [startTime, endTime) 区间按 width 列聚合的峰值
+   * 
+   * 自动选择每列至少包含一个峰值的最粗一层; 索引读取后缓存在内存中, 之后的查询不访问磁盘。
+   * 
+   * @param indexPath - buildWaveformIndex 返回的 sidecar 路径
+   * @param startTime - 开始时间 (秒)
+   * @param endTime - 结束时间 (秒)
+   * @param width - 列数 (通常为像素宽度)
+   */
+  export function getWaveformPeaks(indexPath: string, startTime: number, endTime: number, width: number): WaveformPeaks;
+
+  /**
+   * 释放内存中缓存的波形索引
+   */
+  export function clearWaveformCache(): boolean;
 }
 
 // 默认导出
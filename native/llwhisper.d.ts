@@ -35,6 +35,22 @@ export interface TranscriptSegment {
   endTime: number;
   /** Transcribed text */
   text: string;
+  /** Speaker number (0-based, in order of first appearance); only present when `diarize` is enabled */
+  speakerId?: number;
+  /** Average log probability of the text tokens (closer to 0 = more confident) */
+  avgLogprob?: number;
+  /** Probability that the window contains no speech */
+  noSpeechProb?: number;
+  /** Text length / LZ77-compressed length; high values (> ~2) indicate repetition loops */
+  compressionRatio?: number;
+  /**
+   * Segment scores below logprob_thold / entropy_thold, judged from its tokens after
+   * decoding. An estimate: whisper.cpp does not report whether it actually retried the
+   * window at a higher temperature.
+   */
+  lowConfidence?: boolean;
+  /** Wall-clock time of the 30 s decode window that produced this segment, split evenly across its segments */
+  decodeTimeMs?: number;
 }
 
 /**
@@ -48,9 +64,12 @@ export interface WhisperParams {
   translate?: boolean;
   /** Number of threads to use (default: 4) */
   n_threads?: number;
-  /** Time offset in milliseconds */
+  /**
+   * Time offset in milliseconds. Only audio from here on is decoded (the file is
+   * seeked with a short pre-roll); segment times stay relative to the file start.
+   */
   offset_ms?: number;
-  /** Duration to process in milliseconds (0 = all) */
+  /** Duration to process in milliseconds (0 = all); decoding stops at the end of the range */
   duration_ms?: number;
   /** Entropy threshold (-et, default: 2.4) */
   entropy_thold?: number;
@@ -64,25 +83,397 @@ export interface WhisperParams {
   best_of?: number;
   /** Beam size for beam search (-1 = disable) */
   beam_size?: number;
+  /** Do not feed previously transcribed text back as context (default: false) */
+  no_context?: boolean;
+  /**
+   * Text that primes the decoder with domain vocabulary, names or style.
+   * Tokenised once per loaded model and cached, then reused for every chunk
+   * of transcribeStream, every file of transcribeBatch and later calls. It is
+   * kept at the front of each chunk's prompt, also with no_context.
+   */
+  initial_prompt?: string;
+  /**
+   * Extra context tokens placed after initial_prompt, e.g. `tokenize()` of the
+   * last lines of the previous file. Only the newest tokens are kept when the
+   * prompt exceeds whisper's 224-token limit.
+   */
+  prompt_tokens?: number[] | Int32Array;
   /** Print timestamps (default: true) */
   print_timestamps?: boolean;
   /** Print progress (default: false) */
   print_progress?: boolean;
+  /** Label each segment with a speaker; runs alongside inference (default: false) */
+  diarize?: boolean;
+  /** Maximum number of speakers (0 = decide from speaker_threshold, default: 0) */
+  max_speakers?: number;
+  /** Cosine distance below which two voices are merged into one speaker (default: 0.9) */
+  speaker_threshold?: number;
+  /** High-pass filter the decoded audio to remove rumble and DC (default: false) */
+  highpass?: boolean;
+  /** High-pass cutoff in Hz (default: 80) */
+  highpass_hz?: number;
+  /** Spectral-subtraction denoise of stationary background noise (default: false) */
+  denoise?: boolean;
+  /** Over-subtraction factor; higher removes more noise and more speech detail (default: 1.5) */
+  denoise_strength?: number;
+  /** Loudness normalisation with a slow AGC and peak limiter (default: false) */
+  normalize?: boolean;
+  /** Target speech RMS level in dBFS for normalize (default: -23) */
+  target_dbfs?: number;
+  /**
+   * Decode on a separate thread and run inference chunk by chunk while decoding
+   * continues (default: true). Ignored when diarize, checkpoint_path or dedupe_index is set,
+   * since those need the whole file decoded first. With language "auto" the language is
+   * detected on the first chunk that produces text and kept for the rest of the file.
+   */
+  stream_decode?: boolean;
+  /** Audio chunk length in seconds for stream_decode (default: 30) */
+  chunk_seconds?: number;
+  /**
+   * Cache the decoded 16 kHz PCM in a memory-mapped sidecar (default: false).
+   * The first full-file run decodes and writes the cache; later runs map it and
+   * pass it to whisper without decoding. Invalidated when the media file's size
+   * or modification time changes.
+   */
+  pcm_cache?: boolean;
+  /** Directory for PCM cache files (default: `<media>.llpcm` next to the media file) */
+  pcm_cache_dir?: string;
+  /**
+   * Fingerprint index file for deduplicating re-encodes and re-uploads.
+   * An acoustic fingerprint is computed during decoding; when the index holds an
+   * already-transcribed near-duplicate, its segments are reused (shifted by the
+   * alignment offset; decodeTimeMs is 0) and no inference runs. Only entries
+   * produced with the same model, language, translate, initial_prompt,
+   * prompt_tokens, preprocess and diarize settings are reused. Otherwise the
+   * file is transcribed and added to the index. Disables stream_decode.
+   */
+  dedupe_index?: string;
+  /** Minimum fingerprint similarity, 1 - bit error rate (default: 0.65; unrelated audio scores about 0.5) */
+  dedupe_similarity?: number;
+  /** Minimum share of this file's non-silent frames the duplicate must cover (default: 0.9) */
+  dedupe_coverage?: number;
+  /**
+   * Checkpoint sidecar file. Completed segments are appended after every
+   * 30 s decode window so a crashed or cancelled run can be continued.
+   */
+  checkpoint_path?: string;
+  /**
+   * Continue from checkpoint_path when it matches the same audio file, model
+   * file (path, size, mtime) and every output-affecting option (default: false).
+   * Resumed segments keep their decode statistics.
+   */
+  resume?: boolean;
+}
+
+/**
+ * Result of findDuplicate
+ */
+export interface DuplicateMatch {
+  /** Already-transcribed file in the index */
+  path: string;
+  /** Query time + offsetSeconds = time in the indexed file */
+  offsetSeconds: number;
+  /** 1 - fingerprint bit error rate */
+  similarity: number;
+  /** Share of the query's non-silent frames compared against the indexed file */
+  coverage: number;
+  /** Indexed transcript shifted onto the query's timeline (decodeTimeMs is 0) */
+  segments: TranscriptSegment[];
+}
+
+/**
+ * Options for transcribeTracks
+ */
+export interface TranscribeTracksOptions extends WhisperParams {
+  /** Audio stream indices to transcribe (default: all audio streams) */
+  streams?: number[];
+}
+
+/**
+ * Transcript of a single audio track
+ */
+export interface TrackTranscript {
+  /** Stream index in the container */
+  streamIndex: number;
+  /** Container language tag (e.g. "jpn", "eng"), empty if unknown */
+  language: string;
+  /** Transcript segments */
+  segments: TranscriptSegment[];
+  /** Error message if this track failed, empty otherwise */
+  error: string;
+}
+
+/**
+ * Event emitted by transcribeTwoPass
+ * 
+ * Apply events in order: `segments.splice(replaceStart, replaceCount, ...event.segments)`.
+ * The draft event has replaceStart = replaceCount = 0 and carries the full draft transcript.
+ */
+export interface TwoPassEvent {
+  /** "draft" once after the small model finishes, then "refine" per re-transcribed region */
+  type: 'draft' | 'refine';
+  /** Index of the first replaced segment in the current list */
+  replaceStart: number;
+  /** Number of segments replaced */
+  replaceCount: number;
+  /** New segments */
+  segments: TranscriptSegment[];
+}
+
+/**
+ * Options for detectLanguage
+ */
+export interface DetectLanguageOptions {
+  /** Length of each sampled window in seconds (default: 8; all windows together are capped at 30 s) */
+  sampleSeconds?: number;
+  /** Window centres as fractions of the file duration, 0-1 (default: [0.2, 0.5, 0.8]) */
+  positions?: number[];
+  /** Number of threads (default: 4) */
+  n_threads?: number;
+}
+
+/**
+ * Probability of one spoken language
+ */
+export interface LanguageProbability {
+  /** Language code ("en", "ja", "zh", ...) */
+  language: string;
+  /** Full language name ("english", "japanese", ...) */
+  name: string;
+  probability: number;
+}
+
+/**
+ * Result of detectLanguage
+ */
+export interface LanguageDetection {
+  /** Most likely language code, null if nothing was detected */
+  language: string | null;
+  /** Languages ranked by probability (entries below 0.001 are omitted) */
+  languages: LanguageProbability[];
+  /** Start times (seconds) of the windows that were used; silent windows are skipped */
+  sampleTimes: number[];
+  /** Media duration in seconds (0 if unknown) */
+  duration: number;
+}
+
+/**
+ * Tensor count and size for one GGML tensor type
+ */
+export interface TensorTypeStats {
+  /** GGML type name ("f32", "f16", "q8_0", "q5_1", "q4_0", ...) */
+  type: string;
+  /** Number of tensors stored with this type */
+  tensors: number;
+  /** Total number of elements */
+  elements: number;
+  /** Total size in bytes */
+  bytes: number;
+}
+
+/**
+ * Header and tensor type summary of a GGML whisper model file
+ */
+export interface ModelInfo {
+  /** Model file path */
+  path: string;
+  /** GGML file type (0 = f32, 1 = f16, 2 = q4_0, 7 = q8_0, 9 = q5_1, ...) */
+  ftype: number;
+  /** Quantization format version (0 for unquantized models) */
+  qntVersion: number;
+  nVocab: number;
+  nAudioState: number;
+  nAudioLayer: number;
+  nTextState: number;
+  nTextLayer: number;
+  nMels: number;
+  /** Total size of all tensor data in bytes */
+  tensorBytes: number;
+  /** Per-type breakdown of the tensors in the file */
+  tensorTypes: TensorTypeStats[];
+}
+
+/**
+ * Compute backend options for loadModel
+ */
+export interface BackendOptions {
+  /**
+   * 'auto' (default): whisper's own choice - GPU if available plus every registered accelerator.
+   * 'cpu': plain ggml CPU kernels; fails if an accelerator such as BLAS is registered.
+   * 'blas': CPU plus the BLAS backend (OpenBLAS, BLIS, MKL... whichever ggml-blas links).
+   * 'gpu': require GPU device `gpu_device`.
+   */
+  backend?: 'auto' | 'cpu' | 'blas' | 'gpu';
+  /** Enable flash attention (default: false) */
+  flash_attn?: boolean;
+  /** GPU device index for 'auto' / 'gpu' (default: 0) */
+  gpu_device?: number;
+  /**
+   * ggml backend libraries to load before creating the context (ggml built with
+   * GGML_BACKEND_DL). Backends cannot be unloaded, so use a separate process to
+   * compare libraries.
+   */
+  backend_libraries?: string[];
+}
+
+/**
+ * A compute device registered with ggml
+ */
+export interface BackendDevice {
+  name: string;
+  description: string;
+  type: 'cpu' | 'gpu' | 'accel';
+  /** Backend the device belongs to (CPU, BLAS, CUDA, Vulkan...) */
+  registry: string;
+  memoryFree: number;
+  memoryTotal: number;
+  /** Whether whisper uses this device with the current options */
+  active: boolean;
+}
+
+/**
+ * Result of getBackendInfo
+ */
+export interface BackendInfo {
+  modelLoaded: boolean;
+  /** Options the current model was loaded with (defaults when no model is loaded) */
+  backend: 'auto' | 'cpu' | 'blas' | 'gpu';
+  flashAttn: boolean;
+  gpuDevice: number;
+  /** Registered ggml backends */
+  registries: string[];
+  devices: BackendDevice[];
+  /** whisper_print_system_info(): compiled SIMD / BLAS features */
+  systemInfo: string;
+}
+
+/**
+ * Estimated memory by category, in bytes
+ */
+export interface MemoryUsage {
+  /** Model weights */
+  model: number;
+  /** whisper_state: KV caches and compute buffers */
+  state: number;
+  /** Decoded PCM (whole file, or the ring buffer when streaming) */
+  pcm: number;
+  /** Segments and exported text */
+  output: number;
+  total: number;
+}
+
+/**
+ * A running job's reservation in getMemoryStats().active
+ */
+export interface JobMemory extends MemoryUsage {
+  id: number;
+  /** Job kind and file, e.g. "transcribe: a.mp4" */
+  name: string;
+}
+
+/**
+ * Result of getMemoryStats
+ */
+export interface MemoryStats {
+  /** Budget in bytes (0 = unlimited) */
+  limit: number;
+  /** Loaded models (weights plus their default whisper_state) */
+  resident: MemoryUsage;
+  /** Sum over running jobs */
+  jobs: MemoryUsage;
+  /** resident.total + jobs.total */
+  total: number;
+  /** Highest total seen so far */
+  peak: number;
+  /** Jobs currently waiting for budget */
+  queued: number;
+  /** Jobs switched to chunked streaming because the whole file would not fit */
+  chunked: number;
+  /** Jobs rejected because they could never fit or the queue timeout expired */
+  rejected: number;
+  active: JobMemory[];
+}
+
+/**
+ * Quantization types supported by quantizeModel
+ */
+export type QuantizationType = 'q8_0' | 'q5_1' | 'q5_0' | 'q4_1' | 'q4_0';
+
+/**
+ * A loaded model version (see getLoadedModels)
+ */
+export interface ModelVersion {
+  /** Increases with every successful load (main and draft models share the counter) */
+  version: number;
+  path: string;
+  /** Draft model of transcribeTwoPass */
+  draft: boolean;
+  /** false once replaced: the version is freed when its last job finishes */
+  current: boolean;
+  /** Jobs still running on this version */
+  jobs: number;
+}
+
+/**
+ * Options for reloadModel
+ */
+export interface ReloadModelOptions extends BackendOptions {
+  /** Replace the draft model instead of the main model (backend options are then ignored) */
+  draft?: boolean;
 }
 
 /**
  * Load Whisper model from file
  * 
+ * Loading while jobs run does not interrupt them: each job keeps the model
+ * version it started with, new jobs use the new version, and the old weights
+ * are freed when its last job finishes. If loading fails, the previous model
+ * stays loaded.
+ * 
  * @param modelPath Path to the GGML model file
+ * @param options Compute backend selection (also used by loadDraftModel)
  * @returns true if model loaded successfully
- * @throws Error if model file not found or invalid
+ * @throws Error if model file not found or invalid, or the backend is unavailable
  * 
  * @example
  * ```typescript
  * whisper.loadModel('F:\\ollama\\model\\whisper-large-v2-gglm\\ggml-large-v2-f16.bin');
+ * whisper.loadModel('ggml-base.bin', { backend: 'blas', flash_attn: true });
  * ```
  */
-export function loadModel(modelPath: string): boolean;
+export function loadModel(modelPath: string, options?: BackendOptions): boolean;
+
+/**
+ * Load the small model used for the draft pass of transcribeTwoPass
+ * 
+ * @param modelPath Path to a tiny/base GGML model
+ * @returns true if model loaded successfully
+ * @throws Error if model file not found or invalid
+ */
+export function loadDraftModel(modelPath: string): boolean;
+
+/**
+ * Load a model on a worker thread and swap it in
+ * 
+ * Same semantics as loadModel / loadDraftModel, but the event loop keeps
+ * dispatching jobs (on the current version) while the new weights load.
+ * 
+ * @returns The new version
+ * 
+ * @example
+ * ```typescript
+ * // Swap models on a busy server: running jobs finish on the old weights
+ * const { version } = await whisper.reloadModel('models/ggml-large-v3-q5_1.bin');
+ * const draining = whisper.getLoadedModels().filter(m => !m.current);
+ * console.log(`v${version} live, ${draining.reduce((n, m) => n + m.jobs, 0)} jobs on old versions`);
+ * ```
+ */
+export function reloadModel(modelPath: string, options?: ReloadModelOptions): Promise<ModelVersion>;
+
+/**
+ * The current main / draft model versions, plus replaced versions that still have jobs running
+ */
+export function getLoadedModels(): ModelVersion[];
 
 /**
  * Transcribe audio file to text
@@ -114,6 +505,492 @@ export function loadModel(modelPath: string): boolean;
  */
 export function transcribe(audioPath: string, options?: string | WhisperParams): TranscriptSegment[];
 
+/**
+ * Transcribe while decoding, delivering segments chunk by chunk
+ * 
+ * Decoding runs on its own thread and feeds a ring buffer; inference starts as
+ * soon as the first `chunk_seconds` of audio are decoded, so the first segments
+ * arrive after roughly one chunk instead of after the whole file is decoded.
+ * A segment cut by a chunk boundary is re-recognised with the next chunk, so
+ * segments passed to onSegments are final. Runs on a background thread.
+ * 
+ * @param audioPath Path to audio file
+ * @param options Language code string or WhisperParams object
+ * @param onSegments Receives the segments of each finished chunk
+ * @returns All segments
+ * 
+ * @example
+ * ```typescript
+ * const segments = await whisper.transcribeStream('movie.mkv', { language: 'ja' }, (chunk) => {
+ *   chunk.forEach(seg => console.log(`[${seg.startTime}s] ${seg.text}`));
+ * });
+ * ```
+ */
+export function transcribeStream(
+  audioPath: string,
+  options?: string | WhisperParams,
+  onSegments?: (segments: TranscriptSegment[]) => void
+): Promise<TranscriptSegment[]>;
+
+/**
+ * Two-pass transcription: fast draft first, then refine low-confidence segments
+ * 
+ * The draft model (see loadDraftModel) transcribes the whole file and the draft is
+ * emitted right away. Segments whose average token log probability is below
+ * `logprob_thold`, or whose tokens repeat enough to fall below `entropy_thold`,
+ * are then re-transcribed with the main model and replaced in place. Runs on a
+ * background thread.
+ * 
+ * @param audioPath Path to audio file
+ * @param options Language code string or WhisperParams object
+ * @param onEvent Receives the draft and each refinement as they become available
+ * @returns Final segments (draft with all refinements applied)
+ * 
+ * @example
+ * ```typescript
+ * whisper.loadModel('ggml-large-v3.bin');
+ * whisper.loadDraftModel('ggml-base.bin');
+ * let segments: TranscriptSegment[] = [];
+ * await whisper.transcribeTwoPass('audio.wav', { language: 'ja' }, (event) => {
+ *   segments.splice(event.replaceStart, event.replaceCount, ...event.segments);
+ *   render(segments);
+ * });
+ * ```
+ */
+export function transcribeTwoPass(
+  audioPath: string,
+  options?: string | WhisperParams,
+  onEvent?: (event: TwoPassEvent) => void
+): Promise<TranscriptSegment[]>;
+
+/**
+ * Options for {@link transcribeBatch}
+ */
+export interface BatchOptions {
+  /**
+   * Files transcribed at the same time (default: 1). Each one gets its own
+   * whisper state (KV cache + compute buffers) sharing the loaded weights, so
+   * memory grows with concurrency. Total CPU threads are
+   * `concurrency * n_threads`; lower n_threads accordingly.
+   */
+  concurrency?: number;
+  /** Decoded files allowed to wait for inference (default: 1) */
+  prefetch?: number;
+}
+
+/**
+ * Per-file result of {@link transcribeBatch}
+ */
+export interface BatchFileResult {
+  path: string;
+  segments: TranscriptSegment[];
+  /** Set when this file failed; other files are unaffected */
+  error?: string;
+  /** Duration of the transcribed audio in seconds */
+  audioSeconds: number;
+  decodeMs: number;
+  inferenceMs: number;
+}
+
+/**
+ * Aggregate result of {@link transcribeBatch}
+ */
+export interface BatchResult {
+  /** One entry per input file, in input order */
+  files: BatchFileResult[];
+  /** Total audio transcribed successfully (seconds) */
+  audioSeconds: number;
+  /** Wall-clock time of the whole batch */
+  wallMs: number;
+  /** Throughput: hours of audio transcribed per hour of wall time */
+  audioHoursPerHour: number;
+  /** Whisper states actually allocated (may be lower than concurrency when memory runs out) */
+  states: number;
+}
+
+/**
+ * Transcribe many files with the loaded model
+ * 
+ * A decoder thread decodes the next files (honouring offset_ms / duration_ms,
+ * preprocess and pcm_cache) while earlier files run inference, and files are
+ * spread across `concurrency` whisper states. The per-file checkpoint and
+ * stream_decode options are not used in batch mode. Runs on background threads.
+ * 
+ * @param files Audio / video paths
+ * @param options Language code string or WhisperParams object, applied to every file
+ * @param batchOptions Concurrency and prefetch depth
+ * @param onFile Called as each file finishes (completion order may differ from input order)
+ * @returns Per-file results and aggregate throughput
+ * 
+ * @example
+ * ```typescript
+ * const batch = await whisper.transcribeBatch(files, { language: 'ja', n_threads: 4 }, { concurrency: 2 },
+ *   (index, file) => console.log(`${index}: ${file.error ?? file.segments.length + ' segments'}`));
+ * console.log(`${batch.audioHoursPerHour.toFixed(1)} audio hours / hour`);
+ * ```
+ */
+export function transcribeBatch(
+  files: string[],
+  options?: string | WhisperParams,
+  batchOptions?: BatchOptions,
+  onFile?: (index: number, result: BatchFileResult) => void
+): Promise<BatchResult>;
+
+/**
+ * Tokenise text with the loaded model's vocabulary
+ * 
+ * Shares the cache used for initial_prompt, so repeated calls with the same
+ * text are free. Pass the result as `prompt_tokens` to carry context between
+ * calls.
+ * 
+ * @param text Text to tokenise
+ * @returns Token ids
+ * @throws Error if model not loaded
+ * 
+ * @example
+ * ```typescript
+ * const tail = previous.slice(-5).map(s => s.text).join(' ');
+ * const next = await whisper.transcribe('part2.wav', {
+ *   language: 'ja',
+ *   initial_prompt: '用語: 量子化, ビームサーチ',
+ *   prompt_tokens: whisper.tokenize(tail)
+ * });
+ * ```
+ */
+export function tokenize(text: string): Int32Array;
+
+/**
+ * Transcribe several audio tracks of one file with a single demux pass
+ * 
+ * All selected tracks are decoded in parallel while the container is read once,
+ * then each track is transcribed in turn.
+ * 
+ * @param audioPath Path to media file
+ * @param options Language code string or TranscribeTracksOptions object
+ * @returns One TrackTranscript per selected track
+ * @throws Error if model not loaded or the file cannot be read
+ * 
+ * @example
+ * ```typescript
+ * const tracks = whisper.transcribeTracks('movie.mkv', { streams: [1, 2] });
+ * ```
+ */
+export function transcribeTracks(audioPath: string, options?: string | TranscribeTracksOptions): TrackTranscript[];
+
+/**
+ * Detect the spoken language from a few short windows of the file
+ * 
+ * Only the sampled windows are decoded (via seek), and they are concatenated
+ * into a single 30 s encoder pass, so the cost does not depend on file length.
+ * 
+ * @param audioPath Path to media file
+ * @param options Window length and positions
+ * @returns Promise resolving to the ranked language probabilities
+ * @throws Error if model not loaded
+ * 
+ * @example
+ * ```typescript
+ * const { language, languages } = await whisper.detectLanguage('movie.mkv', { sampleSeconds: 6 });
+ * ```
+ */
+export function detectLanguage(audioPath: string, options?: DetectLanguageOptions): Promise<LanguageDetection>;
+
+/**
+ * Look up an already-transcribed near-duplicate of a file in a fingerprint index
+ * 
+ * Decodes the file (or maps its PCM cache) and fingerprints it without keeping
+ * the samples or running inference. Only transcripts the loaded model would
+ * reuse with these options are considered, so a model must be loaded.
+ * transcribe / transcribeBatch with `dedupe_index` do this automatically.
+ * 
+ * @param audioPath Path to media file
+ * @param options dedupe_index is required; offset_ms, duration_ms, preprocess and pcm_cache are honoured,
+ *                and language, translate, initial_prompt, prompt_tokens and diarize select the entries
+ * @returns Promise resolving to the best match, or null
+ * 
+ * @example
+ * ```typescript
+ * const dup = await whisper.findDuplicate('reupload.mp4', { dedupe_index: 'library.llfp' });
+ * if (dup) console.log(`${dup.path} (+${dup.offsetSeconds.toFixed(2)} s, ${dup.similarity.toFixed(2)})`);
+ * ```
+ */
+export function findDuplicate(audioPath: string, options: WhisperParams): Promise<DuplicateMatch | null>;
+
+/**
+ * Tensor types of the currently loaded model
+ * 
+ * @returns Model info, or null if no model is loaded
+ * 
+ * @example
+ * ```typescript
+ * whisper.loadModel('models/ggml-large-v3-q5_1.bin');
+ * console.log(whisper.getModelInfo()?.tensorTypes);
+ * // [{ type: 'f32', ... }, { type: 'f16', ... }, { type: 'q5_1', tensors: 386, ... }]
+ * ```
+ */
+export function getModelInfo(): ModelInfo | null;
+
+/**
+ * Registered ggml backends and devices, and which of them the current model uses
+ * 
+ * @example
+ * ```typescript
+ * const info = whisper.getBackendInfo();
+ * console.log(info.devices.filter(d => d.active).map(d => d.name));   // ['BLAS', 'CPU']
+ * ```
+ */
+export function getBackendInfo(): BackendInfo;
+
+/**
+ * Limit the memory used by loaded models and running jobs
+ * 
+ * Each job reserves an estimate (from the container duration) before it starts:
+ * - jobs that fit run immediately;
+ * - jobs that fit once other jobs finish wait, for at most queueTimeoutMs (0 = no limit);
+ * - transcribe() calls whose whole-file PCM can never fit switch to chunked streaming;
+ *   jobs that need the whole file (diarize, checkpoints, two-pass, tracks, decodeAudio) are rejected.
+ * transcribeBatch creates fewer whisper states when the budget cannot hold `concurrency` of them.
+ * loadModel fails if the weights alone exceed the budget.
+ * 
+ * @param limitBytes Budget in bytes (0 = unlimited, the default)
+ * @param queueTimeoutMs How long a job may wait for budget before it is rejected (0 = wait indefinitely)
+ * 
+ * @example
+ * ```typescript
+ * whisper.setMemoryBudget(2 * 1024 ** 3, 60000);
+ * ```
+ */
+export function setMemoryBudget(limitBytes: number, queueTimeoutMs?: number): void;
+
+/**
+ * Live memory estimates for loaded models and running jobs (safe to poll while jobs run)
+ * 
+ * @example
+ * ```typescript
+ * setInterval(() => {
+ *   const stats = whisper.getMemoryStats();
+ *   console.log(`${(stats.total / 2 ** 20).toFixed(0)} MB, ${stats.queued} queued`);
+ * }, 1000);
+ * ```
+ */
+export function getMemoryStats(): MemoryStats;
+
+/**
+ * Read the header and tensor table of a model file without loading it
+ * 
+ * @param modelPath Path to the GGML model file
+ * @throws Error if the file is missing or not a GGML whisper model
+ */
+export function inspectModel(modelPath: string): ModelInfo;
+
+/**
+ * Quantize an f32/f16 model (same rules as whisper.cpp's quantize tool)
+ * 
+ * 2D weight matrices are quantized; convolution biases and positional
+ * embeddings keep their original type. Runs on a background thread.
+ * 
+ * @param srcPath Source f32/f16 model
+ * @param dstPath Output model path
+ * @param type Target quantization type
+ * @param options n_threads: worker threads (default: all cores)
+ * @returns Info of the written model
+ * 
+ * @example
+ * ```typescript
+ * const info = await whisper.quantizeModel('ggml-large-v3.bin', 'ggml-large-v3-q5_1.bin', 'q5_1');
+ * console.log(`${(info.tensorBytes / 1048576).toFixed(0)} MB`);
+ * ```
+ */
+export function quantizeModel(
+  srcPath: string,
+  dstPath: string,
+  type: QuantizationType,
+  options?: { n_threads?: number }
+): Promise<ModelInfo>;
+
+/**
+ * Decoded 16 kHz mono audio returned by decodeAudio
+ */
+export interface DecodedAudio {
+  samples: Float32Array;
+  sampleRate: number;
+  /** Total decode time in milliseconds, preprocessing included */
+  decodeMs: number;
+  /** Time spent in highpass / denoise / normalize, in milliseconds */
+  preprocessMs: number;
+}
+
+/**
+ * Decode a media file to the 16 kHz mono PCM that transcribe would see,
+ * with the same highpass / denoise / normalize options applied
+ * 
+ * @param audioPath Path to media file
+ * @param options Preprocessing options (other WhisperParams are ignored)
+ */
+export function decodeAudio(audioPath: string, options?: WhisperParams): DecodedAudio;
+
+/**
+ * Options for resegment. Latin and CJK text have separate limits;
+ * mixed lines are measured proportionally against both.
+ */
+export interface SegmentationOptions {
+  /** Maximum characters per line for Latin text (default: 42) */
+  maxCharsPerLine?: number;
+  /** Maximum characters per line for Chinese / Japanese / Korean text (default: 16) */
+  maxCjkCharsPerLine?: number;
+  /** Maximum lines per cue (default: 2) */
+  maxLines?: number;
+  /** Minimum cue duration in seconds (default: 1.0) */
+  minDuration?: number;
+  /** Maximum cue duration in seconds (default: 7.0) */
+  maxDuration?: number;
+  /**
+   * Reading speed limit for Latin text, characters per second (default: 17).
+   * Only extends a cue's end time into the gap before the next cue; it never
+   * splits a cue, so fast speech with no gap can still exceed the limit.
+   */
+  maxCharsPerSecond?: number;
+  /** Reading speed limit for CJK text, characters per second (default: 7) */
+  maxCjkCharsPerSecond?: number;
+  /** Minimum gap between consecutive cues in seconds (default: 0) */
+  minGap?: number;
+  /** Pause in seconds that always starts a new cue (default: 1.0) */
+  pauseThreshold?: number;
+}
+
+/**
+ * Re-segment a transcript into readable subtitle cues
+ * 
+ * Splits long segments and merges short ones to fit the line and duration
+ * limits, then extends end times toward the reading-speed limit. Breaks prefer sentence ends, then commas, then the
+ * original segment boundaries, and never cross a speaker change. Lines
+ * within a cue are separated by '\n'. Split times are interpolated from
+ * character counts. Runs in linear time.
+ * 
+ * @param segments Transcript segments
+ * @param options Segmentation limits
+ * @returns New segments (speakerId is kept; avgLogprob / noSpeechProb are weighted averages)
+ */
+export function resegment(segments: TranscriptSegment[], options?: SegmentationOptions): TranscriptSegment[];
+
+/**
+ * One row of a transcript store
+ */
+export interface StoredSegment {
+  /** Position in the store (start-time order) */
+  index: number;
+  id: string;
+  startTime: number;
+  endTime: number;
+  text: string;
+  translatedText?: string;
+  speaker?: string;
+}
+
+/**
+ * Fields accepted by createTranscriptStore / updateTranscriptSegment
+ * (other properties, e.g. a TranscriptSegment's stats, are ignored)
+ */
+export interface StoredSegmentFields {
+  id?: string;
+  startTime?: number;
+  endTime?: number;
+  text?: string;
+  /** null or '' clears the translation */
+  translatedText?: string | null;
+  speaker?: string | null;
+}
+
+/**
+ * Result of searchTranscript
+ */
+export interface TranscriptSearchResult {
+  /** Number of matching segments */
+  total: number;
+  /** Ascending indices of the first `limit` matches */
+  indices: Uint32Array;
+}
+
+/**
+ * Create (or replace) an in-process transcript store for the subtitle editor
+ * 
+ * Segments are sorted by start time and indexed for substring search over
+ * text and translation: postings are keyed by pairs of code points, so
+ * CJK text needs no word segmentation. Matching is case-insensitive for
+ * ASCII and treats full-width letters and digits as half-width.
+ * The editor then fetches only the rows it displays.
+ * 
+ * @param key Any string naming the store (e.g. the media path)
+ * @param segments Initial segments
+ * @returns Segment count and end time of the last segment
+ * 
+ * @example
+ * ```typescript
+ * whisper.createTranscriptStore(videoPath, segments);
+ * const rows = whisper.getTranscriptRange(videoPath, firstVisible, 40);
+ * ```
+ */
+export function createTranscriptStore(key: string, segments: StoredSegmentFields[]): { count: number; duration: number };
+
+/**
+ * Segments [start, start + count) of a store (clamped to its size)
+ * @throws Error if the store does not exist
+ */
+export function getTranscriptRange(key: string, start: number, count: number): StoredSegment[];
+
+/**
+ * Contiguous segments from the first one overlapping [startTime, endTime) seconds up to the
+ * last one starting before `endTime`; `first` is the index of the first one, so
+ * `segments[i]` is at index `first + i`. A short segment that ends before `startTime` is
+ * still included when an earlier, longer segment covers `startTime`.
+ */
+export function getTranscriptRangeByTime(
+  key: string,
+  startTime: number,
+  endTime: number
+): { first: number; segments: StoredSegment[] };
+
+/**
+ * Index of the segment playing at `time`, or of the next one to start
+ * (equals the segment count when nothing starts after `time`)
+ */
+export function getTranscriptIndexAt(key: string, time: number): number;
+
+/**
+ * Find segments whose text or translation contains `query`
+ * 
+ * @param limit Maximum number of indices returned (default: 1000)
+ * 
+ * @example
+ * ```typescript
+ * const { total, indices } = whisper.searchTranscript(videoPath, '字幕');
+ * ```
+ */
+export function searchTranscript(key: string, query: string, limit?: number): TranscriptSearchResult;
+
+/**
+ * Update the given fields of one segment and re-index its text
+ * 
+ * @returns The segment's new index (changes only when startTime moves it past a neighbour)
+ * @throws RangeError if index is out of range
+ */
+export function updateTranscriptSegment(key: string, index: number, fields: StoredSegmentFields): number;
+
+/**
+ * Remove one segment; later segments move up by one
+ * 
+ * @returns The new segment count
+ * @throws RangeError if index is out of range
+ */
+export function removeTranscriptSegment(key: string, index: number): number;
+
+/**
+ * Free a transcript store
+ * 
+ * @returns false if no store had this key
+ */
+export function releaseTranscriptStore(key: string): boolean;
+
 /**
  * Export segments to plain text format (-otxt)
  * 
@@ -141,6 +1018,9 @@ export function exportToVtt(segments: TranscriptSegment[]): string;
 /**
  * Export segments to JSON format
  * 
+ * `start` / `end` are seconds with millisecond precision (e.g. `12.340`);
+ * all exporters round times to the nearest millisecond.
+ * 
  * @param segments Transcript segments
  * @returns JSON formatted text
  */
@@ -153,3 +1033,61 @@ export function exportToJson(segments: TranscriptSegment[]): string;
  * @returns LRC formatted text
  */
 export function exportToLrc(segments: TranscriptSegment[]): string;
+
+/**
+ * Export format accepted by {@link exportAll}; also used as the file extension
+ */
+export type ExportFormat = 'txt' | 'srt' | 'vtt' | 'json' | 'lrc';
+
+/**
+ * Options for {@link exportAll}
+ */
+export interface ExportAllOptions {
+  /** Formats to generate */
+  formats: ExportFormat[];
+  /**
+   * Output directory (created if missing). Files are named `<baseName>.<format>`.
+   * When omitted nothing is written and each result carries `content` instead.
+   */
+  outDir?: string;
+  /** File name without extension (default: 'transcript') */
+  baseName?: string;
+}
+
+/**
+ * Result of one format in {@link exportAll}
+ */
+export interface ExportedFile {
+  format: string;
+  /** Written file (only with outDir) */
+  path?: string;
+  /** Size of the output in bytes */
+  bytes: number;
+  /** Formatted output (only without outDir) */
+  content?: string;
+  /** Set when this format failed (unknown / duplicate format, I/O error); other formats are unaffected */
+  error?: string;
+}
+
+/**
+ * Export one transcript to several formats at once.
+ *
+ * Segments are marshalled once, every format is generated on its own thread,
+ * and files are streamed to disk in 1 MB chunks (written to a temporary file
+ * and renamed into place). Output is identical to the matching `exportTo*`
+ * function. Does not require a loaded model.
+ *
+ * @param segments Transcript segments
+ * @param options Formats and output location
+ * @returns One entry per requested format, in request order
+ *
+ * @example
+ * ```typescript
+ * const files = await whisper.exportAll(segments, {
+ *   formats: ['srt', 'vtt', 'json'],
+ *   outDir: 'C:\\subtitles',
+ *   baseName: 'episode01'
+ * });
+ * ```
+ */
+export function exportAll(segments: TranscriptSegment[], options: ExportAllOptions): Promise<ExportedFile[]>;
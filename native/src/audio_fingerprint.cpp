@@ -0,0 +1,503 @@
+#include "audio_fingerprint.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace llwhisper {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int kInputRate = 16000;
+constexpr int kRate = 8000;
+constexpr int kFrameSize = 2048;                 // 256ms
+constexpr int kHop = 512;                        // 64ms
+constexpr int kTaps = 31;                        // 降采样低通 FIR 阶数
+constexpr int kBands = 33;
+constexpr float kMinFreq = 300.0f;
+constexpr float kMaxFreq = 2000.0f;
+constexpr float kSilenceMeanSquare = 1e-8f;      // 约 -80 dBFS
+
+// 索引中每隔几帧建立一次倒排 (查询使用全部帧, 真实偏移下每 kIndexStride 帧命中一次)
+constexpr uint32_t kIndexStride = 2;
+// 出现次数过多的键 (静音附近的常见模式) 不参与投票
+constexpr size_t kMaxPostings = 1024;
+// 投票最多的几个 (记录, 偏移) 进入验证
+constexpr size_t kCandidates = 8;
+// 至少比较这么多帧 (约 2 秒) 才认为匹配可信
+constexpr size_t kMinComparedFrames = 32;
+
+const char kMagic[8] = {'L', 'L', 'F', 'P', 'I', 'D', 'X', '\0'};
+const uint32_t kVersion = 2;                     // 2: 记录含解码 key 与完整片段字段
+const uint32_t kRecordMagic = 0x43455246;        // "FREC"
+
+int popcount32(uint32_t v) {
+    v = v - ((v >> 1) & 0x55555555u);
+    v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+    return static_cast<int>((((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+// 32 位 FNV-1a, 用于发现被截断 / 损坏的记录
+uint32_t checksum(const char* data, size_t n) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putString(std::string& out, const std::string& value) {
+    put<uint32_t>(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+// 顺序读取记录内容, 越界时 ok 置为 false
+struct Reader {
+    const char* data;
+    size_t size;
+    size_t pos = 0;
+    bool ok = true;
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (pos + sizeof(T) > size) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string getString() {
+        const uint32_t n = get<uint32_t>();
+        if (!ok || pos + n > size) {
+            ok = false;
+            return std::string();
+        }
+        std::string value(data + pos, n);
+        pos += n;
+        return value;
+    }
+};
+
+// 两个半字键: 高 16 位与低 16 位分别建立倒排, 其中一半完全一致即可命中
+inline uint32_t halfKey(uint32_t value, int half) {
+    return half == 0 ? (value >> 16) : (0x10000u | (value & 0xFFFFu));
+}
+
+} // namespace
+
+AudioFingerprinter::AudioFingerprinter()
+    : taps(kTaps), fft(kFrameSize), window(kFrameSize), re(kFrameSize), im(kFrameSize),
+      bandEdges(kBands + 1), previous(kBands - 1, 0.0f) {
+    const double pi = 3.14159265358979323846;
+
+    // Hamming 窗 sinc 低通, 截止 3.4kHz (8kHz 输出的奈奎斯特频率以下)
+    const double cutoff = 3400.0 / kInputRate;
+    double sum = 0.0;
+    for (int i = 0; i < kTaps; i++) {
+        const double x = i - (kTaps - 1) / 2.0;
+        const double sinc = x == 0.0 ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * x) / (pi * x);
+        taps[i] = static_cast<float>(sinc * (0.54 - 0.46 * std::cos(2.0 * pi * i / (kTaps - 1))));
+        sum += taps[i];
+    }
+    for (float& tap : taps) {
+        tap = static_cast<float>(tap / sum);
+    }
+
+    for (int i = 0; i < kFrameSize; i++) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * i / kFrameSize));
+    }
+
+    // 频带边界按对数均匀分布, 每个频带至少一个 bin
+    for (int m = 0; m <= kBands; m++) {
+        const double freq = kMinFreq * std::pow(kMaxFreq / kMinFreq, static_cast<double>(m) / kBands);
+        bandEdges[m] = static_cast<int>(std::lround(freq * kFrameSize / kRate));
+        if (m > 0 && bandEdges[m] <= bandEdges[m - 1]) {
+            bandEdges[m] = bandEdges[m - 1] + 1;
+        }
+    }
+}
+
+void AudioFingerprinter::process(const float* samples, size_t n) {
+    input.insert(input.end(), samples, samples + n);
+
+    // 每两个输入样本产生一个 8kHz 样本
+    while (inputStart + kTaps <= input.size()) {
+        const float* x = input.data() + inputStart;
+        float acc = 0.0f;
+        for (int i = 0; i < kTaps; i++) {
+            acc += taps[i] * x[i];
+        }
+        decimated.push_back(acc);
+        inputStart += 2;
+    }
+    input.erase(input.begin(), input.begin() + static_cast<std::ptrdiff_t>(inputStart));
+    inputStart = 0;
+
+    // 两帧共用一次复数 FFT (实部 / 虚部各放一帧); 末尾不成对的帧等下一次输入
+    while (frameStart + kHop + kFrameSize <= decimated.size()) {
+        processFrames(decimated.data() + frameStart);
+        frameStart += 2 * kHop;
+    }
+    decimated.erase(decimated.begin(), decimated.begin() + static_cast<std::ptrdiff_t>(frameStart));
+    frameStart = 0;
+}
+
+void AudioFingerprinter::processFrames(const float* x) {
+    const float* y = x + kHop;
+    float meanSquareX = 0.0f;
+    float meanSquareY = 0.0f;
+    for (int i = 0; i < kFrameSize; i++) {
+        meanSquareX += x[i] * x[i];
+        meanSquareY += y[i] * y[i];
+        re[i] = x[i] * window[i];
+        im[i] = y[i] * window[i];
+    }
+
+    fft.forward(re.data(), im.data());
+
+    // Z = X + iY: X[k] = (Z[k] + conj(Z[N-k])) / 2, Y[k] = (Z[k] - conj(Z[N-k])) / 2i
+    float energyX[kBands];
+    float energyY[kBands];
+    for (int m = 0; m < kBands; m++) {
+        float sumX = 0.0f;
+        float sumY = 0.0f;
+        for (int b = bandEdges[m]; b < bandEdges[m + 1]; b++) {
+            const int mirror = (kFrameSize - b) & (kFrameSize - 1);
+            const float xr = re[b] + re[mirror];
+            const float xi = im[b] - im[mirror];
+            const float yr = im[b] + im[mirror];
+            const float yi = re[b] - re[mirror];
+            sumX += xr * xr + xi * xi;
+            sumY += yr * yr + yi * yi;
+        }
+        energyX[m] = sumX;
+        energyY[m] = sumY;
+    }
+    emitFrame(energyX, meanSquareX / kFrameSize < kSilenceMeanSquare);
+    emitFrame(energyY, meanSquareY / kFrameSize < kSilenceMeanSquare);
+}
+
+void AudioFingerprinter::emitFrame(const float* energy, bool silent) {
+    // 静音帧: 输出 0 并重新开始差分
+    if (silent) {
+        values.push_back(0);
+        hasPrevious = false;
+        return;
+    }
+
+    // 第 m 位: (E[n][m] - E[n][m+1]) - (E[n-1][m] - E[n-1][m+1]) > 0
+    uint32_t value = 0;
+    for (int m = 0; m < kBands - 1; m++) {
+        const float diff = energy[m] - energy[m + 1];
+        if (hasPrevious && diff - previous[m] > 0.0f) {
+            value |= 1u << m;
+        }
+        previous[m] = diff;
+    }
+    values.push_back(hasPrevious ? value : 0);
+    hasPrevious = true;
+}
+
+std::vector<uint32_t> AudioFingerprinter::compute(const float* samples, size_t n) {
+    AudioFingerprinter fingerprinter;
+    // 分块送入, 避免复制整段样本
+    const size_t block = 1 << 16;
+    for (size_t i = 0; i < n; i += block) {
+        fingerprinter.process(samples + i, std::min(block, n - i));
+    }
+    return fingerprinter.values;
+}
+
+bool FingerprintIndex::load(const std::string& path, std::string& error) {
+    filePath = path;
+    entries.clear();
+    byPath.clear();
+    postings.clear();
+    rewrite = false;
+
+    std::ifstream in(fs::u8path(path), std::ios::binary);
+    if (!in.is_open()) {
+        return true;    // 新索引
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.empty()) {
+        return true;
+    }
+
+    Reader header{data.data(), data.size()};
+    char magic[8] = {};
+    for (char& c : magic) c = header.get<char>();
+    const uint32_t version = header.get<uint32_t>();
+    const uint32_t hopMicros = header.get<uint32_t>();
+    if (!header.ok || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || version == 0 || version > kVersion ||
+        hopMicros != static_cast<uint32_t>(std::lround(AudioFingerprinter::kHopSeconds * 1e6))) {
+        error = "Not a fingerprint index (or an incompatible version): " + path;
+        return false;
+    }
+    if (version < kVersion) {
+        rewrite = true;
+        return true;
+    }
+
+    size_t pos = header.pos;
+    while (pos + 8 <= data.size()) {
+        Reader record{data.data() + pos, data.size() - pos};
+        const uint32_t recordMagic = record.get<uint32_t>();
+        const uint32_t payloadSize = record.get<uint32_t>();
+        if (recordMagic != kRecordMagic || record.pos + payloadSize + 4 > record.size) {
+            break;      // 写入中断留下的半条记录
+        }
+        const char* payload = record.data + record.pos;
+        uint32_t stored = 0;
+        std::memcpy(&stored, payload + payloadSize, sizeof(stored));
+        if (stored != checksum(payload, payloadSize)) {
+            break;
+        }
+
+        Reader reader{payload, payloadSize};
+        Entry entry;
+        entry.path = reader.getString();
+        entry.decodeKey = reader.getString();
+        const uint32_t frames = reader.get<uint32_t>();
+        if (reader.ok && reader.pos + static_cast<size_t>(frames) * sizeof(uint32_t) <= reader.size) {
+            entry.fingerprint.resize(frames);
+            std::memcpy(entry.fingerprint.data(), payload + reader.pos, frames * sizeof(uint32_t));
+            reader.pos += frames * sizeof(uint32_t);
+        } else {
+            reader.ok = false;
+        }
+        const uint32_t count = reader.get<uint32_t>();
+        for (uint32_t i = 0; i < count && reader.ok; i++) {
+            TranscriptSegment segment;
+            segment.startTime = reader.get<int64_t>() / 1000.0;
+            segment.endTime = reader.get<int64_t>() / 1000.0;
+            segment.text = reader.getString();
+            segment.speaker = reader.get<int32_t>();
+            segment.avgLogprob = reader.get<double>();
+            segment.noSpeechProb = reader.get<double>();
+            segment.compressionRatio = reader.get<double>();
+            segment.lowConfidence = reader.get<uint8_t>() != 0;
+            entry.segments.push_back(std::move(segment));
+        }
+        if (!reader.ok) {
+            break;
+        }
+
+        const std::string pathKey = entry.path + '\n' + entry.decodeKey;
+        auto it = byPath.find(pathKey);
+        if (it != byPath.end()) {
+            entries[it->second].replaced = true;
+        }
+        byPath[pathKey] = static_cast<uint32_t>(entries.size());
+        entries.push_back(std::move(entry));
+        pos += 8 + payloadSize + 4;
+    }
+
+    // 被替换的记录不建立倒排, 其指纹也不再需要
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        if (entries[i].replaced) {
+            std::vector<uint32_t>().swap(entries[i].fingerprint);
+            std::vector<TranscriptSegment>().swap(entries[i].segments);
+        } else {
+            indexEntry(i);
+        }
+    }
+    return true;
+}
+
+bool FingerprintIndex::add(const std::string& mediaPath, const std::string& decodeKey,
+                           const std::vector<uint32_t>& fingerprint,
+                           const std::vector<TranscriptSegment>& segments, std::string& error) {
+    std::string payload;
+    payload.reserve(mediaPath.size() + decodeKey.size() + fingerprint.size() * sizeof(uint32_t) +
+                    segments.size() * 96 + 16);
+    putString(payload, mediaPath);
+    putString(payload, decodeKey);
+    put<uint32_t>(payload, static_cast<uint32_t>(fingerprint.size()));
+    payload.append(reinterpret_cast<const char*>(fingerprint.data()), fingerprint.size() * sizeof(uint32_t));
+    put<uint32_t>(payload, static_cast<uint32_t>(segments.size()));
+    for (const TranscriptSegment& segment : segments) {
+        put<int64_t>(payload, segment.startMs());
+        put<int64_t>(payload, segment.endMs());
+        putString(payload, segment.text);
+        put<int32_t>(payload, segment.speaker);
+        put<double>(payload, segment.avgLogprob);
+        put<double>(payload, segment.noSpeechProb);
+        put<double>(payload, segment.compressionRatio);
+        put<uint8_t>(payload, segment.lowConfidence ? 1 : 0);
+    }
+
+    std::string record;
+    record.reserve(payload.size() + 12 + 16);
+    std::error_code ec;
+    const bool exists = !rewrite && fs::exists(fs::u8path(filePath), ec) &&
+                        fs::file_size(fs::u8path(filePath), ec) > 0;
+    if (!exists) {
+        record.append(kMagic, sizeof(kMagic));
+        put<uint32_t>(record, kVersion);
+        put<uint32_t>(record, static_cast<uint32_t>(std::lround(AudioFingerprinter::kHopSeconds * 1e6)));
+    }
+    put<uint32_t>(record, kRecordMagic);
+    put<uint32_t>(record, static_cast<uint32_t>(payload.size()));
+    record.append(payload);
+    put<uint32_t>(record, checksum(payload.data(), payload.size()));
+
+    // 整条记录一次写入; 中断时读取端丢弃不完整的末尾
+    std::ofstream out(fs::u8path(filePath), std::ios::binary | (exists ? std::ios::app : std::ios::trunc));
+    if (!out.is_open()) {
+        error = "Cannot open fingerprint index: " + filePath;
+        return false;
+    }
+    out.write(record.data(), static_cast<std::streamsize>(record.size()));
+    out.flush();
+    if (!out.good()) {
+        error = "Failed to write fingerprint index: " + filePath;
+        return false;
+    }
+    rewrite = false;
+
+    Entry entry;
+    entry.path = mediaPath;
+    entry.decodeKey = decodeKey;
+    entry.fingerprint = fingerprint;
+    entry.segments = segments;
+    const std::string pathKey = mediaPath + '\n' + decodeKey;
+    auto it = byPath.find(pathKey);
+    if (it != byPath.end()) {
+        Entry& old = entries[it->second];
+        old.replaced = true;
+        std::vector<uint32_t>().swap(old.fingerprint);
+        std::vector<TranscriptSegment>().swap(old.segments);
+    }
+    const uint32_t index = static_cast<uint32_t>(entries.size());
+    byPath[pathKey] = index;
+    entries.push_back(std::move(entry));
+    indexEntry(index);
+    return true;
+}
+
+void FingerprintIndex::indexEntry(uint32_t entry) {
+    const std::vector<uint32_t>& fingerprint = entries[entry].fingerprint;
+    const size_t oldSize = postings.size();
+    for (uint32_t pos = 0; pos < fingerprint.size(); pos += kIndexStride) {
+        if (fingerprint[pos] == 0) continue;
+        postings.push_back(Posting{halfKey(fingerprint[pos], 0), entry, pos});
+        postings.push_back(Posting{halfKey(fingerprint[pos], 1), entry, pos});
+    }
+    // 新增部分排序后与已有部分归并
+    auto byKey = [](const Posting& a, const Posting& b) { return a.key < b.key; };
+    std::sort(postings.begin() + static_cast<std::ptrdiff_t>(oldSize), postings.end(), byKey);
+    std::inplace_merge(postings.begin(), postings.begin() + static_cast<std::ptrdiff_t>(oldSize), postings.end(), byKey);
+}
+
+bool FingerprintIndex::lookup(const std::string& decodeKey, const std::vector<uint32_t>& fingerprint,
+                              double durationSeconds, double minSimilarity, double minCoverage,
+                              FingerprintMatch& match) const {
+    if (fingerprint.empty() || postings.empty()) {
+        return false;
+    }
+
+    // 只有同一解码参数产生的记录可以复用 (其他模型 / 语言 / 提示的转录不参与投票)
+    std::vector<char> eligible(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        eligible[i] = !entries[i].replaced && entries[i].decodeKey == decodeKey;
+    }
+
+    // 按 (记录, 对齐偏移) 投票
+    std::unordered_map<uint64_t, uint32_t> votes;
+    auto byKey = [](const Posting& a, const Posting& b) { return a.key < b.key; };
+    for (uint32_t q = 0; q < fingerprint.size(); q++) {
+        if (fingerprint[q] == 0) continue;
+        for (int half = 0; half < 2; half++) {
+            const Posting probe{halfKey(fingerprint[q], half), 0, 0};
+            auto range = std::equal_range(postings.begin(), postings.end(), probe, byKey);
+            if (static_cast<size_t>(range.second - range.first) > kMaxPostings) continue;
+            for (auto it = range.first; it != range.second; ++it) {
+                if (!eligible[it->entry]) continue;
+                const int64_t delta = static_cast<int64_t>(it->position) - q;
+                votes[(static_cast<uint64_t>(it->entry) << 32) | static_cast<uint32_t>(delta + 0x80000000LL)]++;
+            }
+        }
+    }
+
+    std::vector<std::pair<uint32_t, uint64_t>> ranked;
+    ranked.reserve(votes.size());
+    for (const auto& vote : votes) {
+        if (vote.second >= 2) ranked.emplace_back(vote.second, vote.first);
+    }
+    const size_t candidates = std::min(kCandidates, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(candidates), ranked.end(),
+                      [](const std::pair<uint32_t, uint64_t>& a, const std::pair<uint32_t, uint64_t>& b) {
+                          return a.first > b.first;
+                      });
+
+    size_t audible = 0;
+    for (uint32_t value : fingerprint) {
+        if (value != 0) audible++;
+    }
+
+    // 验证: 候选偏移及其相邻偏移上的比特错误率
+    bool found = false;
+    uint32_t bestEntry = 0;
+    int64_t bestDelta = 0;
+    for (size_t c = 0; c < candidates; c++) {
+        const uint32_t entry = static_cast<uint32_t>(ranked[c].second >> 32);
+        const int64_t center = static_cast<int64_t>(static_cast<uint32_t>(ranked[c].second)) - 0x80000000LL;
+        const std::vector<uint32_t>& reference = entries[entry].fingerprint;
+        for (int64_t delta = center - 1; delta <= center + 1; delta++) {
+            size_t compared = 0;
+            uint64_t errors = 0;
+            for (size_t q = 0; q < fingerprint.size(); q++) {
+                const int64_t r = static_cast<int64_t>(q) + delta;
+                if (r < 0 || r >= static_cast<int64_t>(reference.size())) continue;
+                if (fingerprint[q] == 0 || reference[r] == 0) continue;
+                errors += popcount32(fingerprint[q] ^ reference[r]);
+                compared++;
+            }
+            if (compared < kMinComparedFrames) continue;
+            const double similarity = 1.0 - static_cast<double>(errors) / (32.0 * compared);
+            const double coverage = static_cast<double>(compared) / audible;
+            if (similarity >= minSimilarity && coverage >= minCoverage && (!found || similarity > match.similarity)) {
+                found = true;
+                bestEntry = entry;
+                bestDelta = delta;
+                match.similarity = similarity;
+                match.coverage = coverage;
+            }
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    const Entry& best = entries[bestEntry];
+    match.path = best.path;
+    match.offsetSeconds = bestDelta * AudioFingerprinter::kHopSeconds;
+    match.segments.clear();
+    for (const TranscriptSegment& segment : best.segments) {
+        TranscriptSegment shifted = segment;
+        shifted.decodeTimeMs = 0.0;     // 复用的片段没有经过解码
+        shifted.startTime = std::max(0.0, segment.startTime - match.offsetSeconds);
+        shifted.endTime = std::min(durationSeconds, segment.endTime - match.offsetSeconds);
+        if (shifted.endTime > shifted.startTime) {
+            match.segments.push_back(std::move(shifted));
+        }
+    }
+    return true;
+}
+
+} // namespace llwhisper
@@ -0,0 +1,249 @@
+#include "audio_preprocess.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define LLWHISPER_PREPROCESS_SSE 1
+#endif
+
+namespace llwhisper {
+
+namespace {
+
+constexpr int kSampleRate = 16000;
+constexpr int kFftSize = 512;
+constexpr int kHop = kFftSize / 2;              // 块大小 16ms
+constexpr int kBins = kFftSize / 2 + 1;
+constexpr float kSpectrumSmoothing = 0.7f;      // 功率谱时间平滑
+constexpr float kNoiseRise = 1.003f;            // 噪声估计每帧最多上升 (约 1.6dB/s)
+constexpr float kGainSmoothing = 0.3f;          // 增益时间平滑, 抑制音乐噪声
+constexpr float kSpeechGate = 1e-6f;            // 均方值低于 -60dBFS 的块不更新响度
+constexpr float kLevelAlpha = 0.01f;            // 响度估计时间常数约 1.6s
+constexpr float kMinGain = 0.25f;               // 最多衰减 12dB
+constexpr float kPeakLimit = 0.98f;
+
+// dst[i] = a[i] * b[i]
+void multiply(float* dst, const float* a, const float* b, int n) {
+    int i = 0;
+#ifdef LLWHISPER_PREPROCESS_SSE
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+#endif
+    for (; i < n; i++) dst[i] = a[i] * b[i];
+}
+
+// dst[i] += a[i] * b[i]
+void multiplyAdd(float* dst, const float* a, const float* b, int n) {
+    int i = 0;
+#ifdef LLWHISPER_PREPROCESS_SSE
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), v));
+    }
+#endif
+    for (; i < n; i++) dst[i] += a[i] * b[i];
+}
+
+// 块的平方和与峰值
+void blockStats(const float* x, int n, float& sumSq, float& peak) {
+    int i = 0;
+    sumSq = 0.0f;
+    peak = 0.0f;
+#ifdef LLWHISPER_PREPROCESS_SSE
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 vsum = _mm_setzero_ps();
+    __m128 vpeak = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(x + i);
+        vsum = _mm_add_ps(vsum, _mm_mul_ps(v, v));
+        vpeak = _mm_max_ps(vpeak, _mm_andnot_ps(signMask, v));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, vsum);
+    sumSq = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm_storeu_ps(lanes, vpeak);
+    peak = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+    for (; i < n; i++) {
+        sumSq += x[i] * x[i];
+        peak = std::max(peak, std::fabs(x[i]));
+    }
+}
+
+// 从 from 线性过渡到 to 的增益
+void applyRamp(float* x, int n, float from, float to) {
+    const float step = (to - from) / n;
+    int i = 0;
+#ifdef LLWHISPER_PREPROCESS_SSE
+    __m128 g = _mm_setr_ps(from, from + step, from + 2 * step, from + 3 * step);
+    const __m128 g4 = _mm_set1_ps(4 * step);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), g));
+        g = _mm_add_ps(g, g4);
+    }
+#endif
+    for (; i < n; i++) x[i] *= from + step * i;
+}
+
+} // namespace
+
+std::string PreprocessOptions::key() const {
+    std::ostringstream out;
+    if (highpass) out << "hp" << highpassHz << ';';
+    if (denoise) out << "dn" << denoiseStrength << ',' << denoiseFloor << ';';
+    if (normalize) out << "ln" << targetDbfs << ',' << maxGainDb << ';';
+    return out.str();
+}
+
+AudioPreprocessor::AudioPreprocessor(const PreprocessOptions& options)
+    : options(options), block(kHop), fft(kFftSize), window(kFftSize), frame(kFftSize, 0.0f),
+      overlap(kFftSize, 0.0f), re(kFftSize), im(kFftSize), smoothed(kBins, 0.0f), noise(kBins, 0.0f),
+      gain(kBins, 1.0f) {
+    const double pi = 3.14159265358979323846;
+
+    if (options.highpass) {
+        // RBJ cookbook 二阶高通, Q = 1/sqrt(2) (Butterworth)
+        double w0 = 2.0 * pi * options.highpassHz / kSampleRate;
+        double alpha = std::sin(w0) / (2.0 * std::sqrt(0.5));
+        double cosw = std::cos(w0);
+        double a0 = 1.0 + alpha;
+        b0 = static_cast<float>((1.0 + cosw) / 2.0 / a0);
+        b1 = static_cast<float>(-(1.0 + cosw) / a0);
+        b2 = b0;
+        a1 = static_cast<float>(-2.0 * cosw / a0);
+        a2 = static_cast<float>((1.0 - alpha) / a0);
+    }
+
+    // 周期 sqrt-Hann: 分析窗 x 合成窗 = Hann, 50% 重叠相加恰好为 1
+    for (int i = 0; i < kFftSize; i++) {
+        window[i] = static_cast<float>(std::sqrt(0.5 - 0.5 * std::cos(2.0 * pi * i / kFftSize)));
+    }
+    if (options.denoise) {
+        latency = kFftSize - kHop;
+    }
+}
+
+void AudioPreprocessor::process(const float* samples, size_t n, std::vector<float>& out) {
+    inputCount += n;
+    while (n > 0) {
+        size_t take = std::min(n, block.size() - blockFill);
+        std::memcpy(block.data() + blockFill, samples, take * sizeof(float));
+        blockFill += take;
+        samples += take;
+        n -= take;
+        if (blockFill == block.size()) {
+            processBlock();
+            emitBlock(out);
+        }
+    }
+}
+
+void AudioPreprocessor::flush(std::vector<float>& out) {
+    // 以静音补齐最后一块并推出 STFT 延迟中的样本
+    while (outputCount < inputCount) {
+        std::fill(block.begin() + blockFill, block.end(), 0.0f);
+        blockFill = block.size();
+        processBlock();
+        emitBlock(out);
+    }
+}
+
+void AudioPreprocessor::processBlock() {
+    if (options.highpass) highpassBlock(block.data());
+    if (options.denoise) denoiseBlock(block.data());
+    if (options.normalize) normalizeBlock(block.data());
+}
+
+void AudioPreprocessor::emitBlock(std::vector<float>& out) {
+    size_t begin = std::min(latency, block.size());
+    latency -= begin;
+    size_t count = std::min(block.size() - begin, inputCount - outputCount);
+    out.insert(out.end(), block.begin() + begin, block.begin() + begin + count);
+    outputCount += count;
+    blockFill = 0;
+}
+
+void AudioPreprocessor::highpassBlock(float* x) {
+    // IIR 递推存在样本间依赖, 逐样本计算 (每样本 5 次乘加)
+    for (int i = 0; i < kHop; i++) {
+        float in = x[i];
+        float y = b0 * in + z1;
+        z1 = b1 * in - a1 * y + z2;
+        z2 = b2 * in - a2 * y;
+        x[i] = y;
+    }
+}
+
+void AudioPreprocessor::denoiseBlock(float* x) {
+    // 滑动分析帧
+    std::memmove(frame.data(), frame.data() + kHop, (kFftSize - kHop) * sizeof(float));
+    std::memcpy(frame.data() + kFftSize - kHop, x, kHop * sizeof(float));
+
+    multiply(re.data(), frame.data(), window.data(), kFftSize);
+    std::fill(im.begin(), im.end(), 0.0f);
+    fft.forward(re.data(), im.data());
+
+    // 最小值跟踪估计噪声: 平滑功率下降时立即跟随, 上升时缓慢跟随
+    const float alpha = options.denoiseStrength;
+    const float floor = options.denoiseFloor;
+    for (int k = 0; k < kBins; k++) {
+        float power = re[k] * re[k] + im[k] * im[k];
+        smoothed[k] = noiseInitialized ? kSpectrumSmoothing * smoothed[k] + (1.0f - kSpectrumSmoothing) * power : power;
+        noise[k] = noiseInitialized ? std::min(smoothed[k], noise[k] * kNoiseRise) : smoothed[k];
+        float g = std::max(floor, 1.0f - alpha * noise[k] / (power + 1e-12f));
+        gain[k] = kGainSmoothing * gain[k] + (1.0f - kGainSmoothing) * g;
+    }
+    noiseInitialized = true;
+
+    // 实信号频谱共轭对称, 负频率使用相同增益
+    for (int k = 0; k < kBins; k++) {
+        re[k] *= gain[k];
+        im[k] *= gain[k];
+    }
+    for (int k = kBins; k < kFftSize; k++) {
+        re[k] *= gain[kFftSize - k];
+        im[k] *= gain[kFftSize - k];
+    }
+    fft.inverse(re.data(), im.data());
+
+    // 合成窗 + 重叠相加, 前半部分已完整
+    multiplyAdd(overlap.data(), re.data(), window.data(), kFftSize);
+    std::memcpy(x, overlap.data(), kHop * sizeof(float));
+    std::memmove(overlap.data(), overlap.data() + kHop, (kFftSize - kHop) * sizeof(float));
+    std::fill(overlap.begin() + (kFftSize - kHop), overlap.end(), 0.0f);
+}
+
+void AudioPreprocessor::normalizeBlock(float* x) {
+    float sumSq = 0.0f;
+    float peak = 0.0f;
+    blockStats(x, kHop, sumSq, peak);
+    const float meanSq = sumSq / kHop;
+
+    // 只用有声块更新响度估计, 静音段保持当前增益
+    if (meanSq > kSpeechGate) {
+        level = level > 0.0f ? (1.0f - kLevelAlpha) * level + kLevelAlpha * meanSq : meanSq;
+    }
+
+    float target = currentGain;
+    if (level > 0.0f) {
+        const float targetRms = std::pow(10.0f, options.targetDbfs / 20.0f);
+        const float maxGain = std::pow(10.0f, options.maxGainDb / 20.0f);
+        target = std::clamp(targetRms / std::sqrt(level), kMinGain, maxGain);
+    }
+
+    // 峰值限制: 块内峰值乘以增益不超过 kPeakLimit
+    float start = currentGain;
+    if (peak > 0.0f) {
+        float limit = kPeakLimit / peak;
+        target = std::min(target, limit);
+        start = std::min(start, limit);
+    }
+    applyRamp(x, kHop, start, target);
+    currentGain = target;
+}
+
+} // namespace llwhisper
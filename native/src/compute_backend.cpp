@@ -0,0 +1,126 @@
+#include "compute_backend.h"
+#include "../whisper.cpp/include/whisper.h"
+#include "ggml-backend.h"
+#include <mutex>
+#include <set>
+
+namespace llwhisper {
+
+namespace {
+
+const char* deviceTypeName(enum ggml_backend_dev_type type) {
+    switch (type) {
+        case GGML_BACKEND_DEVICE_TYPE_CPU: return "cpu";
+        case GGML_BACKEND_DEVICE_TYPE_GPU: return "gpu";
+        default: return "accel";
+    }
+}
+
+// 已加载的后端库 (ggml 不支持卸载后端, 同一路径只加载一次)
+std::mutex loadedMutex;
+std::set<std::string> loadedLibraries;
+
+} // namespace
+
+bool backendUsesGpu(const BackendOptions& options) {
+    return options.backend == "auto" || options.backend == "gpu";
+}
+
+bool prepareBackend(const BackendOptions& options, std::string& error) {
+    if (options.backend != "auto" && options.backend != "cpu" &&
+        options.backend != "blas" && options.backend != "gpu") {
+        error = "Unknown backend: " + options.backend + " (expected auto, cpu, blas or gpu)";
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(loadedMutex);
+        for (const std::string& path : options.libraries) {
+            if (loadedLibraries.count(path)) {
+                continue;
+            }
+            if (ggml_backend_load(path.c_str()) == nullptr) {
+                error = "Failed to load ggml backend library: " + path;
+                return false;
+            }
+            loadedLibraries.insert(path);
+        }
+    }
+
+    int gpus = 0;
+    std::string accel;
+    bool blas = false;
+    for (size_t i = 0; i < ggml_backend_dev_count(); ++i) {
+        ggml_backend_dev_t dev = ggml_backend_dev_get(i);
+        enum ggml_backend_dev_type type = ggml_backend_dev_type(dev);
+        if (type == GGML_BACKEND_DEVICE_TYPE_GPU) {
+            gpus++;
+        } else if (type == GGML_BACKEND_DEVICE_TYPE_ACCEL) {
+            std::string registry = ggml_backend_reg_name(ggml_backend_dev_backend_reg(dev));
+            blas = blas || registry == "BLAS";
+            if (accel.empty()) accel = ggml_backend_dev_name(dev);
+        }
+    }
+
+    // whisper 总是使用所有已注册的加速设备, 已注册后无法单独关闭
+    if (options.backend == "cpu" && !accel.empty()) {
+        error = "Backend 'cpu' requested but accelerator '" + accel + "' is registered and always used; "
+                "build ggml with GGML_BACKEND_DL and load BLAS through libraries only when wanted";
+        return false;
+    }
+    if (options.backend == "blas" && !blas) {
+        error = "Backend 'blas' requested but no BLAS backend is registered "
+                "(build ggml with GGML_BLAS=ON or pass the ggml-blas library in libraries)";
+        return false;
+    }
+    if (options.backend == "gpu" && options.gpuDevice >= gpus) {
+        error = "Backend 'gpu' requested but GPU device " + std::to_string(options.gpuDevice) +
+                " is not available (" + std::to_string(gpus) + " GPU devices registered)";
+        return false;
+    }
+    return true;
+}
+
+BackendInfo queryBackends(const BackendOptions& options) {
+    BackendInfo info;
+    info.options = options;
+    info.systemInfo = whisper_print_system_info();
+
+    for (size_t i = 0; i < ggml_backend_reg_count(); ++i) {
+        info.registries.push_back(ggml_backend_reg_name(ggml_backend_reg_get(i)));
+    }
+
+    // 与 whisper_backend_init 相同: 第 gpuDevice 个 GPU (use_gpu 时) + 全部加速设备 + CPU
+    const bool useGpu = backendUsesGpu(options);
+    int gpuIndex = 0;
+    bool cpuActive = false;
+    for (size_t i = 0; i < ggml_backend_dev_count(); ++i) {
+        ggml_backend_dev_t dev = ggml_backend_dev_get(i);
+        enum ggml_backend_dev_type type = ggml_backend_dev_type(dev);
+
+        BackendDevice device;
+        device.name = ggml_backend_dev_name(dev);
+        device.description = ggml_backend_dev_description(dev);
+        device.type = deviceTypeName(type);
+        device.registry = ggml_backend_reg_name(ggml_backend_dev_backend_reg(dev));
+        size_t memoryFree = 0;
+        size_t memoryTotal = 0;
+        ggml_backend_dev_memory(dev, &memoryFree, &memoryTotal);
+        device.memoryFree = memoryFree;
+        device.memoryTotal = memoryTotal;
+
+        if (type == GGML_BACKEND_DEVICE_TYPE_GPU) {
+            device.active = useGpu && gpuIndex == options.gpuDevice;
+            gpuIndex++;
+        } else if (type == GGML_BACKEND_DEVICE_TYPE_ACCEL) {
+            device.active = true;
+        } else {
+            device.active = !cpuActive;
+            cpuActive = true;
+        }
+        info.devices.push_back(device);
+    }
+    return info;
+}
+
+} // namespace llwhisper
@@ -0,0 +1,467 @@
+#include "diarization.h"
+#include "fft.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define LLWHISPER_DIARIZATION_SSE 1
+#endif
+
+namespace llwhisper {
+
+namespace {
+
+constexpr int kSampleRate = 16000;
+constexpr int kFrameLength = 400;       // 25ms
+constexpr int kFrameShift = 160;        // 10ms
+constexpr int kFftSize = 512;
+constexpr int kSpectrumSize = kFftSize / 2 + 1;
+constexpr int kMelBands = 40;
+constexpr int kEmbeddingDim = kMelBands * 2;   // 每个频带的均值 + 标准差
+constexpr int kWindowFrames = 150;      // 嵌入窗口 1.5s
+constexpr int kWindowShift = 75;        // 窗口步长 0.75s
+constexpr float kMinSpeechRatio = 0.5f; // 窗口内语音帧比例下限
+constexpr float kEnergyMargin = 1.386f; // 静音门限: 噪声底之上 6dB (自然对数)
+constexpr int kMinClusterWindows = 2;   // 少于该窗口数的簇并入最近的簇
+
+// 点积 (嵌入聚类与 mel 滤波的热点)
+float dot(const float* a, const float* b, int n) {
+    int i = 0;
+    float sum = 0.0f;
+#ifdef LLWHISPER_DIARIZATION_SSE
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// 去直流后的帧对数能量 (静音门限只需要能量, 不做 FFT)
+float frameEnergy(const float* samples) {
+    float mean = 0.0f;
+    for (int i = 0; i < kFrameLength; i++) mean += samples[i];
+    mean /= kFrameLength;
+    float energy = 0.0f;
+    for (int i = 0; i < kFrameLength; i++) {
+        float x = samples[i] - mean;
+        energy += x * x;
+    }
+    return std::log(energy + 1e-10f);
+}
+
+// 逐帧提取 log-mel
+// 中间缓冲按实部 / 虚部分开存放, 功率谱与统计量循环可被编译器向量化
+class FeatureExtractor {
+public:
+    FeatureExtractor()
+        : fft(kFftSize), window(kFrameLength), re(kFftSize), im(kFftSize), power(kSpectrumSize) {
+        const double pi = 3.14159265358979323846;
+        for (int i = 0; i < kFrameLength; i++) {
+            window[i] = static_cast<float>(0.54 - 0.46 * std::cos(2.0 * pi * i / (kFrameLength - 1)));
+        }
+        buildMelFilters();
+    }
+
+    // logMel 写入 kMelBands 个值
+    void compute(const float* samples, float* logMel) {
+        float mean = 0.0f;
+        for (int i = 0; i < kFrameLength; i++) mean += samples[i];
+        mean /= kFrameLength;
+
+        // 去直流 + 预加重 + 加窗
+        float prev = samples[0] - mean;
+        for (int i = 0; i < kFrameLength; i++) {
+            float x = samples[i] - mean;
+            re[i] = (x - 0.97f * prev) * window[i];
+            prev = x;
+        }
+        std::fill(re.begin() + kFrameLength, re.end(), 0.0f);
+        std::fill(im.begin(), im.end(), 0.0f);
+
+        fft.forward(re.data(), im.data());
+
+        for (int k = 0; k < kSpectrumSize; k++) {
+            power[k] = re[k] * re[k] + im[k] * im[k];
+        }
+        for (int b = 0; b < kMelBands; b++) {
+            const MelFilter& filter = filters[b];
+            float value = dot(power.data() + filter.start, filter.weights.data(),
+                              static_cast<int>(filter.weights.size()));
+            logMel[b] = std::log(value + 1e-10f);
+        }
+    }
+
+private:
+    struct MelFilter {
+        int start = 0;
+        std::vector<float> weights;
+    };
+
+    static double hzToMel(double hz) { return 2595.0 * std::log10(1.0 + hz / 700.0); }
+    static double melToHz(double mel) { return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0); }
+
+    void buildMelFilters() {
+        const double lowMel = hzToMel(20.0);
+        const double highMel = hzToMel(7600.0);
+        std::vector<double> edges(kMelBands + 2);
+        for (int i = 0; i < kMelBands + 2; i++) {
+            edges[i] = melToHz(lowMel + (highMel - lowMel) * i / (kMelBands + 1));
+        }
+
+        const double binHz = static_cast<double>(kSampleRate) / kFftSize;
+        filters.resize(kMelBands);
+        for (int b = 0; b < kMelBands; b++) {
+            double left = edges[b], center = edges[b + 1], right = edges[b + 2];
+            int first = static_cast<int>(std::ceil(left / binHz));
+            int last = std::min(static_cast<int>(std::floor(right / binHz)), kSpectrumSize - 1);
+            filters[b].start = first;
+            for (int k = first; k <= last; k++) {
+                double hz = k * binHz;
+                double w = hz <= center ? (hz - left) / (center - left) : (right - hz) / (right - center);
+                filters[b].weights.push_back(static_cast<float>(std::max(0.0, w)));
+            }
+        }
+    }
+
+    Fft fft;
+    std::vector<float> window;
+    std::vector<float> re;
+    std::vector<float> im;
+    std::vector<float> power;
+    std::vector<MelFilter> filters;
+};
+
+// 增量凝聚聚类
+// 只保留最多 maxClusters 个活动簇及其两两距离矩阵, 内存与音频长度无关;
+// 超出上限时合并距离最近的一对簇。簇编号通过并查集追踪合并关系。
+class IncrementalClusterer {
+public:
+    IncrementalClusterer(int maxClusters, float threshold)
+        : maxClusters(std::max(2, maxClusters)), threshold(threshold),
+          stride(static_cast<size_t>(this->maxClusters) + 1),
+          distances(stride * stride, 0.0f) {
+    }
+
+    // 加入一个已归一化的嵌入, 返回其簇编号
+    int add(const float* embedding) {
+        size_t best = clusters.size();
+        float bestDistance = std::numeric_limits<float>::max();
+        for (size_t i = 0; i < clusters.size(); i++) {
+            float d = 1.0f - dot(embedding, clusters[i].centroid.data(), kEmbeddingDim);
+            if (d < bestDistance) {
+                bestDistance = d;
+                best = i;
+            }
+        }
+
+        if (best < clusters.size() && bestDistance < threshold) {
+            Cluster& cluster = clusters[best];
+            for (int i = 0; i < kEmbeddingDim; i++) cluster.sum[i] += embedding[i];
+            cluster.count++;
+            updateCentroid(best);
+            return cluster.id;
+        }
+
+        Cluster cluster;
+        cluster.id = static_cast<int>(parent.size());
+        cluster.count = 1;
+        cluster.sum.assign(embedding, embedding + kEmbeddingDim);
+        cluster.centroid.resize(kEmbeddingDim);
+        parent.push_back(cluster.id);
+        clusters.push_back(std::move(cluster));
+        updateCentroid(clusters.size() - 1);
+        int id = clusters.back().id;
+
+        if (clusters.size() > static_cast<size_t>(maxClusters)) {
+            size_t a = 0, b = 0;
+            closestPair(a, b);
+            merge(a, b);
+        }
+        return id;
+    }
+
+    // 收尾: 合并到距离阈值 / 说话人上限以内, 再吸收过小的簇
+    void finalize(int maxSpeakers) {
+        while (clusters.size() > 1) {
+            size_t a = 0, b = 0;
+            float d = closestPair(a, b);
+            bool overLimit = maxSpeakers > 0 && clusters.size() > static_cast<size_t>(maxSpeakers);
+            if (!overLimit && d >= threshold) break;
+            merge(a, b);
+        }
+
+        for (;;) {
+            if (clusters.size() <= 1) break;
+            size_t small = clusters.size();
+            for (size_t i = 0; i < clusters.size(); i++) {
+                if (clusters[i].count < kMinClusterWindows) {
+                    small = i;
+                    break;
+                }
+            }
+            if (small == clusters.size()) break;
+
+            size_t nearest = small == 0 ? 1 : 0;
+            for (size_t j = 0; j < clusters.size(); j++) {
+                if (j != small && distance(small, j) < distance(small, nearest)) nearest = j;
+            }
+            merge(nearest, small);
+        }
+    }
+
+    // 簇编号 -> 合并后的根编号
+    int resolve(int id) {
+        while (parent[id] != id) {
+            parent[id] = parent[parent[id]];
+            id = parent[id];
+        }
+        return id;
+    }
+
+private:
+    struct Cluster {
+        int id = 0;
+        int count = 0;
+        std::vector<float> sum;
+        std::vector<float> centroid;
+    };
+
+    float& distance(size_t a, size_t b) { return distances[a * stride + b]; }
+
+    // 重新归一化质心并刷新该簇所在的行 / 列
+    void updateCentroid(size_t slot) {
+        Cluster& cluster = clusters[slot];
+        float norm = std::sqrt(dot(cluster.sum.data(), cluster.sum.data(), kEmbeddingDim));
+        float scale = norm > 0.0f ? 1.0f / norm : 0.0f;
+        for (int i = 0; i < kEmbeddingDim; i++) cluster.centroid[i] = cluster.sum[i] * scale;
+
+        for (size_t j = 0; j < clusters.size(); j++) {
+            float d = j == slot ? 0.0f
+                    : 1.0f - dot(cluster.centroid.data(), clusters[j].centroid.data(), kEmbeddingDim);
+            distance(slot, j) = d;
+            distance(j, slot) = d;
+        }
+    }
+
+    float closestPair(size_t& a, size_t& b) {
+        float best = std::numeric_limits<float>::max();
+        for (size_t i = 0; i < clusters.size(); i++) {
+            for (size_t j = i + 1; j < clusters.size(); j++) {
+                if (distance(i, j) < best) {
+                    best = distance(i, j);
+                    a = i;
+                    b = j;
+                }
+            }
+        }
+        return best;
+    }
+
+    // 合并两个簇 (保留较大的一个), 被移除的槽位由最后一个簇填补
+    void merge(size_t a, size_t b) {
+        size_t keep = clusters[a].count >= clusters[b].count ? a : b;
+        size_t drop = keep == a ? b : a;
+
+        for (int i = 0; i < kEmbeddingDim; i++) clusters[keep].sum[i] += clusters[drop].sum[i];
+        clusters[keep].count += clusters[drop].count;
+        parent[clusters[drop].id] = clusters[keep].id;
+
+        size_t last = clusters.size() - 1;
+        if (drop != last) {
+            clusters[drop] = std::move(clusters[last]);
+            for (size_t j = 0; j < clusters.size(); j++) {
+                distance(drop, j) = distance(last, j);
+                distance(j, drop) = distance(j, last);
+            }
+            distance(drop, drop) = 0.0f;
+            if (keep == last) keep = drop;
+        }
+        clusters.pop_back();
+        updateCentroid(keep);
+    }
+
+    int maxClusters;
+    float threshold;
+    size_t stride;
+    std::vector<float> distances;
+    std::vector<Cluster> clusters;
+    std::vector<int> parent;
+};
+
+} // namespace
+
+Diarizer::Diarizer(const DiarizationOptions& options) : options(options) {
+}
+
+std::vector<SpeakerTurn> Diarizer::analyze(const float* pcmf32, size_t n_samples) const {
+    std::vector<SpeakerTurn> turns;
+    if (n_samples < static_cast<size_t>(kFrameLength)) {
+        return turns;
+    }
+
+    // 1. 逐帧能量, 门限区分语音 / 静音 (噪声底取 10% 分位)
+    const int nFrames = static_cast<int>(1 + (n_samples - kFrameLength) / kFrameShift);
+    std::vector<float> energy(nFrames);
+    for (int f = 0; f < nFrames; f++) {
+        energy[f] = frameEnergy(pcmf32 + static_cast<size_t>(f) * kFrameShift);
+    }
+    std::vector<float> sorted(energy);
+    std::nth_element(sorted.begin(), sorted.begin() + nFrames / 10, sorted.end());
+    const float speechThreshold = sorted[nFrames / 10] + kEnergyMargin;
+    sorted = std::vector<float>();
+
+    // 2. 每个窗口内语音帧的 log-mel 均值 / 标准差作为嵌入
+    // log-mel 只保留当前窗口的帧 (环形缓冲, 每帧仍只计算一次), 内存与音频长度无关
+    FeatureExtractor extractor;
+    std::vector<float> logMel(static_cast<size_t>(kWindowFrames) * kMelBands);
+    int computed = 0;       // 已计算 log-mel 的帧数
+    std::vector<float> embeddings;
+    std::vector<int> windowStart;
+    float sum[kMelBands];
+    float sumSq[kMelBands];
+    for (int start = 0; start < nFrames; start += kWindowShift) {
+        const int end = std::min(start + kWindowFrames, nFrames);
+        if (end - start < kWindowShift && start > 0) break;
+        for (; computed < end; computed++) {
+            if (energy[computed] < speechThreshold) continue;
+            extractor.compute(pcmf32 + static_cast<size_t>(computed) * kFrameShift,
+                              logMel.data() + static_cast<size_t>(computed % kWindowFrames) * kMelBands);
+        }
+        std::fill(sum, sum + kMelBands, 0.0f);
+        std::fill(sumSq, sumSq + kMelBands, 0.0f);
+        int speechFrames = 0;
+        for (int f = start; f < end; f++) {
+            if (energy[f] < speechThreshold) continue;
+            const float* mel = logMel.data() + static_cast<size_t>(f % kWindowFrames) * kMelBands;
+            for (int b = 0; b < kMelBands; b++) {
+                sum[b] += mel[b];
+                sumSq[b] += mel[b] * mel[b];
+            }
+            speechFrames++;
+        }
+        if (speechFrames == 0 || speechFrames < kMinSpeechRatio * (end - start)) {
+            continue;
+        }
+
+        const float inv = 1.0f / speechFrames;
+        size_t offset = embeddings.size();
+        embeddings.resize(offset + kEmbeddingDim);
+        float* emb = embeddings.data() + offset;
+        for (int b = 0; b < kMelBands; b++) {
+            float mean = sum[b] * inv;
+            emb[b] = mean;
+            emb[kMelBands + b] = std::sqrt(std::max(0.0f, sumSq[b] * inv - mean * mean));
+        }
+        windowStart.push_back(start);
+    }
+
+    const size_t nWindows = windowStart.size();
+    if (nWindows == 0) {
+        return turns;
+    }
+
+    // 3. 全局标准化 (去除信道影响) 后 L2 归一化
+    std::vector<float> mean(kEmbeddingDim, 0.0f);
+    std::vector<float> var(kEmbeddingDim, 0.0f);
+    for (size_t w = 0; w < nWindows; w++) {
+        const float* emb = embeddings.data() + w * kEmbeddingDim;
+        for (int i = 0; i < kEmbeddingDim; i++) mean[i] += emb[i];
+    }
+    for (int i = 0; i < kEmbeddingDim; i++) mean[i] /= nWindows;
+    for (size_t w = 0; w < nWindows; w++) {
+        const float* emb = embeddings.data() + w * kEmbeddingDim;
+        for (int i = 0; i < kEmbeddingDim; i++) {
+            float d = emb[i] - mean[i];
+            var[i] += d * d;
+        }
+    }
+    for (int i = 0; i < kEmbeddingDim; i++) {
+        var[i] = 1.0f / std::sqrt(var[i] / nWindows + 1e-6f);
+    }
+    for (size_t w = 0; w < nWindows; w++) {
+        float* emb = embeddings.data() + w * kEmbeddingDim;
+        for (int i = 0; i < kEmbeddingDim; i++) emb[i] = (emb[i] - mean[i]) * var[i];
+        float norm = std::sqrt(dot(emb, emb, kEmbeddingDim));
+        float scale = norm > 0.0f ? 1.0f / norm : 0.0f;
+        for (int i = 0; i < kEmbeddingDim; i++) emb[i] *= scale;
+    }
+
+    // 4. 增量聚类
+    IncrementalClusterer clusterer(options.maxClusters, options.threshold);
+    std::vector<int> labels(nWindows);
+    for (size_t w = 0; w < nWindows; w++) {
+        labels[w] = clusterer.add(embeddings.data() + w * kEmbeddingDim);
+    }
+    clusterer.finalize(options.maxSpeakers);
+
+    // 5. 按首次出现顺序编号, 相邻同一说话人的窗口合并为区间
+    std::vector<int> speakerOfRoot;
+    int nextSpeaker = 0;
+    const double frameSeconds = static_cast<double>(kFrameShift) / kSampleRate;
+    for (size_t w = 0; w < nWindows; w++) {
+        int root = clusterer.resolve(labels[w]);
+        if (root >= static_cast<int>(speakerOfRoot.size())) speakerOfRoot.resize(root + 1, -1);
+        if (speakerOfRoot[root] < 0) speakerOfRoot[root] = nextSpeaker++;
+        int speaker = speakerOfRoot[root];
+
+        // 每个窗口负责其步长范围, 最后一个窗口延伸到窗口末尾
+        int endFrame = w + 1 < nWindows ? windowStart[w] + kWindowShift
+                                        : std::min(windowStart[w] + kWindowFrames, nFrames);
+        double startTime = windowStart[w] * frameSeconds;
+        double endTime = endFrame * frameSeconds;
+
+        if (!turns.empty() && turns.back().speaker == speaker &&
+            startTime - turns.back().endTime <= kWindowShift * frameSeconds) {
+            turns.back().endTime = endTime;
+        } else {
+            turns.push_back({startTime, endTime, speaker});
+        }
+    }
+
+    return turns;
+}
+
+void assignSpeakers(std::vector<TranscriptSegment>& segments, const std::vector<SpeakerTurn>& turns) {
+    if (turns.empty()) {
+        return;
+    }
+
+    int nSpeakers = 0;
+    for (const SpeakerTurn& turn : turns) nSpeakers = std::max(nSpeakers, turn.speaker + 1);
+    std::vector<double> overlap(nSpeakers);
+
+    for (TranscriptSegment& segment : segments) {
+        std::fill(overlap.begin(), overlap.end(), 0.0);
+
+        // 区间按时间排序且互不重叠, 二分找到第一个可能重叠的区间
+        auto it = std::lower_bound(turns.begin(), turns.end(), segment.startTime,
+                                   [](const SpeakerTurn& turn, double t) { return turn.endTime <= t; });
+        for (; it != turns.end() && it->startTime < segment.endTime; ++it) {
+            double o = std::min(it->endTime, segment.endTime) - std::max(it->startTime, segment.startTime);
+            if (o > 0.0) overlap[it->speaker] += o;
+        }
+
+        int best = -1;
+        double bestOverlap = 0.0;
+        for (int s = 0; s < nSpeakers; s++) {
+            if (overlap[s] > bestOverlap) {
+                bestOverlap = overlap[s];
+                best = s;
+            }
+        }
+        segment.speaker = best;
+    }
+}
+
+} // namespace llwhisper
@@ -0,0 +1,368 @@
+#include "../include/ffmpeg_context_pool.h"
+#include <utility>
+
+namespace llvideo {
+
+namespace {
+
+// FNV-1a 64 位哈希, 用于生成池的 key
+class KeyBuilder {
+public:
+    template <typename T>
+    KeyBuilder& add(const T& value) {
+        return addBytes(&value, sizeof(value));
+    }
+
+    KeyBuilder& addBytes(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return *this;
+    }
+
+    KeyBuilder& addLayout(const AVChannelLayout* layout) {
+        add(static_cast<int>(layout->order));
+        add(layout->nb_channels);
+        return add(layout->u.mask);
+    }
+
+    uint64_t value() const { return hash; }
+
+private:
+    uint64_t hash = 14695981039346656037ULL;
+};
+
+} // namespace
+
+std::string ffmpegErrorString(int errorCode) {
+    char errBuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errorCode, errBuf, sizeof(errBuf));
+    return std::string(errBuf);
+}
+
+InputFormatPtr openInput(const std::string& path, AVDictionary** options, int* errorCode) {
+    AVFormatContext* formatCtx = nullptr;
+    int ret = avformat_open_input(&formatCtx, path.c_str(), nullptr, options);
+    if (errorCode) *errorCode = ret;
+    if (ret < 0) {
+        return InputFormatPtr();
+    }
+    return InputFormatPtr(formatCtx);
+}
+
+// ============================================================================
+// PooledDecoder
+// ============================================================================
+PooledDecoder::PooledDecoder(ContextPool* pool, uint64_t key, AVCodecContext* ctx)
+    : pool(pool), key(key), ctx(ctx) {
+}
+
+PooledDecoder::PooledDecoder(PooledDecoder&& other) noexcept
+    : pool(other.pool), key(other.key), ctx(other.ctx) {
+    other.ctx = nullptr;
+}
+
+PooledDecoder& PooledDecoder::operator=(PooledDecoder&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        key = other.key;
+        ctx = other.ctx;
+        other.ctx = nullptr;
+    }
+    return *this;
+}
+
+PooledDecoder::~PooledDecoder() {
+    release();
+}
+
+void PooledDecoder::discard() {
+    if (ctx) avcodec_free_context(&ctx);
+}
+
+void PooledDecoder::release() {
+    if (!ctx) return;
+    if (pool) {
+        pool->releaseDecoder(key, ctx);
+    } else {
+        avcodec_free_context(&ctx);
+    }
+    ctx = nullptr;
+}
+
+// ============================================================================
+// PooledResampler
+// ============================================================================
+PooledResampler::PooledResampler(ContextPool* pool, uint64_t key, SwrContext* ctx)
+    : pool(pool), key(key), ctx(ctx) {
+}
+
+PooledResampler::PooledResampler(PooledResampler&& other) noexcept
+    : pool(other.pool), key(other.key), ctx(other.ctx) {
+    other.ctx = nullptr;
+}
+
+PooledResampler& PooledResampler::operator=(PooledResampler&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        key = other.key;
+        ctx = other.ctx;
+        other.ctx = nullptr;
+    }
+    return *this;
+}
+
+PooledResampler::~PooledResampler() {
+    release();
+}
+
+void PooledResampler::discard() {
+    if (ctx) swr_free(&ctx);
+}
+
+void PooledResampler::release() {
+    if (!ctx) return;
+    if (pool) {
+        pool->releaseResampler(key, ctx);
+    } else {
+        swr_free(&ctx);
+    }
+    ctx = nullptr;
+}
+
+// ============================================================================
+// ContextPool
+// ============================================================================
+ContextPool& ContextPool::instance() {
+    static ContextPool pool;
+    return pool;
+}
+
+ContextPool::~ContextPool() {
+    clear();
+}
+
+PooledDecoder ContextPool::acquireDecoder(const AVCodecParameters* codecpar, int* errorCode) {
+    if (errorCode) *errorCode = 0;
+
+    KeyBuilder kb;
+    kb.add(static_cast<int>(codecpar->codec_id))
+      .add(codecpar->codec_tag)
+      .add(codecpar->format)
+      .add(codecpar->sample_rate)
+      .add(codecpar->block_align)
+      .add(codecpar->bits_per_coded_sample)
+      .addLayout(&codecpar->ch_layout);
+    if (codecpar->extradata && codecpar->extradata_size > 0) {
+        kb.addBytes(codecpar->extradata, codecpar->extradata_size);
+    }
+    uint64_t key = kb.value();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (enabled) {
+            auto it = idleDecoders.find(key);
+            if (it != idleDecoders.end() && !it->second.empty()) {
+                AVCodecContext* ctx = it->second.back();
+                it->second.pop_back();
+                stats.decoderHits++;
+                return PooledDecoder(this, key, ctx);
+            }
+        }
+        stats.decoderMisses++;
+    }
+
+    const AVCodec* decoder = avcodec_find_decoder(codecpar->codec_id);
+    if (!decoder) {
+        if (errorCode) *errorCode = AVERROR_DECODER_NOT_FOUND;
+        return PooledDecoder();
+    }
+
+    CodecContextPtr ctx(avcodec_alloc_context3(decoder));
+    if (!ctx) {
+        if (errorCode) *errorCode = AVERROR(ENOMEM);
+        return PooledDecoder();
+    }
+
+    int ret = avcodec_parameters_to_context(ctx.get(), codecpar);
+    if (ret >= 0) {
+        ret = avcodec_open2(ctx.get(), decoder, nullptr);
+    }
+    if (ret < 0) {
+        if (errorCode) *errorCode = ret;
+        return PooledDecoder();
+    }
+
+    return PooledDecoder(this, key, ctx.release());
+}
+
+PooledResampler ContextPool::acquireResampler(const AVChannelLayout* inLayout, AVSampleFormat inFormat, int inRate,
+                                              const AVChannelLayout* outLayout, AVSampleFormat outFormat, int outRate) {
+    KeyBuilder kb;
+    kb.addLayout(inLayout).add(static_cast<int>(inFormat)).add(inRate)
+      .addLayout(outLayout).add(static_cast<int>(outFormat)).add(outRate);
+    uint64_t key = kb.value();
+
+    SwrContext* swrCtx = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (enabled) {
+            auto it = idleResamplers.find(key);
+            if (it != idleResamplers.end() && !it->second.empty()) {
+                swrCtx = it->second.back();
+                it->second.pop_back();
+                stats.resamplerHits++;
+            }
+        }
+        if (!swrCtx) stats.resamplerMisses++;
+    }
+
+    // 空闲的重采样器在归还时已 swr_close, 参数保留, 只需重新 swr_init
+    if (!swrCtx) {
+        if (swr_alloc_set_opts2(&swrCtx, outLayout, outFormat, outRate,
+                                inLayout, inFormat, inRate, 0, nullptr) < 0) {
+            swr_free(&swrCtx);
+            return PooledResampler();
+        }
+    }
+
+    if (swr_init(swrCtx) < 0) {
+        swr_free(&swrCtx);
+        return PooledResampler();
+    }
+
+    return PooledResampler(this, key, swrCtx);
+}
+
+PacketPtr ContextPool::acquirePacket() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (enabled && !idlePackets.empty()) {
+            PacketPtr packet = std::move(idlePackets.back());
+            idlePackets.pop_back();
+            stats.packetHits++;
+            return packet;
+        }
+    }
+    return PacketPtr(av_packet_alloc());
+}
+
+void ContextPool::releasePacket(PacketPtr packet) {
+    if (!packet) return;
+    av_packet_unref(packet.get());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (enabled && idlePackets.size() < kMaxIdlePackets) {
+        idlePackets.push_back(std::move(packet));
+    }
+}
+
+FramePtr ContextPool::acquireFrame() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (enabled && !idleFrames.empty()) {
+            FramePtr frame = std::move(idleFrames.back());
+            idleFrames.pop_back();
+            stats.frameHits++;
+            return frame;
+        }
+    }
+    return FramePtr(av_frame_alloc());
+}
+
+void ContextPool::releaseFrame(FramePtr frame) {
+    if (!frame) return;
+    av_frame_unref(frame.get());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (enabled && idleFrames.size() < kMaxIdlePackets) {
+        idleFrames.push_back(std::move(frame));
+    }
+}
+
+void ContextPool::releaseDecoder(uint64_t key, AVCodecContext* ctx) {
+    // 清空内部缓冲, 下一个文件从干净状态开始解码
+    avcodec_flush_buffers(ctx);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& idle = idleDecoders[key];
+        if (enabled && idle.size() < kMaxIdlePerKey) {
+            idle.push_back(ctx);
+            return;
+        }
+    }
+    avcodec_free_context(&ctx);
+}
+
+void ContextPool::releaseResampler(uint64_t key, SwrContext* ctx) {
+    // swr_close 丢弃残留的延迟样本, 保留已设置的参数
+    swr_close(ctx);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& idle = idleResamplers[key];
+        if (enabled && idle.size() < kMaxIdlePerKey) {
+            idle.push_back(ctx);
+            return;
+        }
+    }
+    swr_free(&ctx);
+}
+
+void ContextPool::setEnabled(bool value) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        enabled = value;
+    }
+    if (!value) {
+        clear();
+    }
+}
+
+bool ContextPool::isEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return enabled;
+}
+
+void ContextPool::clear() {
+    std::unordered_map<uint64_t, std::vector<AVCodecContext*>> decoders;
+    std::unordered_map<uint64_t, std::vector<SwrContext*>> resamplers;
+    std::vector<PacketPtr> packets;
+    std::vector<FramePtr> frames;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        decoders.swap(idleDecoders);
+        resamplers.swap(idleResamplers);
+        packets.swap(idlePackets);
+        frames.swap(idleFrames);
+    }
+
+    for (auto& entry : decoders) {
+        for (AVCodecContext* ctx : entry.second) {
+            avcodec_free_context(&ctx);
+        }
+    }
+    for (auto& entry : resamplers) {
+        for (SwrContext* ctx : entry.second) {
+            swr_free(&ctx);
+        }
+    }
+}
+
+ContextPoolStats ContextPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    ContextPoolStats result = stats;
+    result.enabled = enabled;
+    result.idleDecoders = 0;
+    for (const auto& entry : idleDecoders) result.idleDecoders += entry.second.size();
+    result.idleResamplers = 0;
+    for (const auto& entry : idleResamplers) result.idleResamplers += entry.second.size();
+    return result;
+}
+
+} // namespace llvideo
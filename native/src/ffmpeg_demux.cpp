@@ -0,0 +1,191 @@
+#include "../include/ffmpeg_demux.h"
+#include "../include/ffmpeg_context_pool.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace llvideo {
+
+namespace {
+
+// 有界包队列: demux 线程写入, 解码线程读取; 空指针表示流结束
+class PacketQueue {
+public:
+    explicit PacketQueue(size_t capacity) : capacity(capacity) {}
+
+    void push(PacketPtr packet) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return packets.size() < capacity; });
+        packets.push_back(std::move(packet));
+        notEmpty.notify_one();
+    }
+
+    PacketPtr pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return !packets.empty(); });
+        PacketPtr packet = std::move(packets.front());
+        packets.pop_front();
+        notFull.notify_one();
+        return packet;
+    }
+
+private:
+    size_t capacity;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<PacketPtr> packets;
+};
+
+// 每个音频流的解码状态
+struct TrackWorker {
+    DemuxTrack* track = nullptr;
+    PooledDecoder decoder;
+    FramePtr frame;
+    bool decodeFailed = false;             // 出现过解码错误, 解码器不再回池
+    PacketQueue queue{64};
+    std::thread thread;
+};
+
+void receiveFrames(TrackWorker& worker) {
+    int ret;
+    while ((ret = avcodec_receive_frame(worker.decoder.get(), worker.frame.get())) >= 0) {
+        if (worker.track->ok && !worker.track->onFrame(worker.frame.get())) {
+            worker.track->ok = false;
+            if (worker.track->error.empty()) worker.track->error = "Failed to process decoded frame";
+        }
+        av_frame_unref(worker.frame.get());
+    }
+    worker.decodeFailed = worker.decodeFailed || isDecodeError(ret);
+}
+
+void runTrackWorker(TrackWorker& worker) {
+    ContextPool& pool = ContextPool::instance();
+
+    for (;;) {
+        PacketPtr packet = worker.queue.pop();
+        if (!packet) break;
+
+        // 出错后继续取包, 避免 demux 线程在满队列上阻塞
+        if (worker.track->ok) {
+            int ret = avcodec_send_packet(worker.decoder.get(), packet.get());
+            if (ret >= 0) {
+                receiveFrames(worker);
+            } else {
+                worker.decodeFailed = worker.decodeFailed || isDecodeError(ret);
+            }
+        }
+        pool.releasePacket(std::move(packet));
+    }
+
+    if (worker.track->ok) {
+        avcodec_send_packet(worker.decoder.get(), nullptr);
+        receiveFrames(worker);
+    }
+    if (worker.track->ok && worker.track->onFinish && !worker.track->onFinish()) {
+        worker.track->ok = false;
+    }
+    // 中途停止或出错的解码器状态不确定, 直接释放
+    if (!worker.track->ok || worker.decodeFailed) {
+        worker.decoder.discard();
+    }
+}
+
+} // namespace
+
+std::vector<int> findAudioStreams(AVFormatContext* formatCtx) {
+    std::vector<int> streams;
+    for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+        if (formatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+            streams.push_back(static_cast<int>(i));
+        }
+    }
+    return streams;
+}
+
+bool demuxAudioTracks(AVFormatContext* formatCtx, std::vector<DemuxTrack>& tracks, std::string& error) {
+    ContextPool& pool = ContextPool::instance();
+
+    // 流索引 -> worker 下标
+    std::vector<int> slotOfStream(formatCtx->nb_streams, -1);
+    std::vector<std::unique_ptr<TrackWorker>> workers;
+
+    for (DemuxTrack& track : tracks) {
+        if (track.streamIndex < 0 || track.streamIndex >= static_cast<int>(formatCtx->nb_streams) ||
+            formatCtx->streams[track.streamIndex]->codecpar->codec_type != AVMEDIA_TYPE_AUDIO) {
+            track.ok = false;
+            track.error = "Not an audio stream: " + std::to_string(track.streamIndex);
+            continue;
+        }
+        if (slotOfStream[track.streamIndex] != -1) {
+            track.ok = false;
+            track.error = "Duplicate stream: " + std::to_string(track.streamIndex);
+            continue;
+        }
+
+        auto worker = std::make_unique<TrackWorker>();
+        worker->track = &track;
+
+        int ret = 0;
+        worker->decoder = pool.acquireDecoder(formatCtx->streams[track.streamIndex]->codecpar, &ret);
+        if (!worker->decoder) {
+            track.ok = false;
+            track.error = "Cannot open decoder: " + ffmpegErrorString(ret);
+            continue;
+        }
+        if (track.onOpen && !track.onOpen(worker->decoder.get())) {
+            track.ok = false;
+            if (track.error.empty()) track.error = "Failed to prepare output";
+            worker->decoder.discard();
+            continue;
+        }
+        worker->frame = pool.acquireFrame();
+
+        slotOfStream[track.streamIndex] = static_cast<int>(workers.size());
+        workers.push_back(std::move(worker));
+    }
+
+    if (workers.empty()) {
+        error = "No decodable audio stream selected";
+        return false;
+    }
+
+    for (auto& worker : workers) {
+        TrackWorker* w = worker.get();
+        w->thread = std::thread([w] { runTrackWorker(*w); });
+    }
+
+    // 单次遍历容器, 把包分发给对应的解码线程
+    PacketPtr packet = pool.acquirePacket();
+    int ret = 0;
+    while ((ret = av_read_frame(formatCtx, packet.get())) >= 0) {
+        int slot = packet->stream_index < static_cast<int>(slotOfStream.size())
+                 ? slotOfStream[packet->stream_index] : -1;
+        if (slot >= 0) {
+            PacketPtr queued = pool.acquirePacket();
+            av_packet_move_ref(queued.get(), packet.get());
+            workers[slot]->queue.push(std::move(queued));
+        } else {
+            av_packet_unref(packet.get());
+        }
+    }
+    pool.releasePacket(std::move(packet));
+
+    for (auto& worker : workers) {
+        worker->queue.push(PacketPtr());
+    }
+    for (auto& worker : workers) {
+        worker->thread.join();
+        pool.releaseFrame(std::move(worker->frame));
+    }
+
+    if (ret != AVERROR_EOF) {
+        error = "Demux error: " + ffmpegErrorString(ret);
+        return false;
+    }
+    return true;
+}
+
+} // namespace llvideo
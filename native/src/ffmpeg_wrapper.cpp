@@ -1,7 +1,12 @@
 #include "../include/ffmpeg_wrapper.h"
+#include "../include/ffmpeg_context_pool.h"
+#include "../include/ffmpeg_demux.h"
 #include <iostream>
 #include <cstring>
 #include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -46,41 +51,72 @@ bool FFmpegWrapper::isValidMediaFile(const std::string& inputPath) {
         return false;
     }
 
-    AVFormatContext* formatCtx = nullptr;
-    int ret = avformat_open_input(&formatCtx, inputPath.c_str(), nullptr, nullptr);
-    
-    if (ret < 0) {
-        char errBuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errBuf, sizeof(errBuf));
-        setError(std::string("Cannot open file: ") + errBuf);
+    int ret = 0;
+    InputFormatPtr formatCtx = openInput(inputPath, nullptr, &ret);
+    if (!formatCtx) {
+        setError("Cannot open file: " + ffmpegErrorString(ret));
         return false;
     }
 
-    avformat_close_input(&formatCtx);
     return true;
 }
 
-VideoInfo FFmpegWrapper::getVideoInfo(const std::string& inputPath) {
-    VideoInfo info;
-    AVFormatContext* formatCtx = nullptr;
-    
-    int ret = avformat_open_input(&formatCtx, inputPath.c_str(), nullptr, nullptr);
-    if (ret < 0) {
-        char errBuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errBuf, sizeof(errBuf));
-        setError(std::string("Cannot open input file: ") + errBuf);
-        return info;
+// 读取流元数据, 不存在时返回空字符串
+static std::string metadataValue(const AVDictionary* metadata, const char* key) {
+    AVDictionaryEntry* entry = av_dict_get(metadata, key, nullptr, 0);
+    return entry ? std::string(entry->value) : std::string();
+}
+
+// 仅凭容器头无法得到关键参数时 (如 MPEG-TS / 裸流), 需要再做一次有界的流探测
+static bool needsStreamInfo(AVFormatContext* formatCtx) {
+    if (formatCtx->nb_streams == 0 || formatCtx->duration == AV_NOPTS_VALUE) {
+        return true;
     }
+    for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+        const AVCodecParameters* codecpar = formatCtx->streams[i]->codecpar;
+        if (codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+            (codecpar->sample_rate <= 0 || codecpar->ch_layout.nb_channels <= 0)) {
+            return true;
+        }
+        if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO &&
+            (codecpar->width <= 0 || codecpar->height <= 0)) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    ret = avformat_find_stream_info(formatCtx, nullptr);
-    if (ret < 0) {
-        setError("Cannot find stream information");
-        avformat_close_input(&formatCtx);
-        return info;
+// 打开并探测单个文件, 不修改 lastError (可在工作线程中调用)
+static bool probeFile(const std::string& inputPath, ProbeMode mode,
+                      int64_t probeSize, int64_t analyzeDuration,
+                      VideoInfo& info, std::string& error) {
+    AVDictionary* openOptions = nullptr;
+    if (mode == ProbeMode::Header) {
+        av_dict_set_int(&openOptions, "probesize", probeSize, 0);
+        av_dict_set_int(&openOptions, "analyzeduration", analyzeDuration, 0);
+        av_dict_set_int(&openOptions, "fpsprobesize", 0, 0);
+    }
+
+    int ret = 0;
+    InputFormatPtr formatCtx = openInput(inputPath, &openOptions, &ret);
+    av_dict_free(&openOptions);
+    if (!formatCtx) {
+        error = "Cannot open input file: " + ffmpegErrorString(ret);
+        return false;
+    }
+
+    if (mode == ProbeMode::Full || needsStreamInfo(formatCtx.get())) {
+        ret = avformat_find_stream_info(formatCtx.get(), nullptr);
+        if (ret < 0) {
+            error = "Cannot find stream information";
+            return false;
+        }
     }
 
     info.format = formatCtx->iformat->name;
-    info.duration = formatCtx->duration / (double)AV_TIME_BASE;
+    if (formatCtx->duration != AV_NOPTS_VALUE) {
+        info.duration = formatCtx->duration / (double)AV_TIME_BASE;
+    }
     info.bitrate = formatCtx->bit_rate;
 
     for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
@@ -92,7 +128,7 @@ VideoInfo FFmpegWrapper::getVideoInfo(const std::string& inputPath) {
             info.width = codecpar->width;
             info.height = codecpar->height;
             
-            AVRational frameRate = av_guess_frame_rate(formatCtx, stream, nullptr);
+            AVRational frameRate = av_guess_frame_rate(formatCtx.get(), stream, nullptr);
             if (frameRate.num && frameRate.den) {
                 info.fps = av_q2d(frameRate);
             }
@@ -102,230 +138,760 @@ VideoInfo FFmpegWrapper::getVideoInfo(const std::string& inputPath) {
                 info.videoCodec = codec->name;
             }
         }
-        else if (codecpar->codec_type == AVMEDIA_TYPE_AUDIO && !info.hasAudio) {
-            info.hasAudio = true;
-            info.audioSampleRate = codecpar->sample_rate;
-            info.audioChannels = codecpar->ch_layout.nb_channels;
+        else if (codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+            AudioStreamInfo streamInfo;
+            streamInfo.index = static_cast<int>(i);
+            streamInfo.sampleRate = codecpar->sample_rate;
+            streamInfo.channels = codecpar->ch_layout.nb_channels;
+            streamInfo.isDefault = (stream->disposition & AV_DISPOSITION_DEFAULT) != 0;
+            streamInfo.language = metadataValue(stream->metadata, "language");
+            streamInfo.title = metadataValue(stream->metadata, "title");
             
             const AVCodec* codec = avcodec_find_decoder(codecpar->codec_id);
             if (codec) {
-                info.audioCodec = codec->name;
+                streamInfo.codec = codec->name;
+            }
+            
+            if (!info.hasAudio) {
+                info.hasAudio = true;
+                info.audioSampleRate = streamInfo.sampleRate;
+                info.audioChannels = streamInfo.channels;
+                info.audioCodec = streamInfo.codec;
             }
+            info.audioStreams.push_back(streamInfo);
         }
     }
 
-    avformat_close_input(&formatCtx);
-    return info;
+    return true;
 }
 
-bool FFmpegWrapper::extractAudio(const std::string& inputPath,
-                                 const std::string& outputPath,
-                                 const AudioExtractionOptions& options,
-                                 ProgressCallback callback) {
-    AVFormatContext* inputFormatCtx = nullptr;
-    AVFormatContext* outputFormatCtx = nullptr;
-    AVCodecContext* decoderCtx = nullptr;
-    AVCodecContext* encoderCtx = nullptr;
-    SwrContext* swrCtx = nullptr;
-    
-    int ret;
-    int audioStreamIndex = -1;
-    bool success = false;
+VideoInfo FFmpegWrapper::getVideoInfo(const std::string& inputPath) {
+    return getVideoInfo(inputPath, ProbeMode::Full);
+}
 
-    // 打开输入文件
-    ret = avformat_open_input(&inputFormatCtx, inputPath.c_str(), nullptr, nullptr);
-    if (ret < 0) {
-        char errBuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errBuf, sizeof(errBuf));
-        setError(std::string("Cannot open input: ") + errBuf);
-        goto cleanup;
+VideoInfo FFmpegWrapper::getVideoInfo(const std::string& inputPath, ProbeMode mode) {
+    VideoInfo info;
+    ProbeOptions defaults;
+    std::string error;
+    if (!probeFile(inputPath, mode, defaults.probeSize, defaults.analyzeDuration, info, error)) {
+        setError(error);
+        return VideoInfo();
     }
+    return info;
+}
 
-    ret = avformat_find_stream_info(inputFormatCtx, nullptr);
-    if (ret < 0) {
-        setError("Cannot find stream info");
-        goto cleanup;
-    }
+std::vector<ProbeResult> FFmpegWrapper::probeBatch(const std::vector<std::string>& paths,
+                                                   const ProbeOptions& options) {
+    std::vector<ProbeResult> results(paths.size());
+    std::atomic<size_t> nextIndex(0);
+
+    auto worker = [&]() {
+        for (size_t i = nextIndex++; i < paths.size(); i = nextIndex++) {
+            ProbeResult& result = results[i];
+            result.path = paths[i];
+
+            std::error_code ec;
+            uintmax_t size = fs::file_size(result.path, ec);
+            if (ec) {
+                result.error = "File does not exist: " + result.path;
+                continue;
+            }
+            int64_t mtime = fs::last_write_time(result.path, ec).time_since_epoch().count();
+
+            // 完整探测的缓存结果同样满足头部探测请求
+            if (options.useCache) {
+                std::lock_guard<std::mutex> lock(probeCacheMutex);
+                auto it = probeCache.find(result.path);
+                if (it != probeCache.end() && it->second.mtime == mtime && it->second.size == size &&
+                    (it->second.mode == ProbeMode::Full || options.mode == ProbeMode::Header)) {
+                    result.ok = true;
+                    result.cached = true;
+                    result.info = it->second.info;
+                    continue;
+                }
+            }
 
-    // 查找音频流
-    for (unsigned int i = 0; i < inputFormatCtx->nb_streams; i++) {
-        if (inputFormatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
-            audioStreamIndex = i;
-            break;
+            result.ok = probeFile(result.path, options.mode, options.probeSize,
+                                  options.analyzeDuration, result.info, result.error);
+
+            if (result.ok && options.useCache) {
+                std::lock_guard<std::mutex> lock(probeCacheMutex);
+                ProbeCacheEntry& entry = probeCache[result.path];
+                entry.mtime = mtime;
+                entry.size = size;
+                entry.mode = options.mode;
+                entry.info = result.info;
+            }
         }
-    }
+    };
 
-    if (audioStreamIndex == -1) {
-        setError("No audio stream found");
-        goto cleanup;
-    }
+    size_t threadCount = options.threads > 0 ? (size_t)options.threads
+                                             : std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, paths.size());
 
-    {
-        AVStream* audioStream = inputFormatCtx->streams[audioStreamIndex];
-        AVCodecParameters* codecpar = audioStream->codecpar;
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < threadCount; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
 
-        // 打开解码器
-        const AVCodec* decoder = avcodec_find_decoder(codecpar->codec_id);
-        if (!decoder) {
-            setError("Cannot find decoder");
-            goto cleanup;
-        }
+    return results;
+}
 
-        decoderCtx = avcodec_alloc_context3(decoder);
-        avcodec_parameters_to_context(decoderCtx, codecpar);
-        
-        ret = avcodec_open2(decoderCtx, decoder, nullptr);
-        if (ret < 0) {
-            setError("Cannot open decoder");
-            goto cleanup;
-        }
+void FFmpegWrapper::clearProbeCache() {
+    std::lock_guard<std::mutex> lock(probeCacheMutex);
+    probeCache.clear();
+}
 
+// 把解码后的音频帧重采样、编码并写入输出文件
+class AudioTrackWriter {
+public:
+    bool open(const std::string& outputPath, const AudioExtractionOptions& options,
+              AVCodecContext* decoderCtx, std::string& error) {
         // 创建输出
-        avformat_alloc_output_context2(&outputFormatCtx, nullptr, 
+        AVFormatContext* rawOutputCtx = nullptr;
+        avformat_alloc_output_context2(&rawOutputCtx, nullptr,
                                        options.format.c_str(), outputPath.c_str());
+        outputFormatCtx.reset(rawOutputCtx);
         if (!outputFormatCtx) {
-            setError("Cannot create output context");
-            goto cleanup;
+            error = "Cannot create output context";
+            return false;
         }
 
         // 查找编码器
         const AVCodec* encoder = avcodec_find_encoder_by_name(options.codec.c_str());
         if (!encoder) {
-            setError("Cannot find encoder: " + options.codec);
-            goto cleanup;
+            error = "Cannot find encoder: " + options.codec;
+            return false;
+        }
+
+        outStream = avformat_new_stream(outputFormatCtx.get(), nullptr);
+        encoderCtx.reset(avcodec_alloc_context3(encoder));
+        if (!outStream || !encoderCtx) {
+            error = "Cannot allocate encoder";
+            return false;
         }
 
-        AVStream* outStream = avformat_new_stream(outputFormatCtx, nullptr);
-        encoderCtx = avcodec_alloc_context3(encoder);
-        
         encoderCtx->sample_rate = options.sampleRate;
-        encoderCtx->ch_layout.nb_channels = options.channels;
         if (options.channels == 1) {
             encoderCtx->ch_layout = AV_CHANNEL_LAYOUT_MONO;
         } else {
             encoderCtx->ch_layout = AV_CHANNEL_LAYOUT_STEREO;
         }
         encoderCtx->sample_fmt = encoder->sample_fmts[0];
-        
+
         if (outputFormatCtx->oformat->flags & AVFMT_GLOBALHEADER) {
             encoderCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
         }
 
-        ret = avcodec_open2(encoderCtx, encoder, nullptr);
+        int ret = avcodec_open2(encoderCtx.get(), encoder, nullptr);
         if (ret < 0) {
-            char errBuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(ret, errBuf, sizeof(errBuf));
-            setError(std::string("Cannot open encoder: ") + errBuf);
-            goto cleanup;
+            error = "Cannot open encoder: " + ffmpegErrorString(ret);
+            return false;
         }
 
-        avcodec_parameters_from_context(outStream->codecpar, encoderCtx);
+        avcodec_parameters_from_context(outStream->codecpar, encoderCtx.get());
         outStream->time_base = encoderCtx->time_base;
 
-        // 创建重采样器
-        swr_alloc_set_opts2(&swrCtx,
-                           &encoderCtx->ch_layout,
-                           encoderCtx->sample_fmt,
-                           encoderCtx->sample_rate,
-                           &decoderCtx->ch_layout,
-                           decoderCtx->sample_fmt,
-                           decoderCtx->sample_rate,
-                           0, nullptr);
-        swr_init(swrCtx);
+        // 创建重采样器 (从池中复用)
+        swrCtx = ContextPool::instance().acquireResampler(
+            &decoderCtx->ch_layout, decoderCtx->sample_fmt, decoderCtx->sample_rate,
+            &encoderCtx->ch_layout, encoderCtx->sample_fmt, encoderCtx->sample_rate);
+        if (!swrCtx) {
+            error = "Cannot initialize resampler";
+            return false;
+        }
 
         // 打开输出文件
         if (!(outputFormatCtx->oformat->flags & AVFMT_NOFILE)) {
             ret = avio_open(&outputFormatCtx->pb, outputPath.c_str(), AVIO_FLAG_WRITE);
             if (ret < 0) {
-                setError("Cannot open output file");
-                goto cleanup;
+                error = "Cannot open output file";
+                return false;
             }
         }
 
-        avformat_write_header(outputFormatCtx, nullptr);
+        ret = avformat_write_header(outputFormatCtx.get(), nullptr);
+        if (ret < 0) {
+            error = "Cannot write header: " + ffmpegErrorString(ret);
+            return false;
+        }
 
-        // 处理音频帧
-        AVPacket* packet = av_packet_alloc();
-        AVFrame* frame = av_frame_alloc();
-        AVFrame* outFrame = av_frame_alloc();
+        outPkt = ContextPool::instance().acquirePacket();
+        outFrame = ContextPool::instance().acquireFrame();
+        return true;
+    }
 
+    // 重采样并编码一帧; frame 为空时冲刷重采样器中的剩余样本
+    // 重采样 / 编码 / 写入失败 (磁盘已满、muxer 出错等) 时返回 false
+    bool writeFrame(const AVFrame* frame, std::string& error) {
+        // 每次由 swr_convert_frame 按实际样本数分配缓冲, 编码器可安全持有上一帧的引用
+        av_frame_unref(outFrame.get());
         outFrame->format = encoderCtx->sample_fmt;
-        outFrame->ch_layout = encoderCtx->ch_layout;
+        av_channel_layout_copy(&outFrame->ch_layout, &encoderCtx->ch_layout);
         outFrame->sample_rate = encoderCtx->sample_rate;
-        outFrame->nb_samples = encoderCtx->frame_size > 0 ? encoderCtx->frame_size : 1024;
-        av_frame_get_buffer(outFrame, 0);
-
-        double totalDuration = inputFormatCtx->duration / (double)AV_TIME_BASE;
-
-        while (av_read_frame(inputFormatCtx, packet) >= 0) {
-            if (packet->stream_index == audioStreamIndex) {
-                ret = avcodec_send_packet(decoderCtx, packet);
-                
-                while (ret >= 0) {
-                    ret = avcodec_receive_frame(decoderCtx, frame);
-                    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) break;
-                    if (ret < 0) break;
-
-                    // 重采样
-                    swr_convert_frame(swrCtx, outFrame, frame);
-
-                    // 编码
-                    avcodec_send_frame(encoderCtx, outFrame);
-                    AVPacket* outPkt = av_packet_alloc();
-                    while (avcodec_receive_packet(encoderCtx, outPkt) >= 0) {
-                        outPkt->stream_index = 0;
-                        av_packet_rescale_ts(outPkt, encoderCtx->time_base, outStream->time_base);
-                        av_interleaved_write_frame(outputFormatCtx, outPkt);
-                        av_packet_unref(outPkt);
-                    }
-                    av_packet_free(&outPkt);
-
-                    // 进度回调
-                    if (callback && totalDuration > 0) {
-                        double current = frame->pts * av_q2d(audioStream->time_base);
-                        callback((current / totalDuration) * 100.0);
-                    }
-
-                    av_frame_unref(frame);
+        int ret = swr_convert_frame(swrCtx.get(), outFrame.get(), frame);
+        if (ret < 0) {
+            error = "Resampling failed: " + ffmpegErrorString(ret);
+            return false;
+        }
+        if (outFrame->nb_samples > 0) {
+            ret = avcodec_send_frame(encoderCtx.get(), outFrame.get());
+            if (ret < 0) {
+                error = "Encoding failed: " + ffmpegErrorString(ret);
+                return false;
+            }
+            return drainEncoder(error);
+        }
+        return true;
+    }
+
+    // 冲刷重采样器与编码器并写入文件尾; 成功与否都把 packet / frame 还给池
+    bool finish(std::string& error) {
+        bool ok = writeFrame(nullptr, error);
+        if (ok) {
+            int ret = avcodec_send_frame(encoderCtx.get(), nullptr);
+            if (ret < 0) {
+                error = "Encoding failed: " + ffmpegErrorString(ret);
+                ok = false;
+            }
+        }
+        ok = ok && drainEncoder(error);
+        if (ok) {
+            int ret = av_write_trailer(outputFormatCtx.get());
+            if (ret < 0) {
+                error = "Cannot write trailer: " + ffmpegErrorString(ret);
+                ok = false;
+            }
+        }
+        ContextPool::instance().releasePacket(std::move(outPkt));
+        ContextPool::instance().releaseFrame(std::move(outFrame));
+        return ok;
+    }
+
+private:
+    // 将编码器中已产生的包全部写出
+    bool drainEncoder(std::string& error) {
+        while (true) {
+            int ret = avcodec_receive_packet(encoderCtx.get(), outPkt.get());
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+                return true;
+            }
+            if (ret < 0) {
+                error = "Encoding failed: " + ffmpegErrorString(ret);
+                return false;
+            }
+            outPkt->stream_index = outStream->index;
+            av_packet_rescale_ts(outPkt.get(), encoderCtx->time_base, outStream->time_base);
+            ret = av_interleaved_write_frame(outputFormatCtx.get(), outPkt.get());
+            av_packet_unref(outPkt.get());
+            if (ret < 0) {
+                error = "Cannot write packet: " + ffmpegErrorString(ret);
+                return false;
+            }
+        }
+    }
+
+    OutputFormatPtr outputFormatCtx;
+    CodecContextPtr encoderCtx;
+    AVStream* outStream = nullptr;
+    PooledResampler swrCtx;
+    PacketPtr outPkt;
+    FramePtr outFrame;
+};
+
+bool FFmpegWrapper::extractAudio(const std::string& inputPath,
+                                 const std::string& outputPath,
+                                 const AudioExtractionOptions& options,
+                                 ProgressCallback callback) {
+    ContextPool& pool = ContextPool::instance();
+    int ret = 0;
+
+    // 打开输入文件
+    InputFormatPtr inputFormatCtx = openInput(inputPath, nullptr, &ret);
+    if (!inputFormatCtx) {
+        setError("Cannot open input: " + ffmpegErrorString(ret));
+        return false;
+    }
+
+    ret = avformat_find_stream_info(inputFormatCtx.get(), nullptr);
+    if (ret < 0) {
+        setError("Cannot find stream info");
+        return false;
+    }
+
+    // 查找音频流
+    std::vector<int> audioStreams = findAudioStreams(inputFormatCtx.get());
+    if (audioStreams.empty()) {
+        setError("No audio stream found");
+        return false;
+    }
+
+    int audioStreamIndex = audioStreams[0];
+    AVStream* audioStream = inputFormatCtx->streams[audioStreamIndex];
+
+    // 打开解码器 (从池中复用)
+    PooledDecoder decoderCtx = pool.acquireDecoder(audioStream->codecpar, &ret);
+    if (!decoderCtx) {
+        setError(ret == AVERROR_DECODER_NOT_FOUND ? "Cannot find decoder" : "Cannot open decoder");
+        return false;
+    }
+
+    AudioTrackWriter writer;
+    std::string error;
+    if (!writer.open(outputPath, options, decoderCtx.get(), error)) {
+        setError(error);
+        decoderCtx.discard();
+        return false;
+    }
+
+    // 处理音频帧: packet / frame 在整个循环中复用
+    PacketPtr packet = pool.acquirePacket();
+    FramePtr frame = pool.acquireFrame();
+
+    double totalDuration = inputFormatCtx->duration / (double)AV_TIME_BASE;
+    bool decodeFailed = false;
+    bool writeFailed = false;
+
+    while (!writeFailed && av_read_frame(inputFormatCtx.get(), packet.get()) >= 0) {
+        if (packet->stream_index == audioStreamIndex) {
+            ret = avcodec_send_packet(decoderCtx.get(), packet.get());
+            
+            while (ret >= 0) {
+                ret = avcodec_receive_frame(decoderCtx.get(), frame.get());
+                if (ret < 0) break;
+
+                if (!writer.writeFrame(frame.get(), error)) {
+                    av_frame_unref(frame.get());
+                    writeFailed = true;
+                    break;
                 }
+
+                // 进度回调
+                if (callback && totalDuration > 0) {
+                    double current = frame->pts * av_q2d(audioStream->time_base);
+                    callback((current / totalDuration) * 100.0);
+                }
+
+                av_frame_unref(frame.get());
             }
-            av_packet_unref(packet);
+            decodeFailed = decodeFailed || isDecodeError(ret);
         }
+        av_packet_unref(packet.get());
+    }
 
-        // 刷新编码器
-        avcodec_send_frame(encoderCtx, nullptr);
-        AVPacket* outPkt = av_packet_alloc();
-        while (avcodec_receive_packet(encoderCtx, outPkt) >= 0) {
-            outPkt->stream_index = 0;
-            av_packet_rescale_ts(outPkt, encoderCtx->time_base, outStream->time_base);
-            av_interleaved_write_frame(outputFormatCtx, outPkt);
-            av_packet_unref(outPkt);
+    // 写入已失败时不再冲刷编码器 (writer 析构时释放其 packet / frame)
+    if (!writeFailed && !writer.finish(error)) {
+        writeFailed = true;
+    }
+
+    pool.releasePacket(std::move(packet));
+    pool.releaseFrame(std::move(frame));
+    if (decodeFailed) {
+        decoderCtx.discard();
+    }
+    if (writeFailed) {
+        setError(error);
+        return false;
+    }
+
+    if (callback) callback(100.0);
+    return true;
+}
+
+// 替换输出路径模板中的占位符
+static std::string expandTrackPattern(std::string pattern, int streamIndex, const std::string& language) {
+    auto replaceAll = [&pattern](const std::string& key, const std::string& value) {
+        for (size_t pos = pattern.find(key); pos != std::string::npos; pos = pattern.find(key, pos + value.size())) {
+            pattern.replace(pos, key.size(), value);
         }
-        av_packet_free(&outPkt);
+    };
+    replaceAll("{stream}", std::to_string(streamIndex));
+    replaceAll("{lang}", language.empty() ? "und" : language);
+    return pattern;
+}
 
-        av_write_trailer(outputFormatCtx);
+std::vector<AudioTrackResult> FFmpegWrapper::extractAudioTracks(const std::string& inputPath,
+                                                                const std::string& outputPattern,
+                                                                const std::vector<int>& streams,
+                                                                const AudioExtractionOptions& options) {
+    std::vector<AudioTrackResult> results;
+    int ret = 0;
+
+    InputFormatPtr inputFormatCtx = openInput(inputPath, nullptr, &ret);
+    if (!inputFormatCtx) {
+        setError("Cannot open input: " + ffmpegErrorString(ret));
+        return results;
+    }
 
-        av_frame_free(&frame);
-        av_frame_free(&outFrame);
-        av_packet_free(&packet);
+    ret = avformat_find_stream_info(inputFormatCtx.get(), nullptr);
+    if (ret < 0) {
+        setError("Cannot find stream info");
+        return results;
+    }
 
-        if (callback) callback(100.0);
-        success = true;
+    std::vector<int> selected = streams.empty() ? findAudioStreams(inputFormatCtx.get()) : streams;
+    if (selected.empty()) {
+        setError("No audio stream found");
+        return results;
     }
 
-cleanup:
-    if (decoderCtx) avcodec_free_context(&decoderCtx);
-    if (encoderCtx) avcodec_free_context(&encoderCtx);
-    if (swrCtx) swr_free(&swrCtx);
-    if (outputFormatCtx) {
-        if (!(outputFormatCtx->oformat->flags & AVFMT_NOFILE)) {
-            avio_closep(&outputFormatCtx->pb);
+    // 多条音轨时模板必须区分输出文件
+    std::string pattern = outputPattern;
+    if (selected.size() > 1 && pattern.find("{stream}") == std::string::npos) {
+        fs::path p(pattern);
+        pattern = (p.parent_path() / (p.stem().string() + ".{stream}" + p.extension().string())).string();
+    }
+
+    results.resize(selected.size());
+    std::vector<AudioTrackWriter> writers(selected.size());
+    std::vector<DemuxTrack> tracks(selected.size());
+
+    for (size_t i = 0; i < selected.size(); i++) {
+        AudioTrackResult& result = results[i];
+        result.streamIndex = selected[i];
+        if (selected[i] >= 0 && selected[i] < static_cast<int>(inputFormatCtx->nb_streams)) {
+            result.language = metadataValue(inputFormatCtx->streams[selected[i]]->metadata, "language");
+        }
+        result.outputPath = expandTrackPattern(pattern, result.streamIndex, result.language);
+
+        DemuxTrack& track = tracks[i];
+        AudioTrackWriter* writer = &writers[i];
+        track.streamIndex = selected[i];
+        track.onOpen = [writer, &track, &result, &options](AVCodecContext* decoder) {
+            return writer->open(result.outputPath, options, decoder, track.error);
+        };
+        track.onFrame = [writer, &track](AVFrame* frame) {
+            return writer->writeFrame(frame, track.error);
+        };
+        track.onFinish = [writer, &track]() {
+            return writer->finish(track.error);
+        };
+    }
+
+    std::string error;
+    bool demuxed = demuxAudioTracks(inputFormatCtx.get(), tracks, error);
+    if (!demuxed) {
+        setError(error);
+    }
+
+    for (size_t i = 0; i < results.size(); i++) {
+        results[i].ok = demuxed && tracks[i].ok;
+        results[i].error = tracks[i].ok ? error : tracks[i].error;
+    }
+
+    return results;
+}
+
+// libavcodec 文本字幕编码器需要的默认 ASS 头
+static const char* kDefaultAssHeader =
+    "[Script Info]\r\n"
+    "ScriptType: v4.00+\r\n"
+    "PlayResX: 384\r\n"
+    "PlayResY: 288\r\n"
+    "ScaledBorderAndShadow: yes\r\n"
+    "\r\n"
+    "[V4+ Styles]\r\n"
+    "Format: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, BackColour, "
+    "Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, Outline, Shadow, "
+    "Alignment, MarginL, MarginR, MarginV, Encoding\r\n"
+    "Style: Default,Arial,16,&Hffffff,&Hffffff,&H0,&H0,0,0,0,0,100,100,0,0,1,1,0,2,10,10,10,1\r\n"
+    "\r\n"
+    "[Events]\r\n"
+    "Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\r\n";
+
+// 根据输出容器选择字幕编码器名称
+static std::string pickSubtitleEncoder(const AVOutputFormat* oformat, const std::string& requested) {
+    if (!requested.empty()) {
+        return requested;
+    }
+    std::string name = oformat->name ? oformat->name : "";
+    if (name.find("mp4") != std::string::npos || name.find("mov") != std::string::npos ||
+        name.find("3gp") != std::string::npos || name == "ipod") {
+        return "mov_text";
+    }
+    if (name == "webm") {
+        return "webvtt";
+    }
+    if (name == "matroska") {
+        return "srt";
+    }
+    const AVCodec* codec = avcodec_find_encoder(oformat->subtitle_codec);
+    return codec ? codec->name : "";
+}
+
+// 输出容器能否保存附件流 (字体等); 只有 Matroska 支持, WebM 不允许附件
+static bool supportsAttachments(const AVOutputFormat* oformat) {
+    return oformat->name && strcmp(oformat->name, "matroska") == 0;
+}
+
+// 转换为 ASS 事件行: ReadOrder,Layer,Style,Name,MarginL,MarginR,MarginV,Effect,Text
+// 用户文本中的 { } 需要转义, 否则会被当作 ASS 覆盖标签解析
+static std::string toAssEvent(int readOrder, const std::string& text) {
+    std::string line = std::to_string(readOrder) + ",0,Default,,0,0,0,,";
+    line.reserve(line.size() + text.size() + 8);
+    for (char c : text) {
+        if (c == '\n') {
+            line += "\\N";
+        } else if (c == '{' || c == '}') {
+            line += '\\';
+            line += c;
+        } else if (c != '\r') {
+            line += c;
+        }
+    }
+    return line;
+}
+
+// 已编码的字幕包 (时间单位: 毫秒)
+struct EncodedCue {
+    int64_t startMs = 0;
+    int64_t durationMs = 0;
+    std::vector<uint8_t> data;
+};
+
+bool FFmpegWrapper::muxSubtitles(const std::string& videoPath,
+                                 const std::vector<SubtitleCue>& cues,
+                                 const std::string& outputPath,
+                                 const SubtitleMuxOptions& options,
+                                 ProgressCallback callback) {
+    int ret = 0;
+
+    InputFormatPtr inputFormatCtx = openInput(videoPath, nullptr, &ret);
+    if (!inputFormatCtx) {
+        setError("Cannot open input: " + ffmpegErrorString(ret));
+        return false;
+    }
+
+    ret = avformat_find_stream_info(inputFormatCtx.get(), nullptr);
+    if (ret < 0) {
+        setError("Cannot find stream info");
+        return false;
+    }
+
+    AVFormatContext* rawOutputCtx = nullptr;
+    avformat_alloc_output_context2(&rawOutputCtx, nullptr, nullptr, outputPath.c_str());
+    OutputFormatPtr outputFormatCtx(rawOutputCtx);
+    if (!outputFormatCtx) {
+        setError("Cannot create output context for: " + outputPath);
+        return false;
+    }
+
+    // 复制音视频流参数 (stream copy, 不解码)
+    // 附件流 (字体等) 也一并复制, 否则带样式的原有字幕无法正确渲染; 附件数据在 extradata 中, 没有数据包
+    const bool copyAttachments = supportsAttachments(outputFormatCtx->oformat);
+    std::vector<int> streamMap(inputFormatCtx->nb_streams, -1);
+    for (unsigned int i = 0; i < inputFormatCtx->nb_streams; i++) {
+        AVStream* inStream = inputFormatCtx->streams[i];
+        AVMediaType type = inStream->codecpar->codec_type;
+        if (type == AVMEDIA_TYPE_ATTACHMENT && !copyAttachments) {
+            continue;
+        }
+        if (type != AVMEDIA_TYPE_VIDEO && type != AVMEDIA_TYPE_AUDIO && type != AVMEDIA_TYPE_SUBTITLE &&
+            type != AVMEDIA_TYPE_ATTACHMENT) {
+            continue;
+        }
+        // 输出容器不支持的原有字幕轨 (如 MKV 中的 mov_text) 不复制, 否则写文件头会失败
+        if (type == AVMEDIA_TYPE_SUBTITLE &&
+            avformat_query_codec(outputFormatCtx->oformat, inStream->codecpar->codec_id, FF_COMPLIANCE_NORMAL) == 0) {
+            continue;
+        }
+
+        AVStream* outStream = avformat_new_stream(outputFormatCtx.get(), nullptr);
+        if (!outStream || avcodec_parameters_copy(outStream->codecpar, inStream->codecpar) < 0) {
+            setError("Cannot copy stream parameters");
+            return false;
+        }
+        outStream->codecpar->codec_tag = 0;
+        outStream->time_base = inStream->time_base;
+        outStream->disposition = inStream->disposition;
+        av_dict_copy(&outStream->metadata, inStream->metadata, 0);
+        streamMap[i] = outStream->index;
+    }
+
+    // 创建字幕编码器
+    std::string encoderName = pickSubtitleEncoder(outputFormatCtx->oformat, options.codec);
+    const AVCodec* encoder = encoderName.empty() ? nullptr : avcodec_find_encoder_by_name(encoderName.c_str());
+    if (!encoder) {
+        setError("Cannot find subtitle encoder: " + (encoderName.empty() ? std::string("(none)") : encoderName));
+        return false;
+    }
+
+    CodecContextPtr encoderCtx(avcodec_alloc_context3(encoder));
+    AVStream* subStream = avformat_new_stream(outputFormatCtx.get(), nullptr);
+    if (!encoderCtx || !subStream) {
+        setError("Cannot allocate subtitle encoder");
+        return false;
+    }
+
+    encoderCtx->time_base = AVRational{1, 1000};
+    size_t headerSize = strlen(kDefaultAssHeader);
+    encoderCtx->subtitle_header = static_cast<uint8_t*>(av_mallocz(headerSize + 1));
+    if (!encoderCtx->subtitle_header) {
+        setError("Out of memory");
+        return false;
+    }
+    memcpy(encoderCtx->subtitle_header, kDefaultAssHeader, headerSize);
+    encoderCtx->subtitle_header_size = static_cast<int>(headerSize);
+    if (outputFormatCtx->oformat->flags & AVFMT_GLOBALHEADER) {
+        encoderCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    ret = avcodec_open2(encoderCtx.get(), encoder, nullptr);
+    if (ret < 0) {
+        setError("Cannot open subtitle encoder: " + ffmpegErrorString(ret));
+        return false;
+    }
+
+    avcodec_parameters_from_context(subStream->codecpar, encoderCtx.get());
+    subStream->time_base = encoderCtx->time_base;
+    if (!options.language.empty()) {
+        av_dict_set(&subStream->metadata, "language", options.language.c_str(), 0);
+    }
+    if (!options.title.empty()) {
+        av_dict_set(&subStream->metadata, "title", options.title.c_str(), 0);
+    }
+    if (options.setDefault) {
+        subStream->disposition |= AV_DISPOSITION_DEFAULT;
+    }
+
+    // 字幕时间从 0 开始, 复制的包保留原始时间戳; start_time 不为 0 的文件 (MPEG-TS 等) 需要整体平移
+    const int64_t startOffsetMs = inputFormatCtx->start_time != AV_NOPTS_VALUE
+                                ? av_rescale_q(inputFormatCtx->start_time, AV_TIME_BASE_Q, AVRational{1, 1000}) : 0;
+
+    // 预先编码所有字幕 (文本量很小), 按开始时间排序
+    std::vector<EncodedCue> encoded;
+    encoded.reserve(cues.size());
+    std::vector<uint8_t> buffer(64 * 1024);
+    for (size_t i = 0; i < cues.size(); i++) {
+        const SubtitleCue& cue = cues[i];
+        if (cue.endTime <= cue.startTime) continue;
+
+        std::string assLine = toAssEvent(static_cast<int>(i), cue.text);
+        AVSubtitleRect rect;
+        memset(&rect, 0, sizeof(rect));
+        rect.type = SUBTITLE_ASS;
+        rect.ass = &assLine[0];
+        AVSubtitleRect* rects[1] = { &rect };
+
+        EncodedCue out;
+        out.startMs = static_cast<int64_t>(cue.startTime * 1000.0 + 0.5);
+        out.durationMs = static_cast<int64_t>(cue.endTime * 1000.0 + 0.5) - out.startMs;
+
+        AVSubtitle sub;
+        memset(&sub, 0, sizeof(sub));
+        sub.start_display_time = 0;
+        sub.end_display_time = static_cast<uint32_t>(out.durationMs);
+        sub.num_rects = 1;
+        sub.rects = rects;
+        sub.pts = out.startMs * 1000;  // AV_TIME_BASE
+
+        int size = avcodec_encode_subtitle(encoderCtx.get(), buffer.data(), static_cast<int>(buffer.size()), &sub);
+        if (size < 0) {
+            setError("Failed to encode subtitle " + std::to_string(i) + ": " + ffmpegErrorString(size));
+            return false;
+        }
+        out.data.assign(buffer.begin(), buffer.begin() + size);
+        out.startMs += startOffsetMs;
+        encoded.push_back(std::move(out));
+    }
+    std::stable_sort(encoded.begin(), encoded.end(),
+                     [](const EncodedCue& a, const EncodedCue& b) { return a.startMs < b.startMs; });
+
+    // 打开输出文件
+    if (!(outputFormatCtx->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&outputFormatCtx->pb, outputPath.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            setError("Cannot open output file: " + ffmpegErrorString(ret));
+            return false;
         }
-        avformat_free_context(outputFormatCtx);
     }
-    if (inputFormatCtx) avformat_close_input(&inputFormatCtx);
-    
-    return success;
+
+    ret = avformat_write_header(outputFormatCtx.get(), nullptr);
+    if (ret < 0) {
+        setError("Cannot write header: " + ffmpegErrorString(ret));
+        return false;
+    }
+
+    PacketPtr packet = ContextPool::instance().acquirePacket();
+    PacketPtr subPacket = ContextPool::instance().acquirePacket();
+    size_t nextCue = 0;
+
+    // 写出开始时间不晚于 untilMs 的字幕包
+    auto writeCuesUntil = [&](int64_t untilMs) -> bool {
+        for (; nextCue < encoded.size() && encoded[nextCue].startMs <= untilMs; nextCue++) {
+            const EncodedCue& cue = encoded[nextCue];
+            if (av_new_packet(subPacket.get(), static_cast<int>(cue.data.size())) < 0) {
+                return false;
+            }
+            memcpy(subPacket->data, cue.data.data(), cue.data.size());
+            subPacket->stream_index = subStream->index;
+            subPacket->pts = av_rescale_q(cue.startMs, AVRational{1, 1000}, subStream->time_base);
+            subPacket->dts = subPacket->pts;
+            subPacket->duration = av_rescale_q(cue.durationMs, AVRational{1, 1000}, subStream->time_base);
+            subPacket->flags |= AV_PKT_FLAG_KEY;
+            if (av_interleaved_write_frame(outputFormatCtx.get(), subPacket.get()) < 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    double totalDuration = inputFormatCtx->duration != AV_NOPTS_VALUE
+                         ? inputFormatCtx->duration / (double)AV_TIME_BASE : 0.0;
+    bool success = true;
+
+    while (av_read_frame(inputFormatCtx.get(), packet.get()) >= 0) {
+        int outIndex = packet->stream_index < static_cast<int>(streamMap.size())
+                     ? streamMap[packet->stream_index] : -1;
+        if (outIndex < 0) {
+            av_packet_unref(packet.get());
+            continue;
+        }
+
+        AVStream* inStream = inputFormatCtx->streams[packet->stream_index];
+        AVStream* outStream = outputFormatCtx->streams[outIndex];
+
+        // 按时间顺序穿插字幕包
+        int64_t ts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+        if (ts != AV_NOPTS_VALUE) {
+            int64_t tsMs = av_rescale_q(ts, inStream->time_base, AVRational{1, 1000});
+            if (!writeCuesUntil(tsMs)) {
+                success = false;
+                break;
+            }
+            if (callback && totalDuration > 0) {
+                callback(std::clamp((tsMs - startOffsetMs) / 10.0 / totalDuration, 0.0, 100.0));
+            }
+        }
+
+        av_packet_rescale_ts(packet.get(), inStream->time_base, outStream->time_base);
+        packet->stream_index = outIndex;
+        packet->pos = -1;
+        if (av_interleaved_write_frame(outputFormatCtx.get(), packet.get()) < 0) {
+            success = false;
+            break;
+        }
+    }
+
+    if (success) {
+        success = writeCuesUntil(INT64_MAX);
+    }
+    ContextPool::instance().releasePacket(std::move(packet));
+    ContextPool::instance().releasePacket(std::move(subPacket));
+
+    if (!success) {
+        setError("Failed to write output packets");
+        return false;
+    }
+
+    av_write_trailer(outputFormatCtx.get());
+
+    if (callback) callback(100.0);
+    return true;
 }
 
 } // namespace llvideo
@@ -0,0 +1,62 @@
+#include "fft.h"
+#include <cmath>
+#include <utility>
+
+namespace llwhisper {
+
+Fft::Fft(int size) : n(size), cosTable(size / 2), sinTable(size / 2), bitrev(size) {
+    const double pi = 3.14159265358979323846;
+    for (int k = 0; k < n / 2; k++) {
+        cosTable[k] = static_cast<float>(std::cos(2.0 * pi * k / n));
+        sinTable[k] = static_cast<float>(std::sin(2.0 * pi * k / n));
+    }
+    int bits = 0;
+    while ((1 << bits) < n) bits++;
+    for (int i = 0; i < n; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        bitrev[i] = r;
+    }
+}
+
+void Fft::forward(float* re, float* im) const {
+    for (int i = 0; i < n; i++) {
+        int j = bitrev[i];
+        if (i < j) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        const int half = len / 2;
+        const int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int k = 0; k < half; k++) {
+                const float wr = cosTable[k * step];
+                const float wi = -sinTable[k * step];
+                const int p = i + k;
+                const int q = p + half;
+                const float vr = re[q] * wr - im[q] * wi;
+                const float vi = re[q] * wi + im[q] * wr;
+                re[q] = re[p] - vr;
+                im[q] = im[p] - vi;
+                re[p] += vr;
+                im[p] += vi;
+            }
+        }
+    }
+}
+
+void Fft::inverse(float* re, float* im) const {
+    // IFFT(x) = conj(FFT(conj(x))) / N, 交换实部与虚部即可实现共轭
+    forward(im, re);
+    const float scale = 1.0f / n;
+    for (int i = 0; i < n; i++) {
+        re[i] *= scale;
+        im[i] *= scale;
+    }
+}
+
+} // namespace llwhisper
@@ -1,5 +1,7 @@
 #include <napi.h>
 #include "../include/ffmpeg_wrapper.h"
+#include "../include/ffmpeg_context_pool.h"
+#include "../include/waveform_index.h"
 
 using namespace Napi;
 
@@ -13,6 +15,31 @@ void EnsureFFmpegInitialized() {
     }
 }
 
+// 解析音频提取选项
+static void ParseExtractionOptions(const Napi::Object& opts, llvideo::AudioExtractionOptions& options) {
+    if (opts.Has("sampleRate")) {
+        options.sampleRate = opts.Get("sampleRate").As<Napi::Number>().Int32Value();
+    }
+    if (opts.Has("channels")) {
+        options.channels = opts.Get("channels").As<Napi::Number>().Int32Value();
+    }
+    if (opts.Has("codec")) {
+        options.codec = opts.Get("codec").As<Napi::String>().Utf8Value();
+    }
+    if (opts.Has("format")) {
+        options.format = opts.Get("format").As<Napi::String>().Utf8Value();
+    }
+    if (opts.Has("bitrate")) {
+        options.bitrate = opts.Get("bitrate").As<Napi::Number>().Int32Value();
+    }
+    if (opts.Has("startTime")) {
+        options.startTime = opts.Get("startTime").As<Napi::Number>().DoubleValue();
+    }
+    if (opts.Has("duration")) {
+        options.duration = opts.Get("duration").As<Napi::Number>().DoubleValue();
+    }
+}
+
 // 提取音频
 Napi::Value ExtractAudio(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
@@ -35,40 +62,134 @@ Napi::Value ExtractAudio(const Napi::CallbackInfo& info) {
     llvideo::AudioExtractionOptions options;
     
     // 解析 options 对象
+    if (info.Length() >= 3 && info[2].IsObject()) {
+        ParseExtractionOptions(info[2].As<Napi::Object>(), options);
+    }
+    
+    try {
+        EnsureFFmpegInitialized();
+        
+        bool result = ffmpegWrapper->extractAudio(inputPath, outputPath, options);
+        
+        if (!result) {
+            std::string error = ffmpegWrapper->getLastError();
+            Napi::Error::New(env, "Failed to extract audio: " + error).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        
+        return Napi::Boolean::New(env, true);
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// 单次 demux 提取多条音轨
+Napi::Value ExtractAudioTracks(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // extractAudioTracks(inputPath, outputPattern, options)
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "First two arguments must be strings").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string inputPath = info[0].As<Napi::String>().Utf8Value();
+    std::string outputPattern = info[1].As<Napi::String>().Utf8Value();
+    
+    llvideo::AudioExtractionOptions options;
+    std::vector<int> streams;
     if (info.Length() >= 3 && info[2].IsObject()) {
         Napi::Object opts = info[2].As<Napi::Object>();
+        ParseExtractionOptions(opts, options);
+        if (opts.Has("streams") && opts.Get("streams").IsArray()) {
+            Napi::Array streamsArray = opts.Get("streams").As<Napi::Array>();
+            for (uint32_t i = 0; i < streamsArray.Length(); i++) {
+                streams.push_back(streamsArray.Get(i).As<Napi::Number>().Int32Value());
+            }
+        }
+    }
+    
+    try {
+        EnsureFFmpegInitialized();
+        
+        std::vector<llvideo::AudioTrackResult> results =
+            ffmpegWrapper->extractAudioTracks(inputPath, outputPattern, streams, options);
         
-        if (opts.Has("sampleRate")) {
-            options.sampleRate = opts.Get("sampleRate").As<Napi::Number>().Int32Value();
+        if (results.empty()) {
+            std::string error = ffmpegWrapper->getLastError();
+            Napi::Error::New(env, "Failed to extract audio tracks: " + error).ThrowAsJavaScriptException();
+            return env.Null();
         }
-        if (opts.Has("channels")) {
-            options.channels = opts.Get("channels").As<Napi::Number>().Int32Value();
+        
+        Napi::Array array = Napi::Array::New(env, results.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set("streamIndex", Napi::Number::New(env, results[i].streamIndex));
+            obj.Set("language", Napi::String::New(env, results[i].language));
+            obj.Set("outputPath", Napi::String::New(env, results[i].outputPath));
+            obj.Set("ok", Napi::Boolean::New(env, results[i].ok));
+            obj.Set("error", Napi::String::New(env, results[i].error));
+            array.Set(i, obj);
         }
+        return array;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// 添加字幕轨 (音视频流直接复制)
+Napi::Value MuxSubtitles(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // muxSubtitles(videoPath, segments, outputPath, options)
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsArray() || !info[2].IsString()) {
+        Napi::TypeError::New(env, "Expected (videoPath: string, segments: array, outputPath: string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string videoPath = info[0].As<Napi::String>().Utf8Value();
+    std::string outputPath = info[2].As<Napi::String>().Utf8Value();
+    
+    Napi::Array segmentsArray = info[1].As<Napi::Array>();
+    std::vector<llvideo::SubtitleCue> cues;
+    cues.reserve(segmentsArray.Length());
+    for (uint32_t i = 0; i < segmentsArray.Length(); i++) {
+        Napi::Object obj = segmentsArray.Get(i).As<Napi::Object>();
+        llvideo::SubtitleCue cue;
+        cue.startTime = obj.Get("startTime").As<Napi::Number>().DoubleValue();
+        cue.endTime = obj.Get("endTime").As<Napi::Number>().DoubleValue();
+        cue.text = obj.Get("text").As<Napi::String>().Utf8Value();
+        cues.push_back(cue);
+    }
+    
+    llvideo::SubtitleMuxOptions options;
+    if (info.Length() >= 4 && info[3].IsObject()) {
+        Napi::Object opts = info[3].As<Napi::Object>();
+        
         if (opts.Has("codec")) {
             options.codec = opts.Get("codec").As<Napi::String>().Utf8Value();
         }
-        if (opts.Has("format")) {
-            options.format = opts.Get("format").As<Napi::String>().Utf8Value();
-        }
-        if (opts.Has("bitrate")) {
-            options.bitrate = opts.Get("bitrate").As<Napi::Number>().Int32Value();
+        if (opts.Has("language")) {
+            options.language = opts.Get("language").As<Napi::String>().Utf8Value();
         }
-        if (opts.Has("startTime")) {
-            options.startTime = opts.Get("startTime").As<Napi::Number>().DoubleValue();
+        if (opts.Has("title")) {
+            options.title = opts.Get("title").As<Napi::String>().Utf8Value();
         }
-        if (opts.Has("duration")) {
-            options.duration = opts.Get("duration").As<Napi::Number>().DoubleValue();
+        if (opts.Has("default")) {
+            options.setDefault = opts.Get("default").As<Napi::Boolean>().Value();
         }
     }
     
     try {
         EnsureFFmpegInitialized();
         
-        bool result = ffmpegWrapper->extractAudio(inputPath, outputPath, options);
+        bool result = ffmpegWrapper->muxSubtitles(videoPath, cues, outputPath, options);
         
         if (!result) {
             std::string error = ffmpegWrapper->getLastError();
-            Napi::Error::New(env, "Failed to extract audio: " + error).ThrowAsJavaScriptException();
+            Napi::Error::New(env, "Failed to mux subtitles: " + error).ThrowAsJavaScriptException();
             return env.Null();
         }
         
@@ -79,6 +200,59 @@ Napi::Value ExtractAudio(const Napi::CallbackInfo& info) {
     }
 }
 
+// 视频信息转换为 JS 对象
+static Napi::Object VideoInfoToObject(Napi::Env env, const llvideo::VideoInfo& videoInfo) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("format", Napi::String::New(env, videoInfo.format));
+    obj.Set("duration", Napi::Number::New(env, videoInfo.duration));
+    obj.Set("width", Napi::Number::New(env, videoInfo.width));
+    obj.Set("height", Napi::Number::New(env, videoInfo.height));
+    obj.Set("fps", Napi::Number::New(env, videoInfo.fps));
+    obj.Set("hasAudio", Napi::Boolean::New(env, videoInfo.hasAudio));
+    obj.Set("hasVideo", Napi::Boolean::New(env, videoInfo.hasVideo));
+    obj.Set("audioCodec", Napi::String::New(env, videoInfo.audioCodec));
+    obj.Set("videoCodec", Napi::String::New(env, videoInfo.videoCodec));
+    obj.Set("audioSampleRate", Napi::Number::New(env, videoInfo.audioSampleRate));
+    obj.Set("audioChannels", Napi::Number::New(env, videoInfo.audioChannels));
+    obj.Set("bitrate", Napi::Number::New(env, (double)videoInfo.bitrate));
+    
+    Napi::Array audioStreams = Napi::Array::New(env, videoInfo.audioStreams.size());
+    for (size_t i = 0; i < videoInfo.audioStreams.size(); i++) {
+        const llvideo::AudioStreamInfo& stream = videoInfo.audioStreams[i];
+        Napi::Object streamObj = Napi::Object::New(env);
+        streamObj.Set("index", Napi::Number::New(env, stream.index));
+        streamObj.Set("codec", Napi::String::New(env, stream.codec));
+        streamObj.Set("language", Napi::String::New(env, stream.language));
+        streamObj.Set("title", Napi::String::New(env, stream.title));
+        streamObj.Set("sampleRate", Napi::Number::New(env, stream.sampleRate));
+        streamObj.Set("channels", Napi::Number::New(env, stream.channels));
+        streamObj.Set("isDefault", Napi::Boolean::New(env, stream.isDefault));
+        audioStreams.Set(i, streamObj);
+    }
+    obj.Set("audioStreams", audioStreams);
+    return obj;
+}
+
+// 解析探测模式 ('header' | 'full'); 非字符串或未知取值返回 false, 由调用方抛出 TypeError
+static bool ParseProbeMode(const Napi::Object& opts, llvideo::ProbeMode& mode) {
+    Napi::Value modeValue = opts.Get("mode");
+    if (modeValue.IsUndefined()) {
+        return true;
+    }
+    if (!modeValue.IsString()) {
+        return false;
+    }
+    std::string value = modeValue.As<Napi::String>().Utf8Value();
+    if (value == "header") {
+        mode = llvideo::ProbeMode::Header;
+    } else if (value == "full") {
+        mode = llvideo::ProbeMode::Full;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 // 获取视频信息
 Napi::Value GetVideoInfo(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
@@ -90,32 +264,131 @@ Napi::Value GetVideoInfo(const Napi::CallbackInfo& info) {
     
     std::string inputPath = info[0].As<Napi::String>().Utf8Value();
     
+    llvideo::ProbeMode mode = llvideo::ProbeMode::Full;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+        if (!ParseProbeMode(info[1].As<Napi::Object>(), mode)) {
+            Napi::TypeError::New(env, "mode must be 'header' or 'full'").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+    
     try {
         EnsureFFmpegInitialized();
         
-        llvideo::VideoInfo videoInfo = ffmpegWrapper->getVideoInfo(inputPath);
-        
-        Napi::Object obj = Napi::Object::New(env);
-        obj.Set("format", Napi::String::New(env, videoInfo.format));
-        obj.Set("duration", Napi::Number::New(env, videoInfo.duration));
-        obj.Set("width", Napi::Number::New(env, videoInfo.width));
-        obj.Set("height", Napi::Number::New(env, videoInfo.height));
-        obj.Set("fps", Napi::Number::New(env, videoInfo.fps));
-        obj.Set("hasAudio", Napi::Boolean::New(env, videoInfo.hasAudio));
-        obj.Set("hasVideo", Napi::Boolean::New(env, videoInfo.hasVideo));
-        obj.Set("audioCodec", Napi::String::New(env, videoInfo.audioCodec));
-        obj.Set("videoCodec", Napi::String::New(env, videoInfo.videoCodec));
-        obj.Set("audioSampleRate", Napi::Number::New(env, videoInfo.audioSampleRate));
-        obj.Set("audioChannels", Napi::Number::New(env, videoInfo.audioChannels));
-        obj.Set("bitrate", Napi::Number::New(env, (double)videoInfo.bitrate));
-        
-        return obj;
+        llvideo::VideoInfo videoInfo = ffmpegWrapper->getVideoInfo(inputPath, mode);
+        return VideoInfoToObject(env, videoInfo);
     } catch (const std::exception& e) {
         Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
 }
 
+// 批量探测的后台任务
+class ProbeBatchWorker : public Napi::AsyncWorker {
+public:
+    ProbeBatchWorker(Napi::Env env, std::vector<std::string> paths, const llvideo::ProbeOptions& options)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)),
+          paths(std::move(paths)), options(options) {
+    }
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+    void Execute() override {
+        try {
+            results = ffmpegWrapper->probeBatch(paths, options);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Array array = Napi::Array::New(env, results.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            const llvideo::ProbeResult& result = results[i];
+            Napi::Object obj = VideoInfoToObject(env, result.info);
+            obj.Set("path", Napi::String::New(env, result.path));
+            obj.Set("ok", Napi::Boolean::New(env, result.ok));
+            obj.Set("cached", Napi::Boolean::New(env, result.cached));
+            obj.Set("error", Napi::String::New(env, result.error));
+            array.Set(i, obj);
+        }
+        deferred.Resolve(array);
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    std::vector<std::string> paths;
+    llvideo::ProbeOptions options;
+    std::vector<llvideo::ProbeResult> results;
+};
+
+// 批量探测媒体文件
+Napi::Value ProbeBatch(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // probeBatch(paths, options)
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected array of paths").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Array pathsArray = info[0].As<Napi::Array>();
+    std::vector<std::string> paths;
+    paths.reserve(pathsArray.Length());
+    for (uint32_t i = 0; i < pathsArray.Length(); i++) {
+        Napi::Value value = pathsArray.Get(i);
+        if (!value.IsString()) {
+            Napi::TypeError::New(env, "Paths must be strings").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        paths.push_back(value.As<Napi::String>().Utf8Value());
+    }
+    
+    llvideo::ProbeOptions options;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+        Napi::Object opts = info[1].As<Napi::Object>();
+        
+        if (!ParseProbeMode(opts, options.mode)) {
+            Napi::TypeError::New(env, "mode must be 'header' or 'full'").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (opts.Has("threads")) {
+            options.threads = opts.Get("threads").As<Napi::Number>().Int32Value();
+        }
+        if (opts.Has("probeSize")) {
+            options.probeSize = opts.Get("probeSize").As<Napi::Number>().Int64Value();
+        }
+        if (opts.Has("analyzeDuration")) {
+            options.analyzeDuration = opts.Get("analyzeDuration").As<Napi::Number>().Int64Value();
+        }
+        if (opts.Has("cache")) {
+            options.useCache = opts.Get("cache").As<Napi::Boolean>().Value();
+        }
+    }
+    
+    EnsureFFmpegInitialized();
+    
+    ProbeBatchWorker* worker = new ProbeBatchWorker(env, std::move(paths), options);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// 清空探测缓存
+Napi::Value ClearProbeCache(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    EnsureFFmpegInitialized();
+    ffmpegWrapper->clearProbeCache();
+    return Napi::Boolean::New(env, true);
+}
+
 // 检查文件是否有效
 Napi::Value IsValidMediaFile(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
@@ -149,12 +422,196 @@ Napi::Value GetLastError(const Napi::CallbackInfo& info) {
     }
 }
 
+// 启用/禁用解码器复用池
+Napi::Value SetContextPoolEnabled(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsBoolean()) {
+        Napi::TypeError::New(env, "Expected boolean argument").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    llvideo::ContextPool::instance().setEnabled(info[0].As<Napi::Boolean>().Value());
+    return Napi::Boolean::New(env, true);
+}
+
+// 获取解码器复用池统计
+Napi::Value GetContextPoolStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    llvideo::ContextPoolStats stats = llvideo::ContextPool::instance().getStats();
+    
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("enabled", Napi::Boolean::New(env, stats.enabled));
+    obj.Set("decoderHits", Napi::Number::New(env, (double)stats.decoderHits));
+    obj.Set("decoderMisses", Napi::Number::New(env, (double)stats.decoderMisses));
+    obj.Set("resamplerHits", Napi::Number::New(env, (double)stats.resamplerHits));
+    obj.Set("resamplerMisses", Napi::Number::New(env, (double)stats.resamplerMisses));
+    obj.Set("packetHits", Napi::Number::New(env, (double)stats.packetHits));
+    obj.Set("frameHits", Napi::Number::New(env, (double)stats.frameHits));
+    obj.Set("idleDecoders", Napi::Number::New(env, (double)stats.idleDecoders));
+    obj.Set("idleResamplers", Napi::Number::New(env, (double)stats.idleResamplers));
+    
+    return obj;
+}
+
+// 波形索引的基本信息
+static Napi::Object WaveformIndexToObject(Napi::Env env, const llvideo::WaveformIndex& index) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("indexPath", Napi::String::New(env, index.indexPath()));
+    obj.Set("sampleRate", Napi::Number::New(env, index.sampleRate()));
+    obj.Set("totalSamples", Napi::Number::New(env, (double)index.totalSamples()));
+    obj.Set("duration", Napi::Number::New(env, index.duration()));
+    
+    const std::vector<llvideo::WaveformLevel>& levels = index.getLevels();
+    Napi::Array levelsArray = Napi::Array::New(env, levels.size());
+    for (size_t i = 0; i < levels.size(); i++) {
+        Napi::Object level = Napi::Object::New(env);
+        level.Set("samplesPerPeak", Napi::Number::New(env, levels[i].samplesPerPeak));
+        level.Set("peaks", Napi::Number::New(env, (double)levels[i].size()));
+        levelsArray.Set(i, level);
+    }
+    obj.Set("levels", levelsArray);
+    return obj;
+}
+
+// 构建波形索引的后台任务
+class BuildWaveformIndexWorker : public Napi::AsyncWorker {
+public:
+    BuildWaveformIndexWorker(Napi::Env env, std::string mediaPath, const llvideo::WaveformIndexOptions& options)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)),
+          mediaPath(std::move(mediaPath)), options(options) {
+    }
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+    void Execute() override {
+        std::string error;
+        index = llvideo::WaveformIndex::build(mediaPath, options, error);
+        if (!index) {
+            SetError(error);
+        }
+    }
+
+    void OnOK() override {
+        deferred.Resolve(WaveformIndexToObject(Env(), *index));
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    std::string mediaPath;
+    llvideo::WaveformIndexOptions options;
+    std::shared_ptr<const llvideo::WaveformIndex> index;
+};
+
+// 构建多分辨率波形索引
+Napi::Value BuildWaveformIndex(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // buildWaveformIndex(mediaPath, levels | options)
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected string argument (mediaPath)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    llvideo::WaveformIndexOptions options;
+    if (info.Length() >= 2 && info[1].IsNumber()) {
+        options.levels = info[1].As<Napi::Number>().Int32Value();
+    } else if (info.Length() >= 2 && info[1].IsObject()) {
+        Napi::Object opts = info[1].As<Napi::Object>();
+        if (opts.Has("levels")) {
+            options.levels = opts.Get("levels").As<Napi::Number>().Int32Value();
+        }
+        if (opts.Has("samplesPerPeak")) {
+            options.samplesPerPeak = opts.Get("samplesPerPeak").As<Napi::Number>().Int32Value();
+        }
+        if (opts.Has("levelFactor")) {
+            options.levelFactor = opts.Get("levelFactor").As<Napi::Number>().Int32Value();
+        }
+        if (opts.Has("streamIndex")) {
+            options.streamIndex = opts.Get("streamIndex").As<Napi::Number>().Int32Value();
+        }
+        if (opts.Has("indexPath")) {
+            options.indexPath = opts.Get("indexPath").As<Napi::String>().Utf8Value();
+        }
+        if (opts.Has("force")) {
+            options.force = opts.Get("force").As<Napi::Boolean>().Value();
+        }
+    }
+    
+    BuildWaveformIndexWorker* worker = new BuildWaveformIndexWorker(env, info[0].As<Napi::String>().Utf8Value(), options);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// 从波形索引读取某个时间区间的峰值 (索引已在内存中时不访问磁盘)
+Napi::Value GetWaveformPeaks(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // getWaveformPeaks(indexPath, startTime, endTime, width)
+    if (info.Length() < 4 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (indexPath: string, startTime: number, endTime: number, width: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string error;
+    std::shared_ptr<const llvideo::WaveformIndex> index =
+        llvideo::WaveformIndex::open(info[0].As<Napi::String>().Utf8Value(), error);
+    if (!index) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    llvideo::WaveformRange range = index->query(info[1].As<Napi::Number>().DoubleValue(),
+                                                info[2].As<Napi::Number>().DoubleValue(),
+                                                info[3].As<Napi::Number>().Int32Value());
+    
+    Napi::Float32Array minArray = Napi::Float32Array::New(env, range.min.size());
+    Napi::Float32Array maxArray = Napi::Float32Array::New(env, range.max.size());
+    Napi::Float32Array rmsArray = Napi::Float32Array::New(env, range.rms.size());
+    std::copy(range.min.begin(), range.min.end(), minArray.Data());
+    std::copy(range.max.begin(), range.max.end(), maxArray.Data());
+    std::copy(range.rms.begin(), range.rms.end(), rmsArray.Data());
+    
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("level", Napi::Number::New(env, range.level));
+    obj.Set("samplesPerPeak", Napi::Number::New(env, range.samplesPerPeak));
+    obj.Set("sampleRate", Napi::Number::New(env, index->sampleRate()));
+    obj.Set("min", minArray);
+    obj.Set("max", maxArray);
+    obj.Set("rms", rmsArray);
+    return obj;
+}
+
+// 释放内存中的波形索引
+Napi::Value ClearWaveformCache(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    llvideo::WaveformIndex::clearCache();
+    return Napi::Boolean::New(env, true);
+}
+
 // 模块初始化
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
     exports.Set("extractAudio", Napi::Function::New(env, ExtractAudio));
+    exports.Set("extractAudioTracks", Napi::Function::New(env, ExtractAudioTracks));
+    exports.Set("muxSubtitles", Napi::Function::New(env, MuxSubtitles));
     exports.Set("getVideoInfo", Napi::Function::New(env, GetVideoInfo));
     exports.Set("isValidMediaFile", Napi::Function::New(env, IsValidMediaFile));
     exports.Set("getLastError", Napi::Function::New(env, GetLastError));
+    exports.Set("probeBatch", Napi::Function::New(env, ProbeBatch));
+    exports.Set("clearProbeCache", Napi::Function::New(env, ClearProbeCache));
+    exports.Set("setContextPoolEnabled", Napi::Function::New(env, SetContextPoolEnabled));
+    exports.Set("getContextPoolStats", Napi::Function::New(env, GetContextPoolStats));
+    exports.Set("buildWaveformIndex", Napi::Function::New(env, BuildWaveformIndex));
+    exports.Set("getWaveformPeaks", Napi::Function::New(env, GetWaveformPeaks));
+    exports.Set("clearWaveformCache", Napi::Function::New(env, ClearWaveformCache));
     return exports;
 }
 
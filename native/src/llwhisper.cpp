@@ -1,155 +1,1502 @@
 #include <napi.h>
 #include "../include/whisper_wrapper.h"
+#include "../include/subtitle_segmenter.h"
+#include "../include/audio_fingerprint.h"
+#include "../include/transcript_store.h"
 
 using namespace Napi;
 
 // Whisper Wrapper 实例
 static llwhisper::WhisperWrapper* whisperWrapper = nullptr;
 
+// 可选的计算后端选项: { backend, flash_attn, gpu_device, backend_libraries }
+static void ParseBackendOptions(const Napi::CallbackInfo& info, size_t index, llwhisper::BackendOptions& backend) {
+    if (info.Length() <= index || !info[index].IsObject()) {
+        return;
+    }
+    Napi::Object options = info[index].As<Napi::Object>();
+    if (options.Has("backend")) {
+        backend.backend = options.Get("backend").As<Napi::String>().Utf8Value();
+    }
+    if (options.Has("flash_attn")) {
+        backend.flashAttn = options.Get("flash_attn").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("gpu_device")) {
+        backend.gpuDevice = options.Get("gpu_device").As<Napi::Number>().Int32Value();
+    }
+    if (options.Has("backend_libraries") && options.Get("backend_libraries").IsArray()) {
+        Napi::Array libraries = options.Get("backend_libraries").As<Napi::Array>();
+        for (uint32_t i = 0; i < libraries.Length(); i++) {
+            backend.libraries.push_back(libraries.Get(i).As<Napi::String>().Utf8Value());
+        }
+    }
+}
+
 // 加载模型
 Napi::Value LoadModel(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
     if (info.Length() < 1 || !info[0].IsString()) {
-        Napi::TypeError::New(env, "Expected string argument").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected string argument").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string modelPath = info[0].As<Napi::String>().Utf8Value();
+    llwhisper::BackendOptions backend;
+    ParseBackendOptions(info, 1, backend);
+    
+    try {
+        if (whisperWrapper == nullptr) {
+            whisperWrapper = new llwhisper::WhisperWrapper();
+        }
+        
+        std::string error;
+        bool result = whisperWrapper->loadModel(modelPath, backend, error);
+        
+        if (!result) {
+            Napi::Error::New(env, "Failed to load model: " + error).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        
+        return Napi::Boolean::New(env, true);
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+static Napi::Object ModelVersionToObject(Napi::Env env, const llwhisper::ModelVersionInfo& version) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("version", Napi::Number::New(env, static_cast<double>(version.version)));
+    obj.Set("path", Napi::String::New(env, version.path));
+    obj.Set("draft", Napi::Boolean::New(env, version.draft));
+    obj.Set("current", Napi::Boolean::New(env, version.current));
+    obj.Set("jobs", Napi::Number::New(env, static_cast<double>(version.jobs)));
+    return obj;
+}
+
+// 在后台线程加载新版本并替换当前模型 (加载期间事件循环与进行中的作业都不受影响)
+class ReloadModelWorker : public Napi::AsyncWorker {
+public:
+    ReloadModelWorker(Napi::Env env, std::string modelPath, const llwhisper::BackendOptions& backend, bool draft)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)),
+          modelPath(std::move(modelPath)), backend(backend), draft(draft) {
+    }
+    
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+    
+protected:
+    void Execute() override {
+        std::string error;
+        bool ok = draft ? whisperWrapper->loadDraftModel(modelPath, error, &loaded)
+                        : whisperWrapper->loadModel(modelPath, backend, error, &loaded);
+        if (!ok) {
+            SetError(std::string(draft ? "Failed to load draft model: " : "Failed to load model: ") + error);
+        }
+    }
+    
+    void OnOK() override {
+        deferred.Resolve(ModelVersionToObject(Env(), loaded));
+    }
+    
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+    
+private:
+    Napi::Promise::Deferred deferred;
+    std::string modelPath;
+    llwhisper::BackendOptions backend;
+    bool draft;
+    llwhisper::ModelVersionInfo loaded;
+};
+
+Napi::Value ReloadModel(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // reloadModel(modelPath, options?) - options 同 loadModel, 另有 { draft: true } 替换草稿模型
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected string argument").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    llwhisper::BackendOptions backend;
+    ParseBackendOptions(info, 1, backend);
+    bool draft = false;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        draft = options.Has("draft") && options.Get("draft").ToBoolean().Value();
+    }
+    
+    if (whisperWrapper == nullptr) {
+        whisperWrapper = new llwhisper::WhisperWrapper();
+    }
+    ReloadModelWorker* worker = new ReloadModelWorker(env, info[0].As<Napi::String>().Utf8Value(), backend, draft);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// 当前模型版本与仍有作业在使用的旧版本
+Napi::Value GetLoadedModels(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    std::vector<llwhisper::ModelVersionInfo> versions;
+    if (whisperWrapper != nullptr) {
+        versions = whisperWrapper->getLoadedModels();
+    }
+    Napi::Array result = Napi::Array::New(env, versions.size());
+    for (size_t i = 0; i < versions.size(); i++) {
+        result.Set(static_cast<uint32_t>(i), ModelVersionToObject(env, versions[i]));
+    }
+    return result;
+}
+
+// 加载两遍模式的草稿模型
+Napi::Value LoadDraftModel(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected string argument").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string modelPath = info[0].As<Napi::String>().Utf8Value();
+    
+    try {
+        if (whisperWrapper == nullptr) {
+            whisperWrapper = new llwhisper::WhisperWrapper();
+        }
+        
+        std::string error;
+        if (!whisperWrapper->loadDraftModel(modelPath, error)) {
+            Napi::Error::New(env, "Failed to load draft model: " + error).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        
+        return Napi::Boolean::New(env, true);
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// 从 JS 参数对象读取 WhisperParams
+static void ParseWhisperParams(const Napi::Object& options, llwhisper::WhisperParams& params) {
+    if (options.Has("language")) {
+        params.language = options.Get("language").As<Napi::String>().Utf8Value();
+    }
+    if (options.Has("translate")) {
+        params.translate = options.Get("translate").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("n_threads")) {
+        params.n_threads = options.Get("n_threads").As<Napi::Number>().Int32Value();
+    }
+    if (options.Has("offset_ms")) {
+        params.offset_ms = options.Get("offset_ms").As<Napi::Number>().Int32Value();
+    }
+    if (options.Has("duration_ms")) {
+        params.duration_ms = options.Get("duration_ms").As<Napi::Number>().Int32Value();
+    }
+    if (options.Has("entropy_thold")) {
+        params.entropy_thold = options.Get("entropy_thold").As<Napi::Number>().FloatValue();
+    }
+    if (options.Has("logprob_thold")) {
+        params.logprob_thold = options.Get("logprob_thold").As<Napi::Number>().FloatValue();
+    }
+    if (options.Has("temperature")) {
+        params.temperature = options.Get("temperature").As<Napi::Number>().FloatValue();
+    }
+    if (options.Has("suppress_nst")) {
+        params.suppress_non_speech_tokens = options.Get("suppress_nst").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("best_of")) {
+        params.best_of = options.Get("best_of").As<Napi::Number>().Int32Value();
+    }
+    if (options.Has("beam_size")) {
+        params.beam_size = options.Get("beam_size").As<Napi::Number>().Int32Value();
+    }
+    if (options.Has("print_timestamps")) {
+        params.print_timestamps = options.Get("print_timestamps").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("print_progress")) {
+        params.print_progress = options.Get("print_progress").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("diarize")) {
+        params.diarize = options.Get("diarize").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("max_speakers")) {
+        params.max_speakers = options.Get("max_speakers").As<Napi::Number>().Int32Value();
+    }
+    if (options.Has("speaker_threshold")) {
+        params.speaker_threshold = options.Get("speaker_threshold").As<Napi::Number>().FloatValue();
+    }
+    if (options.Has("highpass")) {
+        params.preprocess.highpass = options.Get("highpass").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("highpass_hz")) {
+        params.preprocess.highpassHz = options.Get("highpass_hz").As<Napi::Number>().FloatValue();
+    }
+    if (options.Has("denoise")) {
+        params.preprocess.denoise = options.Get("denoise").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("denoise_strength")) {
+        params.preprocess.denoiseStrength = options.Get("denoise_strength").As<Napi::Number>().FloatValue();
+    }
+    if (options.Has("normalize")) {
+        params.preprocess.normalize = options.Get("normalize").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("target_dbfs")) {
+        params.preprocess.targetDbfs = options.Get("target_dbfs").As<Napi::Number>().FloatValue();
+    }
+    if (options.Has("stream_decode")) {
+        params.stream_decode = options.Get("stream_decode").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("chunk_seconds")) {
+        params.chunk_seconds = options.Get("chunk_seconds").As<Napi::Number>().Int32Value();
+    }
+    if (options.Has("pcm_cache")) {
+        params.pcm_cache = options.Get("pcm_cache").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("pcm_cache_dir")) {
+        params.pcm_cache_dir = options.Get("pcm_cache_dir").As<Napi::String>().Utf8Value();
+    }
+    if (options.Has("dedupe_index")) {
+        params.dedupe_index = options.Get("dedupe_index").As<Napi::String>().Utf8Value();
+    }
+    if (options.Has("dedupe_similarity")) {
+        params.dedupe_similarity = options.Get("dedupe_similarity").As<Napi::Number>().FloatValue();
+    }
+    if (options.Has("dedupe_coverage")) {
+        params.dedupe_coverage = options.Get("dedupe_coverage").As<Napi::Number>().FloatValue();
+    }
+    if (options.Has("no_context")) {
+        params.no_context = options.Get("no_context").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("initial_prompt")) {
+        params.initial_prompt = options.Get("initial_prompt").As<Napi::String>().Utf8Value();
+    }
+    if (options.Has("prompt_tokens")) {
+        Napi::Value tokens = options.Get("prompt_tokens");
+        if (tokens.IsTypedArray()) {
+            Napi::Int32Array array = tokens.As<Napi::Int32Array>();
+            params.prompt_tokens.assign(array.Data(), array.Data() + array.ElementLength());
+        } else if (tokens.IsArray()) {
+            Napi::Array array = tokens.As<Napi::Array>();
+            for (uint32_t i = 0; i < array.Length(); i++) {
+                params.prompt_tokens.push_back(array.Get(i).As<Napi::Number>().Int32Value());
+            }
+        }
+    }
+    if (options.Has("checkpoint_path")) {
+        params.checkpoint_path = options.Get("checkpoint_path").As<Napi::String>().Utf8Value();
+    }
+    if (options.Has("resume")) {
+        params.resume = options.Get("resume").As<Napi::Boolean>().Value();
+    }
+}
+
+// 读取第二个参数（语言字符串或参数对象）
+static void ParseWhisperParamsArg(const Napi::CallbackInfo& info, size_t index, llwhisper::WhisperParams& params) {
+    if (info.Length() <= index) {
+        return;
+    }
+    if (info[index].IsString()) {
+        // 简单模式：只提供语言
+        params.language = info[index].As<Napi::String>().Utf8Value();
+    } else if (info[index].IsObject()) {
+        // 完整模式：提供参数对象
+        ParseWhisperParams(info[index].As<Napi::Object>(), params);
+    }
+}
+
+// 转录片段转换为 JS 数组
+static Napi::Array SegmentsToArray(Napi::Env env, const std::vector<llwhisper::TranscriptSegment>& segments) {
+    Napi::Array result = Napi::Array::New(env, segments.size());
+    for (size_t i = 0; i < segments.size(); i++) {
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("startTime", Napi::Number::New(env, segments[i].startTime));
+        obj.Set("endTime", Napi::Number::New(env, segments[i].endTime));
+        obj.Set("text", Napi::String::New(env, segments[i].text));
+        if (segments[i].speaker >= 0) {
+            obj.Set("speakerId", Napi::Number::New(env, segments[i].speaker));
+        }
+        obj.Set("avgLogprob", Napi::Number::New(env, segments[i].avgLogprob));
+        obj.Set("noSpeechProb", Napi::Number::New(env, segments[i].noSpeechProb));
+        obj.Set("compressionRatio", Napi::Number::New(env, segments[i].compressionRatio));
+        obj.Set("lowConfidence", Napi::Boolean::New(env, segments[i].lowConfidence));
+        obj.Set("decodeTimeMs", Napi::Number::New(env, segments[i].decodeTimeMs));
+        result.Set(i, obj);
+    }
+    return result;
+}
+
+// JS 片段数组转换为 TranscriptSegment (统计字段可选, 缺省时保持默认值)
+static std::vector<llwhisper::TranscriptSegment> ArrayToSegments(const Napi::Array& array) {
+    std::vector<llwhisper::TranscriptSegment> segments;
+    segments.reserve(array.Length());
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Object obj = array.Get(i).As<Napi::Object>();
+        llwhisper::TranscriptSegment seg;
+        seg.startTime = obj.Get("startTime").As<Napi::Number>().DoubleValue();
+        seg.endTime = obj.Get("endTime").As<Napi::Number>().DoubleValue();
+        seg.text = obj.Get("text").As<Napi::String>().Utf8Value();
+        if (obj.Has("speakerId") && obj.Get("speakerId").IsNumber()) {
+            seg.speaker = obj.Get("speakerId").As<Napi::Number>().Int32Value();
+        }
+        if (obj.Has("avgLogprob") && obj.Get("avgLogprob").IsNumber()) {
+            seg.avgLogprob = obj.Get("avgLogprob").As<Napi::Number>().DoubleValue();
+        }
+        if (obj.Has("noSpeechProb") && obj.Get("noSpeechProb").IsNumber()) {
+            seg.noSpeechProb = obj.Get("noSpeechProb").As<Napi::Number>().DoubleValue();
+        }
+        if (obj.Has("compressionRatio") && obj.Get("compressionRatio").IsNumber()) {
+            seg.compressionRatio = obj.Get("compressionRatio").As<Napi::Number>().DoubleValue();
+        }
+        if (obj.Has("lowConfidence") && obj.Get("lowConfidence").IsBoolean()) {
+            seg.lowConfidence = obj.Get("lowConfidence").As<Napi::Boolean>().Value();
+        }
+        if (obj.Has("decodeTimeMs") && obj.Get("decodeTimeMs").IsNumber()) {
+            seg.decodeTimeMs = obj.Get("decodeTimeMs").As<Napi::Number>().DoubleValue();
+        }
+        segments.push_back(std::move(seg));
+    }
+    return segments;
+}
+
+// 转录音频（完整参数版本）
+Napi::Value Transcribe(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1) {
+        Napi::TypeError::New(env, "Expected at least 1 argument (audioPath)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (!info[0].IsString()) {
+        Napi::TypeError::New(env, "First argument must be a string (audioPath)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string audioPath = info[0].As<Napi::String>().Utf8Value();
+    
+    try {
+        if (whisperWrapper == nullptr || !whisperWrapper->isModelLoaded()) {
+            Napi::Error::New(env, "Model not loaded. Call loadModel first.").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        
+        llwhisper::WhisperParams params;
+        
+        // 如果提供了第二个参数（可以是字符串或对象）
+        ParseWhisperParamsArg(info, 1, params);
+        
+        std::vector<llwhisper::TranscriptSegment> segments = whisperWrapper->transcribe(audioPath, params);
+        
+        return SegmentsToArray(env, segments);
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// 流式转录: 每块确定的片段通过 onSegments 回调送回 JS 线程, 最终结果通过 Promise 返回
+class TranscribeStreamWorker : public Napi::AsyncProgressQueueWorker<llwhisper::TranscriptSegment> {
+public:
+    TranscribeStreamWorker(Napi::Env env, std::string audioPath, const llwhisper::WhisperParams& params)
+        : Napi::AsyncProgressQueueWorker<llwhisper::TranscriptSegment>(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          audioPath(std::move(audioPath)), params(params) {
+    }
+    
+    void SetSegmentCallback(const Napi::Function& callback) {
+        onSegments = Napi::Persistent(callback);
+    }
+    
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+    
+protected:
+    void Execute(const ExecutionProgress& progress) override {
+        try {
+            result = whisperWrapper->transcribeStream(audioPath, params,
+                [&progress](const std::vector<llwhisper::TranscriptSegment>& segments) {
+                    progress.Send(segments.data(), segments.size());
+                });
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+    
+    void OnProgress(const llwhisper::TranscriptSegment* segments, size_t count) override {
+        if (onSegments.IsEmpty() || count == 0) {
+            return;
+        }
+        onSegments.Call({ SegmentsToArray(Env(), std::vector<llwhisper::TranscriptSegment>(segments, segments + count)) });
+    }
+    
+    void OnOK() override {
+        deferred.Resolve(SegmentsToArray(Env(), result));
+    }
+    
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+    
+private:
+    Napi::Promise::Deferred deferred;
+    Napi::FunctionReference onSegments;
+    std::string audioPath;
+    llwhisper::WhisperParams params;
+    std::vector<llwhisper::TranscriptSegment> result;
+};
+
+// 边解码边转录（异步, 按块回调片段）
+Napi::Value TranscribeStream(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // transcribeStream(audioPath, options, onSegments)
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "First argument must be a string (audioPath)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (whisperWrapper == nullptr || !whisperWrapper->isModelLoaded()) {
+        Napi::Error::New(env, "Model not loaded. Call loadModel first.").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    llwhisper::WhisperParams params;
+    ParseWhisperParamsArg(info, 1, params);
+    
+    TranscribeStreamWorker* worker = new TranscribeStreamWorker(env, info[0].As<Napi::String>().Utf8Value(), params);
+    if (info.Length() >= 3 && info[2].IsFunction()) {
+        worker->SetSegmentCallback(info[2].As<Napi::Function>());
+    }
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// 批量转录中单个文件的完成事件
+struct BatchFileEvent {
+    size_t index = 0;
+    llwhisper::BatchFileResult result;
+};
+
+static Napi::Object BatchFileToObject(Napi::Env env, const llwhisper::BatchFileResult& file) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("path", Napi::String::New(env, file.path));
+    obj.Set("segments", SegmentsToArray(env, file.segments));
+    if (!file.error.empty()) {
+        obj.Set("error", Napi::String::New(env, file.error));
+    }
+    obj.Set("audioSeconds", Napi::Number::New(env, file.audioSeconds));
+    obj.Set("decodeMs", Napi::Number::New(env, file.decodeMs));
+    obj.Set("inferenceMs", Napi::Number::New(env, file.inferenceMs));
+    return obj;
+}
+
+// 批量转录: 每个文件完成后通过 onFile 回调送回 JS 线程, 汇总结果通过 Promise 返回
+class TranscribeBatchWorker : public Napi::AsyncProgressQueueWorker<BatchFileEvent> {
+public:
+    TranscribeBatchWorker(Napi::Env env, std::vector<std::string> files, const llwhisper::WhisperParams& params,
+                          const llwhisper::BatchOptions& options)
+        : Napi::AsyncProgressQueueWorker<BatchFileEvent>(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          files(std::move(files)), params(params), options(options) {
+    }
+    
+    void SetFileCallback(const Napi::Function& callback) {
+        onFile = Napi::Persistent(callback);
+    }
+    
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+    
+protected:
+    void Execute(const ExecutionProgress& progress) override {
+        try {
+            const bool notify = !onFile.IsEmpty();
+            result = whisperWrapper->transcribeBatch(files, params, options,
+                [&progress, notify](size_t index, const llwhisper::BatchFileResult& file) {
+                    if (!notify) return;
+                    BatchFileEvent event;
+                    event.index = index;
+                    event.result = file;
+                    progress.Send(&event, 1);
+                });
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+    
+    void OnProgress(const BatchFileEvent* events, size_t count) override {
+        if (onFile.IsEmpty()) {
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            onFile.Call({ Napi::Number::New(Env(), static_cast<double>(events[i].index)),
+                          BatchFileToObject(Env(), events[i].result) });
+        }
+    }
+    
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Array filesArray = Napi::Array::New(env, result.files.size());
+        for (size_t i = 0; i < result.files.size(); i++) {
+            filesArray.Set(i, BatchFileToObject(env, result.files[i]));
+        }
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("files", filesArray);
+        obj.Set("audioSeconds", Napi::Number::New(env, result.audioSeconds));
+        obj.Set("wallMs", Napi::Number::New(env, result.wallMs));
+        obj.Set("audioHoursPerHour", Napi::Number::New(env, result.audioHoursPerHour));
+        obj.Set("states", Napi::Number::New(env, result.states));
+        deferred.Resolve(obj);
+    }
+    
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+    
+private:
+    Napi::Promise::Deferred deferred;
+    Napi::FunctionReference onFile;
+    std::vector<std::string> files;
+    llwhisper::WhisperParams params;
+    llwhisper::BatchOptions options;
+    llwhisper::BatchResult result;
+};
+
+// 批量转录多个文件 (异步, 模型常驻, 解码与推理重叠)
+Napi::Value TranscribeBatch(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // transcribeBatch(files, options, batchOptions, onFile)
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "First argument must be an array of file paths").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (whisperWrapper == nullptr || !whisperWrapper->isModelLoaded()) {
+        Napi::Error::New(env, "Model not loaded. Call loadModel first.").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<std::string> files;
+    Napi::Array filesArray = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < filesArray.Length(); i++) {
+        files.push_back(filesArray.Get(i).As<Napi::String>().Utf8Value());
+    }
+    
+    llwhisper::WhisperParams params;
+    ParseWhisperParamsArg(info, 1, params);
+    
+    llwhisper::BatchOptions options;
+    if (info.Length() >= 3 && info[2].IsObject()) {
+        Napi::Object opts = info[2].As<Napi::Object>();
+        if (opts.Has("concurrency")) {
+            options.concurrency = opts.Get("concurrency").As<Napi::Number>().Int32Value();
+        }
+        if (opts.Has("prefetch")) {
+            options.prefetch = opts.Get("prefetch").As<Napi::Number>().Int32Value();
+        }
+    }
+    
+    TranscribeBatchWorker* worker = new TranscribeBatchWorker(env, std::move(files), params, options);
+    if (info.Length() >= 4 && info[3].IsFunction()) {
+        worker->SetFileCallback(info[3].As<Napi::Function>());
+    }
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// 两遍转录: 草稿 / 精修事件通过 onEvent 回调送回 JS 线程, 最终结果通过 Promise 返回
+class TranscribeTwoPassWorker : public Napi::AsyncProgressQueueWorker<llwhisper::TwoPassEvent> {
+public:
+    TranscribeTwoPassWorker(Napi::Env env, std::string audioPath, const llwhisper::WhisperParams& params)
+        : Napi::AsyncProgressQueueWorker<llwhisper::TwoPassEvent>(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          audioPath(std::move(audioPath)), params(params) {
+    }
+    
+    void SetEventCallback(const Napi::Function& callback) {
+        onEvent = Napi::Persistent(callback);
+    }
+    
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+    
+protected:
+    void Execute(const ExecutionProgress& progress) override {
+        try {
+            result = whisperWrapper->transcribeTwoPass(audioPath, params,
+                [&progress](const llwhisper::TwoPassEvent& event) {
+                    progress.Send(&event, 1);
+                });
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+    
+    void OnProgress(const llwhisper::TwoPassEvent* events, size_t count) override {
+        if (onEvent.IsEmpty()) {
+            return;
+        }
+        Napi::Env env = Env();
+        for (size_t i = 0; i < count; i++) {
+            const llwhisper::TwoPassEvent& event = events[i];
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set("type", Napi::String::New(env, event.kind == llwhisper::TwoPassEvent::Draft ? "draft" : "refine"));
+            obj.Set("replaceStart", Napi::Number::New(env, static_cast<double>(event.replaceStart)));
+            obj.Set("replaceCount", Napi::Number::New(env, static_cast<double>(event.replaceCount)));
+            obj.Set("segments", SegmentsToArray(env, event.segments));
+            onEvent.Call({ obj });
+        }
+    }
+    
+    void OnOK() override {
+        deferred.Resolve(SegmentsToArray(Env(), result));
+    }
+    
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+    
+private:
+    Napi::Promise::Deferred deferred;
+    Napi::FunctionReference onEvent;
+    std::string audioPath;
+    llwhisper::WhisperParams params;
+    std::vector<llwhisper::TranscriptSegment> result;
+};
+
+// 两遍转录（草稿模型 + 主模型精修）
+Napi::Value TranscribeTwoPass(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // transcribeTwoPass(audioPath, options, onEvent)
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "First argument must be a string (audioPath)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (whisperWrapper == nullptr || !whisperWrapper->isModelLoaded()) {
+        Napi::Error::New(env, "Model not loaded. Call loadModel first.").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (!whisperWrapper->isDraftModelLoaded()) {
+        Napi::Error::New(env, "Draft model not loaded. Call loadDraftModel first.").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    llwhisper::WhisperParams params;
+    ParseWhisperParamsArg(info, 1, params);
+    
+    TranscribeTwoPassWorker* worker = new TranscribeTwoPassWorker(env, info[0].As<Napi::String>().Utf8Value(), params);
+    if (info.Length() >= 3 && info[2].IsFunction()) {
+        worker->SetEventCallback(info[2].As<Napi::Function>());
+    }
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// 语言检测在后台线程运行 (只解码采样窗口并运行一次编码器)
+class DetectLanguageWorker : public Napi::AsyncWorker {
+public:
+    DetectLanguageWorker(Napi::Env env, std::string audioPath, const llwhisper::LanguageDetectOptions& options)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)),
+          audioPath(std::move(audioPath)), options(options) {
+    }
+    
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+    
+protected:
+    void Execute() override {
+        try {
+            result = whisperWrapper->detectLanguage(audioPath, options);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+    
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Object obj = Napi::Object::New(env);
+        
+        Napi::Array languages = Napi::Array::New(env, result.languages.size());
+        for (size_t i = 0; i < result.languages.size(); i++) {
+            Napi::Object lang = Napi::Object::New(env);
+            lang.Set("language", Napi::String::New(env, result.languages[i].language));
+            lang.Set("name", Napi::String::New(env, result.languages[i].name));
+            lang.Set("probability", Napi::Number::New(env, result.languages[i].probability));
+            languages.Set(i, lang);
+        }
+        Napi::Array sampleTimes = Napi::Array::New(env, result.sampleTimes.size());
+        for (size_t i = 0; i < result.sampleTimes.size(); i++) {
+            sampleTimes.Set(i, Napi::Number::New(env, result.sampleTimes[i]));
+        }
+        
+        obj.Set("language", result.languages.empty() ? env.Null() : Napi::String::New(env, result.languages[0].language));
+        obj.Set("languages", languages);
+        obj.Set("sampleTimes", sampleTimes);
+        obj.Set("duration", Napi::Number::New(env, result.durationSeconds));
+        deferred.Resolve(obj);
+    }
+    
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+    
+private:
+    Napi::Promise::Deferred deferred;
+    std::string audioPath;
+    llwhisper::LanguageDetectOptions options;
+    llwhisper::LanguageDetectResult result;
+};
+
+// 在采样窗口上检测语言
+Napi::Value DetectLanguage(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // detectLanguage(audioPath, { sampleSeconds, positions, n_threads })
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "First argument must be a string (audioPath)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (whisperWrapper == nullptr || !whisperWrapper->isModelLoaded()) {
+        Napi::Error::New(env, "Model not loaded. Call loadModel first.").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    llwhisper::LanguageDetectOptions options;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+        Napi::Object opts = info[1].As<Napi::Object>();
+        if (opts.Has("sampleSeconds")) {
+            options.sampleSeconds = opts.Get("sampleSeconds").As<Napi::Number>().DoubleValue();
+        }
+        if (opts.Has("positions") && opts.Get("positions").IsArray()) {
+            Napi::Array positions = opts.Get("positions").As<Napi::Array>();
+            for (uint32_t i = 0; i < positions.Length(); i++) {
+                options.positions.push_back(positions.Get(i).As<Napi::Number>().DoubleValue());
+            }
+        }
+        if (opts.Has("n_threads")) {
+            options.n_threads = opts.Get("n_threads").As<Napi::Number>().Int32Value();
+        }
+    }
+    
+    DetectLanguageWorker* worker = new DetectLanguageWorker(env, info[0].As<Napi::String>().Utf8Value(), options);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// 指纹查重在后台线程运行 (解码并计算指纹, 不推理)
+class FindDuplicateWorker : public Napi::AsyncWorker {
+public:
+    FindDuplicateWorker(Napi::Env env, std::string audioPath, const llwhisper::WhisperParams& params)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)),
+          audioPath(std::move(audioPath)), params(params) {
+    }
+    
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+    
+protected:
+    void Execute() override {
+        try {
+            found = whisperWrapper->findDuplicate(audioPath, params, match);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+    
+    void OnOK() override {
+        Napi::Env env = Env();
+        if (!found) {
+            deferred.Resolve(env.Null());
+            return;
+        }
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("path", Napi::String::New(env, match.path));
+        obj.Set("offsetSeconds", Napi::Number::New(env, match.offsetSeconds));
+        obj.Set("similarity", Napi::Number::New(env, match.similarity));
+        obj.Set("coverage", Napi::Number::New(env, match.coverage));
+        obj.Set("segments", SegmentsToArray(env, match.segments));
+        deferred.Resolve(obj);
+    }
+    
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+    
+private:
+    Napi::Promise::Deferred deferred;
+    std::string audioPath;
+    llwhisper::WhisperParams params;
+    llwhisper::FingerprintMatch match;
+    bool found = false;
+};
+
+// 在指纹索引中查找当前模型已转录的近似重复文件
+Napi::Value FindDuplicate(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // findDuplicate(audioPath, { dedupe_index, dedupe_similarity, dedupe_coverage, offset_ms, ... })
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsObject()) {
+        Napi::TypeError::New(env, "Expected (audioPath, options)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    llwhisper::WhisperParams params;
+    ParseWhisperParams(info[1].As<Napi::Object>(), params);
+    if (params.dedupe_index.empty()) {
+        Napi::TypeError::New(env, "options.dedupe_index is required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (whisperWrapper == nullptr) {
+        whisperWrapper = new llwhisper::WhisperWrapper();
+    }
+    FindDuplicateWorker* worker = new FindDuplicateWorker(env, info[0].As<Napi::String>().Utf8Value(), params);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// 单次 demux 转录多条音轨
+Napi::Value TranscribeTracks(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // transcribeTracks(audioPath, options)
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "First argument must be a string (audioPath)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string audioPath = info[0].As<Napi::String>().Utf8Value();
+    
+    try {
+        if (whisperWrapper == nullptr || !whisperWrapper->isModelLoaded()) {
+            Napi::Error::New(env, "Model not loaded. Call loadModel first.").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        
+        llwhisper::WhisperParams params;
+        std::vector<int> streams;
+        ParseWhisperParamsArg(info, 1, params);
+        
+        if (info.Length() >= 2 && info[1].IsObject()) {
+            Napi::Object options = info[1].As<Napi::Object>();
+            if (options.Has("streams") && options.Get("streams").IsArray()) {
+                Napi::Array streamsArray = options.Get("streams").As<Napi::Array>();
+                for (uint32_t i = 0; i < streamsArray.Length(); i++) {
+                    streams.push_back(streamsArray.Get(i).As<Napi::Number>().Int32Value());
+                }
+            }
+        }
+        
+        std::vector<llwhisper::TrackTranscript> tracks = whisperWrapper->transcribeTracks(audioPath, params, streams);
+        
+        Napi::Array result = Napi::Array::New(env, tracks.size());
+        for (size_t i = 0; i < tracks.size(); i++) {
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set("streamIndex", Napi::Number::New(env, tracks[i].streamIndex));
+            obj.Set("language", Napi::String::New(env, tracks[i].language));
+            obj.Set("segments", SegmentsToArray(env, tracks[i].segments));
+            obj.Set("error", Napi::String::New(env, tracks[i].error));
+            result.Set(i, obj);
+        }
+        
+        return result;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// 用当前模型分词 (与 initial_prompt 共用缓存), 结果可作为下一次调用的 prompt_tokens
+Napi::Value Tokenize(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "First argument must be a string (text)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (whisperWrapper == nullptr || !whisperWrapper->isModelLoaded()) {
+        Napi::Error::New(env, "Model not loaded. Call loadModel first.").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<int32_t> tokens = whisperWrapper->tokenize(info[0].As<Napi::String>().Utf8Value());
+    Napi::Int32Array result = Napi::Int32Array::New(env, tokens.size());
+    std::copy(tokens.begin(), tokens.end(), result.Data());
+    return result;
+}
+
+// 模型信息转换为 JS 对象
+static Napi::Object ModelInfoToObject(Napi::Env env, const llwhisper::ModelInfo& modelInfo) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("path", Napi::String::New(env, modelInfo.path));
+    obj.Set("ftype", Napi::Number::New(env, modelInfo.ftype));
+    obj.Set("qntVersion", Napi::Number::New(env, modelInfo.qntVersion));
+    obj.Set("nVocab", Napi::Number::New(env, modelInfo.nVocab));
+    obj.Set("nAudioState", Napi::Number::New(env, modelInfo.nAudioState));
+    obj.Set("nAudioLayer", Napi::Number::New(env, modelInfo.nAudioLayer));
+    obj.Set("nTextState", Napi::Number::New(env, modelInfo.nTextState));
+    obj.Set("nTextLayer", Napi::Number::New(env, modelInfo.nTextLayer));
+    obj.Set("nMels", Napi::Number::New(env, modelInfo.nMels));
+    obj.Set("tensorBytes", Napi::Number::New(env, static_cast<double>(modelInfo.tensorBytes)));
+    
+    Napi::Array types = Napi::Array::New(env, modelInfo.tensorTypes.size());
+    for (size_t i = 0; i < modelInfo.tensorTypes.size(); i++) {
+        const llwhisper::TensorTypeStats& stats = modelInfo.tensorTypes[i];
+        Napi::Object typeObj = Napi::Object::New(env);
+        typeObj.Set("type", Napi::String::New(env, stats.type));
+        typeObj.Set("tensors", Napi::Number::New(env, stats.tensors));
+        typeObj.Set("elements", Napi::Number::New(env, static_cast<double>(stats.elements)));
+        typeObj.Set("bytes", Napi::Number::New(env, static_cast<double>(stats.bytes)));
+        types.Set(i, typeObj);
+    }
+    obj.Set("tensorTypes", types);
+    return obj;
+}
+
+// 当前已加载模型的信息
+Napi::Value GetModelInfo(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (whisperWrapper == nullptr || !whisperWrapper->isModelLoaded()) {
+        return env.Null();
+    }
+    return ModelInfoToObject(env, whisperWrapper->getModelInfo());
+}
+
+// 已注册的计算后端与设备
+Napi::Value GetBackendInfo(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    llwhisper::BackendInfo backendInfo = whisperWrapper != nullptr && whisperWrapper->isModelLoaded()
+        ? whisperWrapper->getBackendInfo()
+        : llwhisper::queryBackends(llwhisper::BackendOptions());
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("modelLoaded", Napi::Boolean::New(env, whisperWrapper != nullptr && whisperWrapper->isModelLoaded()));
+    result.Set("backend", Napi::String::New(env, backendInfo.options.backend));
+    result.Set("flashAttn", Napi::Boolean::New(env, backendInfo.options.flashAttn));
+    result.Set("gpuDevice", Napi::Number::New(env, backendInfo.options.gpuDevice));
+    
+    Napi::Array registries = Napi::Array::New(env, backendInfo.registries.size());
+    for (size_t i = 0; i < backendInfo.registries.size(); i++) {
+        registries.Set(i, Napi::String::New(env, backendInfo.registries[i]));
+    }
+    result.Set("registries", registries);
+    
+    Napi::Array devices = Napi::Array::New(env, backendInfo.devices.size());
+    for (size_t i = 0; i < backendInfo.devices.size(); i++) {
+        const llwhisper::BackendDevice& device = backendInfo.devices[i];
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("name", Napi::String::New(env, device.name));
+        obj.Set("description", Napi::String::New(env, device.description));
+        obj.Set("type", Napi::String::New(env, device.type));
+        obj.Set("registry", Napi::String::New(env, device.registry));
+        obj.Set("memoryFree", Napi::Number::New(env, static_cast<double>(device.memoryFree)));
+        obj.Set("memoryTotal", Napi::Number::New(env, static_cast<double>(device.memoryTotal)));
+        obj.Set("active", Napi::Boolean::New(env, device.active));
+        devices.Set(i, obj);
+    }
+    result.Set("devices", devices);
+    result.Set("systemInfo", Napi::String::New(env, backendInfo.systemInfo));
+    return result;
+}
+
+// 设置内存预算: setMemoryBudget(limitBytes, queueTimeoutMs?), limitBytes 为 0 表示不限制
+// 可以在加载模型之前调用, 超出预算的模型不会被加载
+Napi::Value SetMemoryBudget(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected limitBytes (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    const double limit = info[0].As<Napi::Number>().DoubleValue();
+    const double timeout = info.Length() >= 2 && info[1].IsNumber() ? info[1].As<Napi::Number>().DoubleValue() : 0.0;
+    if (limit < 0 || timeout < 0) {
+        Napi::RangeError::New(env, "limitBytes and queueTimeoutMs must not be negative").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (whisperWrapper == nullptr) {
+        whisperWrapper = new llwhisper::WhisperWrapper();
+    }
+    whisperWrapper->setMemoryBudget(static_cast<uint64_t>(limit), static_cast<uint64_t>(timeout));
+    return env.Undefined();
+}
+
+// 按类别的内存用量转换为 JS 对象
+static Napi::Object MemoryUsageToObject(Napi::Env env, const llwhisper::MemoryUsage& usage) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("model", Napi::Number::New(env, static_cast<double>(usage.model)));
+    obj.Set("state", Napi::Number::New(env, static_cast<double>(usage.state)));
+    obj.Set("pcm", Napi::Number::New(env, static_cast<double>(usage.pcm)));
+    obj.Set("output", Napi::Number::New(env, static_cast<double>(usage.output)));
+    obj.Set("total", Napi::Number::New(env, static_cast<double>(usage.total())));
+    return obj;
+}
+
+// 常驻模型与运行中作业的内存估算 (可在作业运行时随时调用)
+Napi::Value GetMemoryStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    llwhisper::MemoryStats stats = whisperWrapper != nullptr ? whisperWrapper->getMemoryStats() : llwhisper::MemoryStats();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("limit", Napi::Number::New(env, static_cast<double>(stats.limit)));
+    result.Set("resident", MemoryUsageToObject(env, stats.resident));
+    result.Set("jobs", MemoryUsageToObject(env, stats.jobs));
+    result.Set("total", Napi::Number::New(env, static_cast<double>(stats.total)));
+    result.Set("peak", Napi::Number::New(env, static_cast<double>(stats.peak)));
+    result.Set("queued", Napi::Number::New(env, stats.queued));
+    result.Set("chunked", Napi::Number::New(env, static_cast<double>(stats.chunked)));
+    result.Set("rejected", Napi::Number::New(env, static_cast<double>(stats.rejected)));
+    
+    Napi::Array active = Napi::Array::New(env, stats.active.size());
+    for (size_t i = 0; i < stats.active.size(); i++) {
+        const llwhisper::JobMemory& job = stats.active[i];
+        Napi::Object obj = MemoryUsageToObject(env, job.usage);
+        obj.Set("id", Napi::Number::New(env, static_cast<double>(job.id)));
+        obj.Set("name", Napi::String::New(env, job.name));
+        active.Set(i, obj);
+    }
+    result.Set("active", active);
+    return result;
+}
+
+// 读取模型文件的张量类型分布 (无需加载)
+Napi::Value InspectModel(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected string argument").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string modelPath = info[0].As<Napi::String>().Utf8Value();
+    llwhisper::ModelInfo modelInfo;
+    std::string error;
+    if (!llwhisper::inspectModel(modelPath, modelInfo, error)) {
+        Napi::Error::New(env, "Failed to inspect model: " + error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return ModelInfoToObject(env, modelInfo);
+}
+
+// 后台线程量化模型
+class QuantizeModelWorker : public Napi::AsyncWorker {
+public:
+    QuantizeModelWorker(Napi::Env env, std::string srcPath, std::string dstPath, std::string type, int nThreads)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)),
+          srcPath(std::move(srcPath)), dstPath(std::move(dstPath)), type(std::move(type)), nThreads(nThreads) {
+    }
+    
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+    
+protected:
+    void Execute() override {
+        std::string error;
+        if (!llwhisper::quantizeModel(srcPath, dstPath, type, nThreads, &result, error)) {
+            SetError("Failed to quantize model: " + error);
+        }
+    }
+    
+    void OnOK() override {
+        deferred.Resolve(ModelInfoToObject(Env(), result));
+    }
+    
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+    
+private:
+    Napi::Promise::Deferred deferred;
+    std::string srcPath;
+    std::string dstPath;
+    std::string type;
+    int nThreads;
+    llwhisper::ModelInfo result;
+};
+
+// 量化模型
+Napi::Value QuantizeModel(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // quantizeModel(srcPath, dstPath, type, options)
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsString() || !info[2].IsString()) {
+        Napi::TypeError::New(env, "Expected (srcPath: string, dstPath: string, type: string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    int nThreads = 0;
+    if (info.Length() >= 4 && info[3].IsObject()) {
+        Napi::Object options = info[3].As<Napi::Object>();
+        if (options.Has("n_threads")) {
+            nThreads = options.Get("n_threads").As<Napi::Number>().Int32Value();
+        }
+    }
+    
+    QuantizeModelWorker* worker = new QuantizeModelWorker(env,
+        info[0].As<Napi::String>().Utf8Value(),
+        info[1].As<Napi::String>().Utf8Value(),
+        info[2].As<Napi::String>().Utf8Value(),
+        nThreads);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// 只解码 (含预处理) 不转录, 用于检查预处理效果与基准测试
+Napi::Value DecodeAudio(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // decodeAudio(audioPath, options)
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "First argument must be a string (audioPath)").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    std::string modelPath = info[0].As<Napi::String>().Utf8Value();
+    llwhisper::WhisperParams params;
+    ParseWhisperParamsArg(info, 1, params);
     
     try {
         if (whisperWrapper == nullptr) {
             whisperWrapper = new llwhisper::WhisperWrapper();
         }
         
-        bool result = whisperWrapper->loadModel(modelPath);
+        double decodeMs = 0.0;
+        double preprocessMs = 0.0;
+        std::vector<float> pcm = whisperWrapper->decodeAudio(info[0].As<Napi::String>().Utf8Value(), params,
+                                                             decodeMs, preprocessMs);
         
-        if (!result) {
-            Napi::Error::New(env, "Failed to load model").ThrowAsJavaScriptException();
-            return env.Null();
-        }
+        Napi::Float32Array samples = Napi::Float32Array::New(env, pcm.size());
+        std::copy(pcm.begin(), pcm.end(), samples.Data());
         
-        return Napi::Boolean::New(env, true);
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("samples", samples);
+        obj.Set("sampleRate", Napi::Number::New(env, 16000));
+        obj.Set("decodeMs", Napi::Number::New(env, decodeMs));
+        obj.Set("preprocessMs", Napi::Number::New(env, preprocessMs));
+        return obj;
     } catch (const std::exception& e) {
         Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
 }
 
-// 转录音频（完整参数版本）
-Napi::Value Transcribe(const Napi::CallbackInfo& info) {
+// 按行宽 / 行数 / 时长 / 阅读速度重新分段
+Napi::Value Resegment(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (info.Length() < 1) {
-        Napi::TypeError::New(env, "Expected at least 1 argument (audioPath)").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-    
-    if (!info[0].IsString()) {
-        Napi::TypeError::New(env, "First argument must be a string (audioPath)").ThrowAsJavaScriptException();
+    // resegment(segments, options)
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected array of segments").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    std::string audioPath = info[0].As<Napi::String>().Utf8Value();
-    
-    try {
-        if (whisperWrapper == nullptr || !whisperWrapper->isModelLoaded()) {
-            Napi::Error::New(env, "Model not loaded. Call loadModel first.").ThrowAsJavaScriptException();
-            return env.Null();
+    llwhisper::SegmentationOptions options;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+        Napi::Object opts = info[1].As<Napi::Object>();
+        if (opts.Has("maxCharsPerLine")) {
+            options.maxCharsPerLine = opts.Get("maxCharsPerLine").As<Napi::Number>().Int32Value();
         }
-        
-        llwhisper::WhisperParams params;
-        
-        // 如果提供了第二个参数（可以是字符串或对象）
-        if (info.Length() >= 2) {
-            if (info[1].IsString()) {
-                // 简单模式：只提供语言
-                params.language = info[1].As<Napi::String>().Utf8Value();
-            } else if (info[1].IsObject()) {
-                // 完整模式：提供参数对象
-                Napi::Object options = info[1].As<Napi::Object>();
-                
-                if (options.Has("language")) {
-                    params.language = options.Get("language").As<Napi::String>().Utf8Value();
-                }
-                if (options.Has("translate")) {
-                    params.translate = options.Get("translate").As<Napi::Boolean>().Value();
-                }
-                if (options.Has("n_threads")) {
-                    params.n_threads = options.Get("n_threads").As<Napi::Number>().Int32Value();
-                }
-                if (options.Has("offset_ms")) {
-                    params.offset_ms = options.Get("offset_ms").As<Napi::Number>().Int32Value();
-                }
-                if (options.Has("duration_ms")) {
-                    params.duration_ms = options.Get("duration_ms").As<Napi::Number>().Int32Value();
-                }
-                if (options.Has("entropy_thold")) {
-                    params.entropy_thold = options.Get("entropy_thold").As<Napi::Number>().FloatValue();
-                }
-                if (options.Has("logprob_thold")) {
-                    params.logprob_thold = options.Get("logprob_thold").As<Napi::Number>().FloatValue();
-                }
-                if (options.Has("temperature")) {
-                    params.temperature = options.Get("temperature").As<Napi::Number>().FloatValue();
-                }
-                if (options.Has("suppress_nst")) {
-                    params.suppress_non_speech_tokens = options.Get("suppress_nst").As<Napi::Boolean>().Value();
-                }
-                if (options.Has("best_of")) {
-                    params.best_of = options.Get("best_of").As<Napi::Number>().Int32Value();
-                }
-                if (options.Has("beam_size")) {
-                    params.beam_size = options.Get("beam_size").As<Napi::Number>().Int32Value();
-                }
-                if (options.Has("print_timestamps")) {
-                    params.print_timestamps = options.Get("print_timestamps").As<Napi::Boolean>().Value();
-                }
-                if (options.Has("print_progress")) {
-                    params.print_progress = options.Get("print_progress").As<Napi::Boolean>().Value();
-                }
-            }
+        if (opts.Has("maxCjkCharsPerLine")) {
+            options.maxCjkCharsPerLine = opts.Get("maxCjkCharsPerLine").As<Napi::Number>().Int32Value();
         }
-        
-        std::vector<llwhisper::TranscriptSegment> segments = whisperWrapper->transcribe(audioPath, params);
-        
-        Napi::Array result = Napi::Array::New(env, segments.size());
-        for (size_t i = 0; i < segments.size(); i++) {
-            Napi::Object obj = Napi::Object::New(env);
-            obj.Set("startTime", Napi::Number::New(env, segments[i].startTime));
-            obj.Set("endTime", Napi::Number::New(env, segments[i].endTime));
-            obj.Set("text", Napi::String::New(env, segments[i].text));
-            result.Set(i, obj);
+        if (opts.Has("maxLines")) {
+            options.maxLines = opts.Get("maxLines").As<Napi::Number>().Int32Value();
         }
-        
-        return result;
+        if (opts.Has("minDuration")) {
+            options.minDuration = opts.Get("minDuration").As<Napi::Number>().DoubleValue();
+        }
+        if (opts.Has("maxDuration")) {
+            options.maxDuration = opts.Get("maxDuration").As<Napi::Number>().DoubleValue();
+        }
+        if (opts.Has("maxCharsPerSecond")) {
+            options.maxCharsPerSecond = opts.Get("maxCharsPerSecond").As<Napi::Number>().DoubleValue();
+        }
+        if (opts.Has("maxCjkCharsPerSecond")) {
+            options.maxCjkCharsPerSecond = opts.Get("maxCjkCharsPerSecond").As<Napi::Number>().DoubleValue();
+        }
+        if (opts.Has("minGap")) {
+            options.minGap = opts.Get("minGap").As<Napi::Number>().DoubleValue();
+        }
+        if (opts.Has("pauseThreshold")) {
+            options.pauseThreshold = opts.Get("pauseThreshold").As<Napi::Number>().DoubleValue();
+        }
+    }
+    
+    try {
+        std::vector<llwhisper::TranscriptSegment> segments = ArrayToSegments(info[0].As<Napi::Array>());
+        return SegmentsToArray(env, llwhisper::resegment(segments, options));
     } catch (const std::exception& e) {
         Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
 }
 
-// 导出为不同格式
-Napi::Value ExportToTxt(const Napi::CallbackInfo& info) {
+// ---- 字幕编辑器的片段存储 (界面只取可见的行) ----
+
+static Napi::Object StoredSegmentToObject(Napi::Env env, const llwhisper::StoredSegment& seg, size_t index) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("index", Napi::Number::New(env, static_cast<double>(index)));
+    obj.Set("id", Napi::String::New(env, seg.id));
+    obj.Set("startTime", Napi::Number::New(env, seg.startTime));
+    obj.Set("endTime", Napi::Number::New(env, seg.endTime));
+    obj.Set("text", Napi::String::New(env, seg.text));
+    if (!seg.translatedText.empty()) {
+        obj.Set("translatedText", Napi::String::New(env, seg.translatedText));
+    }
+    if (!seg.speaker.empty()) {
+        obj.Set("speaker", Napi::String::New(env, seg.speaker));
+    }
+    return obj;
+}
+
+// 只覆盖对象中出现的字段 (创建时从空片段开始, 更新时从现有片段开始)
+static void ApplyStoredSegmentFields(const Napi::Object& obj, llwhisper::StoredSegment& seg) {
+    if (obj.Has("id") && obj.Get("id").IsString()) {
+        seg.id = obj.Get("id").As<Napi::String>().Utf8Value();
+    }
+    if (obj.Has("startTime") && obj.Get("startTime").IsNumber()) {
+        seg.startTime = obj.Get("startTime").As<Napi::Number>().DoubleValue();
+    }
+    if (obj.Has("endTime") && obj.Get("endTime").IsNumber()) {
+        seg.endTime = obj.Get("endTime").As<Napi::Number>().DoubleValue();
+    }
+    if (obj.Has("text") && obj.Get("text").IsString()) {
+        seg.text = obj.Get("text").As<Napi::String>().Utf8Value();
+    }
+    if (obj.Has("translatedText")) {
+        Napi::Value value = obj.Get("translatedText");
+        seg.translatedText = value.IsString() ? value.As<Napi::String>().Utf8Value() : std::string();
+    }
+    if (obj.Has("speaker")) {
+        Napi::Value value = obj.Get("speaker");
+        seg.speaker = value.IsString() ? value.As<Napi::String>().Utf8Value() : std::string();
+    }
+}
+
+static std::shared_ptr<llwhisper::TranscriptStore> FindTranscriptStore(Napi::Env env, const Napi::Value& key) {
+    std::string name = key.As<Napi::String>().Utf8Value();
+    std::shared_ptr<llwhisper::TranscriptStore> store = llwhisper::TranscriptStore::get(name);
+    if (!store) {
+        Napi::Error::New(env, "Transcript store not found: " + name).ThrowAsJavaScriptException();
+    }
+    return store;
+}
+
+Napi::Value CreateTranscriptStore(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (info.Length() < 1 || !info[0].IsArray()) {
-        Napi::TypeError::New(env, "Expected array of segments").ThrowAsJavaScriptException();
+    // createTranscriptStore(key, segments)
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsArray()) {
+        Napi::TypeError::New(env, "Expected (key: string, segments: array)").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    Napi::Array segmentsArray = info[0].As<Napi::Array>();
-    std::vector<llwhisper::TranscriptSegment> segments;
+    Napi::Array array = info[1].As<Napi::Array>();
+    std::vector<llwhisper::StoredSegment> segments;
+    segments.reserve(array.Length());
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Value value = array.Get(i);
+        if (!value.IsObject()) continue;
+        llwhisper::StoredSegment seg;
+        ApplyStoredSegmentFields(value.As<Napi::Object>(), seg);
+        segments.push_back(std::move(seg));
+    }
+    
+    std::shared_ptr<llwhisper::TranscriptStore> store =
+        llwhisper::TranscriptStore::create(info[0].As<Napi::String>().Utf8Value(), std::move(segments));
+    
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("count", Napi::Number::New(env, static_cast<double>(store->size())));
+    obj.Set("duration", Napi::Number::New(env, store->duration()));
+    return obj;
+}
+
+Napi::Value GetTranscriptRange(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // getTranscriptRange(key, start, count)
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (key: string, start: number, count: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::shared_ptr<llwhisper::TranscriptStore> store = FindTranscriptStore(env, info[0]);
+    if (!store) return env.Null();
+    
+    double start = std::max(0.0, info[1].As<Napi::Number>().DoubleValue());
+    double count = std::max(0.0, info[2].As<Napi::Number>().DoubleValue());
+    std::vector<llwhisper::StoredSegment> segments =
+        store->range(static_cast<size_t>(start), static_cast<size_t>(std::min(count, 1e9)));
+    
+    Napi::Array result = Napi::Array::New(env, segments.size());
+    for (size_t i = 0; i < segments.size(); i++) {
+        result.Set(static_cast<uint32_t>(i), StoredSegmentToObject(env, segments[i], static_cast<size_t>(start) + i));
+    }
+    return result;
+}
+
+Napi::Value GetTranscriptRangeByTime(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // getTranscriptRangeByTime(key, startTime, endTime)
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (key: string, startTime: number, endTime: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::shared_ptr<llwhisper::TranscriptStore> store = FindTranscriptStore(env, info[0]);
+    if (!store) return env.Null();
+    
+    size_t first = 0;
+    std::vector<llwhisper::StoredSegment> segments = store->rangeByTime(
+        info[1].As<Napi::Number>().DoubleValue(), info[2].As<Napi::Number>().DoubleValue(), first);
+    
+    Napi::Array array = Napi::Array::New(env, segments.size());
+    for (size_t i = 0; i < segments.size(); i++) {
+        array.Set(static_cast<uint32_t>(i), StoredSegmentToObject(env, segments[i], first + i));
+    }
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("first", Napi::Number::New(env, static_cast<double>(first)));
+    obj.Set("segments", array);
+    return obj;
+}
+
+Napi::Value GetTranscriptIndexAt(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // getTranscriptIndexAt(key, time)
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (key: string, time: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::shared_ptr<llwhisper::TranscriptStore> store = FindTranscriptStore(env, info[0]);
+    if (!store) return env.Null();
+    
+    return Napi::Number::New(env, static_cast<double>(store->indexAt(info[1].As<Napi::Number>().DoubleValue())));
+}
+
+Napi::Value SearchTranscript(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // searchTranscript(key, query, limit?)
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected (key: string, query: string, limit?: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::shared_ptr<llwhisper::TranscriptStore> store = FindTranscriptStore(env, info[0]);
+    if (!store) return env.Null();
+    
+    size_t limit = 1000;
+    if (info.Length() >= 3 && info[2].IsNumber()) {
+        limit = static_cast<size_t>(std::max(0.0, std::min(info[2].As<Napi::Number>().DoubleValue(), 1e9)));
+    }
+    
+    size_t total = 0;
+    std::vector<uint32_t> indices = store->search(info[1].As<Napi::String>().Utf8Value(), limit, total);
+    
+    Napi::Uint32Array array = Napi::Uint32Array::New(env, indices.size());
+    std::copy(indices.begin(), indices.end(), array.Data());
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("total", Napi::Number::New(env, static_cast<double>(total)));
+    obj.Set("indices", array);
+    return obj;
+}
+
+Napi::Value UpdateTranscriptSegment(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // updateTranscriptSegment(key, index, fields)
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsObject()) {
+        Napi::TypeError::New(env, "Expected (key: string, index: number, fields: object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::shared_ptr<llwhisper::TranscriptStore> store = FindTranscriptStore(env, info[0]);
+    if (!store) return env.Null();
+    
+    size_t index = static_cast<size_t>(std::max(0.0, info[1].As<Napi::Number>().DoubleValue()));
+    Napi::Object fields = info[2].As<Napi::Object>();
+    size_t newIndex = index;
+    // 读取与写回在同一次加锁中完成, 其他线程的修改不会夹在中间被覆盖
+    if (!store->update(index, [&fields](llwhisper::StoredSegment& seg) { ApplyStoredSegmentFields(fields, seg); },
+                       newIndex)) {
+        Napi::RangeError::New(env, "Segment index out of range").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Napi::Number::New(env, static_cast<double>(newIndex));
+}
+
+Napi::Value RemoveTranscriptSegment(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // removeTranscriptSegment(key, index)
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (key: string, index: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
     
-    for (uint32_t i = 0; i < segmentsArray.Length(); i++) {
-        Napi::Object obj = segmentsArray.Get(i).As<Napi::Object>();
+    std::shared_ptr<llwhisper::TranscriptStore> store = FindTranscriptStore(env, info[0]);
+    if (!store) return env.Null();
+    
+    size_t index = static_cast<size_t>(std::max(0.0, info[1].As<Napi::Number>().DoubleValue()));
+    if (!store->remove(index)) {
+        Napi::RangeError::New(env, "Segment index out of range").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Napi::Number::New(env, static_cast<double>(store->size()));
+}
+
+Napi::Value ReleaseTranscriptStore(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (key: string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Napi::Boolean::New(env, llwhisper::TranscriptStore::release(info[0].As<Napi::String>().Utf8Value()));
+}
+
+// 导出只用到时间与文本, 只读取这三个字段
+static std::vector<llwhisper::TranscriptSegment> ArrayToExportSegments(const Napi::Array& array) {
+    std::vector<llwhisper::TranscriptSegment> segments;
+    segments.reserve(array.Length());
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Object obj = array.Get(i).As<Napi::Object>();
         llwhisper::TranscriptSegment seg;
         seg.startTime = obj.Get("startTime").As<Napi::Number>().DoubleValue();
         seg.endTime = obj.Get("endTime").As<Napi::Number>().DoubleValue();
         seg.text = obj.Get("text").As<Napi::String>().Utf8Value();
-        segments.push_back(seg);
+        segments.push_back(std::move(seg));
+    }
+    return segments;
+}
+
+// 导出为不同格式
+Napi::Value ExportToTxt(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected array of segments").ThrowAsJavaScriptException();
+        return env.Null();
     }
     
+    std::vector<llwhisper::TranscriptSegment> segments = ArrayToExportSegments(info[0].As<Napi::Array>());
+    
     if (whisperWrapper) {
         std::string result = whisperWrapper->exportToTxt(segments);
         return Napi::String::New(env, result);
@@ -166,17 +1513,7 @@ Napi::Value ExportToSrt(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
-    Napi::Array segmentsArray = info[0].As<Napi::Array>();
-    std::vector<llwhisper::TranscriptSegment> segments;
-    
-    for (uint32_t i = 0; i < segmentsArray.Length(); i++) {
-        Napi::Object obj = segmentsArray.Get(i).As<Napi::Object>();
-        llwhisper::TranscriptSegment seg;
-        seg.startTime = obj.Get("startTime").As<Napi::Number>().DoubleValue();
-        seg.endTime = obj.Get("endTime").As<Napi::Number>().DoubleValue();
-        seg.text = obj.Get("text").As<Napi::String>().Utf8Value();
-        segments.push_back(seg);
-    }
+    std::vector<llwhisper::TranscriptSegment> segments = ArrayToExportSegments(info[0].As<Napi::Array>());
     
     if (whisperWrapper) {
         std::string result = whisperWrapper->exportToSrt(segments);
@@ -194,17 +1531,7 @@ Napi::Value ExportToVtt(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
-    Napi::Array segmentsArray = info[0].As<Napi::Array>();
-    std::vector<llwhisper::TranscriptSegment> segments;
-    
-    for (uint32_t i = 0; i < segmentsArray.Length(); i++) {
-        Napi::Object obj = segmentsArray.Get(i).As<Napi::Object>();
-        llwhisper::TranscriptSegment seg;
-        seg.startTime = obj.Get("startTime").As<Napi::Number>().DoubleValue();
-        seg.endTime = obj.Get("endTime").As<Napi::Number>().DoubleValue();
-        seg.text = obj.Get("text").As<Napi::String>().Utf8Value();
-        segments.push_back(seg);
-    }
+    std::vector<llwhisper::TranscriptSegment> segments = ArrayToExportSegments(info[0].As<Napi::Array>());
     
     if (whisperWrapper) {
         std::string result = whisperWrapper->exportToVtt(segments);
@@ -222,17 +1549,7 @@ Napi::Value ExportToJson(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
-    Napi::Array segmentsArray = info[0].As<Napi::Array>();
-    std::vector<llwhisper::TranscriptSegment> segments;
-    
-    for (uint32_t i = 0; i < segmentsArray.Length(); i++) {
-        Napi::Object obj = segmentsArray.Get(i).As<Napi::Object>();
-        llwhisper::TranscriptSegment seg;
-        seg.startTime = obj.Get("startTime").As<Napi::Number>().DoubleValue();
-        seg.endTime = obj.Get("endTime").As<Napi::Number>().DoubleValue();
-        seg.text = obj.Get("text").As<Napi::String>().Utf8Value();
-        segments.push_back(seg);
-    }
+    std::vector<llwhisper::TranscriptSegment> segments = ArrayToExportSegments(info[0].As<Napi::Array>());
     
     if (whisperWrapper) {
         std::string result = whisperWrapper->exportToJson(segments);
@@ -250,17 +1567,7 @@ Napi::Value ExportToLrc(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
-    Napi::Array segmentsArray = info[0].As<Napi::Array>();
-    std::vector<llwhisper::TranscriptSegment> segments;
-    
-    for (uint32_t i = 0; i < segmentsArray.Length(); i++) {
-        Napi::Object obj = segmentsArray.Get(i).As<Napi::Object>();
-        llwhisper::TranscriptSegment seg;
-        seg.startTime = obj.Get("startTime").As<Napi::Number>().DoubleValue();
-        seg.endTime = obj.Get("endTime").As<Napi::Number>().DoubleValue();
-        seg.text = obj.Get("text").As<Napi::String>().Utf8Value();
-        segments.push_back(seg);
-    }
+    std::vector<llwhisper::TranscriptSegment> segments = ArrayToExportSegments(info[0].As<Napi::Array>());
     
     if (whisperWrapper) {
         std::string result = whisperWrapper->exportToLrc(segments);
@@ -270,15 +1577,131 @@ Napi::Value ExportToLrc(const Napi::CallbackInfo& info) {
     return env.Null();
 }
 
+// 后台线程导出多种格式
+class ExportAllWorker : public Napi::AsyncWorker {
+public:
+    ExportAllWorker(Napi::Env env, std::vector<llwhisper::TranscriptSegment> segments, llwhisper::ExportOptions options)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)),
+          segments(std::move(segments)), options(std::move(options)) {
+    }
+    
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+    
+protected:
+    void Execute() override {
+        results = llwhisper::WhisperWrapper::exportAll(segments, options);
+    }
+    
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Array array = Napi::Array::New(env, results.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            const llwhisper::ExportedFile& file = results[i];
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set("format", Napi::String::New(env, file.format));
+            obj.Set("bytes", Napi::Number::New(env, static_cast<double>(file.bytes)));
+            if (!file.path.empty()) {
+                obj.Set("path", Napi::String::New(env, file.path));
+            }
+            if (options.outDir.empty() && file.error.empty()) {
+                obj.Set("content", Napi::String::New(env, file.content));
+            }
+            if (!file.error.empty()) {
+                obj.Set("error", Napi::String::New(env, file.error));
+            }
+            array.Set(i, obj);
+        }
+        deferred.Resolve(array);
+    }
+    
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+    
+private:
+    Napi::Promise::Deferred deferred;
+    std::vector<llwhisper::TranscriptSegment> segments;
+    llwhisper::ExportOptions options;
+    std::vector<llwhisper::ExportedFile> results;
+};
+
+// 一次导出多种格式 (不需要已加载模型)
+Napi::Value ExportAll(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    // exportAll(segments, { formats, outDir, baseName })
+    if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsObject()) {
+        Napi::TypeError::New(env, "Expected (segments: array, options: object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Object opts = info[1].As<Napi::Object>();
+    llwhisper::ExportOptions options;
+    if (!opts.Has("formats") || !opts.Get("formats").IsArray()) {
+        Napi::TypeError::New(env, "options.formats must be an array of strings").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Array formats = opts.Get("formats").As<Napi::Array>();
+    for (uint32_t i = 0; i < formats.Length(); i++) {
+        options.formats.push_back(formats.Get(i).As<Napi::String>().Utf8Value());
+    }
+    if (opts.Has("outDir") && opts.Get("outDir").IsString()) {
+        options.outDir = opts.Get("outDir").As<Napi::String>().Utf8Value();
+    }
+    if (opts.Has("baseName") && opts.Get("baseName").IsString()) {
+        options.baseName = opts.Get("baseName").As<Napi::String>().Utf8Value();
+    }
+    
+    std::vector<llwhisper::TranscriptSegment> segments;
+    try {
+        segments = ArrayToExportSegments(info[0].As<Napi::Array>());
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    ExportAllWorker* worker = new ExportAllWorker(env, std::move(segments), std::move(options));
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
 // 模块初始化
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
     exports.Set("loadModel", Napi::Function::New(env, LoadModel));
+    exports.Set("loadDraftModel", Napi::Function::New(env, LoadDraftModel));
+    exports.Set("reloadModel", Napi::Function::New(env, ReloadModel));
+    exports.Set("getLoadedModels", Napi::Function::New(env, GetLoadedModels));
     exports.Set("transcribe", Napi::Function::New(env, Transcribe));
+    exports.Set("transcribeStream", Napi::Function::New(env, TranscribeStream));
+    exports.Set("transcribeTwoPass", Napi::Function::New(env, TranscribeTwoPass));
+    exports.Set("transcribeBatch", Napi::Function::New(env, TranscribeBatch));
+    exports.Set("transcribeTracks", Napi::Function::New(env, TranscribeTracks));
+    exports.Set("detectLanguage", Napi::Function::New(env, DetectLanguage));
+    exports.Set("findDuplicate", Napi::Function::New(env, FindDuplicate));
+    exports.Set("tokenize", Napi::Function::New(env, Tokenize));
+    exports.Set("getModelInfo", Napi::Function::New(env, GetModelInfo));
+    exports.Set("getBackendInfo", Napi::Function::New(env, GetBackendInfo));
+    exports.Set("setMemoryBudget", Napi::Function::New(env, SetMemoryBudget));
+    exports.Set("getMemoryStats", Napi::Function::New(env, GetMemoryStats));
+    exports.Set("inspectModel", Napi::Function::New(env, InspectModel));
+    exports.Set("quantizeModel", Napi::Function::New(env, QuantizeModel));
+    exports.Set("decodeAudio", Napi::Function::New(env, DecodeAudio));
+    exports.Set("resegment", Napi::Function::New(env, Resegment));
+    exports.Set("createTranscriptStore", Napi::Function::New(env, CreateTranscriptStore));
+    exports.Set("getTranscriptRange", Napi::Function::New(env, GetTranscriptRange));
+    exports.Set("getTranscriptRangeByTime", Napi::Function::New(env, GetTranscriptRangeByTime));
+    exports.Set("getTranscriptIndexAt", Napi::Function::New(env, GetTranscriptIndexAt));
+    exports.Set("searchTranscript", Napi::Function::New(env, SearchTranscript));
+    exports.Set("updateTranscriptSegment", Napi::Function::New(env, UpdateTranscriptSegment));
+    exports.Set("removeTranscriptSegment", Napi::Function::New(env, RemoveTranscriptSegment));
+    exports.Set("releaseTranscriptStore", Napi::Function::New(env, ReleaseTranscriptStore));
     exports.Set("exportToTxt", Napi::Function::New(env, ExportToTxt));
     exports.Set("exportToSrt", Napi::Function::New(env, ExportToSrt));
     exports.Set("exportToVtt", Napi::Function::New(env, ExportToVtt));
     exports.Set("exportToJson", Napi::Function::New(env, ExportToJson));
     exports.Set("exportToLrc", Napi::Function::New(env, ExportToLrc));
+    exports.Set("exportAll", Napi::Function::New(env, ExportAll));
     return exports;
 }
 
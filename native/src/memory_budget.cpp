@@ -0,0 +1,200 @@
+#include "memory_budget.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace llwhisper {
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other) {
+    model += other.model;
+    state += other.state;
+    pcm += other.pcm;
+    output += other.output;
+    return *this;
+}
+
+std::string formatMegabytes(uint64_t bytes) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.0f MB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+    return buffer;
+}
+
+MemoryBudget::Reservation::Reservation(Reservation&& other) noexcept
+    : owner(other.owner), id(other.id) {
+    other.owner = nullptr;
+    other.id = 0;
+}
+
+MemoryBudget::Reservation& MemoryBudget::Reservation::operator=(Reservation&& other) noexcept {
+    if (this != &other) {
+        release();
+        owner = other.owner;
+        id = other.id;
+        other.owner = nullptr;
+        other.id = 0;
+    }
+    return *this;
+}
+
+void MemoryBudget::Reservation::update(const MemoryUsage& usage) {
+    if (owner) owner->updateJob(id, usage);
+}
+
+void MemoryBudget::Reservation::release() {
+    if (owner) {
+        owner->releaseJob(id);
+        owner = nullptr;
+        id = 0;
+    }
+}
+
+void MemoryBudget::setLimit(uint64_t limit, uint64_t timeoutMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    limitBytes = limit;
+    queueTimeoutMs = timeoutMs;
+    // 放宽预算后排队中的作业可能已经放得下
+    released.notify_all();
+}
+
+uint64_t MemoryBudget::limit() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return limitBytes;
+}
+
+void MemoryBudget::setResident(const std::string& key, const MemoryUsage& usage) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (usage.total() == 0) {
+        resident.erase(key);
+        released.notify_all();
+    } else {
+        resident[key] = usage;
+    }
+    peak = std::max(peak, usedLocked());
+}
+
+uint64_t MemoryBudget::usedLocked() const {
+    uint64_t used = 0;
+    for (const auto& entry : resident) used += entry.second.total();
+    for (const auto& entry : jobs) used += entry.second.usage.total();
+    return used;
+}
+
+bool MemoryBudget::fitsAlone(const MemoryUsage& usage) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (limitBytes == 0) return true;
+    uint64_t residentBytes = 0;
+    for (const auto& entry : resident) residentBytes += entry.second.total();
+    return residentBytes + usage.total() <= limitBytes;
+}
+
+void MemoryBudget::grant(const std::string& job, const MemoryUsage& usage, Reservation& reservation) {
+    JobMemory entry;
+    entry.id = nextId++;
+    entry.name = job;
+    entry.usage = usage;
+    jobs[entry.id] = entry;
+    peak = std::max(peak, usedLocked());
+    reservation.release();
+    reservation.owner = this;
+    reservation.id = entry.id;
+}
+
+bool MemoryBudget::reserve(const std::string& job, const MemoryUsage& usage, Reservation& reservation,
+                           std::string& error) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto fits = [&]() { return limitBytes == 0 || usedLocked() + usage.total() <= limitBytes; };
+    auto fitsAloneLocked = [&]() {
+        if (limitBytes == 0) return true;
+        uint64_t residentBytes = 0;
+        for (const auto& entry : resident) residentBytes += entry.second.total();
+        return residentBytes + usage.total() <= limitBytes;
+    };
+
+    if (!fitsAloneLocked()) {
+        rejected++;
+        error = "Memory budget exceeded: " + job + " needs about " + formatMegabytes(usage.total()) +
+                " but the budget is " + formatMegabytes(limitBytes);
+        return false;
+    }
+
+    if (!fits()) {
+        // 排队等待其它作业释放
+        queued++;
+        bool ok = true;
+        if (queueTimeoutMs > 0) {
+            ok = released.wait_for(lock, std::chrono::milliseconds(queueTimeoutMs),
+                                   [&]() { return fits() || !fitsAloneLocked(); });
+        } else {
+            released.wait(lock, [&]() { return fits() || !fitsAloneLocked(); });
+        }
+        queued--;
+        // 等待期间预算被调低, 单独也放不下了
+        if (ok && !fits()) {
+            ok = false;
+        }
+        if (!ok) {
+            rejected++;
+            error = "Memory budget exceeded: " + job + " waited for " + formatMegabytes(usage.total()) +
+                    " but only " + formatMegabytes(limitBytes > usedLocked() ? limitBytes - usedLocked() : 0) +
+                    " became available";
+            return false;
+        }
+    }
+
+    grant(job, usage, reservation);
+    return true;
+}
+
+bool MemoryBudget::tryReserve(const std::string& job, const MemoryUsage& usage, Reservation& reservation) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (limitBytes != 0 && usedLocked() + usage.total() > limitBytes) {
+        return false;
+    }
+    grant(job, usage, reservation);
+    return true;
+}
+
+void MemoryBudget::updateJob(uint64_t id, const MemoryUsage& usage) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(id);
+    if (it == jobs.end()) return;
+    const bool shrunk = usage.total() < it->second.usage.total();
+    it->second.usage = usage;
+    peak = std::max(peak, usedLocked());
+    if (shrunk) released.notify_all();
+}
+
+void MemoryBudget::releaseJob(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.erase(id);
+    released.notify_all();
+}
+
+void MemoryBudget::countChunked() {
+    std::lock_guard<std::mutex> lock(mutex);
+    chunked++;
+}
+
+void MemoryBudget::countRejected() {
+    std::lock_guard<std::mutex> lock(mutex);
+    rejected++;
+}
+
+MemoryStats MemoryBudget::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    MemoryStats result;
+    result.limit = limitBytes;
+    for (const auto& entry : resident) result.resident += entry.second;
+    for (const auto& entry : jobs) {
+        result.jobs += entry.second.usage;
+        result.active.push_back(entry.second);
+    }
+    result.total = result.resident.total() + result.jobs.total();
+    result.peak = peak;
+    result.queued = queued;
+    result.chunked = chunked;
+    result.rejected = rejected;
+    return result;
+}
+
+} // namespace llwhisper
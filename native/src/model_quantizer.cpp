@@ -0,0 +1,366 @@
+#include "model_quantizer.h"
+#include "ggml.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace llwhisper {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kGgmlMagic = 0x67676d6c; // "ggml"
+
+// 不量化的张量 (与 whisper.cpp examples/quantize 一致)
+const char* const kSkipTensors[] = {
+    "encoder.conv1.bias",
+    "encoder.conv2.bias",
+    "encoder.positional_embedding",
+    "decoder.positional_embedding",
+};
+
+struct QuantType {
+    const char* name;
+    ggml_type type;
+    ggml_ftype ftype;
+};
+
+const QuantType kQuantTypes[] = {
+    { "q8_0", GGML_TYPE_Q8_0, GGML_FTYPE_MOSTLY_Q8_0 },
+    { "q5_1", GGML_TYPE_Q5_1, GGML_FTYPE_MOSTLY_Q5_1 },
+    { "q5_0", GGML_TYPE_Q5_0, GGML_FTYPE_MOSTLY_Q5_0 },
+    { "q4_1", GGML_TYPE_Q4_1, GGML_FTYPE_MOSTLY_Q4_1 },
+    { "q4_0", GGML_TYPE_Q4_0, GGML_FTYPE_MOSTLY_Q4_0 },
+};
+
+template <typename T>
+bool readValue(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+template <typename T>
+void writeValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// 文件头 (hparams + mel 滤波器 + 词表), 量化时原样复制, 只替换 ftype
+struct ModelHeader {
+    int32_t hparams[11] = {};               // n_vocab ... n_mels, ftype
+    std::string rest;                       // mel 滤波器与词表的原始字节
+};
+
+enum HParam {
+    kVocab = 0, kAudioCtx, kAudioState, kAudioHead, kAudioLayer,
+    kTextCtx, kTextState, kTextHead, kTextLayer, kMels, kFtype
+};
+
+bool readHeader(std::istream& in, ModelHeader& header, std::string& error) {
+    uint32_t magic = 0;
+    if (!readValue(in, magic) || magic != kGgmlMagic) {
+        error = "Not a GGML whisper model (bad magic)";
+        return false;
+    }
+    for (int32_t& value : header.hparams) {
+        if (!readValue(in, value)) {
+            error = "Truncated model header";
+            return false;
+        }
+    }
+
+    // 记录 mel 滤波器与词表的范围, 按原始字节读出
+    std::streampos begin = in.tellg();
+    int32_t nMel = 0, nFft = 0;
+    if (!readValue(in, nMel) || !readValue(in, nFft) || nMel < 0 || nFft < 0) {
+        error = "Truncated mel filters";
+        return false;
+    }
+    in.seekg(static_cast<std::streamoff>(nMel) * nFft * sizeof(float), std::ios::cur);
+
+    int32_t nVocab = 0;
+    if (!readValue(in, nVocab) || nVocab < 0) {
+        error = "Truncated vocabulary";
+        return false;
+    }
+    for (int32_t i = 0; i < nVocab; i++) {
+        uint32_t len = 0;
+        if (!readValue(in, len)) {
+            error = "Truncated vocabulary";
+            return false;
+        }
+        in.seekg(len, std::ios::cur);
+    }
+    std::streampos end = in.tellg();
+    if (!in) {
+        error = "Truncated vocabulary";
+        return false;
+    }
+
+    header.rest.resize(static_cast<size_t>(end - begin));
+    in.seekg(begin);
+    in.read(&header.rest[0], static_cast<std::streamsize>(header.rest.size()));
+    return static_cast<bool>(in);
+}
+
+struct TensorHeader {
+    int32_t nDims = 0;
+    int32_t type = 0;
+    int32_t ne[4] = { 1, 1, 1, 1 };
+    std::string name;
+
+    int64_t elements() const {
+        return static_cast<int64_t>(ne[0]) * ne[1] * ne[2] * ne[3];
+    }
+    size_t dataSize() const {
+        return ggml_row_size(static_cast<ggml_type>(type), ne[0]) * static_cast<size_t>(elements() / ne[0]);
+    }
+};
+
+// 读取下一个张量头; 文件结束返回 false 且 error 为空
+bool readTensorHeader(std::istream& in, TensorHeader& tensor, std::string& error) {
+    int32_t nameLen = 0;
+    if (!readValue(in, tensor.nDims)) {
+        return false;
+    }
+    if (!readValue(in, nameLen) || !readValue(in, tensor.type) ||
+        tensor.nDims < 1 || tensor.nDims > 4 || nameLen <= 0 ||
+        tensor.type < 0 || tensor.type >= GGML_TYPE_COUNT) {
+        error = "Corrupt tensor header";
+        return false;
+    }
+    std::fill(tensor.ne, tensor.ne + 4, 1);
+    for (int32_t i = 0; i < tensor.nDims; i++) {
+        if (!readValue(in, tensor.ne[i]) || tensor.ne[i] <= 0) {
+            error = "Corrupt tensor shape";
+            return false;
+        }
+    }
+    tensor.name.resize(nameLen);
+    if (!in.read(&tensor.name[0], nameLen)) {
+        error = "Truncated tensor name";
+        return false;
+    }
+    return true;
+}
+
+void addTensorStats(ModelInfo& info, ggml_type type, int64_t elements, size_t bytes) {
+    const char* name = ggml_type_name(type);
+    auto it = std::find_if(info.tensorTypes.begin(), info.tensorTypes.end(),
+                           [name](const TensorTypeStats& stats) { return stats.type == name; });
+    if (it == info.tensorTypes.end()) {
+        info.tensorTypes.push_back(TensorTypeStats());
+        it = info.tensorTypes.end() - 1;
+        it->type = name;
+    }
+    it->tensors++;
+    it->elements += static_cast<uint64_t>(elements);
+    it->bytes += bytes;
+    info.tensorBytes += bytes;
+}
+
+void fillInfo(ModelInfo& info, const std::string& path, const ModelHeader& header) {
+    info = ModelInfo();
+    info.path = path;
+    info.ftype = header.hparams[kFtype] % GGML_QNT_VERSION_FACTOR;
+    info.qntVersion = header.hparams[kFtype] / GGML_QNT_VERSION_FACTOR;
+    info.nVocab = header.hparams[kVocab];
+    info.nAudioState = header.hparams[kAudioState];
+    info.nAudioLayer = header.hparams[kAudioLayer];
+    info.nTextState = header.hparams[kTextState];
+    info.nTextLayer = header.hparams[kTextLayer];
+    info.nMels = header.hparams[kMels];
+}
+
+bool shouldQuantize(const TensorHeader& tensor, ggml_type target) {
+    if (tensor.nDims != 2) return false;
+    if (tensor.type != GGML_TYPE_F32 && tensor.type != GGML_TYPE_F16) return false;
+    if (tensor.ne[0] % ggml_blck_size(target) != 0) return false;
+    for (const char* skip : kSkipTensors) {
+        if (tensor.name == skip) return false;
+    }
+    return true;
+}
+
+// 按行分块, 多线程调用 ggml_quantize_chunk
+size_t quantizeRows(ggml_type type, const float* src, void* dst, int64_t nRows, int64_t nPerRow, int nThreads) {
+    nThreads = static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(nThreads, nRows)));
+    if (nThreads == 1) {
+        return ggml_quantize_chunk(type, src, dst, 0, nRows, nPerRow, nullptr);
+    }
+
+    std::vector<size_t> sizes(nThreads, 0);
+    std::vector<std::thread> workers;
+    const int64_t rowsPerThread = (nRows + nThreads - 1) / nThreads;
+    for (int t = 0; t < nThreads; t++) {
+        const int64_t first = t * rowsPerThread;
+        const int64_t count = std::min(rowsPerThread, nRows - first);
+        if (count <= 0) break;
+        workers.emplace_back([=, &sizes]() {
+            sizes[t] = ggml_quantize_chunk(type, src, dst, first * nPerRow, count, nPerRow, nullptr);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    size_t total = 0;
+    for (size_t size : sizes) total += size;
+    return total;
+}
+
+} // namespace
+
+bool inspectModel(const std::string& path, ModelInfo& info, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.good()) {
+        error = "Model file not found: " + path;
+        return false;
+    }
+
+    ModelHeader header;
+    if (!readHeader(in, header, error)) {
+        return false;
+    }
+    fillInfo(info, path, header);
+
+    TensorHeader tensor;
+    while (readTensorHeader(in, tensor, error)) {
+        size_t size = tensor.dataSize();
+        addTensorStats(info, static_cast<ggml_type>(tensor.type), tensor.elements(), size);
+        in.seekg(static_cast<std::streamoff>(size), std::ios::cur);
+    }
+    return error.empty();
+}
+
+bool quantizeModel(const std::string& srcPath, const std::string& dstPath, const std::string& type,
+                   int nThreads, ModelInfo* dstInfo, std::string& error,
+                   QuantizeProgressCallback progress) {
+    const QuantType* target = nullptr;
+    for (const QuantType& candidate : kQuantTypes) {
+        if (type == candidate.name) target = &candidate;
+    }
+    if (!target) {
+        error = "Unsupported quantization type: " + type + " (expected q8_0, q5_1, q5_0, q4_1 or q4_0)";
+        return false;
+    }
+    if (nThreads <= 0) {
+        nThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    std::ifstream in(srcPath, std::ios::binary);
+    if (!in.good()) {
+        error = "Model file not found: " + srcPath;
+        return false;
+    }
+    in.seekg(0, std::ios::end);
+    const double srcSize = static_cast<double>(in.tellg());
+    in.seekg(0, std::ios::beg);
+
+    ModelHeader header;
+    if (!readHeader(in, header, error)) {
+        return false;
+    }
+    if (header.hparams[kFtype] / GGML_QNT_VERSION_FACTOR != 0) {
+        error = "Model is already quantized";
+        return false;
+    }
+
+    // 先写临时文件, 全部成功后再替换 dstPath; 中途失败时删除临时文件, 不留下看似可加载的半个模型
+    const std::string tmpPath = dstPath + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out.good()) {
+        error = "Cannot create output file: " + dstPath;
+        return false;
+    }
+    struct TempFileGuard {
+        std::ofstream& out;
+        const std::string& path;
+        bool committed = false;
+        ~TempFileGuard() {
+            if (committed) return;
+            out.close();
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+    } guard{out, tmpPath};
+
+    ModelInfo info;
+    fillInfo(info, dstPath, header);
+    info.ftype = target->ftype;
+    info.qntVersion = GGML_QNT_VERSION;
+
+    header.hparams[kFtype] = target->ftype + GGML_QNT_VERSION * GGML_QNT_VERSION_FACTOR;
+    writeValue(out, kGgmlMagic);
+    for (int32_t value : header.hparams) writeValue(out, value);
+    out.write(header.rest.data(), static_cast<std::streamsize>(header.rest.size()));
+
+    ggml_quantize_init(target->type);
+
+    std::vector<char> data;
+    std::vector<float> f32;
+    std::vector<char> quantized;
+    TensorHeader tensor;
+    while (readTensorHeader(in, tensor, error)) {
+        data.resize(tensor.dataSize());
+        if (!in.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+            error = "Truncated tensor data: " + tensor.name;
+            return false;
+        }
+
+        const char* outData = data.data();
+        size_t outSize = data.size();
+        ggml_type outType = static_cast<ggml_type>(tensor.type);
+
+        if (shouldQuantize(tensor, target->type)) {
+            const int64_t n = tensor.elements();
+            const float* src = reinterpret_cast<const float*>(data.data());
+            if (tensor.type == GGML_TYPE_F16) {
+                f32.resize(n);
+                ggml_fp16_to_fp32_row(reinterpret_cast<const ggml_fp16_t*>(data.data()), f32.data(), n);
+                src = f32.data();
+            }
+
+            quantized.resize(ggml_row_size(target->type, tensor.ne[0]) * static_cast<size_t>(n / tensor.ne[0]));
+            outSize = quantizeRows(target->type, src, quantized.data(), n / tensor.ne[0], tensor.ne[0], nThreads);
+            outData = quantized.data();
+            outType = target->type;
+        }
+
+        const int32_t nameLen = static_cast<int32_t>(tensor.name.size());
+        const int32_t ttype = outType;
+        writeValue(out, tensor.nDims);
+        writeValue(out, nameLen);
+        writeValue(out, ttype);
+        for (int32_t i = 0; i < tensor.nDims; i++) writeValue(out, tensor.ne[i]);
+        out.write(tensor.name.data(), nameLen);
+        out.write(outData, static_cast<std::streamsize>(outSize));
+
+        addTensorStats(info, outType, tensor.elements(), outSize);
+
+        if (progress && srcSize > 0) {
+            progress(static_cast<float>(static_cast<double>(in.tellg()) / srcSize));
+        }
+    }
+    if (!error.empty()) {
+        return false;
+    }
+
+    out.close();
+    if (!out.good()) {
+        error = "Failed to write output file: " + dstPath;
+        return false;
+    }
+    std::error_code ec;
+    fs::rename(tmpPath, dstPath, ec);
+    if (ec) {
+        error = "Failed to write output file: " + dstPath;
+        return false;
+    }
+    guard.committed = true;
+
+    if (dstInfo) *dstInfo = info;
+    return true;
+}
+
+} // namespace llwhisper
@@ -0,0 +1,203 @@
+#include "pcm_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace llwhisper {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kMagic[8] = {'L', 'L', 'P', 'C', 'M', '\0', '\0', '\0'};
+const uint32_t kVersion = 1;
+const uint32_t kSampleRate = 16000;
+
+// 固定 64 字节, 样本从 64 字节处开始 (映射起点按页对齐, 样本地址因此 64 字节对齐)
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sampleRate;
+    uint64_t sampleCount;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint8_t reserved[24];
+};
+static_assert(sizeof(CacheHeader) == 64, "PCM cache header must be 64 bytes");
+
+bool sourceStat(const std::string& mediaPath, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    size = fs::file_size(fs::u8path(mediaPath), ec);
+    if (ec) return false;
+    mtime = fs::last_write_time(fs::u8path(mediaPath), ec).time_since_epoch().count();
+    return !ec;
+}
+
+// 64 位 FNV-1a
+uint64_t hashPath(const std::string& path) {
+    uint64_t hash = 1469598103934665603ull;
+    for (unsigned char c : path) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// 临时文件名后缀带进程号与线程号: 同时缓存同一媒体的作业 (批量转录等) 各写各的临时文件
+std::string tempSuffix() {
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+    size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return "." + std::to_string(pid) + "-" + std::to_string(thread) + ".tmp";
+}
+
+} // namespace
+
+PcmCache::~PcmCache() {
+#ifdef _WIN32
+    if (mapping) UnmapViewOfFile(mapping);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+#else
+    if (mapping) munmap(mapping, mappedBytes);
+#endif
+}
+
+std::string PcmCache::cachePath(const std::string& mediaPath, const std::string& cacheDir) {
+    if (cacheDir.empty()) {
+        return mediaPath + ".llpcm";
+    }
+    std::error_code ec;
+    fs::path absolute = fs::absolute(fs::u8path(mediaPath), ec);
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.llpcm",
+                  static_cast<unsigned long long>(hashPath(ec ? mediaPath : absolute.u8string())));
+    return (fs::u8path(cacheDir) / name).u8string();
+}
+
+std::unique_ptr<PcmCache> PcmCache::open(const std::string& cachePath, const std::string& mediaPath) {
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+    if (!sourceStat(mediaPath, sourceSize, sourceMtime)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<PcmCache> cache(new PcmCache());
+#ifdef _WIN32
+    HANDLE file = CreateFileW(fs::u8path(cachePath).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    cache->fileHandle = file;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(CacheHeader))) {
+        return nullptr;
+    }
+    cache->mappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (cache->mappingHandle == nullptr) {
+        return nullptr;
+    }
+    cache->mappedBytes = static_cast<size_t>(fileSize.QuadPart);
+    cache->mapping = MapViewOfFile(cache->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (cache->mapping == nullptr) {
+        return nullptr;
+    }
+#else
+    int fd = ::open(cachePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(CacheHeader))) {
+        ::close(fd);
+        return nullptr;
+    }
+    cache->mappedBytes = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, cache->mappedBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // 映射建立后不再需要文件描述符
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+    cache->mapping = mapped;
+    // whisper 从头到尾顺序读取样本
+    madvise(mapped, cache->mappedBytes, MADV_SEQUENTIAL);
+#endif
+
+    CacheHeader header;
+    std::memcpy(&header, cache->mapping, sizeof(header));
+    const uint64_t expectedBytes = sizeof(CacheHeader) + header.sampleCount * sizeof(float);
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.sampleRate != kSampleRate || header.sourceSize != sourceSize ||
+        header.sourceMtime != sourceMtime || expectedBytes != cache->mappedBytes) {
+        return nullptr;
+    }
+
+    cache->data = reinterpret_cast<const float*>(static_cast<const char*>(cache->mapping) + sizeof(CacheHeader));
+    cache->count = static_cast<size_t>(header.sampleCount);
+    return cache;
+}
+
+bool PcmCache::write(const std::string& cachePath, const std::string& mediaPath,
+                     const float* samples, size_t count, std::string& error) {
+    CacheHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.sampleRate = kSampleRate;
+    header.sampleCount = count;
+    if (!sourceStat(mediaPath, header.sourceSize, header.sourceMtime)) {
+        error = "Cannot stat media file: " + mediaPath;
+        return false;
+    }
+
+    // 先写临时文件再替换, 中断时不会留下半个缓存; 并发写入时后完成的一个替换先完成的 (内容相同)
+    std::error_code ec;
+    fs::path target = fs::u8path(cachePath);
+    if (target.has_parent_path()) {
+        fs::create_directories(target.parent_path(), ec);
+    }
+    fs::path tmp = fs::u8path(cachePath + tempSuffix());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            error = "Cannot create PCM cache: " + cachePath;
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(samples), static_cast<std::streamsize>(count * sizeof(float)));
+        if (!out.good()) {
+            out.close();
+            fs::remove(tmp, ec);
+            error = "Failed to write PCM cache: " + cachePath;
+            return false;
+        }
+    }
+
+    fs::rename(tmp, target, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        error = "Failed to write PCM cache: " + cachePath;
+        return false;
+    }
+    return true;
+}
+
+} // namespace llwhisper
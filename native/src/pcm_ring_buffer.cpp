@@ -0,0 +1,94 @@
+#include "pcm_ring_buffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace llwhisper {
+
+namespace {
+
+// 先让出时间片若干次, 仍未就绪再休眠 (解码与推理都以毫秒计, 不需要更细的唤醒)
+void backoff(int& spins) {
+    if (spins < 64) {
+        spins++;
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+} // namespace
+
+PcmRingBuffer::PcmRingBuffer(size_t capacity) : buffer(std::max<size_t>(capacity, 1)) {
+}
+
+bool PcmRingBuffer::write(const float* samples, size_t n) {
+    const size_t cap = buffer.size();
+    size_t pos = writePos.load(std::memory_order_relaxed);
+    int spins = 0;
+    while (n > 0) {
+        if (isCancelled.load(std::memory_order_acquire)) {
+            return false;
+        }
+        size_t space = cap - (pos - readPos.load(std::memory_order_acquire));
+        if (space == 0) {
+            backoff(spins);
+            continue;
+        }
+        spins = 0;
+
+        // 最多分两段写入 (跨越缓冲末尾时回绕)
+        size_t count = std::min(n, space);
+        size_t index = pos % cap;
+        size_t first = std::min(count, cap - index);
+        std::memcpy(buffer.data() + index, samples, first * sizeof(float));
+        std::memcpy(buffer.data(), samples + first, (count - first) * sizeof(float));
+
+        pos += count;
+        samples += count;
+        n -= count;
+        writePos.store(pos, std::memory_order_release);
+    }
+    return true;
+}
+
+void PcmRingBuffer::close() {
+    isClosed.store(true, std::memory_order_release);
+}
+
+size_t PcmRingBuffer::waitFor(size_t n) const {
+    n = std::min(n, buffer.size());
+    int spins = 0;
+    while (true) {
+        // 先读关闭标志: 关闭之后 writePos 不再变化, 随后读到的可读数即为最终值
+        bool done = isClosed.load(std::memory_order_acquire);
+        size_t count = available();
+        if (count >= n || done) {
+            return count;
+        }
+        backoff(spins);
+    }
+}
+
+size_t PcmRingBuffer::available() const {
+    return writePos.load(std::memory_order_acquire) - readPos.load(std::memory_order_relaxed);
+}
+
+void PcmRingBuffer::peek(float* dst, size_t n) const {
+    const size_t cap = buffer.size();
+    size_t index = readPos.load(std::memory_order_relaxed) % cap;
+    size_t first = std::min(n, cap - index);
+    std::memcpy(dst, buffer.data() + index, first * sizeof(float));
+    std::memcpy(dst + first, buffer.data(), (n - first) * sizeof(float));
+}
+
+void PcmRingBuffer::consume(size_t n) {
+    readPos.store(readPos.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+void PcmRingBuffer::cancel() {
+    isCancelled.store(true, std::memory_order_release);
+}
+
+} // namespace llwhisper
@@ -0,0 +1,416 @@
+#include "subtitle_segmenter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace llwhisper {
+
+namespace {
+
+// 断点质量 (单元之后断开)
+constexpr int kBreakNone = 0;       // CJK 字符之间
+constexpr int kBreakWord = 1;       // 拉丁单词之间
+constexpr int kBreakClause = 2;     // 逗号 / 原片段边界
+constexpr int kBreakSentence = 3;   // 句末标点 / 较长停顿
+constexpr double kShortPause = 0.3; // 片段之间超过该间隔视为句子边界
+constexpr double kBreakBonus = 0.15;// 两行均分时标点断点的加分 (以行宽为单位)
+
+// 不可再分的排版单元: 拉丁文字为一个单词, CJK 文字为一个字 (连同避头尾标点)
+struct Unit {
+    uint32_t offset = 0;        // 在来源片段文本中的字节范围
+    uint32_t length = 0;
+    int latin = 0;              // 拉丁字符数
+    int cjk = 0;                // 中日韩字符数
+    bool spaceBefore = false;   // 与前一单元之间有空格
+    int breakAfter = kBreakNone;
+    bool hardBreakAfter = false;// 说话人切换 / 长停顿, 必须断开
+    double start = 0.0;
+    double end = 0.0;
+    size_t source = 0;          // 来源片段
+};
+
+char32_t decodeUtf8(const std::string& text, size_t& i) {
+    unsigned char c = static_cast<unsigned char>(text[i++]);
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+    char32_t cp = extra == 3 ? (c & 0x07) : extra == 2 ? (c & 0x0F) : extra == 1 ? (c & 0x1F) : c;
+    for (; extra > 0 && i < text.size(); extra--) {
+        unsigned char next = static_cast<unsigned char>(text[i]);
+        if ((next & 0xC0) != 0x80) break;
+        cp = (cp << 6) | (next & 0x3F);
+        i++;
+    }
+    return cp;
+}
+
+bool isHangul(char32_t cp) {
+    return (cp >= 0x1100 && cp <= 0x11FF) || (cp >= 0x3130 && cp <= 0x318F) || (cp >= 0xAC00 && cp <= 0xD7AF);
+}
+
+// 全角文字 (占两个拉丁字符宽度, 阅读速度按 CJK 计算)
+bool isWide(char32_t cp) {
+    return (cp >= 0x1100 && cp <= 0x11FF) || (cp >= 0x2E80 && cp <= 0x9FFF) ||
+           (cp >= 0xAC00 && cp <= 0xD7AF) || (cp >= 0xF900 && cp <= 0xFAFF) ||
+           (cp >= 0xFE30 && cp <= 0xFE4F) || (cp >= 0xFF00 && cp <= 0xFF60) ||
+           (cp >= 0xFFE0 && cp <= 0xFFE6) || (cp >= 0x20000 && cp <= 0x2FFFF);
+}
+
+// 中日文字之间可以任意断行; 韩文以空格分词, 与拉丁文字相同
+bool breaksPerChar(char32_t cp) {
+    return isWide(cp) && !isHangul(cp);
+}
+
+// 避头: 不能出现在行首的字符
+bool noBreakBefore(char32_t cp) {
+    switch (cp) {
+        case U'、': case U'。': case U'，': case U'．': case U'！': case U'？': case U'：': case U'；':
+        case U'）': case U'」': case U'』': case U'】': case U'〉': case U'》': case U'〕': case U'］': case U'｝':
+        case U'…': case U'‥': case U'ー': case U'・': case U'々': case U'〜': case U'～':
+        case U'ぁ': case U'ぃ': case U'ぅ': case U'ぇ': case U'ぉ': case U'っ': case U'ゃ': case U'ゅ': case U'ょ': case U'ゎ':
+        case U'ァ': case U'ィ': case U'ゥ': case U'ェ': case U'ォ': case U'ッ': case U'ャ': case U'ュ': case U'ョ': case U'ヮ':
+        case U'ヵ': case U'ヶ':
+        case '.': case ',': case '!': case '?': case ':': case ';': case ')': case ']': case '}': case '%':
+            return true;
+        default:
+            return false;
+    }
+}
+
+// 避尾: 不能出现在行尾的字符
+bool noBreakAfter(char32_t cp) {
+    switch (cp) {
+        case U'（': case U'「': case U'『': case U'【': case U'〈': case U'《': case U'〔': case U'［': case U'｛':
+        case '(': case '[': case '{':
+            return true;
+        default:
+            return false;
+    }
+}
+
+int punctuationBreak(char32_t cp) {
+    switch (cp) {
+        case '.': case '!': case '?': case U'。': case U'！': case U'？': case U'．': case U'…':
+            return kBreakSentence;
+        case ',': case ';': case ':': case U'、': case U'，': case U'；': case U'：':
+            return kBreakClause;
+        default:
+            return kBreakNone;
+    }
+}
+
+bool isSpace(char32_t cp) {
+    return cp == ' ' || cp == '\t' || cp == '\n' || cp == '\r' || cp == 0x3000 || cp == 0xA0;
+}
+
+// 把一个片段拆成排版单元并按字符数插值时间
+// previousTail 为上一个非空片段的末字符
+void tokenize(const TranscriptSegment& segment, size_t source, std::vector<Unit>& units, char32_t& previousTail) {
+    const size_t first = units.size();
+    const std::string& text = segment.text;
+
+    Unit current;
+    char32_t last = 0;
+    char32_t head = 0;          // 第一个单元的首字符
+    bool pendingSpace = false;
+    auto flush = [&]() {
+        if (current.length == 0) return;
+        int punct = punctuationBreak(last);
+        current.breakAfter = punct != kBreakNone ? punct : breaksPerChar(last) ? kBreakNone : kBreakWord;
+        current.source = source;
+        units.push_back(std::move(current));
+        current = Unit();
+    };
+
+    size_t i = 0;
+    while (i < text.size()) {
+        size_t begin = i;
+        char32_t cp = decodeUtf8(text, i);
+        if (isSpace(cp)) {
+            flush();
+            pendingSpace = true;
+            continue;
+        }
+        // CJK 字符前后可以断开 (遵守避头尾)
+        bool split = current.length > 0 && !noBreakAfter(last) && !noBreakBefore(cp) &&
+                     (breaksPerChar(cp) || breaksPerChar(last));
+        if (split) {
+            flush();
+        }
+        if (current.length == 0) {
+            current.spaceBefore = pendingSpace;
+            current.offset = static_cast<uint32_t>(begin);
+            pendingSpace = false;
+        }
+        if (head == 0) head = cp;
+        current.length += static_cast<uint32_t>(i - begin);
+        if (isWide(cp)) current.cjk++; else current.latin++;
+        last = cp;
+    }
+    flush();
+
+    if (units.size() == first) return;
+
+    // 原片段边界至少是从句边界; 与前一片段之间是否加空格取决于两侧是否为中日文字
+    units[first].spaceBefore = !(breaksPerChar(head) || breaksPerChar(previousTail));
+    previousTail = last;
+    units.back().breakAfter = std::max(units.back().breakAfter, kBreakClause);
+
+    // CJK 字符按两倍权重分配时间 (一个字通常对应一个以上音节)
+    double total = 0.0;
+    for (size_t u = first; u < units.size(); u++) total += units[u].latin + 2.0 * units[u].cjk;
+    const double span = std::max(0.0, segment.endTime - segment.startTime);
+    double cumulative = 0.0;
+    for (size_t u = first; u < units.size(); u++) {
+        units[u].start = segment.startTime + (total > 0 ? span * cumulative / total : 0.0);
+        cumulative += units[u].latin + 2.0 * units[u].cjk;
+        units[u].end = segment.startTime + (total > 0 ? span * cumulative / total : span);
+    }
+}
+
+// 逐单元贪心排版, 用于判断一条字幕需要几行
+class LineFiller {
+public:
+    LineFiller(const std::vector<Unit>& units, const SegmentationOptions& options)
+        : units(units), latinWidth(1.0 / std::max(1, options.maxCharsPerLine)),
+          cjkWidth(1.0 / std::max(1, options.maxCjkCharsPerLine)) {
+    }
+
+    double width(size_t u) const {
+        return units[u].latin * latinWidth + units[u].cjk * cjkWidth;
+    }
+
+    double spaceWidth(size_t u, size_t first) const {
+        return u > first && units[u].spaceBefore ? latinWidth : 0.0;
+    }
+
+    void reset(size_t first) {
+        cueFirst = first;
+        lines = 0;
+        lineFill = 0.0;
+    }
+
+    // 追加单元后的行数
+    int linesAfter(size_t u) const {
+        int l = lines;
+        double f = lineFill;
+        add(u, l, f);
+        return l;
+    }
+
+    void push(size_t u) {
+        add(u, lines, lineFill);
+    }
+
+    int lineCount() const { return lines; }
+
+private:
+    void add(size_t u, int& l, double& f) const {
+        double w = width(u);
+        if (l == 0) {
+            l = 1;
+            f = w;
+        } else if (f + spaceWidth(u, cueFirst) + w <= 1.0 + 1e-9) {
+            f += spaceWidth(u, cueFirst) + w;
+        } else {
+            l++;
+            f = w;
+        }
+        // 超过一行宽的单元 (长单词) 独占多行
+        while (f > 1.0 + 1e-9) {
+            l++;
+            f -= 1.0;
+        }
+    }
+
+    const std::vector<Unit>& units;
+    double latinWidth;
+    double cjkWidth;
+    size_t cueFirst = 0;
+    int lines = 0;
+    double lineFill = 0.0;
+};
+
+// 在 (first, end) 的后半段中选择质量最高的断点, 同等质量取最靠后的
+size_t chooseBreak(const std::vector<Unit>& units, size_t first, size_t end) {
+    size_t best = end;
+    int bestScore = -1;
+    for (size_t j = end; j > first + (end - first) / 2 && j > first + 1; j--) {
+        int score = units[j - 1].breakAfter;
+        if (score > bestScore) {
+            bestScore = score;
+            best = j;
+        }
+    }
+    return best;
+}
+
+// 生成一条字幕: 两行时在标点附近均分, 更多行时贪心填充
+TranscriptSegment buildCue(const std::vector<Unit>& units, size_t first, size_t end,
+                           const std::vector<TranscriptSegment>& segments, const LineFiller& filler,
+                           int lineCount) {
+    std::vector<size_t> lineStarts{first};
+    if (lineCount == 2) {
+        double total = 0.0;
+        for (size_t u = first; u < end; u++) total += filler.spaceWidth(u, first) + filler.width(u);
+        double prefix = 0.0;
+        double bestCost = 1e9;
+        size_t best = 0;
+        for (size_t j = first + 1; j < end; j++) {
+            prefix += filler.spaceWidth(j - 1, first) + filler.width(j - 1);
+            double rest = total - prefix - filler.spaceWidth(j, first);
+            if (prefix > 1.0 + 1e-9) break;
+            if (rest > 1.0 + 1e-9) continue;
+            double cost = std::fabs(prefix - rest) - kBreakBonus * units[j - 1].breakAfter;
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = j;
+            }
+        }
+        if (best > 0) lineStarts.push_back(best);
+    }
+    if (lineCount > 2 || (lineCount == 2 && lineStarts.size() == 1)) {
+        double fill = 0.0;
+        for (size_t u = first; u < end; u++) {
+            double w = filler.width(u);
+            double space = u == lineStarts.back() ? 0.0 : filler.spaceWidth(u, first);
+            if (u > lineStarts.back() && fill + space + w > 1.0 + 1e-9) {
+                lineStarts.push_back(u);
+                fill = w;
+            } else {
+                fill += space + w;
+            }
+        }
+    }
+
+    TranscriptSegment cue;
+    cue.startTime = units[first].start;
+    cue.endTime = units[end - 1].end;
+    cue.speaker = segments[units[first].source].speaker;
+    cue.avgLogprob = 0.0;
+    cue.noSpeechProb = 0.0;
+    cue.compressionRatio = 0.0;
+
+    // 统计量按来源片段的字符占比加权
+    double weightSum = 0.0;
+    size_t line = 0;
+    for (size_t u = first; u < end; u++) {
+        if (line + 1 < lineStarts.size() && u == lineStarts[line + 1]) {
+            cue.text += '\n';
+            line++;
+        } else if (u > first && units[u].spaceBefore) {
+            cue.text += ' ';
+        }
+        const TranscriptSegment& src = segments[units[u].source];
+        cue.text.append(src.text, units[u].offset, units[u].length);
+
+        double w = units[u].latin + 2.0 * units[u].cjk;
+        weightSum += w;
+        cue.avgLogprob += w * src.avgLogprob;
+        cue.noSpeechProb += w * src.noSpeechProb;
+        cue.compressionRatio = std::max(cue.compressionRatio, src.compressionRatio);
+        cue.lowConfidence = cue.lowConfidence || src.lowConfidence;
+        double srcSpan = src.endTime - src.startTime;
+        if (srcSpan > 0) {
+            cue.decodeTimeMs += src.decodeTimeMs * (units[u].end - units[u].start) / srcSpan;
+        }
+    }
+    if (weightSum > 0) {
+        cue.avgLogprob /= weightSum;
+        cue.noSpeechProb /= weightSum;
+    }
+    if (cue.compressionRatio <= 0.0) cue.compressionRatio = 1.0;
+    return cue;
+}
+
+} // namespace
+
+std::vector<TranscriptSegment> resegment(const std::vector<TranscriptSegment>& segments,
+                                         const SegmentationOptions& options) {
+    std::vector<Unit> units;
+    units.reserve(segments.size() * 8);
+    char32_t tail = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        size_t before = units.size();
+        tokenize(segments[i], i, units, tail);
+        if (before == 0 || units.size() == before) continue;
+
+        // 片段之间: 说话人切换或长停顿必须断开, 短停顿视为句子边界
+        Unit& prev = units[before - 1];
+        double gap = units[before].start - prev.end;
+        if (segments[prev.source].speaker != segments[i].speaker || gap >= options.pauseThreshold) {
+            prev.hardBreakAfter = true;
+        } else if (gap >= kShortPause) {
+            prev.breakAfter = kBreakSentence;
+        }
+    }
+
+    std::vector<TranscriptSegment> cues;
+    if (units.empty()) return cues;
+
+    const int maxLines = std::max(1, options.maxLines);
+    LineFiller filler(units, options);
+    size_t first = 0;
+    filler.reset(first);
+
+    auto emit = [&](size_t end) {
+        LineFiller layout(units, options);
+        layout.reset(first);
+        for (size_t u = first; u < end; u++) layout.push(u);
+        cues.push_back(buildCue(units, first, end, segments, layout, layout.lineCount()));
+    };
+
+    size_t i = 0;
+    while (i < units.size()) {
+        if (i > first) {
+            const Unit& prev = units[i - 1];
+            bool sentence = prev.breakAfter >= kBreakSentence &&
+                            prev.end - units[first].start >= options.minDuration;
+            if (prev.hardBreakAfter || sentence) {
+                emit(i);
+                first = i;
+                filler.reset(first);
+                continue;
+            }
+
+            bool tooLong = units[i].end - units[first].start > options.maxDuration;
+            if (filler.linesAfter(i) > maxLines || tooLong) {
+                // 回退到后半段中最好的断点, 断点之后的单元重新排入下一条字幕
+                size_t cut = chooseBreak(units, first, i);
+                emit(cut);
+                first = cut;
+                filler.reset(first);
+                for (size_t u = first; u < i; u++) filler.push(u);
+                continue;
+            }
+        }
+        filler.push(i);
+        i++;
+    }
+    emit(units.size());
+
+    // 时长: 满足最短时长与阅读速度, 但不侵占下一条字幕
+    // 阅读速度只用于延长结束时间, 不会导致切分: 语速由音频决定, 切分后每条的字数 / 秒不变;
+    // 与下一条字幕之间没有足够间隔时, 该字幕仍会超过阅读速度上限
+    for (size_t c = 0; c < cues.size(); c++) {
+        TranscriptSegment& cue = cues[c];
+        int latin = 0;
+        int cjk = 0;
+        for (size_t k = 0; k < cue.text.size();) {
+            char32_t cp = decodeUtf8(cue.text, k);
+            if (isSpace(cp)) continue;
+            if (isWide(cp)) cjk++; else latin++;
+        }
+        double reading = latin / std::max(1.0, options.maxCharsPerSecond) +
+                         cjk / std::max(1.0, options.maxCjkCharsPerSecond);
+        double needed = std::min(std::max(options.minDuration, reading), options.maxDuration);
+        double limit = c + 1 < cues.size() ? cues[c + 1].startTime - options.minGap : cue.startTime + needed;
+
+        if (cue.endTime - cue.startTime < needed) {
+            cue.endTime = std::max(cue.endTime, std::min(cue.startTime + needed, limit));
+        }
+        if (cue.endTime > limit && limit > cue.startTime) {
+            cue.endTime = limit;
+        }
+    }
+    return cues;
+}
+
+} // namespace llwhisper
@@ -0,0 +1,183 @@
+#include "transcript_checkpoint.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+
+namespace llwhisper {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// 2: S 行带有片段统计量与说话人
+const char* const kMagic = "LLWHISPER-CHECKPOINT 2";
+const int kSegmentFields = 9;       // S 行中 "S" 之后的字段数 (文本在最后)
+
+// 文本中的反斜杠、制表符与换行转义后写成一行
+std::string escapeText(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '\\': result += "\\\\"; break;
+            case '\t': result += "\\t"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            default: result += c; break;
+        }
+    }
+    return result;
+}
+
+std::string unescapeText(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] != '\\' || i + 1 == text.size()) {
+            result += text[i];
+            continue;
+        }
+        char c = text[++i];
+        result += c == 't' ? '\t' : c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+    }
+    return result;
+}
+
+// double 以 17 位有效数字写出, 读回后与原值相同
+std::string formatDouble(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    return buffer;
+}
+
+} // namespace
+
+bool TranscriptCheckpoint::load(const std::string& path, const std::string& key, CheckpointData& data) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.good()) {
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(in, line) || line != kMagic) return false;
+    if (!std::getline(in, line) || line != "K\t" + key) return false;
+
+    data = CheckpointData();
+    data.validBytes = static_cast<uint64_t>(in.tellg());
+    std::vector<TranscriptSegment> pending;
+
+    while (std::getline(in, line)) {
+        // 最后一行没有换行符说明写入被中断
+        if (in.eof()) break;
+        if (line.empty()) continue;
+
+        switch (line[0]) {
+            case 'S': {
+                // S \t start_ms \t end_ms \t speaker \t avg_logprob \t no_speech_prob \t compression_ratio
+                //   \t low_confidence \t decode_ms \t text
+                size_t fields[kSegmentFields];
+                size_t pos = 1;
+                for (int f = 0; f < kSegmentFields; f++) {
+                    pos = line.find('\t', pos);
+                    if (pos == std::string::npos) return false;
+                    fields[f] = ++pos;
+                }
+                const char* c = line.c_str();
+                TranscriptSegment segment;
+                segment.startTime = std::strtoll(c + fields[0], nullptr, 10) / 1000.0;
+                segment.endTime = std::strtoll(c + fields[1], nullptr, 10) / 1000.0;
+                segment.speaker = std::atoi(c + fields[2]);
+                segment.avgLogprob = std::strtod(c + fields[3], nullptr);
+                segment.noSpeechProb = std::strtod(c + fields[4], nullptr);
+                segment.compressionRatio = std::strtod(c + fields[5], nullptr);
+                segment.lowConfidence = std::atoi(c + fields[6]) != 0;
+                segment.decodeTimeMs = std::strtod(c + fields[7], nullptr);
+                segment.text = unescapeText(line.substr(fields[8]));
+                pending.push_back(segment);
+                break;
+            }
+            case 'O':
+                // 提交记录: 之前的片段全部生效
+                data.offsetMs = std::atoi(line.c_str() + 2);
+                data.segments.insert(data.segments.end(), pending.begin(), pending.end());
+                pending.clear();
+                data.validBytes = static_cast<uint64_t>(in.tellg());
+                break;
+            case 'P': {
+                data.promptTokens.clear();
+                std::istringstream tokens(line.substr(2));
+                int32_t token;
+                while (tokens >> token) data.promptTokens.push_back(token);
+                data.validBytes = static_cast<uint64_t>(in.tellg());
+                break;
+            }
+            case 'E':
+                data.complete = true;
+                data.validBytes = static_cast<uint64_t>(in.tellg());
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+bool TranscriptCheckpoint::open(const std::string& path, const std::string& key, const CheckpointData* resumed) {
+    if (out.is_open()) out.close();
+
+    // 去掉崩溃时写了一半的行和未提交的片段, 否则新记录会接在残行后面,
+    // 未提交的片段也会被下一条提交记录当作已完成
+    if (resumed) {
+        std::error_code ec;
+        fs::resize_file(path, resumed->validBytes, ec);
+        if (ec) return false;
+    }
+
+    out.open(path, std::ios::binary | (resumed ? std::ios::app : std::ios::trunc));
+    if (!out.is_open()) {
+        return false;
+    }
+    if (!resumed) {
+        out << kMagic << '\n' << "K\t" << key << '\n';
+        out.flush();
+    }
+    return out.good();
+}
+
+void TranscriptCheckpoint::commit(const std::vector<TranscriptSegment>& segments, int offsetMs,
+                                  const std::vector<int32_t>& promptTokens) {
+    if (!out.is_open()) return;
+
+    std::string buffer;
+    for (const TranscriptSegment& segment : segments) {
+        buffer += "S\t" + std::to_string(segment.startMs()) +
+                  "\t" + std::to_string(segment.endMs()) +
+                  "\t" + std::to_string(segment.speaker) +
+                  "\t" + formatDouble(segment.avgLogprob) +
+                  "\t" + formatDouble(segment.noSpeechProb) +
+                  "\t" + formatDouble(segment.compressionRatio) +
+                  "\t" + (segment.lowConfidence ? "1" : "0") +
+                  "\t" + formatDouble(segment.decodeTimeMs) +
+                  "\t" + escapeText(segment.text) + "\n";
+    }
+    buffer += "O\t" + std::to_string(offsetMs) + "\n";
+    buffer += "P\t";
+    for (size_t i = 0; i < promptTokens.size(); i++) {
+        if (i > 0) buffer += ' ';
+        buffer += std::to_string(promptTokens[i]);
+    }
+    buffer += "\n";
+
+    // 一次写入并立即刷新, 进程崩溃时最多丢失当前窗口
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+}
+
+void TranscriptCheckpoint::markComplete() {
+    if (!out.is_open()) return;
+    out << "E\n";
+    out.flush();
+}
+
+} // namespace llwhisper
@@ -0,0 +1,336 @@
+#include "transcript_store.h"
+#include <algorithm>
+#include <limits>
+
+namespace llwhisper {
+
+namespace {
+
+constexpr uint32_t kNoPosition = std::numeric_limits<uint32_t>::max();
+
+std::mutex registryMutex;
+std::unordered_map<std::string, std::shared_ptr<TranscriptStore>> registry;
+
+// 解码一个 UTF-8 码点, 非法字节按单字节 U+FFFD 处理
+uint32_t decodeUtf8(const std::string& s, size_t& i) {
+    unsigned char c = static_cast<unsigned char>(s[i]);
+    size_t len = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+    if (len == 0 || i + len > s.size()) {
+        ++i;
+        return 0xFFFD;
+    }
+    uint32_t cp = len == 1 ? c : c & (0x7F >> len);
+    for (size_t k = 1; k < len; ++k) {
+        unsigned char cc = static_cast<unsigned char>(s[i + k]);
+        if ((cc & 0xC0) != 0x80) {
+            ++i;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    i += len;
+    return cp;
+}
+
+void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// 搜索用的码点规范化: 全角英数字 / 符号转半角, 全角空格转空格, ASCII 大写转小写
+inline uint32_t foldCodePoint(uint32_t cp) {
+    if (cp >= 0xFF01 && cp <= 0xFF5E) cp -= 0xFEE0;
+    else if (cp == 0x3000) cp = ' ';
+    if (cp >= 'A' && cp <= 'Z') cp += 'a' - 'A';
+    return cp;
+}
+
+// 规范化文本并追加码点 (codePoints 可为空)
+void normalize(const std::string& text, std::string& out, std::vector<uint32_t>* codePoints) {
+    for (size_t i = 0; i < text.size();) {
+        uint32_t cp = foldCodePoint(decodeUtf8(text, i));
+        appendUtf8(out, cp);
+        if (codePoints) codePoints->push_back(cp);
+    }
+}
+
+inline uint64_t bigramKey(uint32_t a, uint32_t b) {
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+// 片段的全部二元组 (去重); 原文与译文之间的 '\n' 保证不会跨字段匹配
+std::vector<uint64_t> bigramsOf(const std::vector<uint32_t>& cps) {
+    std::vector<uint64_t> keys;
+    if (cps.size() < 2) return keys;
+    keys.reserve(cps.size() - 1);
+    for (size_t i = 0; i + 1 < cps.size(); ++i) {
+        keys.push_back(bigramKey(cps[i], cps[i + 1]));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+} // namespace
+
+std::shared_ptr<TranscriptStore> TranscriptStore::create(const std::string& key, std::vector<StoredSegment> segments) {
+    std::stable_sort(segments.begin(), segments.end(), [](const StoredSegment& a, const StoredSegment& b) {
+        return a.startTime < b.startTime;
+    });
+
+    auto store = std::make_shared<TranscriptStore>();
+    store->slots.resize(segments.size());
+    store->order.resize(segments.size());
+    store->position.resize(segments.size());
+    store->maxEnd.resize(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i) {
+        store->slots[i].segment = std::move(segments[i]);
+        store->order[i] = static_cast<uint32_t>(i);
+        store->position[i] = static_cast<uint32_t>(i);
+        // 槽号递增, 倒排表按追加顺序即为升序
+        store->indexSlot(static_cast<uint32_t>(i));
+    }
+    store->renumber(0);
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry[key] = store;
+    return store;
+}
+
+std::shared_ptr<TranscriptStore> TranscriptStore::get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = registry.find(key);
+    return it != registry.end() ? it->second : nullptr;
+}
+
+bool TranscriptStore::release(const std::string& key) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return registry.erase(key) > 0;
+}
+
+void TranscriptStore::indexSlot(uint32_t slot) {
+    Slot& s = slots[slot];
+    std::vector<uint32_t> cps;
+    s.normalized.clear();
+    normalize(s.segment.text, s.normalized, &cps);
+    s.normalized += '\n';
+    cps.push_back('\n');
+    normalize(s.segment.translatedText, s.normalized, &cps);
+
+    for (uint64_t key : bigramsOf(cps)) {
+        std::vector<uint32_t>& list = postings[key];
+        if (list.empty() || list.back() < slot) {
+            list.push_back(slot);
+        } else {
+            auto it = std::lower_bound(list.begin(), list.end(), slot);
+            if (it == list.end() || *it != slot) list.insert(it, slot);
+        }
+    }
+}
+
+void TranscriptStore::unindexSlot(uint32_t slot) {
+    std::vector<uint32_t> cps;
+    cps.reserve(slots[slot].normalized.size());
+    const std::string& normalized = slots[slot].normalized;
+    for (size_t i = 0; i < normalized.size();) {
+        cps.push_back(decodeUtf8(normalized, i));
+    }
+    for (uint64_t key : bigramsOf(cps)) {
+        auto found = postings.find(key);
+        if (found == postings.end()) continue;
+        std::vector<uint32_t>& list = found->second;
+        auto it = std::lower_bound(list.begin(), list.end(), slot);
+        if (it != list.end() && *it == slot) list.erase(it);
+        if (list.empty()) postings.erase(found);
+    }
+    slots[slot].normalized.clear();
+}
+
+// 重新编号 from 之后的下标, 并更新结束时间的前缀最大值
+void TranscriptStore::renumber(size_t from) {
+    maxEnd.resize(order.size());
+    double end = from > 0 ? maxEnd[from - 1] : 0.0;
+    for (size_t i = from; i < order.size(); ++i) {
+        position[order[i]] = static_cast<uint32_t>(i);
+        end = std::max(end, slots[order[i]].segment.endTime);
+        maxEnd[i] = end;
+    }
+}
+
+size_t TranscriptStore::sortedPosition(double startTime) const {
+    auto it = std::upper_bound(order.begin(), order.end(), startTime, [this](double t, uint32_t slot) {
+        return t < slots[slot].segment.startTime;
+    });
+    return static_cast<size_t>(it - order.begin());
+}
+
+size_t TranscriptStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return order.size();
+}
+
+double TranscriptStore::duration() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxEnd.empty() ? 0.0 : maxEnd.back();
+}
+
+std::vector<StoredSegment> TranscriptStore::range(size_t start, size_t count) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<StoredSegment> result;
+    if (start >= order.size()) return result;
+    size_t end = start + std::min(count, order.size() - start);
+    result.reserve(end - start);
+    for (size_t i = start; i < end; ++i) {
+        result.push_back(slots[order[i]].segment);
+    }
+    return result;
+}
+
+size_t TranscriptStore::indexAt(double time) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    // 最后一个开始时间 <= time 的片段; 它已经结束时取下一个
+    size_t pos = sortedPosition(time);
+    if (pos > 0 && slots[order[pos - 1]].segment.endTime > time) {
+        return pos - 1;
+    }
+    return pos;
+}
+
+std::vector<StoredSegment> TranscriptStore::rangeByTime(double startTime, double endTime, size_t& first) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    // 前缀最大结束时间单调不减: 第一个超过 startTime 的位置就是第一个仍覆盖 startTime 的片段
+    // (不论它开始得多早); 没有时从第一个开始于 startTime 之后的片段开始
+    size_t pos = sortedPosition(startTime);
+    auto covering = std::upper_bound(maxEnd.begin(), maxEnd.begin() + static_cast<std::ptrdiff_t>(pos), startTime);
+    first = static_cast<size_t>(covering - maxEnd.begin());
+
+    std::vector<StoredSegment> result;
+    for (size_t i = first; i < order.size(); ++i) {
+        const StoredSegment& seg = slots[order[i]].segment;
+        if (seg.startTime >= endTime) break;
+        result.push_back(seg);
+    }
+    return result;
+}
+
+std::vector<uint32_t> TranscriptStore::search(const std::string& query, size_t limit, size_t& total) const {
+    total = 0;
+    std::string needle;
+    std::vector<uint32_t> cps;
+    normalize(query, needle, &cps);
+    std::vector<uint32_t> result;
+    if (cps.empty()) return result;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cps.size() == 1) {
+        // 单个字符没有二元组, 直接扫描规范化文本
+        for (uint32_t slot : order) {
+            if (slots[slot].normalized.find(needle) != std::string::npos) {
+                result.push_back(position[slot]);
+            }
+        }
+        total = result.size();
+        if (result.size() > limit) result.resize(limit);
+        return result;
+    }
+
+    // 从最短的倒排表开始求交集
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (uint64_t key : bigramsOf(cps)) {
+        auto it = postings.find(key);
+        if (it == postings.end()) return result;
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) {
+        return a->size() < b->size();
+    });
+    std::vector<uint32_t> candidates = *lists[0];
+    for (size_t l = 1; l < lists.size() && !candidates.empty(); ++l) {
+        const std::vector<uint32_t>& list = *lists[l];
+        size_t kept = 0;
+        auto cursor = list.begin();
+        for (uint32_t slot : candidates) {
+            cursor = std::lower_bound(cursor, list.end(), slot);
+            if (cursor == list.end()) break;
+            if (*cursor == slot) candidates[kept++] = slot;
+        }
+        candidates.resize(kept);
+    }
+
+    // 二元组都出现不代表顺序相邻, 在规范化文本上确认
+    for (uint32_t slot : candidates) {
+        if (slots[slot].normalized.find(needle) != std::string::npos) {
+            result.push_back(position[slot]);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    total = result.size();
+    if (result.size() > limit) result.resize(limit);
+    return result;
+}
+
+bool TranscriptStore::update(size_t index, const StoredSegment& segment, size_t& newIndex) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index >= order.size()) return false;
+    replace(index, segment, newIndex);
+    return true;
+}
+
+bool TranscriptStore::update(size_t index, const std::function<void(StoredSegment&)>& edit, size_t& newIndex) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index >= order.size()) return false;
+    StoredSegment segment = slots[order[index]].segment;
+    edit(segment);
+    replace(index, segment, newIndex);
+    return true;
+}
+
+void TranscriptStore::replace(size_t index, const StoredSegment& segment, size_t& newIndex) {
+    uint32_t slot = order[index];
+    Slot& s = slots[slot];
+    const bool textChanged = s.segment.text != segment.text || s.segment.translatedText != segment.translatedText;
+    const bool moved = s.segment.startTime != segment.startTime;
+    const bool resized = s.segment.endTime != segment.endTime;
+
+    if (textChanged) unindexSlot(slot);
+    s.segment = segment;
+    if (textChanged) indexSlot(slot);
+
+    newIndex = index;
+    if (moved) {
+        // 先移出再按新的开始时间插回 (相同开始时间的片段之后)
+        order.erase(order.begin() + index);
+        newIndex = sortedPosition(segment.startTime);
+        order.insert(order.begin() + newIndex, slot);
+        renumber(std::min(index, newIndex));
+    } else if (resized) {
+        renumber(index);
+    }
+}
+
+bool TranscriptStore::remove(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index >= order.size()) return false;
+    uint32_t slot = order[index];
+    unindexSlot(slot);
+    slots[slot].segment = StoredSegment();
+    position[slot] = kNoPosition;
+    order.erase(order.begin() + index);
+    renumber(index);
+    return true;
+}
+
+} // namespace llwhisper
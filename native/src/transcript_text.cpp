@@ -0,0 +1,195 @@
+#include "transcript_text.h"
+
+namespace llwhisper {
+
+namespace {
+
+inline char* put2(char* p, uint32_t value) {
+    p[0] = static_cast<char>('0' + value / 10);
+    p[1] = static_cast<char>('0' + value % 10);
+    return p + 2;
+}
+
+inline char* put3(char* p, uint32_t value) {
+    p[0] = static_cast<char>('0' + value / 100);
+    p[1] = static_cast<char>('0' + value / 10 % 10);
+    p[2] = static_cast<char>('0' + value % 10);
+    return p + 3;
+}
+
+// 两位数字, 超过 99 时按实际位数
+inline char* putAtLeast2(char* p, uint64_t value) {
+    if (value < 100) return put2(p, static_cast<uint32_t>(value));
+    return p + writeUnsigned(p, value);
+}
+
+// UTF-8 首字节对应的序列长度, 非法首字节返回 0
+inline size_t utf8Length(unsigned char c) {
+    if (c < 0x80) return 1;
+    if (c >= 0xC2 && c <= 0xDF) return 2;
+    if (c >= 0xE0 && c <= 0xEF) return 3;
+    if (c >= 0xF0 && c <= 0xF4) return 4;
+    return 0;
+}
+
+// s[i] 起的空白字符字节数 (不是空白时为 0)
+inline size_t whitespaceLength(const char* s, size_t i, size_t n) {
+    unsigned char c = static_cast<unsigned char>(s[i]);
+    if (c == ' ' || (c >= '\t' && c <= '\r')) return 1;
+    if (c == 0xC2 && i + 1 < n && static_cast<unsigned char>(s[i + 1]) == 0xA0) return 2;
+    return 0;
+}
+
+// s[i] 起的特殊 token 字节数 (不是特殊 token 时为 0)
+inline size_t specialTokenLength(const char* s, size_t i, size_t n) {
+    const size_t kMaxToken = 48;
+    if (i + 1 >= n) return 0;
+    if (s[i] == '<' && s[i + 1] == '|') {
+        // <|xxx|>, 内部不含空白
+        for (size_t j = i + 2; j + 1 < n && j - i < kMaxToken; ++j) {
+            if (s[j] == '|' && s[j + 1] == '>') return j + 2 - i;
+            if (s[j] == ' ' || s[j] == '<') return 0;
+        }
+        return 0;
+    }
+    if (s[i] == '[' && s[i + 1] == '_') {
+        // [_BEG_] / [_TT_1500], 内部只有大写字母、数字、下划线
+        for (size_t j = i + 2; j < n && j - i < kMaxToken; ++j) {
+            char c = s[j];
+            if (c == ']') return j > i + 2 ? j + 1 - i : 0;
+            if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')) return 0;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+size_t writeUnsigned(char* out, uint64_t value) {
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+size_t writeTimestamp(char* out, int64_t ms, char separator) {
+    uint64_t t = ms > 0 ? static_cast<uint64_t>(ms) : 0;
+    const uint32_t millis = static_cast<uint32_t>(t % 1000);
+    t /= 1000;
+    const uint32_t secs = static_cast<uint32_t>(t % 60);
+    t /= 60;
+    const uint32_t minutes = static_cast<uint32_t>(t % 60);
+    const uint64_t hours = t / 60;
+
+    char* p = putAtLeast2(out, hours);
+    *p++ = ':';
+    p = put2(p, minutes);
+    *p++ = ':';
+    p = put2(p, secs);
+    *p++ = separator;
+    p = put3(p, millis);
+    return static_cast<size_t>(p - out);
+}
+
+size_t writeLrcTimestamp(char* out, int64_t ms) {
+    uint64_t centis = ms > 0 ? (static_cast<uint64_t>(ms) + 5) / 10 : 0;
+    const uint32_t fraction = static_cast<uint32_t>(centis % 100);
+    centis /= 100;
+    const uint32_t secs = static_cast<uint32_t>(centis % 60);
+    const uint64_t minutes = centis / 60;
+
+    char* p = out;
+    *p++ = '[';
+    p = putAtLeast2(p, minutes);
+    *p++ = ':';
+    p = put2(p, secs);
+    *p++ = '.';
+    p = put2(p, fraction);
+    *p++ = ']';
+    return static_cast<size_t>(p - out);
+}
+
+size_t writeSeconds(char* out, int64_t ms) {
+    char* p = out;
+    uint64_t t;
+    if (ms < 0) {
+        *p++ = '-';
+        t = static_cast<uint64_t>(-(ms + 1)) + 1;
+    } else {
+        t = static_cast<uint64_t>(ms);
+    }
+    p += writeUnsigned(p, t / 1000);
+    *p++ = '.';
+    p = put3(p, static_cast<uint32_t>(t % 1000));
+    return static_cast<size_t>(p - out);
+}
+
+void normalizeSegmentText(std::string& text, std::string* carry) {
+    if (carry && !carry->empty()) {
+        text.insert(0, *carry);
+        carry->clear();
+    }
+    char* s = &text[0];
+    const size_t n = text.size();
+    size_t w = 0;
+    bool pendingSpace = false;
+
+    for (size_t r = 0; r < n;) {
+        // 快速路径: 普通可见 ASCII 字符直接复制
+        const unsigned char c = static_cast<unsigned char>(s[r]);
+        if (c > ' ' && c < 0x7F && c != '<' && c != '[') {
+            if (pendingSpace && w > 0) {
+                s[w++] = ' ';
+            }
+            pendingSpace = false;
+            s[w++] = s[r++];
+            continue;
+        }
+
+        size_t len = whitespaceLength(s, r, n);
+        if (len > 0) {
+            pendingSpace = true;
+            r += len;
+            continue;
+        }
+        len = specialTokenLength(s, r, n);
+        if (len > 0) {
+            r += len;
+            continue;
+        }
+
+        // 校验 UTF-8 序列, 不完整的整段丢弃
+        len = utf8Length(c);
+        bool valid = len > 0;
+        for (size_t k = 1; valid && k < len && r + k < n; ++k) {
+            valid = (static_cast<unsigned char>(s[r + k]) & 0xC0) == 0x80;
+        }
+        if (valid && r + len > n) {
+            // 被片段末尾截断的字符: 交给下一片段补全
+            if (carry) carry->assign(s + r, n - r);
+            break;
+        }
+        if (!valid) {
+            r++;
+            continue;
+        }
+
+        // 空白只在两段文本之间输出, 首尾空白因此自然去掉
+        if (pendingSpace && w > 0) {
+            s[w++] = ' ';
+        }
+        pendingSpace = false;
+        for (size_t k = 0; k < len; ++k) {
+            s[w++] = s[r++];
+        }
+    }
+    text.resize(w);
+}
+
+} // namespace llwhisper
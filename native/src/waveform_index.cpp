@@ -0,0 +1,488 @@
+#include "waveform_index.h"
+#include "ffmpeg_context_pool.h"
+#include "ffmpeg_demux.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define LLVIDEO_WAVEFORM_SSE 1
+#endif
+
+extern "C" {
+#include <libswresample/swresample.h>
+}
+
+namespace llvideo {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kMagic[8] = {'L', 'L', 'W', 'A', 'V', 'E', '1', '\0'};
+constexpr uint32_t kVersion = 1;
+
+// 已读取的索引, 按 sidecar 的修改时间判断是否失效
+struct CacheEntry {
+    int64_t mtime = 0;
+    std::shared_ptr<const WaveformIndex> index;
+};
+
+std::mutex cacheMutex;
+std::unordered_map<std::string, CacheEntry> cache;
+
+void storeInCache(const std::string& indexPath, std::shared_ptr<const WaveformIndex> index) {
+    std::error_code ec;
+    int64_t mtime = fs::last_write_time(indexPath, ec).time_since_epoch().count();
+    if (ec) return;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache[indexPath] = CacheEntry{mtime, std::move(index)};
+}
+
+// 一段样本的 min / max / 平方和 (峰值构建的热点, 每个样本只访问一次)
+void scanBlock(const float* x, size_t n, float& mn, float& mx, double& sumSq) {
+    size_t i = 0;
+#ifdef LLVIDEO_WAVEFORM_SSE
+    if (n >= 4) {
+        __m128 vmin = _mm_loadu_ps(x);
+        __m128 vmax = vmin;
+        __m128 vsum = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(x + i);
+            vmin = _mm_min_ps(vmin, v);
+            vmax = _mm_max_ps(vmax, v);
+            vsum = _mm_add_ps(vsum, _mm_mul_ps(v, v));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, vmin);
+        mn = std::min({mn, lanes[0], lanes[1], lanes[2], lanes[3]});
+        _mm_storeu_ps(lanes, vmax);
+        mx = std::max({mx, lanes[0], lanes[1], lanes[2], lanes[3]});
+        _mm_storeu_ps(lanes, vsum);
+        sumSq += (static_cast<double>(lanes[0]) + lanes[1]) + (static_cast<double>(lanes[2]) + lanes[3]);
+    }
+#endif
+    for (; i < n; i++) {
+        mn = std::min(mn, x[i]);
+        mx = std::max(mx, x[i]);
+        sumSq += static_cast<double>(x[i]) * x[i];
+    }
+}
+
+int16_t quantize(float value) {
+    long q = std::lround(value * 32767.0f);
+    return static_cast<int16_t>(std::clamp(q, -32768L, 32767L));
+}
+
+// 构建期间使用的浮点峰值 (meanSq 与 count 用于向上聚合 rms)
+struct FloatLevel {
+    uint32_t samplesPerPeak = 0;
+    std::vector<float> min;
+    std::vector<float> max;
+    std::vector<float> meanSq;
+    std::vector<uint32_t> count;
+};
+
+// 以 blockSize 为单位累积最精细一层
+class PeakAccumulator {
+public:
+    explicit PeakAccumulator(uint32_t blockSize) : blockSize(blockSize) {
+        level.samplesPerPeak = blockSize;
+        reset();
+    }
+
+    void push(const float* x, size_t n) {
+        total += n;
+        while (n > 0) {
+            size_t take = std::min<size_t>(n, blockSize - filled);
+            scanBlock(x, take, curMin, curMax, curSumSq);
+            filled += static_cast<uint32_t>(take);
+            x += take;
+            n -= take;
+            if (filled == blockSize) emit();
+        }
+    }
+
+    FloatLevel finish() {
+        if (filled > 0) emit();
+        return std::move(level);
+    }
+
+    uint64_t totalSamples() const { return total; }
+
+private:
+    void emit() {
+        level.min.push_back(curMin);
+        level.max.push_back(curMax);
+        level.meanSq.push_back(static_cast<float>(curSumSq / filled));
+        level.count.push_back(filled);
+        reset();
+    }
+
+    void reset() {
+        curMin = 1.0f;
+        curMax = -1.0f;
+        curSumSq = 0.0;
+        filled = 0;
+    }
+
+    uint32_t blockSize;
+    FloatLevel level;
+    float curMin = 1.0f;
+    float curMax = -1.0f;
+    double curSumSq = 0.0;
+    uint32_t filled = 0;
+    uint64_t total = 0;
+};
+
+// 每 factor 个峰值合并为上一层的一个峰值
+FloatLevel reduceLevel(const FloatLevel& src, int factor) {
+    FloatLevel dst;
+    dst.samplesPerPeak = src.samplesPerPeak * factor;
+    const size_t n = (src.min.size() + factor - 1) / factor;
+    dst.min.resize(n);
+    dst.max.resize(n);
+    dst.meanSq.resize(n);
+    dst.count.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        size_t begin = i * factor;
+        size_t end = std::min(begin + factor, src.min.size());
+        float mn = src.min[begin];
+        float mx = src.max[begin];
+        double sumSq = 0.0;
+        uint32_t count = 0;
+        for (size_t j = begin; j < end; j++) {
+            mn = std::min(mn, src.min[j]);
+            mx = std::max(mx, src.max[j]);
+            sumSq += static_cast<double>(src.meanSq[j]) * src.count[j];
+            count += src.count[j];
+        }
+        dst.min[i] = mn;
+        dst.max[i] = mx;
+        dst.meanSq[i] = count > 0 ? static_cast<float>(sumSq / count) : 0.0f;
+        dst.count[i] = count;
+    }
+    return dst;
+}
+
+WaveformLevel quantizeLevel(const FloatLevel& src) {
+    WaveformLevel level;
+    level.samplesPerPeak = src.samplesPerPeak;
+    level.peaks.resize(src.min.size() * 3);
+    for (size_t i = 0; i < src.min.size(); i++) {
+        level.peaks[i * 3] = quantize(src.min[i]);
+        level.peaks[i * 3 + 1] = quantize(src.max[i]);
+        level.peaks[i * 3 + 2] = quantize(std::sqrt(src.meanSq[i]));
+    }
+    return level;
+}
+
+template <typename T>
+void writePod(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readPod(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+} // namespace
+
+std::string WaveformIndex::defaultIndexPath(const std::string& mediaPath) {
+    return mediaPath + ".llwave";
+}
+
+bool WaveformIndex::write(const std::string& file, std::string& error) const {
+    // 先写临时文件再替换, 中断时不会留下半个 sidecar
+    std::string tmp = file + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            error = "Cannot create waveform index: " + file;
+            return false;
+        }
+        out.write(kMagic, sizeof(kMagic));
+        writePod(out, kVersion);
+        writePod(out, static_cast<uint32_t>(rate));
+        writePod(out, samples);
+        writePod(out, sourceSize);
+        writePod(out, sourceMtime);
+        writePod(out, static_cast<uint32_t>(sourcePath.size()));
+        out.write(sourcePath.data(), sourcePath.size());
+        writePod(out, static_cast<uint32_t>(levels.size()));
+        for (const WaveformLevel& level : levels) {
+            writePod(out, level.samplesPerPeak);
+            writePod(out, static_cast<uint64_t>(level.size()));
+        }
+        for (const WaveformLevel& level : levels) {
+            out.write(reinterpret_cast<const char*>(level.peaks.data()),
+                      static_cast<std::streamsize>(level.peaks.size() * sizeof(int16_t)));
+        }
+        out.close();
+        if (!out.good()) {
+            std::error_code ec;
+            fs::remove(tmp, ec);
+            error = "Failed to write waveform index: " + file;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmp, file, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        error = "Failed to write waveform index: " + file;
+        return false;
+    }
+    return true;
+}
+
+bool WaveformIndex::read(const std::string& file, std::string& error) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in.is_open()) {
+        error = "Cannot open waveform index: " + file;
+        return false;
+    }
+
+    char magic[sizeof(kMagic)];
+    uint32_t version = 0;
+    uint32_t sampleRate = 0;
+    uint32_t pathLength = 0;
+    uint32_t levelCount = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !readPod(in, version) || version != kVersion) {
+        error = "Not a waveform index: " + file;
+        return false;
+    }
+    if (!readPod(in, sampleRate) || !readPod(in, samples) || !readPod(in, sourceSize) ||
+        !readPod(in, sourceMtime) || !readPod(in, pathLength) || pathLength > 65536) {
+        error = "Corrupted waveform index: " + file;
+        return false;
+    }
+    sourcePath.resize(pathLength);
+    if (!in.read(&sourcePath[0], pathLength) || !readPod(in, levelCount) || levelCount > 32) {
+        error = "Corrupted waveform index: " + file;
+        return false;
+    }
+
+    levels.assign(levelCount, WaveformLevel());
+    for (WaveformLevel& level : levels) {
+        uint64_t count = 0;
+        if (!readPod(in, level.samplesPerPeak) || !readPod(in, count) || level.samplesPerPeak == 0 ||
+            count > samples / level.samplesPerPeak + 1) {
+            error = "Corrupted waveform index: " + file;
+            return false;
+        }
+        level.peaks.resize(count * 3);
+    }
+    for (WaveformLevel& level : levels) {
+        if (!in.read(reinterpret_cast<char*>(level.peaks.data()),
+                     static_cast<std::streamsize>(level.peaks.size() * sizeof(int16_t)))) {
+            error = "Corrupted waveform index: " + file;
+            return false;
+        }
+    }
+
+    rate = static_cast<int>(sampleRate);
+    path = file;
+    return true;
+}
+
+std::shared_ptr<const WaveformIndex> WaveformIndex::open(const std::string& indexPath, std::string& error) {
+    std::error_code ec;
+    int64_t mtime = fs::last_write_time(indexPath, ec).time_since_epoch().count();
+    if (ec) {
+        error = "Waveform index does not exist: " + indexPath;
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cache.find(indexPath);
+        if (it != cache.end()) {
+            // sidecar 被其他进程重建时重新读取
+            if (it->second.mtime == mtime) {
+                return it->second.index;
+            }
+            cache.erase(it);
+        }
+    }
+
+    auto index = std::make_shared<WaveformIndex>();
+    if (!index->read(indexPath, error)) {
+        return nullptr;
+    }
+
+    storeInCache(indexPath, index);
+    return index;
+}
+
+void WaveformIndex::clearCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.clear();
+}
+
+std::shared_ptr<const WaveformIndex> WaveformIndex::build(const std::string& mediaPath,
+                                                          const WaveformIndexOptions& options,
+                                                          std::string& error) {
+    if (options.levels < 1 || options.levels > 16 || options.samplesPerPeak < 16 || options.levelFactor < 2) {
+        error = "Invalid waveform index options";
+        return nullptr;
+    }
+
+    std::error_code ec;
+    uint64_t size = fs::file_size(mediaPath, ec);
+    if (ec) {
+        error = "File does not exist: " + mediaPath;
+        return nullptr;
+    }
+    int64_t mtime = fs::last_write_time(mediaPath, ec).time_since_epoch().count();
+    const std::string indexPath = options.indexPath.empty() ? defaultIndexPath(mediaPath) : options.indexPath;
+
+    // 源文件与层级配置都没有变化时直接复用 sidecar
+    if (!options.force && fs::exists(indexPath, ec)) {
+        std::string openError;
+        std::shared_ptr<const WaveformIndex> existing = open(indexPath, openError);
+        if (existing && existing->sourceSize == size && existing->sourceMtime == mtime &&
+            static_cast<int>(existing->levels.size()) == options.levels &&
+            existing->levels[0].samplesPerPeak == static_cast<uint32_t>(options.samplesPerPeak) &&
+            (options.levels == 1 ||
+             existing->levels[1].samplesPerPeak == static_cast<uint32_t>(options.samplesPerPeak * options.levelFactor))) {
+            return existing;
+        }
+    }
+
+    InputFormatPtr formatCtx = openInput(mediaPath);
+    if (!formatCtx) {
+        error = "Cannot open input file: " + mediaPath;
+        return nullptr;
+    }
+    if (avformat_find_stream_info(formatCtx.get(), nullptr) < 0) {
+        error = "Cannot find stream info";
+        return nullptr;
+    }
+
+    int streamIndex = options.streamIndex;
+    if (streamIndex < 0) {
+        streamIndex = av_find_best_stream(formatCtx.get(), AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    }
+    if (streamIndex < 0 || streamIndex >= static_cast<int>(formatCtx->nb_streams) ||
+        formatCtx->streams[streamIndex]->codecpar->codec_type != AVMEDIA_TYPE_AUDIO) {
+        error = "No audio stream found";
+        return nullptr;
+    }
+
+    // 以原始采样率混为单声道 float, 单次解码填充最精细一层
+    PeakAccumulator accumulator(static_cast<uint32_t>(options.samplesPerPeak));
+    PooledResampler swrCtx;
+    int sampleRate = 0;
+    std::vector<float> output;
+
+    std::vector<DemuxTrack> tracks(1);
+    tracks[0].streamIndex = streamIndex;
+    tracks[0].onOpen = [&](AVCodecContext* decoder) {
+        AVChannelLayout outLayout = AV_CHANNEL_LAYOUT_MONO;
+        sampleRate = decoder->sample_rate;
+        swrCtx = ContextPool::instance().acquireResampler(&decoder->ch_layout, decoder->sample_fmt,
+                                                          decoder->sample_rate, &outLayout,
+                                                          AV_SAMPLE_FMT_FLT, decoder->sample_rate);
+        return sampleRate > 0 && static_cast<bool>(swrCtx);
+    };
+    tracks[0].onFrame = [&](AVFrame* frame) {
+        int outSamples = static_cast<int>(swr_get_delay(swrCtx.get(), sampleRate)) + frame->nb_samples;
+        if (output.size() < static_cast<size_t>(outSamples)) {
+            output.resize(outSamples);
+        }
+        uint8_t* outPtr = reinterpret_cast<uint8_t*>(output.data());
+        outSamples = swr_convert(swrCtx.get(), &outPtr, outSamples, (const uint8_t**)frame->data, frame->nb_samples);
+        if (outSamples < 0) {
+            return false;
+        }
+        accumulator.push(output.data(), static_cast<size_t>(outSamples));
+        return true;
+    };
+
+    if (!demuxAudioTracks(formatCtx.get(), tracks, error)) {
+        return nullptr;
+    }
+    if (!tracks[0].ok) {
+        error = tracks[0].error;
+        return nullptr;
+    }
+
+    auto index = std::make_shared<WaveformIndex>();
+    index->path = indexPath;
+    index->sourcePath = mediaPath;
+    index->sourceSize = size;
+    index->sourceMtime = mtime;
+    index->rate = sampleRate;
+    index->samples = accumulator.totalSamples();
+
+    FloatLevel current = accumulator.finish();
+    index->levels.reserve(options.levels);
+    for (int i = 0; i < options.levels; i++) {
+        if (i > 0) current = reduceLevel(current, options.levelFactor);
+        index->levels.push_back(quantizeLevel(current));
+    }
+
+    if (!index->write(indexPath, error)) {
+        return nullptr;
+    }
+
+    storeInCache(indexPath, index);
+    return index;
+}
+
+WaveformRange WaveformIndex::query(double startTime, double endTime, int width) const {
+    WaveformRange range;
+    if (width <= 0 || levels.empty() || rate <= 0 || endTime <= startTime) {
+        return range;
+    }
+    range.min.assign(width, 0.0f);
+    range.max.assign(width, 0.0f);
+    range.rms.assign(width, 0.0f);
+
+    // 选择每列至少包含一个峰值的最粗一层
+    const double start = startTime * rate;
+    const double samplesPerColumn = (endTime - startTime) * rate / width;
+    size_t levelIndex = 0;
+    for (size_t i = 1; i < levels.size(); i++) {
+        if (levels[i].samplesPerPeak <= samplesPerColumn) levelIndex = i;
+    }
+    const WaveformLevel& level = levels[levelIndex];
+    range.level = static_cast<int>(levelIndex);
+    range.samplesPerPeak = level.samplesPerPeak;
+
+    const int64_t peakCount = static_cast<int64_t>(level.size());
+    const double scale = 1.0 / 32767.0;
+    for (int column = 0; column < width; column++) {
+        double a = start + column * samplesPerColumn;
+        double b = a + samplesPerColumn;
+        if (b <= 0.0) continue;
+        int64_t first = std::max<int64_t>(0, static_cast<int64_t>(a / level.samplesPerPeak));
+        int64_t last = std::min<int64_t>(peakCount, static_cast<int64_t>(std::ceil(b / level.samplesPerPeak)));
+        if (first >= last) continue;
+
+        const int16_t* peak = level.peaks.data() + first * 3;
+        int mn = peak[0];
+        int mx = peak[1];
+        double sumSq = 0.0;
+        for (int64_t i = first; i < last; i++, peak += 3) {
+            mn = std::min<int>(mn, peak[0]);
+            mx = std::max<int>(mx, peak[1]);
+            sumSq += static_cast<double>(peak[2]) * peak[2];
+        }
+        range.min[column] = static_cast<float>(mn * scale);
+        range.max[column] = static_cast<float>(mx * scale);
+        range.rms[column] = static_cast<float>(std::sqrt(sumSq / (last - first)) * scale);
+    }
+    return range;
+}
+
+} // namespace llvideo
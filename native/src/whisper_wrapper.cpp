@@ -1,8 +1,27 @@
 #include "whisper_wrapper.h"
+#include "ffmpeg_context_pool.h"
+#include "ffmpeg_demux.h"
+#include "diarization.h"
+#include "transcript_checkpoint.h"
+#include "pcm_ring_buffer.h"
+#include "pcm_cache.h"
+#include "memory_budget.h"
+#include "audio_fingerprint.h"
 #include "../whisper.cpp/include/whisper.h"
 #include <fstream>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -13,16 +32,45 @@ extern "C" {
 
 namespace llwhisper {
 
+namespace fs = std::filesystem;
+
+// 解码范围 (秒), duration 为 0 表示直到文件结尾
+struct AudioRange {
+    double start = 0.0;
+    double duration = 0.0;
+};
+
+// offset_ms / duration_ms 对应的解码范围
+static AudioRange params_range(const WhisperParams& params) {
+    AudioRange range;
+    range.start = std::max(0, params.offset_ms) / 1000.0;
+    range.duration = std::max(0, params.duration_ms) / 1000.0;
+    return range;
+}
+
+// 范围解码时 seek 到起点之前的预滚时长: 让解码器 (MP3 比特池 / AAC 重叠) 与预处理器进入稳定状态
+static const double kSeekPrerollSeconds = 0.5;
+
 // Helper function to read audio using FFmpeg
+// 解码器、重采样器与 packet/frame 均来自共享的 ContextPool, 批量处理短片段时避免重复初始化
+// 单声道输出在解码循环中逐块预处理; preprocessMs 累计预处理耗时
+// 提供 sink 时单声道样本不写入 pcmf32 而是逐块交给 sink, sink 返回 false 时停止解码
+// range 非空时 (只作用于单声道输出) seek 到起点并按帧时间戳丢弃多余样本, 输出第一个样本即 range.start
+using PcmSink = std::function<bool(const float* samples, size_t n)>;
+
 static bool read_wav(const std::string& fname, std::vector<float>& pcmf32, 
-                     std::vector<std::vector<float>>& pcmf32s, bool stereo) {
-    AVFormatContext* formatCtx = nullptr;
-    if (avformat_open_input(&formatCtx, fname.c_str(), nullptr, nullptr) != 0) {
+                     std::vector<std::vector<float>>& pcmf32s, bool stereo,
+                     const AudioRange& range = AudioRange(),
+                     const PreprocessOptions& preprocess = PreprocessOptions(),
+                     double* preprocessMs = nullptr, const PcmSink& sink = nullptr) {
+    llvideo::ContextPool& pool = llvideo::ContextPool::instance();
+
+    llvideo::InputFormatPtr formatCtx = llvideo::openInput(fname);
+    if (!formatCtx) {
         return false;
     }
     
-    if (avformat_find_stream_info(formatCtx, nullptr) < 0) {
-        avformat_close_input(&formatCtx);
+    if (avformat_find_stream_info(formatCtx.get(), nullptr) < 0) {
         return false;
     }
     
@@ -36,182 +84,618 @@ static bool read_wav(const std::string& fname, std::vector<float>& pcmf32,
     }
     
     if (audioStreamIndex == -1) {
-        avformat_close_input(&formatCtx);
-        return false;
-    }
-    
-    AVCodecParameters* codecParams = formatCtx->streams[audioStreamIndex]->codecpar;
-    const AVCodec* codec = avcodec_find_decoder(codecParams->codec_id);
-    if (!codec) {
-        avformat_close_input(&formatCtx);
         return false;
     }
+    AVStream* stream = formatCtx->streams[audioStreamIndex];
     
-    AVCodecContext* codecCtx = avcodec_alloc_context3(codec);
+    llvideo::PooledDecoder codecCtx = pool.acquireDecoder(stream->codecpar);
     if (!codecCtx) {
-        avformat_close_input(&formatCtx);
-        return false;
-    }
-    
-    if (avcodec_parameters_to_context(codecCtx, codecParams) < 0) {
-        avcodec_free_context(&codecCtx);
-        avformat_close_input(&formatCtx);
         return false;
     }
     
-    if (avcodec_open2(codecCtx, codec, nullptr) < 0) {
-        avcodec_free_context(&codecCtx);
-        avformat_close_input(&formatCtx);
-        return false;
+    // seek 到预滚起点之前的关键帧; 失败时从头解码, 下面按时间戳丢弃同样正确
+    const bool seeking = !stereo && range.start > 0.0;
+    double seekTime = 0.0;      // 帧没有时间戳时假定解码从这里开始
+    if (seeking) {
+        double target = std::max(0.0, range.start - kSeekPrerollSeconds);
+        int64_t ts = av_rescale_q(static_cast<int64_t>(target * AV_TIME_BASE), AV_TIME_BASE_Q, stream->time_base);
+        if (stream->start_time != AV_NOPTS_VALUE) {
+            ts += stream->start_time;
+        }
+        if (av_seek_frame(formatCtx.get(), audioStreamIndex, ts, AVSEEK_FLAG_BACKWARD) >= 0) {
+            avcodec_flush_buffers(codecCtx.get());
+            seekTime = target;
+        }
     }
     
     // Setup resampler to convert to 16kHz mono/stereo float
-    SwrContext* swrCtx = swr_alloc();
-    if (!swrCtx) {
-        avcodec_free_context(&codecCtx);
-        avformat_close_input(&formatCtx);
-        return false;
-    }
-    
     AVChannelLayout out_ch_layout;
-    AVChannelLayout in_ch_layout;
     if (stereo) {
         out_ch_layout = AV_CHANNEL_LAYOUT_STEREO;
     } else {
         out_ch_layout = AV_CHANNEL_LAYOUT_MONO;
     }
-    in_ch_layout = codecCtx->ch_layout;
     
-    av_opt_set_chlayout(swrCtx, "in_chlayout", &in_ch_layout, 0);
-    av_opt_set_chlayout(swrCtx, "out_chlayout", &out_ch_layout, 0);
-    av_opt_set_int(swrCtx, "in_sample_rate", codecCtx->sample_rate, 0);
-    av_opt_set_int(swrCtx, "out_sample_rate", WHISPER_SAMPLE_RATE, 0);
-    av_opt_set_sample_fmt(swrCtx, "in_sample_fmt", codecCtx->sample_fmt, 0);
-    av_opt_set_sample_fmt(swrCtx, "out_sample_fmt", AV_SAMPLE_FMT_FLT, 0);
-    
-    if (swr_init(swrCtx) < 0) {
-        swr_free(&swrCtx);
-        avcodec_free_context(&codecCtx);
-        avformat_close_input(&formatCtx);
+    llvideo::PooledResampler swrCtx = pool.acquireResampler(&codecCtx->ch_layout, codecCtx->sample_fmt, codecCtx->sample_rate,
+                                                            &out_ch_layout, AV_SAMPLE_FMT_FLT, WHISPER_SAMPLE_RATE);
+    if (!swrCtx) {
+        codecCtx.discard();
         return false;
     }
     
-    AVPacket* packet = av_packet_alloc();
-    AVFrame* frame = av_frame_alloc();
+    llvideo::PacketPtr packet = pool.acquirePacket();
+    llvideo::FramePtr frame = pool.acquireFrame();
+    
+    const int n_channels = stereo ? 2 : 1;
+    std::vector<float> output;
     
     pcmf32.clear();
     if (stereo) {
         pcmf32s.resize(2);
     }
     
-    while (av_read_frame(formatCtx, packet) >= 0) {
+    std::unique_ptr<AudioPreprocessor> preprocessor;
+    if (!stereo && preprocess.enabled()) {
+        preprocessor.reset(new AudioPreprocessor(preprocess));
+    }
+    std::chrono::steady_clock::duration preprocessTime{};
+    std::vector<float> processed;
+    
+    // 起点之前的样本: 预滚部分经过预处理器后再丢弃 (dropOutput), 更早的在预处理之前丢弃 (skipInput)
+    // skipInput 由 seek 后第一帧的时间戳确定
+    int64_t skipInput = seeking ? -1 : 0;
+    size_t dropOutput = 0;
+    size_t remaining = !stereo && range.duration > 0.0
+        ? static_cast<size_t>(range.duration * WHISPER_SAMPLE_RATE)
+        : std::numeric_limits<size_t>::max();
+    bool stopped = false;
+    bool decodeFailed = false;   // 跳过坏包继续解码, 但解码器不再回池
+    
+    // 单声道输出: 丢弃预滚, 截断到范围结尾, 写入 pcmf32 或交给 sink
+    auto emit = [&](const float* samples, size_t n) {
+        size_t drop = std::min(dropOutput, n);
+        dropOutput -= drop;
+        samples += drop;
+        n = std::min(n - drop, remaining);
+        remaining -= n;
+        if (n > 0) {
+            if (sink) {
+                stopped = !sink(samples, n);
+            } else {
+                pcmf32.insert(pcmf32.end(), samples, samples + n);
+            }
+        }
+        stopped = stopped || remaining == 0;
+    };
+    
+    while (!stopped && av_read_frame(formatCtx.get(), packet.get()) >= 0) {
         if (packet->stream_index == audioStreamIndex) {
-            if (avcodec_send_packet(codecCtx, packet) >= 0) {
-                while (avcodec_receive_frame(codecCtx, frame) >= 0) {
-                    // Resample
+            int ret = avcodec_send_packet(codecCtx.get(), packet.get());
+            if (ret >= 0) {
+                while ((ret = avcodec_receive_frame(codecCtx.get(), frame.get())) >= 0) {
+                    if (skipInput < 0) {
+                        double frameTime = seekTime;
+                        if (frame->best_effort_timestamp != AV_NOPTS_VALUE) {
+                            int64_t pts = frame->best_effort_timestamp;
+                            if (stream->start_time != AV_NOPTS_VALUE) pts -= stream->start_time;
+                            frameTime = pts * av_q2d(stream->time_base);
+                        }
+                        int64_t skip = std::max<int64_t>(0, std::llround((range.start - frameTime) * WHISPER_SAMPLE_RATE));
+                        int64_t preroll = preprocessor ? std::llround(kSeekPrerollSeconds * WHISPER_SAMPLE_RATE) : 0;
+                        dropOutput = static_cast<size_t>(std::min(skip, preroll));
+                        skipInput = skip - static_cast<int64_t>(dropOutput);
+                    }
+                    
+                    // Resample into a reusable buffer
                     int out_samples = av_rescale_rnd(
-                        swr_get_delay(swrCtx, codecCtx->sample_rate) + frame->nb_samples,
+                        swr_get_delay(swrCtx.get(), codecCtx->sample_rate) + frame->nb_samples,
                         WHISPER_SAMPLE_RATE, codecCtx->sample_rate, AV_ROUND_UP);
                     
-                    uint8_t* output = nullptr;
-                    int out_linesize;
-                    av_samples_alloc(&output, &out_linesize, stereo ? 2 : 1,
-                                   out_samples, AV_SAMPLE_FMT_FLT, 0);
+                    if (output.size() < static_cast<size_t>(out_samples * n_channels)) {
+                        output.resize(out_samples * n_channels);
+                    }
+                    uint8_t* out_ptr = reinterpret_cast<uint8_t*>(output.data());
                     
-                    out_samples = swr_convert(swrCtx, &output, out_samples,
+                    out_samples = swr_convert(swrCtx.get(), &out_ptr, out_samples,
                                             (const uint8_t**)frame->data, frame->nb_samples);
                     
-                    float* floatData = (float*)output;
-                    if (stereo) {
-                        for (int i = 0; i < out_samples; i++) {
-                            pcmf32s[0].push_back(floatData[2*i]);
-                            pcmf32s[1].push_back(floatData[2*i + 1]);
-                        }
-                    } else {
-                        for (int i = 0; i < out_samples; i++) {
-                            pcmf32.push_back(floatData[i]);
+                    if (out_samples > 0) {
+                        const float* floatData = output.data();
+                        if (stereo) {
+                            for (int i = 0; i < out_samples; i++) {
+                                pcmf32s[0].push_back(floatData[2*i]);
+                                pcmf32s[1].push_back(floatData[2*i + 1]);
+                            }
+                        } else {
+                            int64_t offset = std::min<int64_t>(skipInput, out_samples);
+                            skipInput -= offset;
+                            floatData += offset;
+                            size_t count = static_cast<size_t>(out_samples - offset);
+                            if (preprocessor) {
+                                auto start = std::chrono::steady_clock::now();
+                                preprocessor->process(floatData, count, processed);
+                                preprocessTime += std::chrono::steady_clock::now() - start;
+                                emit(processed.data(), processed.size());
+                                processed.clear();
+                            } else {
+                                emit(floatData, count);
+                            }
                         }
                     }
                     
-                    av_freep(&output);
+                    av_frame_unref(frame.get());
+                    if (stopped) break;
                 }
             }
+            decodeFailed = decodeFailed || llvideo::isDecodeError(ret);
+        }
+        av_packet_unref(packet.get());
+    }
+    
+    pool.releasePacket(std::move(packet));
+    pool.releaseFrame(std::move(frame));
+    if (decodeFailed) {
+        codecCtx.discard();
+    }
+    
+    if (preprocessor && !stopped) {
+        auto start = std::chrono::steady_clock::now();
+        preprocessor->flush(processed);
+        preprocessTime += std::chrono::steady_clock::now() - start;
+        emit(processed.data(), processed.size());
+    }
+    if (preprocessMs) {
+        *preprocessMs = std::chrono::duration<double, std::milli>(preprocessTime).count();
+    }
+    
+    return true;
+}
+
+// 解码后的单条音轨
+struct DecodedTrack {
+    int streamIndex = -1;
+    std::string language;
+    std::vector<float> pcmf32;
+    std::string error;
+};
+
+// 单次 demux 把多条音轨并行解码为 16kHz 单声道 float (streams 为空表示全部音轨)
+static bool read_wav_tracks(const std::string& fname, const std::vector<int>& streams,
+                            std::vector<DecodedTrack>& decoded, std::string& error,
+                            const PreprocessOptions& preprocess = PreprocessOptions()) {
+    llvideo::InputFormatPtr formatCtx = llvideo::openInput(fname);
+    if (!formatCtx) {
+        error = "Cannot open input";
+        return false;
+    }
+    
+    if (avformat_find_stream_info(formatCtx.get(), nullptr) < 0) {
+        error = "Cannot find stream info";
+        return false;
+    }
+    
+    std::vector<int> selected = streams.empty() ? llvideo::findAudioStreams(formatCtx.get()) : streams;
+    if (selected.empty()) {
+        error = "No audio stream found";
+        return false;
+    }
+    
+    struct TrackState {
+        llvideo::PooledResampler swrCtx;
+        int inSampleRate = 0;
+        std::vector<float> output;
+        std::unique_ptr<AudioPreprocessor> preprocessor;
+    };
+    
+    decoded.assign(selected.size(), DecodedTrack());
+    std::vector<TrackState> states(selected.size());
+    std::vector<llvideo::DemuxTrack> tracks(selected.size());
+    
+    for (size_t i = 0; i < selected.size(); i++) {
+        decoded[i].streamIndex = selected[i];
+        if (selected[i] >= 0 && selected[i] < static_cast<int>(formatCtx->nb_streams)) {
+            AVDictionaryEntry* lang = av_dict_get(formatCtx->streams[selected[i]]->metadata, "language", nullptr, 0);
+            if (lang) decoded[i].language = lang->value;
+        }
+        
+        TrackState* state = &states[i];
+        std::vector<float>* pcm = &decoded[i].pcmf32;
+        if (preprocess.enabled()) {
+            state->preprocessor.reset(new AudioPreprocessor(preprocess));
         }
-        av_packet_unref(packet);
+        tracks[i].streamIndex = selected[i];
+        tracks[i].onOpen = [state](AVCodecContext* decoder) {
+            AVChannelLayout out_ch_layout = AV_CHANNEL_LAYOUT_MONO;
+            state->inSampleRate = decoder->sample_rate;
+            state->swrCtx = llvideo::ContextPool::instance().acquireResampler(
+                &decoder->ch_layout, decoder->sample_fmt, decoder->sample_rate,
+                &out_ch_layout, AV_SAMPLE_FMT_FLT, WHISPER_SAMPLE_RATE);
+            return static_cast<bool>(state->swrCtx);
+        };
+        tracks[i].onFrame = [state, pcm](AVFrame* frame) {
+            int out_samples = av_rescale_rnd(
+                swr_get_delay(state->swrCtx.get(), state->inSampleRate) + frame->nb_samples,
+                WHISPER_SAMPLE_RATE, state->inSampleRate, AV_ROUND_UP);
+            if (state->output.size() < static_cast<size_t>(out_samples)) {
+                state->output.resize(out_samples);
+            }
+            uint8_t* out_ptr = reinterpret_cast<uint8_t*>(state->output.data());
+            out_samples = swr_convert(state->swrCtx.get(), &out_ptr, out_samples,
+                                      (const uint8_t**)frame->data, frame->nb_samples);
+            if (out_samples < 0) {
+                return false;
+            }
+            if (state->preprocessor) {
+                state->preprocessor->process(state->output.data(), out_samples, *pcm);
+            } else {
+                pcm->insert(pcm->end(), state->output.data(), state->output.data() + out_samples);
+            }
+            return true;
+        };
+        tracks[i].onFinish = [state, pcm]() {
+            if (state->preprocessor) {
+                state->preprocessor->flush(*pcm);
+            }
+            return true;
+        };
     }
     
-    av_frame_free(&frame);
-    av_packet_free(&packet);
-    swr_free(&swrCtx);
-    avcodec_free_context(&codecCtx);
-    avformat_close_input(&formatCtx);
+    if (!llvideo::demuxAudioTracks(formatCtx.get(), tracks, error)) {
+        return false;
+    }
     
+    for (size_t i = 0; i < tracks.size(); i++) {
+        if (!tracks[i].ok) {
+            decoded[i].error = tracks[i].error;
+        }
+    }
     return true;
 }
 
-WhisperWrapper::WhisperWrapper() : ctx(nullptr), modelLoaded(false) {
+// 通过 seek 只解码若干窗口为 16kHz 单声道 float, 不读取窗口之外的数据
+// positions 为窗口中心的相对位置; 时长未知或文件太短时退化为从头读取一个窗口
+static bool read_wav_windows(const std::string& fname, const std::vector<double>& positions, double windowSeconds,
+                             std::vector<std::vector<float>>& windows, std::vector<double>& startTimes,
+                             double& durationSeconds, std::string& error) {
+    llvideo::ContextPool& pool = llvideo::ContextPool::instance();
+    
+    llvideo::InputFormatPtr formatCtx = llvideo::openInput(fname);
+    if (!formatCtx) {
+        error = "Cannot open input";
+        return false;
+    }
+    if (avformat_find_stream_info(formatCtx.get(), nullptr) < 0) {
+        error = "Cannot find stream info";
+        return false;
+    }
+    
+    int audioStreamIndex = av_find_best_stream(formatCtx.get(), AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (audioStreamIndex < 0) {
+        error = "No audio stream found";
+        return false;
+    }
+    AVStream* stream = formatCtx->streams[audioStreamIndex];
+    
+    durationSeconds = 0.0;
+    if (stream->duration != AV_NOPTS_VALUE && stream->duration > 0) {
+        durationSeconds = stream->duration * av_q2d(stream->time_base);
+    } else if (formatCtx->duration != AV_NOPTS_VALUE && formatCtx->duration > 0) {
+        durationSeconds = static_cast<double>(formatCtx->duration) / AV_TIME_BASE;
+    }
+    
+    // 窗口起点限制在文件范围内, 重叠的窗口合并为一个
+    startTimes.clear();
+    if (durationSeconds <= windowSeconds * positions.size()) {
+        startTimes.push_back(0.0);
+        windowSeconds = std::min(windowSeconds * positions.size(), 30.0);
+    } else {
+        for (double position : positions) {
+            double start = std::clamp(position, 0.0, 1.0) * durationSeconds - windowSeconds / 2.0;
+            start = std::clamp(start, 0.0, durationSeconds - windowSeconds);
+            if (!startTimes.empty() && start < startTimes.back() + windowSeconds) {
+                continue;
+            }
+            startTimes.push_back(start);
+        }
+    }
+    
+    llvideo::PooledDecoder codecCtx = pool.acquireDecoder(stream->codecpar);
+    if (!codecCtx) {
+        error = "Cannot open decoder";
+        return false;
+    }
+    
+    llvideo::PacketPtr packet = pool.acquirePacket();
+    llvideo::FramePtr frame = pool.acquireFrame();
+    const size_t windowSamples = static_cast<size_t>(windowSeconds * WHISPER_SAMPLE_RATE);
+    std::vector<float> output;
+    bool decodeFailed = false;
+    
+    windows.assign(startTimes.size(), std::vector<float>());
+    for (size_t w = 0; w < startTimes.size(); w++) {
+        const double start = startTimes[w];
+        std::vector<float>& pcm = windows[w];
+        pcm.reserve(windowSamples);
+        
+        // seek 到窗口起点之前的关键帧, 之前的样本在解码后丢弃
+        int64_t ts = av_rescale_q(static_cast<int64_t>(start * AV_TIME_BASE), AV_TIME_BASE_Q, stream->time_base);
+        if (stream->start_time != AV_NOPTS_VALUE) {
+            ts += stream->start_time;
+        }
+        if (av_seek_frame(formatCtx.get(), audioStreamIndex, ts, AVSEEK_FLAG_BACKWARD) < 0 && start > 0.0) {
+            error = "Seek failed";
+            codecCtx.discard();
+            return false;
+        }
+        avcodec_flush_buffers(codecCtx.get());
+        
+        // 每个窗口使用新的重采样器, 避免上一个窗口残留的延迟样本
+        AVChannelLayout out_ch_layout = AV_CHANNEL_LAYOUT_MONO;
+        llvideo::PooledResampler swrCtx = pool.acquireResampler(&codecCtx->ch_layout, codecCtx->sample_fmt,
+                                                                codecCtx->sample_rate, &out_ch_layout,
+                                                                AV_SAMPLE_FMT_FLT, WHISPER_SAMPLE_RATE);
+        if (!swrCtx) {
+            error = "Cannot create resampler";
+            codecCtx.discard();
+            return false;
+        }
+        
+        int64_t skip = -1;   // 需要丢弃的输出样本数 (由第一帧的时间戳确定)
+        while (pcm.size() < windowSamples && av_read_frame(formatCtx.get(), packet.get()) >= 0) {
+            if (packet->stream_index == audioStreamIndex) {
+                int ret = avcodec_send_packet(codecCtx.get(), packet.get());
+                while (ret >= 0 && pcm.size() < windowSamples) {
+                    ret = avcodec_receive_frame(codecCtx.get(), frame.get());
+                    if (ret < 0) break;
+                    
+                    if (skip < 0) {
+                        double frameTime = 0.0;
+                        if (frame->best_effort_timestamp != AV_NOPTS_VALUE) {
+                            int64_t pts = frame->best_effort_timestamp;
+                            if (stream->start_time != AV_NOPTS_VALUE) pts -= stream->start_time;
+                            frameTime = pts * av_q2d(stream->time_base);
+                        }
+                        skip = std::max<int64_t>(0, static_cast<int64_t>((start - frameTime) * WHISPER_SAMPLE_RATE));
+                    }
+                    
+                    int out_samples = av_rescale_rnd(
+                        swr_get_delay(swrCtx.get(), codecCtx->sample_rate) + frame->nb_samples,
+                        WHISPER_SAMPLE_RATE, codecCtx->sample_rate, AV_ROUND_UP);
+                    if (output.size() < static_cast<size_t>(out_samples)) {
+                        output.resize(out_samples);
+                    }
+                    uint8_t* out_ptr = reinterpret_cast<uint8_t*>(output.data());
+                    out_samples = swr_convert(swrCtx.get(), &out_ptr, out_samples,
+                                              (const uint8_t**)frame->data, frame->nb_samples);
+                    av_frame_unref(frame.get());
+                    
+                    int64_t offset = std::min<int64_t>(skip, std::max(out_samples, 0));
+                    skip -= offset;
+                    size_t take = std::min(windowSamples - pcm.size(), static_cast<size_t>(std::max<int64_t>(0, out_samples - offset)));
+                    pcm.insert(pcm.end(), output.data() + offset, output.data() + offset + take);
+                }
+                decodeFailed = decodeFailed || llvideo::isDecodeError(ret);
+            }
+            av_packet_unref(packet.get());
+        }
+    }
+    
+    pool.releasePacket(std::move(packet));
+    pool.releaseFrame(std::move(frame));
+    if (decodeFailed) {
+        codecCtx.discard();
+    }
+    return true;
 }
 
-WhisperWrapper::~WhisperWrapper() {
+LoadedModel::~LoadedModel() {
     if (ctx != nullptr) {
         whisper_free(static_cast<whisper_context*>(ctx));
-        ctx = nullptr;
+    }
+    if (budget != nullptr) {
+        budget->setResident(residentKey, MemoryUsage());
     }
 }
 
-bool WhisperWrapper::loadModel(const std::string& modelPath) {
-    if (ctx != nullptr) {
-        whisper_free(static_cast<whisper_context*>(ctx));
-        ctx = nullptr;
+WhisperWrapper::WhisperWrapper() {
+}
+
+WhisperWrapper::~WhisperWrapper() {
+}
+
+// 后端选项转换为 whisper_context_params
+static whisper_context_params build_context_params(const BackendOptions& backend) {
+    whisper_context_params cparams = whisper_context_default_params();
+    cparams.use_gpu = backendUsesGpu(backend);
+    cparams.flash_attn = backend.flashAttn;
+    cparams.gpu_device = backend.gpuDevice;
+    return cparams;
+}
+
+// 一份 whisper_state 的估算大小 (与 whisper_init_state 的分配对应, f16 KV)
+// kv_self: 按 3 倍 n_text_ctx 预分配 (多个 decoder / beam 共享); kv_cross: 每层一份编码器输出的 K/V;
+// 计算缓冲以编码器为主, 按 n_audio_ctx * n_audio_state 的倍数估算
+static uint64_t estimate_state_bytes(whisper_context* wctx) {
+    const uint64_t textLayers = whisper_model_n_text_layer(wctx);
+    const uint64_t textState = whisper_model_n_text_state(wctx);
+    const uint64_t textCtx = whisper_model_n_text_ctx(wctx);
+    const uint64_t audioCtx = whisper_model_n_audio_ctx(wctx);
+    const uint64_t audioState = whisper_model_n_audio_state(wctx);
+    const uint64_t kvSelf = 2 * textLayers * textState * textCtx * 3 * 2;
+    const uint64_t kvCross = 2 * textLayers * textState * audioCtx * 2;
+    const uint64_t compute = 48 * audioCtx * audioState * sizeof(float);
+    return kvSelf + kvCross + compute;
+}
+
+// 模型常驻内存: 权重 (按文件大小) + 上下文自带的 whisper_state
+static MemoryUsage model_usage(const std::string& modelPath, whisper_context* wctx) {
+    MemoryUsage usage;
+    std::error_code ec;
+    usage.model = fs::file_size(fs::u8path(modelPath), ec);
+    if (ec) usage.model = 0;
+    usage.state = estimate_state_bytes(wctx);
+    return usage;
+}
+
+bool WhisperWrapper::loadModel(const std::string& modelPath, const BackendOptions& backend, std::string& error,
+                               ModelVersionInfo* installed) {
+    std::lock_guard<std::mutex> lock(loadMutex);
+    return installModel(modelPath, backend, false, error, installed);
+}
+
+bool WhisperWrapper::loadDraftModel(const std::string& modelPath, std::string& error, ModelVersionInfo* installed) {
+    std::lock_guard<std::mutex> lock(loadMutex);
+    BackendOptions backend;
+    {
+        std::lock_guard<std::mutex> modelLock(modelMutex);
+        if (currentModel) backend = currentModel->backend;
     }
-    
+    return installModel(modelPath, backend, true, error, installed);
+}
+
+bool WhisperWrapper::installModel(const std::string& modelPath, const BackendOptions& backend, bool draft,
+                                  std::string& error, ModelVersionInfo* installed) {
     // Check if file exists
     std::ifstream file(modelPath, std::ios::binary);
     if (!file.good()) {
-        lastError = "Model file not found: " + modelPath;
-        modelLoaded = false;
+        error = (draft ? "Draft model file not found: " : "Model file not found: ") + modelPath;
         return false;
     }
     file.close();
     
-    whisper_context* new_ctx = whisper_init_from_file(modelPath.c_str());
-    if (new_ctx == nullptr) {
-        lastError = "Failed to initialize Whisper context from model file";
-        modelLoaded = false;
+    // 权重本身就超出预算时不加载 (替换期间旧版本仍常驻, 之后的作业按实际用量排队)
+    std::error_code sizeError;
+    const uint64_t modelBytes = fs::file_size(fs::u8path(modelPath), sizeError);
+    const uint64_t limit = memoryBudget.limit();
+    if (!sizeError && limit > 0 && !memoryBudget.fitsAlone(MemoryUsage{modelBytes, 0, 0, 0})) {
+        error = std::string("Memory budget exceeded: ") + (draft ? "draft model " : "model ") + modelPath +
+                " needs about " + formatMegabytes(modelBytes) + " but the budget is " + formatMegabytes(limit);
         return false;
     }
     
-    ctx = new_ctx;
-    modelLoaded = true;
-    lastError.clear();
-    return true;
-}
-
-std::vector<TranscriptSegment> WhisperWrapper::transcribe(const std::string& audioPath, 
-                                                           const WhisperParams& params,
-                                                           ProgressCallback callback) {
-    if (!modelLoaded) {
-        lastError = "Model not loaded. Call loadModel first.";
-        throw std::runtime_error(lastError);
+    if (!draft && !prepareBackend(backend, error)) {
+        return false;
     }
     
-    std::vector<TranscriptSegment> segments;
+    // 新上下文在锁外创建, 加载期间作业照常在当前版本上运行
+    whisper_context* new_ctx = whisper_init_from_file_with_params(modelPath.c_str(), build_context_params(backend));
+    if (new_ctx == nullptr) {
+        error = draft ? "Failed to initialize draft Whisper context from model file"
+                      : "Failed to initialize Whisper context from model file";
+        return false;
+    }
     
-    // Read audio file
-    std::vector<float> pcmf32;
-    std::vector<std::vector<float>> pcmf32s;
+    std::shared_ptr<LoadedModel> loaded = std::make_shared<LoadedModel>();
+    loaded->ctx = new_ctx;
+    loaded->backend = backend;
+    loaded->stateBytes = estimate_state_bytes(new_ctx);
     
-    if (!read_wav(audioPath, pcmf32, pcmf32s, false)) {
-        lastError = "Failed to read audio file: " + audioPath;
-        throw std::runtime_error(lastError);
+    // 记录加载时实际使用的张量类型 (只读取张量表, 失败不影响已加载的模型)
+    std::string inspectError;
+    if (!inspectModel(modelPath, loaded->info, inspectError)) {
+        loaded->info = ModelInfo();
+        loaded->info.path = modelPath;
     }
+    std::error_code timeError;
+    const int64_t modelTime = fs::last_write_time(fs::u8path(modelPath), timeError).time_since_epoch().count();
+    loaded->identity = modelPath + "|" + std::to_string(sizeError ? 0 : modelBytes) + "|" +
+                       std::to_string(timeError ? 0 : modelTime) + "|" + std::to_string(loaded->info.ftype);
     
-    if (pcmf32.empty()) {
-        lastError = "Audio file is empty or invalid";
-        throw std::runtime_error(lastError);
+    // 替换当前版本; 旧版本由仍在运行的作业持有, 没有作业时在离开作用域时释放 (不持有 modelMutex)
+    std::shared_ptr<LoadedModel> previous;
+    {
+        std::lock_guard<std::mutex> lock(modelMutex);
+        loaded->version = ++modelVersion;
+        loaded->draft = draft;
+        loaded->budget = &memoryBudget;
+        loaded->residentKey = (draft ? "draft v" : "model v") + std::to_string(loaded->version);
+        memoryBudget.setResident(loaded->residentKey, model_usage(modelPath, new_ctx));
+        if (installed) {
+            installed->version = loaded->version;
+            installed->path = loaded->info.path;
+            installed->draft = draft;
+            installed->current = true;
+            installed->jobs = 0;
+        }
+        
+        std::shared_ptr<LoadedModel>& slot = draft ? currentDraft : currentModel;
+        previous = std::move(slot);
+        slot = std::move(loaded);
+        if (previous) {
+            retiredModels.push_back(previous);
+        }
+        retiredModels.erase(std::remove_if(retiredModels.begin(), retiredModels.end(),
+                                           [](const std::weak_ptr<LoadedModel>& m) { return m.expired(); }),
+                            retiredModels.end());
+    }
+    return true;
+}
+
+std::shared_ptr<LoadedModel> WhisperWrapper::acquireModel(bool draft) {
+    std::lock_guard<std::mutex> lock(modelMutex);
+    std::shared_ptr<LoadedModel> current = draft ? currentDraft : currentModel;
+    if (!current) {
+        throw std::runtime_error(draft ? "Draft model not loaded. Call loadDraftModel first."
+                                       : "Model not loaded. Call loadModel first.");
+    }
+    return current;
+}
+
+std::vector<ModelVersionInfo> WhisperWrapper::getLoadedModels() const {
+    std::lock_guard<std::mutex> lock(modelMutex);
+    std::vector<ModelVersionInfo> versions;
+    auto describe = [&versions](const std::shared_ptr<LoadedModel>& loaded, bool current) {
+        ModelVersionInfo info;
+        info.version = loaded->version;
+        info.path = loaded->info.path;
+        info.draft = loaded->draft;
+        info.current = current;
+        // 引用数减去 WhisperWrapper 持有的引用 (当前版本) 或 lock() 得到的临时引用 (旧版本)
+        info.jobs = std::max(0L, loaded.use_count() - 1);
+        versions.push_back(info);
+    };
+    if (currentModel) describe(currentModel, true);
+    if (currentDraft) describe(currentDraft, true);
+    for (const std::weak_ptr<LoadedModel>& retired : retiredModels) {
+        std::shared_ptr<LoadedModel> loaded = retired.lock();
+        if (loaded) {
+            describe(loaded, false);
+        }
+    }
+    return versions;
+}
+
+std::vector<int32_t> WhisperWrapper::cachedTokens(LoadedModel& model, const std::string& text) {
+    if (text.empty()) {
+        return std::vector<int32_t>();
     }
+    std::lock_guard<std::mutex> lock(model.promptMutex);
+    auto it = model.promptCache.find(text);
+    if (it != model.promptCache.end()) {
+        return it->second;
+    }
+    void* context = model.ctx;
     
-    // Set up Whisper parameters
+    // token 数不会超过字节数
+    std::vector<whisper_token> tokens(text.size() + 8);
+    int n = whisper_tokenize(static_cast<whisper_context*>(context), text.c_str(), tokens.data(),
+                             static_cast<int>(tokens.size()));
+    if (n < 0) {
+        tokens.resize(static_cast<size_t>(-n));
+        n = whisper_tokenize(static_cast<whisper_context*>(context), text.c_str(), tokens.data(),
+                             static_cast<int>(tokens.size()));
+    }
+    tokens.resize(static_cast<size_t>(std::max(0, n)));
+    return model.promptCache.emplace(text, std::vector<int32_t>(tokens.begin(), tokens.end())).first->second;
+}
+
+std::vector<int32_t> WhisperWrapper::tokenize(const std::string& text) {
+    return cachedTokens(*acquireModel(), text);
+}
+
+// 将 WhisperParams 转换为 whisper_full_params
+// 注意: 返回值中的字符串指针指向 params, params 需在 whisper_full 结束前保持有效
+static whisper_full_params build_full_params(const WhisperParams& params) {
     whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
     
     // 设置语言
@@ -259,132 +743,1638 @@ std::vector<TranscriptSegment> WhisperWrapper::transcribe(const std::string& aud
     wparams.token_timestamps = false;
     wparams.max_tokens = 0;
     
-    // 进度回调
-    if (callback) {
-        // Whisper.cpp doesn't have built-in progress callback in the full API
-        // We can estimate progress based on processing
-    }
-    
-    // Run transcription
-    whisper_context* wctx = static_cast<whisper_context*>(ctx);
-    if (whisper_full(wctx, wparams, pcmf32.data(), pcmf32.size()) != 0) {
-        lastError = "Failed to transcribe audio";
-        throw std::runtime_error(lastError);
-    }
-    
-    // Get results
-    const int n_segments = whisper_full_n_segments(wctx);
-    for (int i = 0; i < n_segments; ++i) {
-        TranscriptSegment segment;
-        segment.startTime = static_cast<double>(whisper_full_get_segment_t0(wctx, i)) / 100.0;
-        segment.endTime = static_cast<double>(whisper_full_get_segment_t1(wctx, i)) / 100.0;
-        segment.text = whisper_full_get_segment_text(wctx, i);
-        
-        // Trim whitespace from text
-        size_t start = segment.text.find_first_not_of(" \t\n\r");
-        size_t end = segment.text.find_last_not_of(" \t\n\r");
-        if (start != std::string::npos && end != std::string::npos) {
-            segment.text = segment.text.substr(start, end - start + 1);
-        }
-        
-        segments.push_back(segment);
+    return wparams;
+}
+
+// 64 位 FNV-1a (跨进程 / 编译器稳定, 用于写入磁盘的 key)
+static uint64_t fnv1a64(const void* data, size_t n, uint64_t hash = 14695981039346656037ULL) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
     }
-    
-    lastError.clear();
-    return segments;
+    return hash;
 }
 
-// 简化接口（向后兼容）
-std::vector<TranscriptSegment> WhisperWrapper::transcribe(const std::string& audioPath, 
-                                                           const std::string& language) {
-    WhisperParams params;
-    params.language = language;
-    return transcribe(audioPath, params);
+// 影响转录文本与片段划分的全部解码参数; 检查点与去重索引的 key 都由模型 identity 加上它组成
+// (线程数、打印选项等不影响输出的参数不计入; 提示文本与 token 以 FNV-1a 哈希表示)
+static std::string decode_params_key(const WhisperParams& params) {
+    uint64_t prompt = fnv1a64(params.initial_prompt.data(), params.initial_prompt.size());
+    prompt = fnv1a64(params.prompt_tokens.data(), params.prompt_tokens.size() * sizeof(int32_t), prompt);
+    std::ostringstream key;
+    key << params.language << '|' << (params.translate ? 1 : 0) << '|' << params.preprocess.key() << '|'
+        << params.no_context << params.single_segment << params.suppress_non_speech_tokens << '|'
+        << params.max_len << ',' << params.n_max_text_ctx << ',' << params.audio_ctx << '|'
+        << params.best_of << ',' << params.beam_size << ',' << params.temperature << ',' << params.temperature_inc << '|'
+        << params.entropy_thold << ',' << params.logprob_thold << ',' << params.word_thold << '|'
+        << std::hex << prompt;
+    return key.str();
 }
 
-// 格式化时间戳
-std::string WhisperWrapper::formatTimestamp(double seconds, bool srtFormat) {
-    int hours = static_cast<int>(seconds / 3600);
-    int minutes = static_cast<int>((seconds - hours * 3600) / 60);
-    int secs = static_cast<int>(seconds - hours * 3600 - minutes * 60);
-    int millis = static_cast<int>((seconds - static_cast<int>(seconds)) * 1000);
-    
-    char buffer[32];
-    if (srtFormat) {
-        snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d,%03d", hours, minutes, secs, millis);
-    } else {
-        snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d.%03d", hours, minutes, secs, millis);
+// 从整个文件的 (未预处理) PCM 取出 range 对应的样本
+// 不需要预处理时直接指向原数据 (缓存的映射内存); 否则连同预滚一起预处理到 processed 再丢弃预滚
+static void slice_pcm(const float* data, size_t total, const AudioRange& range, const PreprocessOptions& preprocess,
+                      std::vector<float>& processed, const float*& samples, size_t& n_samples) {
+    const size_t begin = std::min(total, static_cast<size_t>(std::llround(range.start * WHISPER_SAMPLE_RATE)));
+    size_t end = total;
+    if (range.duration > 0.0) {
+        end = std::min(total, begin + static_cast<size_t>(range.duration * WHISPER_SAMPLE_RATE));
+    }
+    
+    if (!preprocess.enabled()) {
+        samples = data + begin;
+        n_samples = end - begin;
+        return;
     }
-    return std::string(buffer);
+    
+    const size_t preroll = std::min(begin, static_cast<size_t>(kSeekPrerollSeconds * WHISPER_SAMPLE_RATE));
+    AudioPreprocessor preprocessor(preprocess);
+    processed.clear();
+    processed.reserve(end - begin + preroll);
+    preprocessor.process(data + begin - preroll, end - begin + preroll, processed);
+    preprocessor.flush(processed);
+    processed.erase(processed.begin(), processed.begin() + preroll);
+    samples = processed.data();
+    n_samples = processed.size();
 }
 
-// 导出为纯文本
-std::string WhisperWrapper::exportToTxt(const std::vector<TranscriptSegment>& segments) {
-    std::string result;
-    for (const auto& seg : segments) {
-        result += seg.text + "\n";
+std::unique_ptr<PcmCache> WhisperWrapper::acquirePcmCache(const std::string& audioPath, const WhisperParams& params,
+                                                          std::vector<float>& decoded) {
+    const std::string cachePath = PcmCache::cachePath(audioPath, params.pcm_cache_dir);
+    std::unique_ptr<PcmCache> cache = PcmCache::open(cachePath, audioPath);
+    if (cache) {
+        return cache;
     }
-    return result;
+    
+    // 未命中: 只有整个文件的转录才解码全部样本并写入缓存, 范围转录仍只解码所需部分
+    if (params.offset_ms > 0 || params.duration_ms > 0) {
+        return nullptr;
+    }
+    std::vector<std::vector<float>> pcmf32s;
+    if (!read_wav(audioPath, decoded, pcmf32s, false)) {
+        throw std::runtime_error("Failed to read audio file: " + audioPath);
+    }
+    
+    // 写入失败 (只读目录等) 不影响转录, 调用方直接使用 decoded
+    std::string error;
+    if (!PcmCache::write(cachePath, audioPath, decoded.data(), decoded.size(), error)) {
+        return nullptr;
+    }
+    cache = PcmCache::open(cachePath, audioPath);
+    if (cache) {
+        std::vector<float>().swap(decoded);
+    }
+    return cache;
 }
 
-// 导出为 SRT 字幕
-std::string WhisperWrapper::exportToSrt(const std::vector<TranscriptSegment>& segments) {
-    std::string result;
-    int index = 1;
-    for (const auto& seg : segments) {
-        result += std::to_string(index++) + "\n";
-        result += formatTimestamp(seg.startTime, true) + " --> " + formatTimestamp(seg.endTime, true) + "\n";
-        result += seg.text + "\n\n";
+// ---- 内存预算 ----
+
+// 流式转录的环形缓冲容量 (音频块数): 推理当前块时解码线程继续向前解码
+static const size_t kStreamBufferChunks = 4;
+
+// 每秒音频产生的片段 (文本 + 时间 + 统计) 估算字节数
+static const uint64_t kOutputBytesPerSecond = 256;
+
+// 只读取容器头得到时长 (秒, 未知时为 0) 与音轨数, 不解码
+static double probe_audio(const std::string& path, size_t& audioStreams) {
+    audioStreams = 0;
+    llvideo::InputFormatPtr formatCtx = llvideo::openInput(path);
+    if (!formatCtx) {
+        return 0.0;
     }
-    return result;
+    for (unsigned int i = 0; i < formatCtx->nb_streams; ++i) {
+        if (formatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+            audioStreams++;
+        }
+    }
+    if (formatCtx->duration != AV_NOPTS_VALUE && formatCtx->duration > 0) {
+        return static_cast<double>(formatCtx->duration) / AV_TIME_BASE;
+    }
+    return 0.0;
 }
 
-// 导出为 VTT 字幕
-std::string WhisperWrapper::exportToVtt(const std::vector<TranscriptSegment>& segments) {
-    std::string result = "WEBVTT\n\n";
-    for (const auto& seg : segments) {
-        result += formatTimestamp(seg.startTime, false) + " --> " + formatTimestamp(seg.endTime, false) + "\n";
-        result += seg.text + "\n\n";
-    }
-    return result;
+// 已解码 n_samples 个样本时的实际用量
+static MemoryUsage pcm_usage(size_t n_samples, size_t tracks = 1) {
+    MemoryUsage usage;
+    usage.pcm = static_cast<uint64_t>(n_samples) * tracks * sizeof(float);
+    usage.output = static_cast<uint64_t>(n_samples) * tracks / WHISPER_SAMPLE_RATE * kOutputBytesPerSecond;
+    return usage;
 }
 
-// 导出为 JSON
-std::string WhisperWrapper::exportToJson(const std::vector<TranscriptSegment>& segments) {
-    std::string result = "{\n  \"segments\": [\n";
-    for (size_t i = 0; i < segments.size(); ++i) {
-        const auto& seg = segments[i];
-        result += "    {\n";
-        result += "      \"start\": " + std::to_string(seg.startTime) + ",\n";
-        result += "      \"end\": " + std::to_string(seg.endTime) + ",\n";
-        result += "      \"text\": \"" + seg.text + "\"\n";
-        result += "    }";
-        if (i < segments.size() - 1) result += ",";
-        result += "\n";
-    }
-    result += "  ]\n}\n";
-    return result;
+// 按 offset_ms / duration_ms 截取后的时长估算用量; 流式时 PCM 只占环形缓冲与推理窗口
+static MemoryUsage estimate_job(double fileSeconds, const WhisperParams& params, bool streaming, size_t tracks) {
+    const AudioRange range = params_range(params);
+    double seconds = std::max(0.0, fileSeconds - range.start);
+    if (range.duration > 0.0) {
+        seconds = fileSeconds > 0.0 ? std::min(seconds, range.duration) : range.duration;
+    }
+    MemoryUsage usage = pcm_usage(static_cast<size_t>(seconds * WHISPER_SAMPLE_RATE), tracks);
+    if (streaming) {
+        const uint64_t chunkSamples = static_cast<uint64_t>(std::max(1, params.chunk_seconds)) * WHISPER_SAMPLE_RATE;
+        usage.pcm = std::min<uint64_t>(usage.pcm, chunkSamples * (kStreamBufferChunks + 1) * sizeof(float));
+    }
+    return usage;
 }
 
-// 导出为 LRC 歌词
-std::string WhisperWrapper::exportToLrc(const std::vector<TranscriptSegment>& segments) {
-    std::string result;
-    for (const auto& seg : segments) {
-        int minutes = static_cast<int>(seg.startTime / 60);
-        double seconds = seg.startTime - minutes * 60;
-        char buffer[16];
-        snprintf(buffer, sizeof(buffer), "[%02d:%05.2f]", minutes, seconds);
-        result += std::string(buffer) + " " + seg.text + "\n";
+bool WhisperWrapper::admitJob(const std::string& job, const std::string& audioPath, const WhisperParams& params,
+                              bool streaming, bool canChunk, MemoryBudget::Reservation& reservation, size_t tracks) {
+    size_t audioStreams = 0;
+    const double seconds = probe_audio(audioPath, audioStreams);
+    if (tracks == 0) {
+        tracks = std::max<size_t>(1, audioStreams);
     }
-    return result;
+    
+    MemoryUsage usage = estimate_job(seconds, params, streaming, tracks);
+    if (!streaming && canChunk && !memoryBudget.fitsAlone(usage)) {
+        // 整段 PCM 放不下: 改为流式分块, 只占环形缓冲
+        streaming = true;
+        usage = estimate_job(seconds, params, true, tracks);
+        memoryBudget.countChunked();
+    }
+    
+    std::string error;
+    if (!memoryBudget.reserve(job + ": " + audioPath, usage, reservation, error)) {
+        throw std::runtime_error(error);
+    }
+    return streaming;
 }
 
-bool WhisperWrapper::isModelLoaded() const {
-    return modelLoaded;
+void WhisperWrapper::setMemoryBudget(uint64_t limitBytes, uint64_t queueTimeoutMs) {
+    memoryBudget.setLimit(limitBytes, queueTimeoutMs);
 }
 
-std::string WhisperWrapper::getLastError() const {
-    return lastError;
+MemoryStats WhisperWrapper::getMemoryStats() const {
+    return memoryBudget.stats();
 }
 
+std::vector<TranscriptSegment> WhisperWrapper::transcribe(const std::string& audioPath, 
+                                                           const WhisperParams& params,
+                                                           ProgressCallback callback) {
+    // 整个作业使用开始时的模型版本 (期间重新加载不影响本作业)
+    std::shared_ptr<LoadedModel> model = acquireModel();
+    
+    // 说话人分离、检查点与去重都需要完整 PCM, 其余情况边解码边推理 (PCM 缓存除外)
+    // 整段 PCM 超出内存预算时也改为边解码边推理
+    const bool dedupe = !params.dedupe_index.empty();
+    const bool canChunk = !params.diarize && params.checkpoint_path.empty() && !dedupe;
+    MemoryBudget::Reservation reservation;
+    const bool streaming = admitJob("transcribe", audioPath, params,
+                                    canChunk && params.stream_decode && !params.pcm_cache, canChunk, reservation);
+    if (streaming) {
+        return runStream(*model, audioPath, params, nullptr);
+    }
+    
+    // 命中 PCM 缓存时直接映射, 不再解码
+    const AudioRange range = params_range(params);
+    if (params.pcm_cache) {
+        std::vector<float> decoded;
+        std::unique_ptr<PcmCache> cache = acquirePcmCache(audioPath, params, decoded);
+        if (cache || !decoded.empty()) {
+            std::vector<float> processed;
+            const float* samples = nullptr;
+            size_t n_samples = 0;
+            slice_pcm(cache ? cache->samples() : decoded.data(), cache ? cache->sampleCount() : decoded.size(),
+                      range, params.preprocess, processed, samples, n_samples);
+            if (n_samples == 0) {
+                throw std::runtime_error("Audio file is empty or invalid");
+            }
+            reservation.update(pcm_usage(n_samples));
+            std::vector<TranscriptSegment> segments = dedupe
+                ? transcribeDeduped(*model, samples, n_samples, AudioFingerprinter::compute(samples, n_samples),
+                                    params, audioPath, range.start)
+                : transcribePcm(*model, samples, n_samples, params, audioPath, range.start);
+            return segments;
+        }
+        // 范围转录未命中缓存: 与不使用缓存时相同 (预算已按整段申请, 偏保守)
+        if (canChunk && params.stream_decode) {
+            return runStream(*model, audioPath, params, nullptr);
+        }
+    }
+    
+    // Read audio file
+    // 只解码 offset_ms / duration_ms 指定的范围; 去重时在解码循环中逐块计算指纹
+    std::vector<float> pcmf32;
+    std::vector<std::vector<float>> pcmf32s;
+    AudioFingerprinter fingerprinter;
+    PcmSink sink;
+    if (dedupe) {
+        sink = [&](const float* samples, size_t n) {
+            fingerprinter.process(samples, n);
+            pcmf32.insert(pcmf32.end(), samples, samples + n);
+            return true;
+        };
+    }
+    if (!read_wav(audioPath, pcmf32, pcmf32s, false, range, params.preprocess, nullptr, sink)) {
+        throw std::runtime_error("Failed to read audio file: " + audioPath);
+    }
+    
+    if (pcmf32.empty()) {
+        throw std::runtime_error("Audio file is empty or invalid");
+    }
+    // 时长未知的容器按实际样本数修正
+    reservation.update(pcm_usage(pcmf32.size()));
+    
+    // 进度回调
+    if (callback) {
+        // Whisper.cpp doesn't have built-in progress callback in the full API
+        // We can estimate progress based on processing
+    }
+    
+    std::vector<TranscriptSegment> segments = dedupe
+        ? transcribeDeduped(*model, pcmf32.data(), pcmf32.size(), fingerprinter.fingerprint(), params, audioPath,
+                            range.start)
+        : transcribePcm(*model, pcmf32.data(), pcmf32.size(), params, audioPath, range.start);
+    return segments;
+}
+
+// ---- 去重 ----
+
+// 影响转录结果的参数: 索引中只复用 key 完全相同的记录 (说话人编号也属于复用的结果)
+static std::string dedupe_key(const LoadedModel& model, const WhisperParams& params) {
+    std::string key = model.identity + "|" + decode_params_key(params) + "|";
+    if (params.diarize) {
+        std::ostringstream speakers;
+        speakers << "spk" << params.max_speakers << ',' << params.speaker_threshold;
+        key += speakers.str();
+    }
+    return key;
+}
+
+FingerprintIndex& WhisperWrapper::dedupeIndex(const std::string& path) {
+    std::unique_ptr<FingerprintIndex>& index = dedupeIndexes[path];
+    if (!index) {
+        std::unique_ptr<FingerprintIndex> loaded(new FingerprintIndex());
+        std::string error;
+        if (!loaded->load(path, error)) {
+            dedupeIndexes.erase(path);
+            throw std::runtime_error(error);
+        }
+        index = std::move(loaded);
+    }
+    return *index;
+}
+
+std::vector<TranscriptSegment> WhisperWrapper::transcribeDeduped(LoadedModel& model,
+                                                                 const float* samples, size_t n_samples,
+                                                                 const std::vector<uint32_t>& fingerprint,
+                                                                 const WhisperParams& params,
+                                                                 const std::string& audioPath,
+                                                                 double startSeconds, void* state) {
+    const double duration = static_cast<double>(n_samples) / WHISPER_SAMPLE_RATE;
+    const std::string key = dedupe_key(model, params);
+    {
+        std::lock_guard<std::mutex> lock(dedupeMutex);
+        FingerprintMatch match;
+        if (dedupeIndex(params.dedupe_index).lookup(key, fingerprint, duration, params.dedupe_similarity,
+                                                    params.dedupe_coverage, match)) {
+            for (TranscriptSegment& segment : match.segments) {
+                segment.startTime += startSeconds;
+                segment.endTime += startSeconds;
+            }
+            return match.segments;
+        }
+    }
+    
+    std::vector<TranscriptSegment> segments = transcribePcm(model, samples, n_samples, params, audioPath,
+                                                            startSeconds, state);
+    
+    // 索引中的时间相对于指纹起点; 写入失败 (只读目录等) 不影响转录结果
+    std::vector<TranscriptSegment> relative = segments;
+    for (TranscriptSegment& segment : relative) {
+        segment.startTime -= startSeconds;
+        segment.endTime -= startSeconds;
+    }
+    std::lock_guard<std::mutex> lock(dedupeMutex);
+    std::string error;
+    dedupeIndex(params.dedupe_index).add(audioPath, key, fingerprint, relative, error);
+    return segments;
+}
+
+bool WhisperWrapper::findDuplicate(const std::string& audioPath, const WhisperParams& params, FingerprintMatch& match) {
+    if (params.dedupe_index.empty()) {
+        throw std::runtime_error("dedupe_index is required");
+    }
+    // 只查找当前模型在相同参数下产生的转录
+    const std::string key = dedupe_key(*acquireModel(), params);
+    
+    // 命中 PCM 缓存时直接对映射的样本计算指纹, 否则边解码边计算, 不保留样本
+    const AudioRange range = params_range(params);
+    std::vector<uint32_t> fingerprint;
+    size_t n_samples = 0;
+    std::unique_ptr<PcmCache> cache = params.pcm_cache
+        ? PcmCache::open(PcmCache::cachePath(audioPath, params.pcm_cache_dir), audioPath)
+        : nullptr;
+    if (cache) {
+        std::vector<float> processed;
+        const float* samples = nullptr;
+        slice_pcm(cache->samples(), cache->sampleCount(), range, params.preprocess, processed, samples, n_samples);
+        fingerprint = AudioFingerprinter::compute(samples, n_samples);
+    } else {
+        AudioFingerprinter fingerprinter;
+        std::vector<float> pcmf32;
+        std::vector<std::vector<float>> pcmf32s;
+        if (!read_wav(audioPath, pcmf32, pcmf32s, false, range, params.preprocess, nullptr,
+                      [&](const float* samples, size_t n) {
+                          fingerprinter.process(samples, n);
+                          n_samples += n;
+                          return true;
+                      })) {
+            throw std::runtime_error("Failed to read audio file: " + audioPath);
+        }
+        fingerprint = fingerprinter.fingerprint();
+    }
+    
+    std::lock_guard<std::mutex> lock(dedupeMutex);
+    const double duration = static_cast<double>(n_samples) / WHISPER_SAMPLE_RATE;
+    if (!dedupeIndex(params.dedupe_index).lookup(key, fingerprint, duration, params.dedupe_similarity,
+                                                 params.dedupe_coverage, match)) {
+        return false;
+    }
+    for (TranscriptSegment& segment : match.segments) {
+        segment.startTime += range.start;
+        segment.endTime += range.start;
+    }
+    return true;
+}
+
+// whisper 只在解码结果超过 32 个 token 时才检查熵, 这里保持一致
+static const int kEntropyMinTokens = 32;
+
+// 文本压缩比估计: 原始字节数 / LZ77 贪心编码后的字节数
+// 含义与 OpenAI whisper 的 gzip 压缩比相同, 重复 / 循环输出的比值明显偏高
+static double compression_ratio(const std::string& text) {
+    const size_t n = text.size();
+    if (n < 4) {
+        return 1.0;
+    }
+    
+    const size_t kWindow = 4096;
+    const size_t kMinMatch = 3;
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(text.data());
+    int64_t head[4096];
+    std::fill(head, head + 4096, -1);
+    auto hash = [s](size_t i) {
+        uint32_t v = (static_cast<uint32_t>(s[i]) << 16) | (static_cast<uint32_t>(s[i + 1]) << 8) | s[i + 2];
+        return (v * 2654435761u) >> 20;
+    };
+    
+    size_t cost = 0;
+    size_t i = 0;
+    while (i < n) {
+        size_t matchLen = 0;
+        if (i + kMinMatch <= n) {
+            uint32_t h = hash(i);
+            int64_t candidate = head[h];
+            head[h] = static_cast<int64_t>(i);
+            if (candidate >= 0 && i - static_cast<size_t>(candidate) <= kWindow) {
+                while (i + matchLen < n && s[candidate + matchLen] == s[i + matchLen]) matchLen++;
+            }
+        }
+        if (matchLen >= kMinMatch) {
+            // 匹配记为 3 字节 (距离 + 长度), 匹配内部的位置也写入哈希表
+            cost += 3;
+            for (size_t k = 1; k < matchLen && i + k + kMinMatch <= n; k++) {
+                head[hash(i + k)] = static_cast<int64_t>(i + k);
+            }
+            i += matchLen;
+        } else {
+            cost += 1;
+            i++;
+        }
+    }
+    return static_cast<double>(n) / static_cast<double>(cost);
+}
+
+// 检查点 / 流式分块之间保留的 prompt token 上限 (与 whisper 使用的历史上下文长度一致)
+static const size_t kCheckpointPromptTokens = 224;
+
+std::vector<int32_t> WhisperWrapper::buildPrompt(LoadedModel& model, const WhisperParams& params,
+                                                 const std::vector<int32_t>& carried) {
+    std::vector<int32_t> prompt = cachedTokens(model, params.initial_prompt);
+    // whisper 只使用最后 224 个 prompt token: initial_prompt 固定在前, 剩余空间留给最近的上下文
+    if (prompt.size() >= kCheckpointPromptTokens) {
+        prompt.erase(prompt.begin(), prompt.end() - kCheckpointPromptTokens);
+        return prompt;
+    }
+    size_t room = kCheckpointPromptTokens - prompt.size();
+    const size_t fromCarried = std::min(room, carried.size());
+    room -= fromCarried;
+    const size_t fromParams = std::min(room, params.prompt_tokens.size());
+    prompt.insert(prompt.end(), params.prompt_tokens.end() - fromParams, params.prompt_tokens.end());
+    prompt.insert(prompt.end(), carried.end() - fromCarried, carried.end());
+    return prompt;
+}
+
+// 读取第 i 个片段及其统计量, 时间戳加上 offsetSeconds (state 为空时读取上下文自带的 state)
+// 统计量全部来自 whisper 已有的 token 数据, 不需要额外推理
+// textCarry: 被片段边界拆开的多字节字符移到下一片段补全, 同一次解码的片段须按顺序读取
+static TranscriptSegment read_segment(whisper_context* wctx, whisper_state* state, int i,
+                                      const WhisperParams& params, double offsetSeconds, std::string& textCarry) {
+    TranscriptSegment segment;
+    const int64_t t0 = state ? whisper_full_get_segment_t0_from_state(state, i) : whisper_full_get_segment_t0(wctx, i);
+    const int64_t t1 = state ? whisper_full_get_segment_t1_from_state(state, i) : whisper_full_get_segment_t1(wctx, i);
+    segment.startTime = offsetSeconds + static_cast<double>(t0) / 100.0;
+    segment.endTime = offsetSeconds + static_cast<double>(t1) / 100.0;
+    segment.text = state ? whisper_full_get_segment_text_from_state(state, i) : whisper_full_get_segment_text(wctx, i);
+    
+    // 原地去掉首尾空白与残留特殊 token
+    normalizeSegmentText(segment.text, &textCarry);
+    
+    // 只统计文本 token (时间戳与控制 token 的 id 都不小于 eot)
+    const whisper_token eot = whisper_token_eot(wctx);
+    std::unordered_map<whisper_token, int> counts;
+    double sumLogprob = 0.0;
+    double entropy = 0.0;
+    int textTokens = 0;
+    const int n_tokens = state ? whisper_full_n_tokens_from_state(state, i) : whisper_full_n_tokens(wctx, i);
+    for (int j = 0; j < n_tokens; ++j) {
+        whisper_token_data data = state ? whisper_full_get_token_data_from_state(state, i, j)
+                                        : whisper_full_get_token_data(wctx, i, j);
+        if (data.id >= eot) continue;
+        sumLogprob += data.plog;
+        counts[data.id]++;
+        textTokens++;
+    }
+    if (textTokens > 0) {
+        segment.avgLogprob = sumLogprob / textTokens;
+        for (const auto& entry : counts) {
+            double p = static_cast<double>(entry.second) / textTokens;
+            entropy -= p * std::log(p);
+        }
+    }
+    
+    segment.noSpeechProb = state ? whisper_full_get_segment_no_speech_prob_from_state(state, i)
+                                 : whisper_full_get_segment_no_speech_prob(wctx, i);
+    segment.compressionRatio = compression_ratio(segment.text);
+    segment.lowConfidence = segment.avgLogprob < params.logprob_thold ||
+                            (textTokens > kEntropyMinTokens && entropy < params.entropy_thold);
+    return segment;
+}
+
+// whisper_full 运行期间的回调状态
+// new_segment_callback 每个片段触发一次, 不能据此划分窗口; encoder_begin_callback 在每个 30 秒解码窗口
+// 开始编码前触发, 因此在它 (以及 whisper_full 返回后) 结束上一个窗口: 记录耗时并提交该窗口的片段
+struct DecodeTiming {
+    std::chrono::steady_clock::time_point windowStart;
+    whisper_state* state = nullptr;                // 回调收到的 state (whisper_full 时为上下文自带的 state)
+    int windowFirst = 0;                           // 当前窗口之前已有的片段数
+    std::vector<std::pair<int, double>> windows;   // (该窗口结束时的片段总数, 耗时毫秒)
+    const WhisperParams* params = nullptr;
+    TranscriptCheckpoint* checkpoint = nullptr;
+    std::vector<TranscriptSegment> pending;
+    std::vector<int32_t> promptTokens;
+    std::string textCarry;                         // 上一窗口末尾被截断的 UTF-8 字节
+    double offsetSeconds = 0.0;                    // PCM 起点在源文件中的时间
+};
+
+// 结束当前解码窗口; 有检查点时追加该窗口的全部片段, 以最后一个片段的结束时间作为恢复位置
+static void close_window(whisper_context* wctx, DecodeTiming* timing) {
+    whisper_state* state = timing->state;
+    auto now = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(now - timing->windowStart).count();
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    timing->windows.emplace_back(n_segments, ms);
+    const int first = timing->windowFirst;
+    timing->windowFirst = n_segments;
+    timing->windowStart = now;
+    
+    if (timing->checkpoint == nullptr || n_segments <= first) {
+        return;
+    }
+    
+    const whisper_token eot = whisper_token_eot(wctx);
+    timing->pending.clear();
+    for (int i = first; i < n_segments; ++i) {
+        TranscriptSegment segment = read_segment(wctx, state, i, *timing->params, timing->offsetSeconds,
+                                                 timing->textCarry);
+        segment.decodeTimeMs = ms / (n_segments - first);
+        timing->pending.push_back(segment);
+        
+        const int n_tokens = whisper_full_n_tokens_from_state(state, i);
+        for (int j = 0; j < n_tokens; ++j) {
+            whisper_token id = whisper_full_get_token_id_from_state(state, i, j);
+            if (id < eot) timing->promptTokens.push_back(id);
+        }
+    }
+    if (timing->promptTokens.size() > kCheckpointPromptTokens) {
+        timing->promptTokens.erase(timing->promptTokens.begin(),
+                                   timing->promptTokens.end() - kCheckpointPromptTokens);
+    }
+    
+    int offsetMs = static_cast<int>(std::llround(timing->offsetSeconds * 1000.0)) +
+                   static_cast<int>(whisper_full_get_segment_t1_from_state(state, n_segments - 1) * 10);
+    timing->checkpoint->commit(timing->pending, offsetMs, timing->promptTokens);
+}
+
+static bool on_encoder_begin(whisper_context* wctx, whisper_state* state, void* user_data) {
+    DecodeTiming* timing = static_cast<DecodeTiming*>(user_data);
+    if (timing->state != nullptr) {
+        close_window(wctx, timing);
+    }
+    timing->state = state;
+    timing->windowStart = std::chrono::steady_clock::now();
+    return true;
+}
+
+// 运行 whisper_full 并读取带统计信息的片段, 时间戳加上 offsetSeconds
+// state 为空时使用上下文自带的 state
+static int run_full(whisper_context* wctx, whisper_full_params wparams, const float* samples, int n_samples,
+                    const WhisperParams& params, double offsetSeconds, std::vector<TranscriptSegment>& segments,
+                    TranscriptCheckpoint* checkpoint = nullptr, whisper_state* state = nullptr) {
+    DecodeTiming timing;
+    timing.params = &params;
+    timing.checkpoint = checkpoint;
+    timing.offsetSeconds = offsetSeconds;
+    wparams.encoder_begin_callback = on_encoder_begin;
+    wparams.encoder_begin_callback_user_data = &timing;
+    
+    int ret = state ? whisper_full_with_state(wctx, state, wparams, samples, n_samples)
+                    : whisper_full(wctx, wparams, samples, n_samples);
+    if (ret != 0) {
+        return ret;
+    }
+    if (timing.state != nullptr) {
+        close_window(wctx, &timing);    // 最后一个窗口之后没有 encoder_begin_callback
+    }
+    
+    const int n_segments = state ? whisper_full_n_segments_from_state(state) : whisper_full_n_segments(wctx);
+    size_t window = 0;
+    std::string textCarry;
+    
+    for (int i = 0; i < n_segments; ++i) {
+        TranscriptSegment segment = read_segment(wctx, state, i, params, offsetSeconds, textCarry);
+        
+        // 窗口耗时按该窗口产生的片段数均分 (没有片段的静音窗口不计入)
+        while (window < timing.windows.size() && timing.windows[window].first <= i) window++;
+        if (window < timing.windows.size()) {
+            int first = window > 0 ? timing.windows[window - 1].first : 0;
+            int count = std::max(1, timing.windows[window].first - first);
+            segment.decodeTimeMs = timing.windows[window].second / count;
+        }
+        
+        segments.push_back(segment);
+    }
+    return 0;
+}
+
+std::vector<TranscriptSegment> WhisperWrapper::transcribePcm(LoadedModel& model,
+                                                              const float* samples, size_t n_samples,
+                                                              const WhisperParams& params,
+                                                              const std::string& sourcePath,
+                                                              double startSeconds,
+                                                              void* state) {
+    std::vector<TranscriptSegment> segments;
+    
+    // Set up Whisper parameters
+    // offset_ms 是源文件中的时间, 换算为相对 PCM 起点的偏移
+    whisper_full_params wparams = build_full_params(params);
+    const int startMs = static_cast<int>(std::llround(startSeconds * 1000.0));
+    wparams.offset_ms = std::max(0, params.offset_ms - startMs);
+    
+    // initial_prompt 的分词结果来自缓存; whisper_full 不再自行分词
+    std::vector<int32_t> prompt = buildPrompt(model, params, std::vector<int32_t>());
+    wparams.prompt_tokens = prompt.empty() ? nullptr : prompt.data();
+    wparams.prompt_n_tokens = static_cast<int>(prompt.size());
+    
+    // 检查点: key 包含音频文件的大小与修改时间、模型 identity 以及影响输出的参数, 任何一项变化都重新开始
+    TranscriptCheckpoint checkpoint;
+    CheckpointData resumed;
+    if (!params.checkpoint_path.empty() && !sourcePath.empty()) {
+        std::error_code ec;
+        uintmax_t size = fs::file_size(sourcePath, ec);
+        int64_t mtime = fs::last_write_time(sourcePath, ec).time_since_epoch().count();
+        std::string key = sourcePath + "|" + std::to_string(size) + "|" + std::to_string(mtime) + "|" +
+                          std::to_string(params.offset_ms) + "|" + std::to_string(params.duration_ms) + "|" +
+                          model.identity + "|" + decode_params_key(params);
+        
+        bool resuming = params.resume && TranscriptCheckpoint::load(params.checkpoint_path, key, resumed);
+        if (resuming && resumed.complete) {
+            return resumed.segments;
+        }
+        if (!checkpoint.open(params.checkpoint_path, key, resuming ? &resumed : nullptr)) {
+            throw std::runtime_error("Cannot open checkpoint file: " + params.checkpoint_path);
+        }
+        
+        // 从最后一次提交的位置继续, 用之前的文本作为 prompt 保持上下文连贯 (检查点中的时间为源文件时间)
+        const int resumeMs = resumed.offsetMs - startMs;
+        if (resuming && resumeMs > wparams.offset_ms) {
+            if (wparams.duration_ms > 0) {
+                wparams.duration_ms = std::max(0, wparams.offset_ms + wparams.duration_ms - resumeMs);
+            }
+            wparams.offset_ms = resumeMs;
+            if (!params.no_context && !resumed.promptTokens.empty()) {
+                prompt = buildPrompt(model, params, resumed.promptTokens);
+                wparams.prompt_tokens = prompt.data();
+                wparams.prompt_n_tokens = static_cast<int>(prompt.size());
+            }
+        }
+    }
+    
+    // 说话人分离只依赖 PCM, 在独立线程中与 whisper_full 同时运行
+    std::future<std::vector<SpeakerTurn>> diarization;
+    if (params.diarize) {
+        DiarizationOptions options;
+        options.maxSpeakers = params.max_speakers;
+        options.threshold = params.speaker_threshold;
+        diarization = std::async(std::launch::async, [samples, n_samples, options]() {
+            return Diarizer(options).analyze(samples, n_samples);
+        });
+    }
+    
+    // Run transcription
+    whisper_context* wctx = static_cast<whisper_context*>(model.ctx);
+    TranscriptCheckpoint* active = checkpoint.isOpen() ? &checkpoint : nullptr;
+    if (state != nullptr) {
+        // 独立的 state 可与其它推理并行; 调用方 (批量转录) 自行记录错误
+        if (run_full(wctx, wparams, samples, static_cast<int>(n_samples), params, startSeconds, segments, active,
+                     static_cast<whisper_state*>(state)) != 0) {
+            throw std::runtime_error("Failed to transcribe audio");
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(model.inferenceMutex);
+        if (run_full(wctx, wparams, samples, static_cast<int>(n_samples), params, startSeconds, segments, active) != 0) {
+            throw std::runtime_error("Failed to transcribe audio");
+        }
+    }
+    
+    if (checkpoint.isOpen()) {
+        checkpoint.markComplete();
+        segments.insert(segments.begin(), resumed.segments.begin(), resumed.segments.end());
+    }
+    
+    if (diarization.valid()) {
+        std::vector<SpeakerTurn> turns = diarization.get();
+        for (SpeakerTurn& turn : turns) {
+            turn.startTime += startSeconds;
+            turn.endTime += startSeconds;
+        }
+        assignSpeakers(segments, turns);
+    }
+    
+    return segments;
+}
+
+std::vector<TranscriptSegment> WhisperWrapper::transcribeStream(const std::string& audioPath,
+                                                                 const WhisperParams& params,
+                                                                 SegmentCallback onSegments) {
+    std::shared_ptr<LoadedModel> model = acquireModel();
+    MemoryBudget::Reservation reservation;
+    admitJob("transcribeStream", audioPath, params, true, true, reservation);
+    return runStream(*model, audioPath, params, onSegments);
+}
+
+std::vector<TranscriptSegment> WhisperWrapper::runStream(LoadedModel& model, const std::string& audioPath,
+                                                          const WhisperParams& params,
+                                                          SegmentCallback onSegments) {
+    const size_t chunkSamples = static_cast<size_t>(std::max(1, params.chunk_seconds)) * WHISPER_SAMPLE_RATE;
+    PcmRingBuffer ring(chunkSamples * kStreamBufferChunks);
+    
+    // 解码线程只解码 offset_ms / duration_ms 范围, 缓冲中的第一个样本即 range.start
+    const AudioRange range = params_range(params);
+    
+    // 解码线程: 缓冲满时等待; 推理结束 (或异常退出) 后 cancel 使其停止解码
+    bool decodeOk = false;
+    std::thread decoder([&]() {
+        try {
+            std::vector<float> pcmf32;
+            std::vector<std::vector<float>> pcmf32s;
+            decodeOk = read_wav(audioPath, pcmf32, pcmf32s, false, range, params.preprocess, nullptr,
+                                [&ring](const float* samples, size_t n) { return ring.write(samples, n); });
+        } catch (const std::exception&) {
+            decodeOk = false;
+        }
+        ring.close();
+    });
+    struct DecoderGuard {
+        PcmRingBuffer& ring;
+        std::thread& thread;
+        ~DecoderGuard() {
+            ring.cancel();
+            if (thread.joinable()) thread.join();
+        }
+    } guard{ring, decoder};
+    
+    whisper_full_params wparams = build_full_params(params);
+    wparams.offset_ms = 0;
+    wparams.duration_ms = 0;
+    
+    whisper_context* wctx = static_cast<whisper_context*>(model.ctx);
+    const whisper_token eot = whisper_token_eot(wctx);
+    std::vector<float> window(chunkSamples);
+    std::vector<whisper_token> carried;    // 已确定片段的文本 token, 作为下一块的上下文
+    std::vector<whisper_token> prompt;
+    std::vector<TranscriptSegment> segments;
+    std::vector<TranscriptSegment> chunk;
+    size_t consumed = 0;
+    
+    while (true) {
+        const size_t n = std::min(ring.waitFor(chunkSamples), chunkSamples);
+        if (n == 0) {
+            break;
+        }
+        // 解码已结束且缓冲中没有更多样本: 本块为最后一块
+        const bool last = ring.closed() && ring.available() <= n;
+        const double base = range.start + static_cast<double>(consumed) / WHISPER_SAMPLE_RATE;
+        ring.peek(window.data(), n);
+        
+        // 每块都带上 initial_prompt (分词结果已缓存), no_context 时不带上一块的文本
+        prompt = buildPrompt(model, params, carried);
+        wparams.prompt_tokens = prompt.empty() ? nullptr : prompt.data();
+        wparams.prompt_n_tokens = static_cast<int>(prompt.size());
+        
+        size_t advance = n;
+        chunk.clear();
+        {
+            std::lock_guard<std::mutex> lock(model.inferenceMutex);
+            if (run_full(wctx, wparams, window.data(), static_cast<int>(n), params, base, chunk) != 0) {
+                throw std::runtime_error("Failed to transcribe audio");
+            }
+            
+            // language 为 auto 时只在第一块 (有文本的块) 检测一次, 之后的块固定使用该语言:
+            // 避免同一文件中途切换语言, 也省去每块的检测开销
+            if (std::strcmp(wparams.language, "auto") == 0 && !chunk.empty()) {
+                const int langId = whisper_full_lang_id(wctx);
+                if (langId >= 0) wparams.language = whisper_lang_str(langId);
+            }
+            
+            // 块尾的片段可能被截断: 丢弃它并让下一块从它的起点开始
+            // (起点离块首不足 1 秒时保留, 保证每块至少前进 1 秒)
+            if (!last && chunk.size() > 1) {
+                double cut = (chunk.back().startTime - base) * WHISPER_SAMPLE_RATE;
+                if (cut >= WHISPER_SAMPLE_RATE && cut < static_cast<double>(n)) {
+                    advance = static_cast<size_t>(cut);
+                    chunk.pop_back();
+                }
+            }
+            
+            // 已确定片段的文本 token 作为下一块的上下文
+            for (size_t i = 0; i < chunk.size() && !params.no_context; ++i) {
+                const int n_tokens = whisper_full_n_tokens(wctx, static_cast<int>(i));
+                for (int j = 0; j < n_tokens; ++j) {
+                    whisper_token id = whisper_full_get_token_id(wctx, static_cast<int>(i), j);
+                    if (id < eot) carried.push_back(id);
+                }
+            }
+        }
+        if (carried.size() > kCheckpointPromptTokens) {
+            carried.erase(carried.begin(), carried.end() - kCheckpointPromptTokens);
+        }
+        
+        ring.consume(advance);
+        consumed += advance;
+        if (!chunk.empty()) {
+            if (onSegments) {
+                onSegments(chunk);
+            }
+            segments.insert(segments.end(), chunk.begin(), chunk.end());
+        }
+    }
+    
+    ring.cancel();
+    decoder.join();
+    if (!decodeOk) {
+        throw std::runtime_error("Failed to read audio file: " + audioPath);
+    }
+    if (consumed == 0) {
+        throw std::runtime_error("Audio file is empty or invalid");
+    }
+    
+    return segments;
+}
+
+// 批量转录中已解码、等待推理的文件
+struct DecodedBatchFile {
+    size_t index = 0;
+    std::unique_ptr<PcmCache> cache;
+    std::vector<float> pcm;                // 直接解码的样本 (或缓存写入失败时的整段 PCM)
+    std::vector<float> processed;          // 缓存样本预处理后的结果
+    const float* samples = nullptr;
+    size_t n_samples = 0;
+    double decodeMs = 0.0;
+    std::string error;
+    MemoryBudget::Reservation reservation;   // 该文件的 PCM 预算, 推理完成后随 item 释放
+    std::vector<uint32_t> fingerprint;       // 去重时在解码线程中计算
+};
+
+BatchResult WhisperWrapper::transcribeBatch(const std::vector<std::string>& files, const WhisperParams& params,
+                                            const BatchOptions& options, BatchCallback onFile) {
+    // 整个批次使用开始时的模型版本 (whisper_state 属于该版本的上下文, 须在它之前释放)
+    std::shared_ptr<LoadedModel> model = acquireModel();
+    
+    const auto started = std::chrono::steady_clock::now();
+    BatchResult result;
+    result.files.resize(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        result.files[i].path = files[i];
+    }
+    if (files.empty()) {
+        return result;
+    }
+    
+    WhisperParams fileParams = params;
+    fileParams.checkpoint_path.clear();
+    const AudioRange range = params_range(fileParams);
+    const bool dedupe = !fileParams.dedupe_index.empty();
+    
+    // 各文件的预算估算 (只读容器头)
+    std::vector<MemoryUsage> estimates(files.size());
+    MemoryUsage largest;
+    for (size_t i = 0; i < files.size(); ++i) {
+        size_t audioStreams = 0;
+        estimates[i] = estimate_job(probe_audio(files[i], audioStreams), fileParams, false, 1);
+        if (estimates[i].total() > largest.total()) largest = estimates[i];
+    }
+    
+    // 每个推理线程一个 whisper_state (共享模型权重), 不占用上下文自带的 state, 单文件接口可同时使用
+    // 每份 state 都要在预算中留出最大文件的空间, 否则解码线程会等待本批次自己占用的预算;
+    // 第一份 state 放不下时排队 / 拒绝, 其余放不下时减少并发
+    whisper_context* wctx = static_cast<whisper_context*>(model->ctx);
+    const size_t wanted = std::min(files.size(), static_cast<size_t>(std::max(1, options.concurrency)));
+    std::vector<whisper_state*> states;
+    std::vector<MemoryBudget::Reservation> stateReservations;
+    struct StateGuard {
+        std::vector<whisper_state*>& states;
+        ~StateGuard() {
+            for (whisper_state* state : states) whisper_free_state(state);
+        }
+    } stateGuard{states};
+    for (size_t i = 0; i < wanted; ++i) {
+        MemoryUsage stateUsage;
+        stateUsage.state = model->stateBytes;
+        MemoryUsage withFile = largest;
+        withFile += stateUsage;
+        MemoryBudget::Reservation reservation;
+        if (i == 0) {
+            std::string error;
+            if (!memoryBudget.reserve("transcribeBatch: whisper_state", withFile, reservation, error)) {
+                throw std::runtime_error(error);
+            }
+        } else if (!memoryBudget.tryReserve("transcribeBatch: whisper_state", withFile, reservation)) {
+            break;
+        }
+        reservation.update(stateUsage);
+        
+        whisper_state* state = whisper_init_state(wctx);
+        if (state == nullptr) break;       // 内存 / 显存不足时按已创建的数量运行
+        states.push_back(state);
+        stateReservations.push_back(std::move(reservation));
+    }
+    if (states.empty()) {
+        throw std::runtime_error("Failed to allocate whisper state");
+    }
+    result.states = static_cast<int>(states.size());
+    
+    // 解码线程按输入顺序解码, 已解码文件最多排队 prefetch 个
+    const size_t queueCapacity = static_cast<size_t>(std::max(1, options.prefetch));
+    std::mutex queueMutex;
+    std::condition_variable queueCv;
+    std::deque<std::unique_ptr<DecodedBatchFile>> queue;
+    bool decodeDone = false;
+    
+    std::thread decoder([&]() {
+        for (size_t i = 0; i < files.size(); ++i) {
+            std::unique_ptr<DecodedBatchFile> item(new DecodedBatchFile());
+            item->index = i;
+            const auto t0 = std::chrono::steady_clock::now();
+            try {
+                // 预算不足时等待正在推理的文件释放
+                std::string budgetError;
+                if (!memoryBudget.reserve("transcribeBatch: " + files[i], estimates[i], item->reservation, budgetError)) {
+                    throw std::runtime_error(budgetError);
+                }
+                if (fileParams.pcm_cache) {
+                    item->cache = acquirePcmCache(files[i], fileParams, item->pcm);
+                }
+                if (item->cache || !item->pcm.empty()) {
+                    slice_pcm(item->cache ? item->cache->samples() : item->pcm.data(),
+                              item->cache ? item->cache->sampleCount() : item->pcm.size(),
+                              range, fileParams.preprocess, item->processed, item->samples, item->n_samples);
+                } else {
+                    std::vector<std::vector<float>> pcmf32s;
+                    AudioFingerprinter fingerprinter;
+                    PcmSink sink;
+                    if (dedupe) {
+                        sink = [&](const float* samples, size_t n) {
+                            fingerprinter.process(samples, n);
+                            item->pcm.insert(item->pcm.end(), samples, samples + n);
+                            return true;
+                        };
+                    }
+                    if (!read_wav(files[i], item->pcm, pcmf32s, false, range, fileParams.preprocess, nullptr, sink)) {
+                        throw std::runtime_error("Failed to read audio file: " + files[i]);
+                    }
+                    item->samples = item->pcm.data();
+                    item->n_samples = item->pcm.size();
+                    item->fingerprint = fingerprinter.fingerprint();
+                }
+                if (dedupe && item->fingerprint.empty() && item->n_samples > 0) {
+                    item->fingerprint = AudioFingerprinter::compute(item->samples, item->n_samples);
+                }
+                if (item->n_samples == 0) {
+                    item->error = "Audio file is empty or invalid";
+                }
+                item->reservation.update(pcm_usage(item->n_samples));
+            } catch (const std::exception& e) {
+                item->error = e.what();
+            }
+            item->decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCv.wait(lock, [&]() { return queue.size() < queueCapacity; });
+            queue.push_back(std::move(item));
+            queueCv.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(queueMutex);
+        decodeDone = true;
+        queueCv.notify_all();
+    });
+    
+    std::mutex callbackMutex;
+    auto work = [&](whisper_state* state) {
+        while (true) {
+            std::unique_ptr<DecodedBatchFile> item;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCv.wait(lock, [&]() { return !queue.empty() || decodeDone; });
+                if (queue.empty()) return;
+                item = std::move(queue.front());
+                queue.pop_front();
+                queueCv.notify_all();
+            }
+            
+            BatchFileResult& file = result.files[item->index];
+            file.decodeMs = item->decodeMs;
+            file.error = item->error;
+            if (file.error.empty()) {
+                file.audioSeconds = static_cast<double>(item->n_samples) / WHISPER_SAMPLE_RATE;
+                const auto t0 = std::chrono::steady_clock::now();
+                try {
+                    file.segments = dedupe
+                        ? transcribeDeduped(*model, item->samples, item->n_samples, item->fingerprint, fileParams,
+                                            files[item->index], range.start, state)
+                        : transcribePcm(*model, item->samples, item->n_samples, fileParams,
+                                        files[item->index], range.start, state);
+                } catch (const std::exception& e) {
+                    file.error = e.what();
+                }
+                file.inferenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            }
+            const size_t index = item->index;
+            item.reset();   // 尽早释放 PCM / 缓存映射
+            
+            if (onFile) {
+                std::lock_guard<std::mutex> lock(callbackMutex);
+                onFile(index, file);
+            }
+        }
+    };
+    
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < states.size(); ++i) {
+        workers.emplace_back(work, states[i]);
+    }
+    work(states[0]);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    decoder.join();
+    
+    for (const BatchFileResult& file : result.files) {
+        if (file.error.empty()) result.audioSeconds += file.audioSeconds;
+    }
+    result.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    if (result.wallMs > 0.0) {
+        result.audioHoursPerHour = result.audioSeconds / (result.wallMs / 1000.0);
+    }
+    return result;
+}
+
+// 静音窗口 (RMS 低于该值) 不参与语言检测
+static const float kSilenceRms = 1e-3f;
+
+LanguageDetectResult WhisperWrapper::detectLanguage(const std::string& audioPath,
+                                                    const LanguageDetectOptions& options) {
+    std::shared_ptr<LoadedModel> model = acquireModel();
+    
+    std::vector<double> positions = options.positions;
+    if (positions.empty()) {
+        positions = {0.2, 0.5, 0.8};
+    }
+    // 所有窗口拼接后由编码器一次处理, 合计不超过 whisper 的 30 秒输入窗口
+    double windowSeconds = std::min(std::max(options.sampleSeconds, 1.0), 30.0 / positions.size());
+    
+    LanguageDetectResult result;
+    std::vector<std::vector<float>> windows;
+    std::string error;
+    if (!read_wav_windows(audioPath, positions, windowSeconds, windows, result.sampleTimes,
+                          result.durationSeconds, error)) {
+        throw std::runtime_error("Failed to read audio file: " + audioPath + " (" + error + ")");
+    }
+    
+    // 去掉静音窗口 (全部静音时保留全部, 由模型给出结果)
+    std::vector<float> pcmf32;
+    std::vector<double> voicedTimes;
+    for (size_t i = 0; i < windows.size(); i++) {
+        double energy = 0.0;
+        for (float sample : windows[i]) energy += static_cast<double>(sample) * sample;
+        if (!windows[i].empty() && std::sqrt(energy / windows[i].size()) >= kSilenceRms) {
+            pcmf32.insert(pcmf32.end(), windows[i].begin(), windows[i].end());
+            voicedTimes.push_back(result.sampleTimes[i]);
+        }
+    }
+    if (pcmf32.empty()) {
+        for (const std::vector<float>& window : windows) {
+            pcmf32.insert(pcmf32.end(), window.begin(), window.end());
+        }
+    } else {
+        result.sampleTimes = voicedTimes;
+    }
+    if (pcmf32.empty()) {
+        throw std::runtime_error("Audio file is empty: " + audioPath);
+    }
+    
+    std::vector<float> probs(whisper_lang_max_id() + 1, 0.0f);
+    {
+        std::lock_guard<std::mutex> lock(model->inferenceMutex);
+        whisper_context* wctx = static_cast<whisper_context*>(model->ctx);
+        if (whisper_pcm_to_mel(wctx, pcmf32.data(), static_cast<int>(pcmf32.size()), options.n_threads) != 0 ||
+            whisper_lang_auto_detect(wctx, 0, options.n_threads, probs.data()) < 0) {
+            throw std::runtime_error("Language detection failed");
+        }
+    }
+    
+    for (int id = 0; id < static_cast<int>(probs.size()); id++) {
+        if (probs[id] < 1e-3f) continue;
+        LanguageProbability lang;
+        lang.language = whisper_lang_str(id);
+        lang.name = whisper_lang_str_full(id);
+        lang.probability = probs[id];
+        result.languages.push_back(lang);
+    }
+    std::sort(result.languages.begin(), result.languages.end(),
+              [](const LanguageProbability& a, const LanguageProbability& b) { return a.probability > b.probability; });
+    
+    return result;
+}
+
+std::vector<float> WhisperWrapper::decodeAudio(const std::string& audioPath, const WhisperParams& params,
+                                               double& decodeMs, double& preprocessMs) {
+    std::vector<float> pcmf32;
+    std::vector<std::vector<float>> pcmf32s;
+    
+    auto start = std::chrono::steady_clock::now();
+    preprocessMs = 0.0;
+    
+    // 返回整段 PCM, 不能分块
+    MemoryBudget::Reservation reservation;
+    admitJob("decodeAudio", audioPath, params, false, false, reservation);
+    
+    if (params.pcm_cache) {
+        std::vector<float> decoded;
+        std::unique_ptr<PcmCache> cache = acquirePcmCache(audioPath, params, decoded);
+        if (cache || !decoded.empty()) {
+            std::vector<float> processed;
+            const float* samples = nullptr;
+            size_t n_samples = 0;
+            auto preprocessStart = std::chrono::steady_clock::now();
+            slice_pcm(cache ? cache->samples() : decoded.data(), cache ? cache->sampleCount() : decoded.size(),
+                      params_range(params), params.preprocess, processed, samples, n_samples);
+            if (params.preprocess.enabled()) {
+                preprocessMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - preprocessStart).count();
+            }
+            pcmf32.assign(samples, samples + n_samples);
+            decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return pcmf32;
+        }
+    }
+    
+    if (!read_wav(audioPath, pcmf32, pcmf32s, false, params_range(params), params.preprocess, &preprocessMs)) {
+        throw std::runtime_error("Failed to read audio file: " + audioPath);
+    }
+    decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    
+    return pcmf32;
+}
+
+std::vector<TrackTranscript> WhisperWrapper::transcribeTracks(const std::string& audioPath,
+                                                              const WhisperParams& params,
+                                                              const std::vector<int>& streams) {
+    std::shared_ptr<LoadedModel> model = acquireModel();
+    
+    // 全部选中音轨的 PCM 同时在内存中, 不能分块
+    MemoryBudget::Reservation reservation;
+    admitJob("transcribeTracks", audioPath, params, false, false, reservation, streams.size());
+    
+    // 一次 demux 解码全部选中的音轨
+    std::vector<DecodedTrack> decoded;
+    std::string error;
+    if (!read_wav_tracks(audioPath, streams, decoded, error, params.preprocess)) {
+        throw std::runtime_error("Failed to read audio file: " + audioPath + " (" + error + ")");
+    }
+    
+    std::vector<TrackTranscript> results;
+    results.reserve(decoded.size());
+    for (DecodedTrack& track : decoded) {
+        TrackTranscript result;
+        result.streamIndex = track.streamIndex;
+        result.language = track.language;
+        result.error = track.error;
+        
+        if (track.error.empty() && track.pcmf32.empty()) {
+            result.error = "Audio track is empty";
+        }
+        if (result.error.empty()) {
+            result.segments = transcribePcm(*model, track.pcmf32.data(), track.pcmf32.size(), params);
+        }
+        
+        // 转录完成后立即释放该音轨的 PCM
+        std::vector<float>().swap(track.pcmf32);
+        results.push_back(std::move(result));
+    }
+    
+    return results;
+}
+
+// 精修区间向两侧扩展的时长 (不会越过相邻的保留片段)
+static const double kRefinePaddingSeconds = 0.5;
+// 两个低置信度片段之间夹着的片段短于该时长时, 一并精修
+static const double kRefineBridgeSeconds = 2.0;
+
+std::vector<TranscriptSegment> WhisperWrapper::transcribeTwoPass(const std::string& audioPath,
+                                                                 const WhisperParams& params,
+                                                                 TwoPassCallback callback) {
+    // 两遍都使用开始时的版本, 草稿与精修之间重新加载不影响本作业
+    std::shared_ptr<LoadedModel> model = acquireModel();
+    std::shared_ptr<LoadedModel> draft = acquireModel(true);
+    
+    // 精修需要按时间回到整段 PCM, 不能分块
+    MemoryBudget::Reservation reservation;
+    admitJob("transcribeTwoPass", audioPath, params, false, false, reservation);
+    
+    // 只解码 offset_ms / duration_ms 范围, 下面的时间均为源文件时间
+    std::vector<float> pcmf32;
+    std::vector<std::vector<float>> pcmf32s;
+    const AudioRange range = params_range(params);
+    if (!read_wav(audioPath, pcmf32, pcmf32s, false, range, params.preprocess)) {
+        throw std::runtime_error("Failed to read audio file: " + audioPath);
+    }
+    if (pcmf32.empty()) {
+        throw std::runtime_error("Audio file is empty or invalid");
+    }
+    reservation.update(pcm_usage(pcmf32.size()));
+    
+    std::future<std::vector<SpeakerTurn>> diarization;
+    if (params.diarize) {
+        DiarizationOptions options;
+        options.maxSpeakers = params.max_speakers;
+        options.threshold = params.speaker_threshold;
+        diarization = std::async(std::launch::async, [&pcmf32, options]() {
+            return Diarizer(options).analyze(pcmf32.data(), pcmf32.size());
+        });
+    }
+    
+    // 第一遍: 草稿模型转录全文
+    std::vector<TranscriptSegment> drafts;
+    std::string detectedLanguage;
+    {
+        std::lock_guard<std::mutex> lock(draft->inferenceMutex);
+        whisper_context* dctx = static_cast<whisper_context*>(draft->ctx);
+        whisper_full_params wparams = build_full_params(params);
+        wparams.offset_ms = 0;
+        wparams.duration_ms = 0;
+        std::vector<int32_t> draftPrompt = buildPrompt(*draft, params, std::vector<int32_t>());
+        wparams.prompt_tokens = draftPrompt.empty() ? nullptr : draftPrompt.data();
+        wparams.prompt_n_tokens = static_cast<int>(draftPrompt.size());
+        if (run_full(dctx, wparams, pcmf32.data(), static_cast<int>(pcmf32.size()), params, range.start, drafts) != 0) {
+            throw std::runtime_error("Failed to transcribe audio with draft model");
+        }
+        
+        int langId = whisper_full_lang_id(dctx);
+        if (langId >= 0) detectedLanguage = whisper_lang_str(langId);
+    }
+    
+    std::vector<SpeakerTurn> turns;
+    if (diarization.valid()) {
+        turns = diarization.get();
+        for (SpeakerTurn& turn : turns) {
+            turn.startTime += range.start;
+            turn.endTime += range.start;
+        }
+        assignSpeakers(drafts, turns);
+    }
+    
+    if (callback) {
+        TwoPassEvent event;
+        event.kind = TwoPassEvent::Draft;
+        event.segments = drafts;
+        callback(event);
+    }
+    
+    // 挑出未通过置信度阈值的片段, 相邻的合并为精修区间 [first, last]
+    std::vector<std::pair<size_t, size_t>> regions;
+    for (size_t i = 0; i < drafts.size(); i++) {
+        if (!drafts[i].lowConfidence) continue;
+        if (!regions.empty()) {
+            size_t last = regions.back().second;
+            bool adjacent = last + 1 == i;
+            bool bridged = last + 2 == i &&
+                           drafts[last + 1].endTime - drafts[last + 1].startTime < kRefineBridgeSeconds;
+            if (adjacent || bridged) {
+                regions.back().second = i;
+                continue;
+            }
+        }
+        regions.push_back(std::make_pair(i, i));
+    }
+    
+    // 第二遍: 主模型只处理精修区间, 区间之间互不依赖, 关闭跨区间的上下文
+    whisper_full_params rparams = build_full_params(params);
+    rparams.offset_ms = 0;
+    rparams.duration_ms = 0;
+    rparams.no_context = true;
+    std::vector<int32_t> refinePrompt = buildPrompt(*model, params, std::vector<int32_t>());
+    rparams.prompt_tokens = refinePrompt.empty() ? nullptr : refinePrompt.data();
+    rparams.prompt_n_tokens = static_cast<int>(refinePrompt.size());
+    if ((params.language == "auto" || params.language.empty()) && !detectedLanguage.empty()) {
+        rparams.language = detectedLanguage.c_str();
+    }
+    
+    const double totalSeconds = range.start + static_cast<double>(pcmf32.size()) / WHISPER_SAMPLE_RATE;
+    std::vector<TranscriptSegment> result = drafts;
+    ptrdiff_t shift = 0;
+    
+    for (const auto& region : regions) {
+        const size_t first = region.first;
+        const size_t last = region.second;
+        double lower = first > 0 ? drafts[first - 1].endTime : range.start;
+        double upper = last + 1 < drafts.size() ? drafts[last + 1].startTime : totalSeconds;
+        double start = std::max(lower, drafts[first].startTime - kRefinePaddingSeconds);
+        double end = std::min(upper, drafts[last].endTime + kRefinePaddingSeconds);
+        
+        size_t s0 = static_cast<size_t>(std::max(0.0, start - range.start) * WHISPER_SAMPLE_RATE);
+        size_t s1 = std::min(pcmf32.size(), static_cast<size_t>(std::max(0.0, end - range.start) * WHISPER_SAMPLE_RATE));
+        if (s1 <= s0) continue;
+        
+        std::vector<TranscriptSegment> refined;
+        {
+            std::lock_guard<std::mutex> lock(model->inferenceMutex);
+            whisper_context* wctx = static_cast<whisper_context*>(model->ctx);
+            if (run_full(wctx, rparams, pcmf32.data() + s0, static_cast<int>(s1 - s0), params,
+                         range.start + static_cast<double>(s0) / WHISPER_SAMPLE_RATE, refined) != 0) {
+                throw std::runtime_error("Failed to refine audio");
+            }
+        }
+        
+        // 主模型没有输出时保留草稿
+        if (refined.empty()) continue;
+        for (TranscriptSegment& segment : refined) {
+            segment.startTime = std::max(segment.startTime, start);
+            segment.endTime = std::min(std::max(segment.endTime, segment.startTime), end);
+        }
+        if (!turns.empty()) {
+            assignSpeakers(refined, turns);
+        }
+        
+        TwoPassEvent event;
+        event.kind = TwoPassEvent::Refine;
+        event.replaceStart = static_cast<size_t>(static_cast<ptrdiff_t>(first) + shift);
+        event.replaceCount = last - first + 1;
+        event.segments = refined;
+        
+        result.erase(result.begin() + event.replaceStart, result.begin() + event.replaceStart + event.replaceCount);
+        result.insert(result.begin() + event.replaceStart, refined.begin(), refined.end());
+        shift += static_cast<ptrdiff_t>(refined.size()) - static_cast<ptrdiff_t>(event.replaceCount);
+        
+        if (callback) {
+            callback(event);
+        }
+    }
+    
+    return result;
+}
+
+// 简化接口（向后兼容）
+std::vector<TranscriptSegment> WhisperWrapper::transcribe(const std::string& audioPath, 
+                                                           const std::string& language) {
+    WhisperParams params;
+    params.language = language;
+    return transcribe(audioPath, params);
+}
+
+// ---- 导出 ----
+
+enum class ExportFormat { Txt, Srt, Vtt, Json, Lrc };
+
+// 格式名同时也是文件扩展名
+static bool parse_export_format(const std::string& name, ExportFormat& format) {
+    if (name == "txt") format = ExportFormat::Txt;
+    else if (name == "srt") format = ExportFormat::Srt;
+    else if (name == "vtt") format = ExportFormat::Vtt;
+    else if (name == "json") format = ExportFormat::Json;
+    else if (name == "lrc") format = ExportFormat::Lrc;
+    else return false;
+    return true;
+}
+
+// 写出阈值: 关联文件时缓冲超过该大小就写一次
+static const size_t kExportFlushBytes = 1 << 20;
+
+// 导出输出: 追加到内存缓冲; 关联文件时按块写出, 内存占用与片段数无关
+class ExportSink {
+public:
+    explicit ExportSink(std::ofstream* file = nullptr) : file(file) {
+        if (file) buffer.reserve(kExportFlushBytes + 4096);
+    }
+
+    void reserve(size_t n) {
+        if (!file) buffer.reserve(n);
+    }
+
+    void append(const char* data, size_t n) {
+        buffer.append(data, n);
+        if (file && buffer.size() >= kExportFlushBytes) flush();
+    }
+
+    void append(const std::string& str) { append(str.data(), str.size()); }
+    void append(const char* str) { append(str, std::strlen(str)); }
+
+    void flush() {
+        if (file && !buffer.empty()) {
+            file->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            written += buffer.size();
+            buffer.clear();
+        }
+    }
+
+    uint64_t bytes() const { return written + buffer.size(); }
+    std::string& content() { return buffer; }
+
+private:
+    std::ofstream* file;
+    std::string buffer;
+    uint64_t written = 0;
+};
+
+static void append_timestamp(ExportSink& out, int64_t ms, bool srtFormat) {
+    char buffer[kMaxTimestampChars];
+    out.append(buffer, writeTimestamp(buffer, ms, srtFormat ? ',' : '.'));
+}
+
+// JSON 字符串 (含引号); 连续的普通字节整段追加
+static void append_json_string(ExportSink& out, const std::string& text) {
+    out.append("\"", 1);
+    size_t runStart = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(text.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"': out.append("\\\"", 2); break;
+            case '\\': out.append("\\\\", 2); break;
+            case '\n': out.append("\\n", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            default: {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out.append(escaped, 6);
+                break;
+            }
+        }
+    }
+    out.append(text.data() + runStart, text.size() - runStart);
+    out.append("\"", 1);
+}
+
+static void write_segments(ExportFormat format, const std::vector<TranscriptSegment>& segments, ExportSink& out) {
+    char buffer[kMaxTimestampChars];
+    switch (format) {
+        case ExportFormat::Txt:
+            for (const auto& seg : segments) {
+                out.append(seg.text);
+                out.append("\n", 1);
+            }
+            break;
+
+        case ExportFormat::Srt: {
+            uint64_t index = 1;
+            for (const auto& seg : segments) {
+                size_t n = writeUnsigned(buffer, index++);
+                buffer[n++] = '\n';
+                out.append(buffer, n);
+                append_timestamp(out, seg.startMs(), true);
+                out.append(" --> ", 5);
+                append_timestamp(out, seg.endMs(), true);
+                out.append("\n", 1);
+                out.append(seg.text);
+                out.append("\n\n", 2);
+            }
+            break;
+        }
+
+        case ExportFormat::Vtt:
+            out.append("WEBVTT\n\n", 8);
+            for (const auto& seg : segments) {
+                append_timestamp(out, seg.startMs(), false);
+                out.append(" --> ", 5);
+                append_timestamp(out, seg.endMs(), false);
+                out.append("\n", 1);
+                out.append(seg.text);
+                out.append("\n\n", 2);
+            }
+            break;
+
+        case ExportFormat::Json:
+            out.append("{\n  \"segments\": [\n");
+            for (size_t i = 0; i < segments.size(); ++i) {
+                const auto& seg = segments[i];
+                out.append("    {\n      \"start\": ");
+                out.append(buffer, writeSeconds(buffer, seg.startMs()));
+                out.append(",\n      \"end\": ");
+                out.append(buffer, writeSeconds(buffer, seg.endMs()));
+                out.append(",\n      \"text\": ");
+                append_json_string(out, seg.text);
+                out.append(i + 1 < segments.size() ? "\n    },\n" : "\n    }\n");
+            }
+            out.append("  ]\n}\n");
+            break;
+
+        case ExportFormat::Lrc:
+            for (const auto& seg : segments) {
+                size_t n = writeLrcTimestamp(buffer, seg.startMs());
+                buffer[n++] = ' ';
+                out.append(buffer, n);
+                out.append(seg.text);
+                out.append("\n", 1);
+            }
+            break;
+    }
+}
+
+// 估算导出大小, 内存输出时一次预留
+static size_t estimate_export_bytes(const std::vector<TranscriptSegment>& segments) {
+    size_t bytes = 64;
+    for (const auto& seg : segments) {
+        bytes += seg.text.size() + 80;
+    }
+    return bytes;
+}
+
+static std::string export_to_string(ExportFormat format, const std::vector<TranscriptSegment>& segments) {
+    ExportSink sink;
+    sink.reserve(estimate_export_bytes(segments));
+    write_segments(format, segments, sink);
+    return std::move(sink.content());
+}
+
+// 导出到文件 (先写临时文件再替换)
+static void export_to_file(ExportFormat format, const std::vector<TranscriptSegment>& segments,
+                    const fs::path& target, ExportedFile& result) {
+    fs::path tmp = target;
+    tmp += ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            result.error = "Cannot create file: " + target.u8string();
+            return;
+        }
+        ExportSink sink(&file);
+        write_segments(format, segments, sink);
+        sink.flush();
+        file.flush();
+        if (!file.good()) {
+            file.close();
+            fs::remove(tmp, ec);
+            result.error = "Failed to write file: " + target.u8string();
+            return;
+        }
+        result.bytes = sink.bytes();
+    }
+    fs::rename(tmp, target, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        result.bytes = 0;
+        result.error = "Failed to write file: " + target.u8string();
+        return;
+    }
+    result.path = target.u8string();
+}
+
+
+// 格式化时间戳
+std::string WhisperWrapper::formatTimestamp(double seconds, bool srtFormat) {
+    char buffer[kMaxTimestampChars];
+    return std::string(buffer, writeTimestamp(buffer, secondsToMs(seconds), srtFormat ? ',' : '.'));
+}
+
+// 导出为纯文本
+std::string WhisperWrapper::exportToTxt(const std::vector<TranscriptSegment>& segments) {
+    return export_to_string(ExportFormat::Txt, segments);
+}
+
+// 导出为 SRT 字幕
+std::string WhisperWrapper::exportToSrt(const std::vector<TranscriptSegment>& segments) {
+    return export_to_string(ExportFormat::Srt, segments);
+}
+
+// 导出为 VTT 字幕
+std::string WhisperWrapper::exportToVtt(const std::vector<TranscriptSegment>& segments) {
+    return export_to_string(ExportFormat::Vtt, segments);
+}
+
+// 导出为 JSON
+std::string WhisperWrapper::exportToJson(const std::vector<TranscriptSegment>& segments) {
+    return export_to_string(ExportFormat::Json, segments);
+}
+
+// 导出为 LRC 歌词
+std::string WhisperWrapper::exportToLrc(const std::vector<TranscriptSegment>& segments) {
+    return export_to_string(ExportFormat::Lrc, segments);
+}
+
+// 一次导出多种格式: 每种格式一个线程, 共享同一份只读片段
+std::vector<ExportedFile> WhisperWrapper::exportAll(const std::vector<TranscriptSegment>& segments,
+                                                    const ExportOptions& options) {
+    std::vector<ExportedFile> results(options.formats.size());
+    std::vector<ExportFormat> formats(options.formats.size());
+    std::vector<bool> runnable(options.formats.size(), false);
+
+    std::string dirError;
+    if (!options.outDir.empty()) {
+        std::error_code ec;
+        fs::create_directories(fs::u8path(options.outDir), ec);
+        if (ec) {
+            dirError = "Cannot create output directory: " + options.outDir;
+        }
+    }
+
+    for (size_t i = 0; i < options.formats.size(); ++i) {
+        results[i].format = options.formats[i];
+        if (!parse_export_format(options.formats[i], formats[i])) {
+            results[i].error = "Unknown export format: " + options.formats[i];
+        } else if (std::find(options.formats.begin(), options.formats.begin() + i, options.formats[i]) !=
+                   options.formats.begin() + i) {
+            results[i].error = "Duplicate export format: " + options.formats[i];
+        } else if (!dirError.empty()) {
+            results[i].error = dirError;
+        } else {
+            runnable[i] = true;
+        }
+    }
+
+    auto run = [&](size_t i) {
+        if (options.outDir.empty()) {
+            results[i].content = export_to_string(formats[i], segments);
+            results[i].bytes = results[i].content.size();
+        } else {
+            fs::path target = fs::u8path(options.outDir) / fs::u8path(options.baseName + "." + options.formats[i]);
+            export_to_file(formats[i], segments, target, results[i]);
+        }
+    };
+
+    // 第一种格式在当前线程执行, 其余各开一个线程
+    std::vector<std::future<void>> jobs;
+    size_t first = options.formats.size();
+    for (size_t i = 0; i < options.formats.size(); ++i) {
+        if (!runnable[i]) continue;
+        if (first == options.formats.size()) {
+            first = i;
+            continue;
+        }
+        jobs.push_back(std::async(std::launch::async, run, i));
+    }
+    if (first < options.formats.size()) {
+        run(first);
+    }
+    for (auto& job : jobs) {
+        job.get();
+    }
+    return results;
+}
+
+bool WhisperWrapper::isModelLoaded() const {
+    std::lock_guard<std::mutex> lock(modelMutex);
+    return currentModel != nullptr;
+}
+
+bool WhisperWrapper::isDraftModelLoaded() const {
+    std::lock_guard<std::mutex> lock(modelMutex);
+    return currentDraft != nullptr;
+}
+
+BackendInfo WhisperWrapper::getBackendInfo() const {
+    std::lock_guard<std::mutex> lock(modelMutex);
+    return queryBackends(currentModel ? currentModel->backend : BackendOptions());
+}
+
+ModelInfo WhisperWrapper::getModelInfo() const {
+    std::lock_guard<std::mutex> lock(modelMutex);
+    return currentModel ? currentModel->info : ModelInfo();
+}
+
+
 } // namespace llwhisper
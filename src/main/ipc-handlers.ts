@@ -1,7 +1,7 @@
 import { ipcMain, dialog } from 'electron';
 import { mainWindow } from './main';
 import { ConfigManager } from './config-manager';
-import { IpcChannels, ProcessingStatus } from '../shared/types';
+import { IpcChannels, ProcessingStatus, TranscribeOptions } from '../shared/types';
 import * as path from 'path';
 import * as fs from 'fs';
 
@@ -12,6 +12,9 @@ const bindings = require('bindings');
 let llvideo: any = null;
 let llwhisper: any = null;
 
+// 字幕编辑器当前使用的片段存储
+let editorTranscriptKey: string | null = null;
+
 // 初始化 native 模块（在 app.whenReady() 之后调用）
 function initializeNativeModules() {
   try {
@@ -138,12 +141,10 @@ export function setupIpcHandlers() {
       const stats = fs.statSync(modelPath);
       console.log(`[Whisper] Model file size: ${(stats.size / 1024 / 1024).toFixed(2)} MB`);
       
-      const result = await llwhisper.loadModel(modelPath);
-      if (!result) {
-        throw new Error('loadModel returned false');
-      }
+      // 在后台线程加载, 进行中的转录继续使用旧模型, 结束后旧模型自动释放
+      const loaded = await llwhisper.reloadModel(modelPath);
       
-      console.log('[Whisper] Model loaded successfully');
+      console.log(`[Whisper] Model v${loaded.version} loaded successfully`);
       return true;
     } catch (error: any) {
       console.error('[Whisper] Load error:', error);
@@ -152,17 +153,23 @@ export function setupIpcHandlers() {
   });
 
   // 转录音频
-  ipcMain.handle(IpcChannels.TRANSCRIBE_AUDIO, async (_, audioPath: string, language: 'ja' | 'en') => {
+  ipcMain.handle(IpcChannels.TRANSCRIBE_AUDIO, async (_, audioPath: string, language: 'ja' | 'en',
+                                                       options: TranscribeOptions = {}) => {
     try {
       if (!llwhisper) {
         throw new Error('llwhisper module not loaded');
       }
-      const segments = await llwhisper.transcribe(audioPath, language);
+      let segments = await llwhisper.transcribe(audioPath, { language, diarize: !!options.diarize });
+      if (options.resegment) {
+        // 按字幕行宽 / 阅读速度重新分段
+        segments = llwhisper.resegment(segments);
+      }
       
-      // 生成唯一 ID
+      // 生成唯一 ID, 说话人编号转换为界面使用的名称
       return segments.map((seg: any, index: number) => ({
         id: `seg_${Date.now()}_${index}`,
         ...seg,
+        speaker: seg.speakerId !== undefined ? speakerLabel(seg.speakerId) : undefined,
         language
       }));
     } catch (error: any) {
@@ -170,6 +177,40 @@ export function setupIpcHandlers() {
     }
   });
 
+  // 批量转录: 一次调用处理整个文件夹, 模型常驻, 下一个文件的解码与当前文件的推理重叠
+  ipcMain.handle(IpcChannels.TRANSCRIBE_BATCH, async (_, files: string[], language: 'ja' | 'en', concurrency?: number,
+                                                       options: TranscribeOptions = {}) => {
+    try {
+      if (!llwhisper) {
+        throw new Error('llwhisper module not loaded');
+      }
+      let done = 0;
+      const batch = await llwhisper.transcribeBatch(files, { language, diarize: !!options.diarize }, { concurrency: concurrency || 1 },
+        (_index: number, file: any) => {
+          done++;
+          sendProcessingStatus({
+            stage: 'transcribing',
+            progress: Math.round(done / files.length * 100),
+            message: `已转录 ${done}/${files.length}: ${path.basename(file.path)}`
+          });
+        });
+      console.log(`[Whisper] Batch: ${batch.files.length} files, ${batch.audioHoursPerHour.toFixed(2)} audio hours/hour`);
+
+      return batch.files.map((file: any) => ({
+        path: file.path,
+        error: file.error,
+        segments: file.error ? [] : (options.resegment ? llwhisper.resegment(file.segments) : file.segments).map((seg: any, index: number) => ({
+          id: `seg_${Date.now()}_${index}`,
+          ...seg,
+          speaker: seg.speakerId !== undefined ? speakerLabel(seg.speakerId) : undefined,
+          language
+        }))
+      }));
+    } catch (error: any) {
+      throw new Error(`批量转录失败: ${error.message}`);
+    }
+  });
+
   // 翻译文本
   ipcMain.handle(IpcChannels.TRANSLATE_TEXT, async (_, text: string, sourceLang: string, targetLang: string) => {
     try {
@@ -191,9 +232,41 @@ export function setupIpcHandlers() {
     }
   });
 
-  // 保存字幕
-  ipcMain.handle(IpcChannels.SAVE_SUBTITLES, async (_, segments, options) => {
+  // 字幕编辑器: 创建 / 替换片段存储, 之后界面只按下标取可见的行
+  // 编辑器同一时间只打开一份字幕, 加载新字幕时释放上一份
+  ipcMain.handle(IpcChannels.TRANSCRIPT_LOAD, async (_, key: string, segments: any[]) => {
+    if (!llwhisper) {
+      throw new Error('llwhisper module not loaded');
+    }
+    if (editorTranscriptKey !== null && editorTranscriptKey !== key) {
+      llwhisper.releaseTranscriptStore(editorTranscriptKey);
+    }
+    editorTranscriptKey = key;
+    return llwhisper.createTranscriptStore(key, segments);
+  });
+
+  ipcMain.handle(IpcChannels.TRANSCRIPT_RANGE, async (_, key: string, start: number, count: number) => {
+    return llwhisper.getTranscriptRange(key, start, count);
+  });
+
+  ipcMain.handle(IpcChannels.TRANSCRIPT_SEARCH, async (_, key: string, query: string, limit?: number) => {
+    return llwhisper.searchTranscript(key, query, limit);
+  });
+
+  ipcMain.handle(IpcChannels.TRANSCRIPT_UPDATE, async (_, key: string, index: number, fields: any) => {
+    return llwhisper.updateTranscriptSegment(key, index, fields);
+  });
+
+  ipcMain.handle(IpcChannels.TRANSCRIPT_REMOVE, async (_, key: string, index: number) => {
+    return llwhisper.removeTranscriptSegment(key, index);
+  });
+
+  // 保存字幕 (segments 为片段数组, 或字幕编辑器的存储 key)
+  ipcMain.handle(IpcChannels.SAVE_SUBTITLES, async (_, source: any[] | string, options) => {
     try {
+      const segments = typeof source === 'string'
+        ? llwhisper.getTranscriptRange(source, 0, Number.MAX_SAFE_INTEGER)
+        : source;
       const result = await dialog.showSaveDialog({
         defaultPath: `subtitles.${options.format}`,
         filters: [
@@ -294,3 +367,8 @@ function formatTime(seconds: number): string {
 function pad(num: number, size: number = 2): string {
   return num.toString().padStart(size, '0');
 }
+
+// 说话人编号 -> 名称 (与渲染进程的默认名称 说话人A / 说话人B ... 一致)
+function speakerLabel(id: number): string {
+  return id < 26 ? `说话人${String.fromCharCode(65 + id)}` : `说话人${id + 1}`;
+}
@@ -3,10 +3,14 @@ const { IpcChannels } = require('../shared/types');
 
 // 状态管理
 let currentConfig: any = null;
-let currentSegments: any[] = [];
 let currentVideoPath: string | null = null;
 let speakers: string[] = ['说话人A', '说话人B', '说话人C'];
 
+// 字幕编辑器: 片段保存在主进程的 native 存储中 (key 为视频路径)
+let transcriptKey: string | null = null;
+let segmentCount = 0;
+let segmentLanguage = '';
+
 // DOM 元素
 const elements = {
     // 视频选择
@@ -19,12 +23,16 @@ const elements = {
     sourceLanguage: document.getElementById('sourceLanguage') as HTMLSelectElement,
     targetLanguage: document.getElementById('targetLanguage') as HTMLSelectElement,
     audioFormat: document.getElementById('audioFormat') as HTMLSelectElement,
+    diarize: document.getElementById('diarize') as HTMLInputElement,
+    resegment: document.getElementById('resegment') as HTMLInputElement,
     
     // 状态
     statusPanel: document.getElementById('statusPanel') as HTMLDivElement,
     
     // 字幕列表
     subtitleList: document.getElementById('subtitleList') as HTMLDivElement,
+    subtitleSearch: document.getElementById('subtitleSearch') as HTMLInputElement,
+    searchStatus: document.getElementById('searchStatus') as HTMLSpanElement,
     exportBtn: document.getElementById('exportBtn') as HTMLButtonElement,
     addSpeakerBtn: document.getElementById('addSpeakerBtn') as HTMLButtonElement,
     
@@ -77,6 +85,21 @@ function setupEventListeners() {
     // 添加说话人
     elements.addSpeakerBtn.addEventListener('click', addSpeaker);
     
+    // 字幕列表: 滚动时只渲染可见的行, 编辑 / 删除在列表上统一处理
+    elements.subtitleList.addEventListener('scroll', scheduleRender, { passive: true });
+    window.addEventListener('resize', scheduleRender);
+    elements.subtitleList.addEventListener('change', onSubtitleChange);
+    elements.subtitleList.addEventListener('click', onSubtitleClick);
+    
+    // 搜索: Enter 下一个, Shift+Enter 上一个
+    elements.subtitleSearch.addEventListener('input', scheduleSearch);
+    elements.subtitleSearch.addEventListener('keydown', (e: KeyboardEvent) => {
+        if (e.key === 'Enter') {
+            e.preventDefault();
+            stepSearch(e.shiftKey ? -1 : 1);
+        }
+    });
+    
     // 设置按钮
     elements.settingsBtn?.addEventListener('click', () => {
         elements.settingsModal?.classList.remove('hidden');
@@ -193,7 +216,8 @@ async function processVideo() {
         const segments = await ipcRenderer.invoke(
             IpcChannels.TRANSCRIBE_AUDIO,
             audioPath,
-            elements.sourceLanguage!.value
+            elements.sourceLanguage!.value,
+            { diarize: elements.diarize!.checked, resegment: elements.resegment!.checked }
         );
         
         // 4. 翻译
@@ -211,11 +235,16 @@ async function processVideo() {
             elements.targetLanguage!.value
         );
         
-        // 合并结果
-        currentSegments = segments.map((seg: any, index: number) => ({
+        // 合并结果, 交给主进程的字幕存储
+        const merged = segments.map((seg: any, index: number) => ({
             ...seg,
             translatedText: translations[index]
         }));
+        const store = await ipcRenderer.invoke(IpcChannels.TRANSCRIPT_LOAD, currentVideoPath, merged);
+        transcriptKey = currentVideoPath;
+        segmentCount = store.count;
+        segmentLanguage = elements.sourceLanguage!.value;
+        elements.subtitleList!.scrollTop = 0;
         
         // 5. 完成
         updateProcessingStatus({
@@ -225,6 +254,7 @@ async function processVideo() {
         });
         
         displaySubtitles();
+        runSearch();
         elements.exportBtn!.disabled = false;
         
     } catch (error: any) {
@@ -250,9 +280,44 @@ function updateProcessingStatus(status: any) {
     percentageEl!.textContent = Math.round(status.progress) + '%';
 }
 
+// ---- 字幕列表 (虚拟列表) ----
+// 片段保存在主进程的 native 存储中, 列表只为可见的行 (加上少量余量) 创建 DOM,
+// 行数据按块读取并缓存; 滚动、编辑与搜索都不会重建整个列表
+const ROW_HEIGHT = 270;          // .subtitle-item 固定高度 260px + 10px 间距 (见 main.css)
+const LIST_PADDING = 20;         // .subtitle-list 的 padding
+const OVERSCAN = 4;              // 可见范围上下多渲染的行数
+const FETCH_BLOCK = 64;          // 每次读取的行数 (按块对齐, 来回滚动时复用)
+const MAX_CACHED_BLOCKS = 64;
+const SEARCH_LIMIT = 5000;
+
+const rowBlocks = new Map<number, any[]>();               // 块号 -> 行数据
+const pendingBlocks = new Set<number>();
+const renderedRows = new Map<number, HTMLDivElement>();   // 下标 -> 行元素
+const rowPool: HTMLDivElement[] = [];
+let listGeneration = 0;          // 存储内容变化 (加载 / 删除) 时递增, 丢弃过期的读取结果
+let spacer: HTMLDivElement | null = null;
+let renderScheduled = false;
+let speakersVersion = 0;
+
+// 搜索状态
+let searchMatches: number[] = [];
+let searchHits = new Set<number>();
+let searchCursor = -1;
+let searchTotal = 0;
+let searchGeneration = 0;
+let searchScheduled = false;
+
 // 显示字幕列表
 function displaySubtitles() {
-    if (currentSegments.length === 0) {
+    listGeneration++;
+    rowBlocks.clear();
+    pendingBlocks.clear();
+    elements.subtitleSearch.disabled = segmentCount === 0;
+    
+    if (segmentCount === 0) {
+        spacer = null;
+        renderedRows.clear();
+        rowPool.length = 0;
         elements.subtitleList!.innerHTML = `
             <div class="empty-state">
                 <p>暂无字幕数据</p>
@@ -261,71 +326,272 @@ function displaySubtitles() {
         return;
     }
     
-    elements.subtitleList!.innerHTML = '';
+    if (!spacer) {
+        elements.subtitleList!.innerHTML = '';
+        spacer = document.createElement('div');
+        spacer.className = 'subtitle-spacer';
+        elements.subtitleList!.appendChild(spacer);
+    }
+    spacer.style.height = `${segmentCount * ROW_HEIGHT}px`;
+    scheduleRender();
+}
+
+function scheduleRender() {
+    if (renderScheduled) return;
+    renderScheduled = true;
+    requestAnimationFrame(renderRows);
+}
+
+// 渲染可见范围内的行, 移出范围的行元素放回池中复用
+function renderRows() {
+    renderScheduled = false;
+    if (!spacer) return;
+    
+    const list = elements.subtitleList!;
+    const top = Math.max(0, list.scrollTop - LIST_PADDING);
+    const first = Math.max(0, Math.floor(top / ROW_HEIGHT) - OVERSCAN);
+    const last = Math.min(segmentCount, Math.ceil((top + list.clientHeight) / ROW_HEIGHT) + OVERSCAN);
+    
+    for (const [index, row] of renderedRows) {
+        if (index < first || index >= last) {
+            renderedRows.delete(index);
+            row.remove();
+            rowPool.push(row);
+        }
+    }
+    
+    for (let index = first; index < last; index++) {
+        const segment = getRow(index);
+        if (!segment) continue;   // 数据读取后会再次渲染
+        
+        let row = renderedRows.get(index);
+        if (!row) {
+            row = rowPool.pop() || createSubtitleItem();
+            spacer.appendChild(row);
+            renderedRows.set(index, row);
+        }
+        fillSubtitleItem(row, segment, index);
+    }
     
-    for (let index = 0; index < currentSegments.length; index++) {
-        const segment = currentSegments[index];
-        const item = createSubtitleItem(segment, index);
-        elements.subtitleList!.appendChild(item);
+    trimRowBlocks(Math.floor(first / FETCH_BLOCK));
+}
+
+// 缓存中的行; 不在缓存中时读取所在的块并返回 undefined
+function getRow(index: number): any | undefined {
+    const block = Math.floor(index / FETCH_BLOCK);
+    const rows = rowBlocks.get(block);
+    if (rows) return rows[index - block * FETCH_BLOCK];
+    fetchBlock(block);
+    return undefined;
+}
+
+async function fetchBlock(block: number) {
+    if (pendingBlocks.has(block) || !transcriptKey) return;
+    pendingBlocks.add(block);
+    const generation = listGeneration;
+    try {
+        const rows = await ipcRenderer.invoke(
+            IpcChannels.TRANSCRIPT_RANGE,
+            transcriptKey,
+            block * FETCH_BLOCK,
+            FETCH_BLOCK
+        );
+        if (generation !== listGeneration) return;
+        rowBlocks.set(block, rows);
+        scheduleRender();
+    } catch (error: any) {
+        console.error('读取字幕失败: ' + error.message);
+    } finally {
+        if (generation === listGeneration) pendingBlocks.delete(block);
     }
 }
 
-// 创建字幕项
-function createSubtitleItem(segment: any, index: number) {
+// 只保留当前位置附近的块
+function trimRowBlocks(center: number) {
+    if (rowBlocks.size <= MAX_CACHED_BLOCKS) return;
+    for (const block of rowBlocks.keys()) {
+        if (Math.abs(block - center) > MAX_CACHED_BLOCKS / 2) {
+            rowBlocks.delete(block);
+        }
+    }
+}
+
+// 创建字幕项 (空模板, 内容由 fillSubtitleItem 填充; 事件在列表上统一处理)
+function createSubtitleItem() {
     const div = document.createElement('div');
     div.className = 'subtitle-item';
-    div.dataset.index = String(index);
-    
-    const speakerOptions = speakers.map(s => 
-        `<option value="${s}" ${segment.speaker === s ? 'selected' : ''}>${s}</option>`
-    ).join('');
-    
     div.innerHTML = `
         <div class="subtitle-header">
-            <span class="subtitle-time">${formatTime(segment.startTime)} → ${formatTime(segment.endTime)}</span>
+            <span class="subtitle-time"></span>
             <div class="subtitle-actions">
-                <select class="speaker-select" data-index="${index}">
-                    <option value="">未分配</option>
-                    ${speakerOptions}
-                </select>
-                <button class="btn btn-secondary btn-edit" data-index="${index}">编辑</button>
-                <button class="btn btn-danger btn-delete" data-index="${index}">删除</button>
+                <select class="speaker-select"></select>
+                <button class="btn btn-secondary btn-edit">编辑</button>
+                <button class="btn btn-danger btn-delete">删除</button>
             </div>
         </div>
         <div class="subtitle-content">
             <div class="subtitle-text original">
-                <div class="subtitle-label">原文 (${segment.language})</div>
-                <textarea class="text-original" data-index="${index}">${segment.text}</textarea>
+                <div class="subtitle-label"></div>
+                <textarea class="text-original"></textarea>
             </div>
             <div class="subtitle-text translation">
                 <div class="subtitle-label">译文 (中文)</div>
-                <textarea class="text-translation" data-index="${index}">${segment.translatedText || ''}</textarea>
+                <textarea class="text-translation"></textarea>
             </div>
         </div>
     `;
     
-    // 事件监听
-    div.querySelector('.speaker-select')?.addEventListener('change', (e: Event) => {
-        const target = e.target as HTMLSelectElement;
-        currentSegments[index].speaker = target.value;
-    });
+    (div as any).fields = {
+        time: div.querySelector('.subtitle-time'),
+        speaker: div.querySelector('.speaker-select'),
+        label: div.querySelector('.original .subtitle-label'),
+        original: div.querySelector('.text-original'),
+        translation: div.querySelector('.text-translation'),
+    };
+    return div;
+}
+
+// 填充字幕项; 行数据与说话人列表都未变化时只更新搜索高亮
+function fillSubtitleItem(row: HTMLDivElement, segment: any, index: number) {
+    const state = row as any;
+    row.classList.toggle('search-hit', searchHits.has(index));
+    row.classList.toggle('search-current', searchCursor >= 0 && searchMatches[searchCursor] === index);
+    if (state.segment === segment && state.index === index && state.speakersVersion === speakersVersion) {
+        return;
+    }
     
-    div.querySelector('.text-original')?.addEventListener('change', (e: Event) => {
-        const target = e.target as HTMLTextAreaElement;
-        currentSegments[index].text = target.value;
-    });
+    const fields = state.fields;
+    row.dataset.index = String(index);
+    row.style.top = `${index * ROW_HEIGHT}px`;
+    fields.time.textContent = `${formatTime(segment.startTime)} → ${formatTime(segment.endTime)}`;
+    fields.label.textContent = `原文 (${segmentLanguage})`;
+    fields.original.value = segment.text;
+    fields.translation.value = segment.translatedText || '';
     
-    div.querySelector('.text-translation')?.addEventListener('change', (e: Event) => {
-        const target = e.target as HTMLTextAreaElement;
-        currentSegments[index].translatedText = target.value;
-    });
+    if (state.speakersVersion !== speakersVersion) {
+        const select = fields.speaker as HTMLSelectElement;
+        select.options.length = 0;
+        select.add(new Option('未分配', ''));
+        for (const name of speakers) {
+            select.add(new Option(name, name));
+        }
+    }
+    fields.speaker.value = segment.speaker || '';
     
-    div.querySelector('.btn-delete')?.addEventListener('click', () => {
-        currentSegments.splice(index, 1);
+    state.segment = segment;
+    state.index = index;
+    state.speakersVersion = speakersVersion;
+}
+
+// 编辑 (列表上统一监听 change)
+function onSubtitleChange(e: Event) {
+    const target = e.target as HTMLElement;
+    const row = target.closest('.subtitle-item') as HTMLDivElement | null;
+    if (!row || !row.dataset.index) return;
+    
+    let fields: any;
+    if (target.classList.contains('speaker-select')) {
+        fields = { speaker: (target as HTMLSelectElement).value || null };
+    } else if (target.classList.contains('text-original')) {
+        fields = { text: (target as HTMLTextAreaElement).value };
+    } else if (target.classList.contains('text-translation')) {
+        fields = { translatedText: (target as HTMLTextAreaElement).value };
+    } else {
+        return;
+    }
+    updateSegment(Number(row.dataset.index), fields);
+}
+
+function onSubtitleClick(e: Event) {
+    const target = e.target as HTMLElement;
+    if (!target.classList.contains('btn-delete')) return;
+    const row = target.closest('.subtitle-item') as HTMLDivElement | null;
+    if (row && row.dataset.index) {
+        removeSegment(Number(row.dataset.index));
+    }
+}
+
+async function updateSegment(index: number, fields: any) {
+    try {
+        await ipcRenderer.invoke(IpcChannels.TRANSCRIPT_UPDATE, transcriptKey, index, fields);
+        // 直接修改缓存的行, 行元素内容已是新值, 不需要重新填充
+        const rows = rowBlocks.get(Math.floor(index / FETCH_BLOCK));
+        if (rows) Object.assign(rows[index % FETCH_BLOCK], fields);
+    } catch (error: any) {
+        showError('保存修改失败: ' + error.message);
+    }
+}
+
+async function removeSegment(index: number) {
+    try {
+        segmentCount = await ipcRenderer.invoke(IpcChannels.TRANSCRIPT_REMOVE, transcriptKey, index);
+        // 之后的行下标都减一: 丢弃缓存, 重新读取可见范围
         displaySubtitles();
+        if (searchMatches.length > 0) runSearch();
+    } catch (error: any) {
+        showError('删除失败: ' + error.message);
+    }
+}
+
+// ---- 搜索 ----
+
+function scheduleSearch() {
+    if (searchScheduled) return;
+    searchScheduled = true;
+    requestAnimationFrame(() => {
+        searchScheduled = false;
+        runSearch();
     });
+}
+
+async function runSearch() {
+    const query = elements.subtitleSearch.value.trim();
+    const generation = ++searchGeneration;
+    if (!query || !transcriptKey || segmentCount === 0) {
+        searchMatches = [];
+        searchHits.clear();
+        searchCursor = -1;
+        searchTotal = 0;
+        elements.searchStatus.textContent = '';
+        scheduleRender();
+        return;
+    }
     
-    return div;
+    try {
+        const result = await ipcRenderer.invoke(IpcChannels.TRANSCRIPT_SEARCH, transcriptKey, query, SEARCH_LIMIT);
+        if (generation !== searchGeneration) return;   // 输入已变化
+        searchMatches = Array.from(result.indices as Uint32Array);
+        searchHits = new Set(searchMatches);
+        searchTotal = result.total;
+        searchCursor = searchMatches.length > 0 ? 0 : -1;
+        updateSearchStatus();
+        if (searchCursor >= 0) scrollToRow(searchMatches[searchCursor]);
+        scheduleRender();
+    } catch (error: any) {
+        console.error('搜索失败: ' + error.message);
+    }
+}
+
+// 跳到下一个 / 上一个匹配
+function stepSearch(step: number) {
+    if (searchMatches.length === 0) return;
+    searchCursor = (searchCursor + step + searchMatches.length) % searchMatches.length;
+    updateSearchStatus();
+    scrollToRow(searchMatches[searchCursor]);
+    scheduleRender();
+}
+
+function updateSearchStatus() {
+    elements.searchStatus.textContent = searchTotal === 0 ? '无匹配' : `${searchCursor + 1}/${searchTotal}`;
+}
+
+// 目标行不在可见范围时滚动到列表中部
+function scrollToRow(index: number) {
+    const list = elements.subtitleList!;
+    const top = LIST_PADDING + index * ROW_HEIGHT;
+    if (top < list.scrollTop || top + ROW_HEIGHT > list.scrollTop + list.clientHeight) {
+        list.scrollTop = Math.max(0, top - (list.clientHeight - ROW_HEIGHT) / 2);
+    }
 }
 
 // 添加说话人
@@ -333,13 +599,14 @@ function addSpeaker() {
     const name = prompt('请输入说话人名称:');
     if (name && !speakers.includes(name)) {
         speakers.push(name);
-        displaySubtitles();
+        speakersVersion++;
+        scheduleRender();
     }
 }
 
 // 导出字幕
 async function exportSubtitles() {
-    if (currentSegments.length === 0) return;
+    if (!transcriptKey || segmentCount === 0) return;
     
     try {
         const options = {
@@ -349,9 +616,10 @@ async function exportSubtitles() {
             includeSpeaker: true
         };
         
+        // 主进程直接从存储中读取全部片段
         const path = await ipcRenderer.invoke(
             IpcChannels.SAVE_SUBTITLES,
-            currentSegments,
+            transcriptKey,
             options
         );
         
@@ -30,6 +30,12 @@ export interface AppConfig {
   audioFormat: 'wav' | 'mp3';
 }
 
+// 转录选项 (界面勾选, 默认关闭)
+export interface TranscribeOptions {
+  diarize?: boolean;  // 说话人分离 (额外耗时, 且需要先解码整个文件)
+  resegment?: boolean;  // 按字幕行宽 / 阅读速度重新分段
+}
+
 // 处理状态
 export interface ProcessingStatus {
   stage: 'idle' | 'extracting' | 'transcribing' | 'translating' | 'completed' | 'error';
@@ -47,6 +53,7 @@ export const IpcChannels = {
   // Whisper
   LOAD_WHISPER_MODEL: 'load-whisper-model',
   TRANSCRIBE_AUDIO: 'transcribe-audio',
+  TRANSCRIBE_BATCH: 'transcribe-batch',
   
   // 翻译
   TRANSLATE_TEXT: 'translate-text',
@@ -61,6 +68,13 @@ export const IpcChannels = {
   SELECT_FOLDER: 'select-folder',
   SAVE_SUBTITLES: 'save-subtitles',
   
+  // 字幕编辑器 (片段保存在主进程的 native 存储中, 界面按需取可见的行)
+  TRANSCRIPT_LOAD: 'transcript-load',
+  TRANSCRIPT_RANGE: 'transcript-range',
+  TRANSCRIPT_SEARCH: 'transcript-search',
+  TRANSCRIPT_UPDATE: 'transcript-update',
+  TRANSCRIPT_REMOVE: 'transcript-remove',
+  
   // 状态更新
   PROCESSING_STATUS: 'processing-status',
   ERROR: 'error',